@@ -12,4 +12,6 @@ macro(EXPORT_CXX_VALUE flag_name)
 endmacro()
 
 EXPORT_CXX_VALUE(HYDRA_ENABLE_GNN)
+EXPORT_CXX_VALUE(HYDRA_ENABLE_ZMQ)
+EXPORT_CXX_VALUE(HYDRA_ENABLE_ZLIB)
 configure_file(cmake/hydra_build_config.h.in ${CMAKE_CURRENT_BINARY_DIR}/hydra_build_config.h)
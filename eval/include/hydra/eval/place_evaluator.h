@@ -34,8 +34,11 @@
  * -------------------------------------------------------------------------- */
 #pragma once
 #include <optional>
+#include <string>
+#include <vector>
 
 #include "hydra/common/dsg_types.h"
+#include "hydra/common/global_info.h"
 #include "hydra/eval/place_metrics.h"
 #include "hydra/places/gvd_integrator_config.h"
 #include "hydra/reconstruction/voxel_types.h"
@@ -46,21 +49,42 @@ class PlaceEvaluator {
  public:
   using Ptr = std::unique_ptr<PlaceEvaluator>;
 
-  PlaceEvaluator(const places::GvdIntegratorConfig& config, const TsdfLayer::Ptr& tsdf);
+  /**
+   * @brief Compute the ground-truth GVD for a TSDF
+   * @param num_threads Number of threads to summarize the GVD with
+   */
+  PlaceEvaluator(
+      const places::GvdIntegratorConfig& config,
+      const TsdfLayer::Ptr& tsdf,
+      int num_threads = GlobalInfo::instance().getConfig().default_num_threads);
 
+  //! Recompute the GT GVD and keep only a compact summary of it
   void computeGroundTruth(const places::GvdIntegratorConfig& config);
 
-  PlaceMetrics eval(const std::string& graph_filepath) const;
+  PlaceMetrics eval(const std::string& graph_filepath, int num_threads = 1) const;
+
+  /**
+   * @brief Evaluate several graphs, loading and scoring them concurrently
+   *
+   * At most num_threads graphs are held in memory at a time. Results are in the same
+   * order as the input paths.
+   */
+  std::vector<PlaceMetrics> eval(
+      const std::vector<std::string>& graph_filepaths,
+      int num_threads = GlobalInfo::instance().getConfig().default_num_threads) const;
 
  public:
-  static PlaceEvaluator::Ptr fromFile(const std::string& config_filepath,
-                                      const std::string& tsdf_filepath,
-                                      std::optional<double> max_dist_m = std::nullopt);
+  static PlaceEvaluator::Ptr fromFile(
+      const std::string& config_filepath,
+      const std::string& tsdf_filepath,
+      std::optional<double> max_dist_m = std::nullopt,
+      int num_threads = GlobalInfo::instance().getConfig().default_num_threads);
 
  private:
   places::GvdIntegratorConfig config_;
+  int num_threads_;
   TsdfLayer::Ptr tsdf_;
-  places::GvdLayer::Ptr gvd_;
+  std::unique_ptr<GvdSummary> gvd_;
 };
 
 }  // namespace hydra::eval
@@ -37,7 +37,9 @@
 #include <vector>
 
 #include "hydra/common/dsg_types.h"
+#include "hydra/common/global_info.h"
 #include "hydra/places/gvd_voxel.h"
+#include "hydra/reconstruction/voxel_types.h"
 
 namespace hydra::eval {
 
@@ -51,6 +53,67 @@ struct PlaceMetrics {
   std::vector<NodeId> node_order;
 };
 
+/**
+ * @brief Compact per-block summary of a ground-truth GVD
+ *
+ * Stores only what place scoring needs (a float distance per voxel and the positions
+ * of GVD voxels) so that the full GVD layer can be released after it is summarized.
+ * Closest-GVD queries search outward from the query block ring by ring instead of
+ * through a global kd-tree.
+ */
+class GvdSummary {
+ public:
+  enum class Status { MISSING, UNOBSERVED, VALID };
+
+  /**
+   * @brief Summarize a GVD layer block by block
+   * @param gvd GVD layer to summarize
+   * @param min_gvd_basis Minimum number of basis points for a voxel to be on the GVD
+   * @param num_threads Number of threads to use
+   */
+  GvdSummary(const places::GvdLayer& gvd,
+             size_t min_gvd_basis,
+             int num_threads = GlobalInfo::instance().getConfig().default_num_threads);
+
+  //! Get the status and (if valid) the GT distance of the voxel containing pos
+  Status lookup(const Eigen::Vector3d& pos, double& distance) const;
+
+  //! Get the distance to the closest GVD voxel (NaN if the GVD is empty)
+  double closestGvdDistance(const Eigen::Vector3d& pos) const;
+
+  size_t numGvdVoxels() const { return num_gvd_voxels_; }
+
+ private:
+  struct BlockSummary {
+    //! GT distance per voxel (NaN if unobserved)
+    std::vector<float> distances;
+    //! Positions of voxels on the GVD
+    std::vector<Eigen::Vector3f> gvd_points;
+  };
+
+  void searchBlock(const BlockIndex& index,
+                   const Eigen::Vector3f& pos,
+                   float& best_sq) const;
+
+  float voxel_size_;
+  int voxels_per_side_;
+  float block_size_;
+  size_t num_gvd_voxels_ = 0;
+  BlockIndexMap<BlockSummary> blocks_;
+  //! Blocks containing at least one GVD voxel
+  BlockIndices gvd_blocks_;
+  BlockIndex min_gvd_block_;
+  BlockIndex max_gvd_block_;
+};
+
+/**
+ * @brief Score places against a GVD summary
+ * @param num_threads Number of threads to score nodes with
+ */
+PlaceMetrics scorePlaces(const SceneGraphLayer& places,
+                         const GvdSummary& gvd,
+                         int num_threads = 1);
+
 PlaceMetrics scorePlaces(const SceneGraphLayer& places,
                          const places::GvdLayer& gvd,
                          size_t min_gvd_basis);
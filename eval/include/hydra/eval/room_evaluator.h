@@ -38,7 +38,9 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "hydra/common/global_info.h"
 #include "hydra/eval/room_io.h"
 #include "hydra/eval/room_metrics.h"
 #include "hydra/reconstruction/voxel_types.h"
@@ -54,6 +56,8 @@ class RoomEvaluator {
     float min_weight = 1.0e-6f;
     float min_distance = 0.0f;
     size_t min_room_nodes = 0;
+    //! Threads for ground-truth indices and batch evaluation
+    int num_threads = GlobalInfo::instance().getConfig().default_num_threads;
   } const config;
 
   RoomEvaluator(const Config& config,
@@ -64,9 +68,19 @@ class RoomEvaluator {
 
   const RoomIndices& getRoomIndices() const;
 
-  void computeDsgIndices(const DynamicSceneGraph& graph, RoomIndices& indices) const;
+  void computeDsgIndices(const DynamicSceneGraph& graph,
+                         RoomIndices& indices,
+                         int num_threads = 1) const;
 
-  RoomMetrics eval(const std::string& graph_filepath) const;
+  RoomMetrics eval(const std::string& graph_filepath, int num_threads = 1) const;
+
+  /**
+   * @brief Evaluate several graphs, loading and scoring them concurrently
+   *
+   * At most config.num_threads graphs are held in memory at a time. Results are in
+   * the same order as the input paths.
+   */
+  std::vector<RoomMetrics> eval(const std::vector<std::string>& graph_filepaths) const;
 
   static GlobalIndices getSphereAroundPoint(const TsdfLayer& layer,
                                             const Point& center,
@@ -34,15 +34,15 @@
  * -------------------------------------------------------------------------- */
 #pragma once
 #include <Eigen/Dense>
-#include <array>
 #include <map>
 #include <ostream>
-#include <set>
 #include <vector>
 
+#include "hydra/reconstruction/voxel_types.h"
+
 namespace hydra::eval {
 
-using RoomIndices = std::map<size_t, std::set<std::array<int64_t, 3>>>;
+using RoomIndices = std::map<size_t, GlobalIndexSet>;
 
 struct RoomMetrics {
   double total_recall;
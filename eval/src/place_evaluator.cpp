@@ -39,36 +39,46 @@
 #include <glog/logging.h>
 
 #include "hydra/places/gvd_integrator.h"
-#include "hydra/reconstruction/volumetric_map.h"
+#include "hydra/reconstruction/parallel_utilities.h"
+#include "hydra/utils/graph_checkpoint.h"
 #include "hydra/utils/layer_io.h"
 
 namespace hydra::eval {
 
 using places::GvdIntegratorConfig;
 using places::GvdLayer;
-using places::GvdVoxel;
 
 PlaceEvaluator::PlaceEvaluator(const GvdIntegratorConfig& config,
-                               const TsdfLayer::Ptr& tsdf)
-    : tsdf_(CHECK_NOTNULL(tsdf)) {
-  gvd_.reset(new GvdLayer(tsdf_->voxel_size, tsdf_->voxels_per_side));
+                               const TsdfLayer::Ptr& tsdf,
+                               int num_threads)
+    : num_threads_(num_threads), tsdf_(CHECK_NOTNULL(tsdf)) {
   computeGroundTruth(config);
 }
 
 void PlaceEvaluator::computeGroundTruth(const GvdIntegratorConfig& config) {
   config_ = config;
+  gvd_.reset();
 
   VLOG(1) << "using GVD config:" << std::endl << config_;
-  places::GvdIntegrator integrator(config_, gvd_, nullptr);
-  auto map = VolumetricMap::fromTsdf(*tsdf_, 0.3, false);
-  CHECK(map) << "Invalid map!";
-  integrator.updateFromTsdf(0, map->getTsdfLayer(), false, true);
-  integrator.updateGvd(0);
+  // The GVD wavefront isn't block-local, so the full GT GVD layer is integrated at
+  // once. The TSDF is read in place (the integrator doesn't modify it when
+  // clear_updated_flag is false) instead of through a copied VolumetricMap.
+  GvdLayer::Ptr gvd(new GvdLayer(tsdf_->voxel_size, tsdf_->voxels_per_side));
+  {
+    places::GvdIntegrator integrator(config_, gvd, nullptr);
+    integrator.updateFromTsdf(0, *tsdf_, false, true);
+    integrator.updateGvd(0);
+  }
+
+  // the full GVD layer is dropped once summarized
+  gvd_ = std::make_unique<GvdSummary>(
+      *gvd, config_.min_basis_for_extraction, num_threads_);
 }
 
 PlaceEvaluator::Ptr PlaceEvaluator::fromFile(const std::string& config_filepath,
                                              const std::string& tsdf_filepath,
-                                             std::optional<double> max_distance_m) {
+                                             std::optional<double> max_distance_m,
+                                             int num_threads) {
   auto config = config::fromYamlFile<GvdIntegratorConfig>(config_filepath);
   if (max_distance_m) {
     config.max_distance_m = *max_distance_m;
@@ -80,11 +90,17 @@ PlaceEvaluator::Ptr PlaceEvaluator::fromFile(const std::string& config_filepath,
     return nullptr;
   }
 
-  return std::make_unique<PlaceEvaluator>(config, tsdf);
+  return std::make_unique<PlaceEvaluator>(config, tsdf, num_threads);
 }
 
-PlaceMetrics PlaceEvaluator::eval(const std::string& graph_filepath) const {
-  const auto graph = DynamicSceneGraph::load(graph_filepath);
+PlaceMetrics PlaceEvaluator::eval(const std::string& graph_filepath,
+                                  int num_threads) const {
+  const auto graph = loadGraph(graph_filepath);
+  if (!graph) {
+    LOG(ERROR) << "Unable to load graph from: " << graph_filepath;
+    return {};
+  }
+
   if (!graph->hasLayer(DsgLayers::PLACES)) {
     LOG(ERROR) << "Graph file: " << graph_filepath << " does not have places";
     return {};
@@ -92,7 +108,22 @@ PlaceMetrics PlaceEvaluator::eval(const std::string& graph_filepath) const {
 
   const auto& places = graph->getLayer(DsgLayers::PLACES);
   LOG(INFO) << "Place Nodes: " << places.nodes().size();
-  return scorePlaces(places, *gvd_, config_.min_basis_for_extraction);
+  return scorePlaces(places, *gvd_, num_threads);
+}
+
+std::vector<PlaceMetrics> PlaceEvaluator::eval(
+    const std::vector<std::string>& graph_filepaths, int num_threads) const {
+  std::vector<PlaceMetrics> results(graph_filepaths.size());
+  if (graph_filepaths.size() == 1) {
+    // nothing to batch, so score the nodes of the single graph in parallel instead
+    results[0] = eval(graph_filepaths[0], num_threads);
+    return results;
+  }
+
+  parallelFor(graph_filepaths.size(), num_threads, [&](size_t i, size_t) {
+    results[i] = eval(graph_filepaths[i]);
+  });
+  return results;
 }
 
 }  // namespace hydra::eval
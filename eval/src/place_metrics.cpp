@@ -36,106 +36,214 @@
 
 #include <glog/logging.h>
 
-#include <nanoflann.hpp>
+#include <cmath>
+#include <limits>
+
+#include "hydra/reconstruction/parallel_utilities.h"
 
 namespace hydra::eval {
 
-using nanoflann::KDTreeSingleIndexAdaptor;
-using nanoflann::L2_Simple_Adaptor;
 using places::GvdLayer;
-using places::GvdVoxel;
 
-void fillGvdPositions(const GvdLayer& layer,
-                      size_t min_gvd_basis,
-                      std::vector<Eigen::Vector3d>& result) {
-  result.clear();
+namespace {
+
+inline BlockIndex blockFromGlobalIndex(const GlobalIndex& index, int vps) {
+  BlockIndex block;
+  for (int i = 0; i < 3; ++i) {
+    // floor division for negative indices
+    const auto quotient = index(i) / vps;
+    block(i) = (index(i) % vps != 0 && index(i) < 0) ? quotient - 1 : quotient;
+  }
+  return block;
+}
+
+}  // namespace
 
-  for (const auto& block : layer) {
-    for (size_t i = 0; i < block.numVoxels(); ++i) {
-      const auto& voxel = block.getVoxel(i);
-      if (!voxel.observed || voxel.num_extra_basis < min_gvd_basis) {
+GvdSummary::GvdSummary(const GvdLayer& gvd, size_t min_gvd_basis, int num_threads)
+    : voxel_size_(gvd.voxel_size),
+      voxels_per_side_(gvd.voxels_per_side),
+      block_size_(gvd.voxel_size * gvd.voxels_per_side),
+      min_gvd_block_(BlockIndex::Zero()),
+      max_gvd_block_(BlockIndex::Zero()) {
+  const auto indices = gvd.allocatedBlockIndices();
+  std::vector<BlockSummary> summaries(indices.size());
+  parallelFor(indices.size(), num_threads, [&](size_t i, size_t) {
+    const auto& block = gvd.getBlock(indices[i]);
+    auto& summary = summaries[i];
+    summary.distances.resize(block.numVoxels());
+    for (size_t v = 0; v < block.numVoxels(); ++v) {
+      const auto& voxel = block.getVoxel(v);
+      if (!voxel.observed) {
+        summary.distances[v] = std::numeric_limits<float>::quiet_NaN();
         continue;
       }
 
-      result.push_back(block.getVoxelPosition(i).cast<double>());
+      summary.distances[v] = voxel.distance;
+      if (voxel.num_extra_basis >= min_gvd_basis) {
+        summary.gvd_points.push_back(block.getVoxelPosition(v));
+      }
     }
+
+    summary.gvd_points.shrink_to_fit();
+  });
+
+  for (size_t i = 0; i < indices.size(); ++i) {
+    const auto& index = indices[i];
+    const auto num_points = summaries[i].gvd_points.size();
+    if (num_points) {
+      min_gvd_block_ = gvd_blocks_.empty() ? index : min_gvd_block_.cwiseMin(index);
+      max_gvd_block_ = gvd_blocks_.empty() ? index : max_gvd_block_.cwiseMax(index);
+      gvd_blocks_.push_back(index);
+      num_gvd_voxels_ += num_points;
+    }
+
+    blocks_.emplace(index, std::move(summaries[i]));
   }
+
+  VLOG(1) << "Summarized " << blocks_.size() << " GVD blocks with " << num_gvd_voxels_
+          << " GVD voxels";
 }
 
-struct VoxelKdTreeAdaptor {
-  VoxelKdTreeAdaptor(const std::vector<Eigen::Vector3d>& positions)
-      : positions(positions) {}
+GvdSummary::Status GvdSummary::lookup(const Eigen::Vector3d& pos,
+                                      double& distance) const {
+  const Point pos_f = pos.cast<float>();
+  const auto global_index =
+      spatial_hash::indexFromPoint<GlobalIndex>(pos_f, 1.0f / voxel_size_);
+  const auto block_index = blockFromGlobalIndex(global_index, voxels_per_side_);
+  const auto iter = blocks_.find(block_index);
+  if (iter == blocks_.end()) {
+    return Status::MISSING;
+  }
 
-  inline size_t kdtree_get_point_count() const { return positions.size(); }
+  const GlobalIndex block_origin =
+      block_index.cast<GlobalIndex::Scalar>() * voxels_per_side_;
+  const VoxelIndex voxel_index = (global_index - block_origin).cast<int>();
+  const auto linear_index =
+      spatial_hash::linearIndexFromVoxelIndex(voxel_index, voxels_per_side_);
+  const float voxel_distance = iter->second.distances.at(linear_index);
+  if (std::isnan(voxel_distance)) {
+    return Status::UNOBSERVED;
+  }
+
+  distance = voxel_distance;
+  return Status::VALID;
+}
 
-  inline double kdtree_get_pt(const size_t idx, const size_t dim) const {
-    return positions[idx](dim);
+void GvdSummary::searchBlock(const BlockIndex& index,
+                             const Eigen::Vector3f& pos,
+                             float& best_sq) const {
+  const auto iter = blocks_.find(index);
+  if (iter == blocks_.end()) {
+    return;
   }
 
-  template <class T>
-  bool kdtree_get_bbox(T&) const {
-    return false;
+  for (const auto& point : iter->second.gvd_points) {
+    best_sq = std::min(best_sq, (point - pos).squaredNorm());
   }
+}
 
-  std::vector<Eigen::Vector3d> positions;
-};
+double GvdSummary::closestGvdDistance(const Eigen::Vector3d& pos) const {
+  if (gvd_blocks_.empty()) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
 
-struct DistanceFinder {
-  using Dist = L2_Simple_Adaptor<double, VoxelKdTreeAdaptor>;
-  using KDTree = KDTreeSingleIndexAdaptor<Dist, VoxelKdTreeAdaptor, 3, size_t>;
+  const Eigen::Vector3f pos_f = pos.cast<float>();
+  const auto center =
+      spatial_hash::indexFromPoint<BlockIndex>(pos_f, 1.0f / block_size_);
 
-  DistanceFinder(std::vector<Eigen::Vector3d>& positions) : adaptor(positions) {
-    kdtree.reset(new KDTree(3, adaptor));
-    kdtree->buildIndex();
+  // no rings past this one contain GVD voxels
+  int max_ring = 0;
+  for (int i = 0; i < 3; ++i) {
+    max_ring = std::max(max_ring, std::abs(center(i) - min_gvd_block_(i)));
+    max_ring = std::max(max_ring, std::abs(center(i) - max_gvd_block_(i)));
   }
 
-  double distance(const Eigen::Vector3d& pos) const {
-    size_t idx;
-    double dist;
-    size_t num_found = kdtree->knnSearch(pos.data(), 1, &idx, &dist);
-    return num_found ? std::sqrt(dist) : std::numeric_limits<double>::quiet_NaN();
+  float best_sq = std::numeric_limits<float>::infinity();
+  for (int r = 0; r <= max_ring; ++r) {
+    const size_t outer = 2 * r + 1;
+    const size_t inner = r > 0 ? 2 * r - 1 : 0;
+    if (outer * outer * outer - inner * inner * inner > gvd_blocks_.size()) {
+      // visiting every occupied block is cheaper than the rest of the rings
+      for (const auto& index : gvd_blocks_) {
+        searchBlock(index, pos_f, best_sq);
+      }
+      break;
+    }
+
+    for (int x = -r; x <= r; ++x) {
+      for (int y = -r; y <= r; ++y) {
+        const bool on_face = r == 0 || std::abs(x) == r || std::abs(y) == r;
+        const int z_step = on_face ? 1 : 2 * r;
+        for (int z = -r; z <= r; z += z_step) {
+          searchBlock(center + BlockIndex(x, y, z), pos_f, best_sq);
+        }
+      }
+    }
+
+    // every voxel in the next ring is at least r blocks away from the query
+    const float next_ring_dist = r * block_size_;
+    if (best_sq <= next_ring_dist * next_ring_dist) {
+      break;
+    }
   }
 
-  VoxelKdTreeAdaptor adaptor;
-  std::unique_ptr<KDTree> kdtree;
-};
+  return std::sqrt(best_sq);
+}
 
 PlaceMetrics scorePlaces(const SceneGraphLayer& places,
-                         const GvdLayer& gvd,
-                         size_t min_gvd_basis) {
+                         const GvdSummary& gvd,
+                         int num_threads) {
   PlaceMetrics metrics;
   metrics.is_valid = true;
 
-  std::vector<Eigen::Vector3d> gvd_positions;
-  fillGvdPositions(gvd, min_gvd_basis, gvd_positions);
-  const DistanceFinder finder(gvd_positions);
-
+  std::vector<const PlaceNodeAttributes*> node_attrs;
   for (auto&& [node_id, node] : places.nodes()) {
-    const auto& attrs = node->attributes<PlaceNodeAttributes>();
     metrics.node_order.push_back(node_id);
+    node_attrs.push_back(&node->attributes<PlaceNodeAttributes>());
+  }
 
-    const auto pos = attrs.position;
-    metrics.node_gvd_distances.push_back(finder.distance(pos));
+  struct NodeResult {
+    GvdSummary::Status status;
+    double closest_distance;
+    double gvd_distance;
+  };
 
-    const Point pos_f = pos.cast<float>();
-    const auto* voxel = gvd.getVoxelPtr(pos_f);
-    if (!voxel) {
-      metrics.num_missing++;
-      continue;
-    }
+  std::vector<NodeResult> results(node_attrs.size());
+  parallelFor(node_attrs.size(), num_threads, [&](size_t i, size_t) {
+    const auto& pos = node_attrs[i]->position;
+    auto& result = results[i];
+    result.closest_distance = gvd.closestGvdDistance(pos);
+    result.status = gvd.lookup(pos, result.gvd_distance);
+  });
 
-    if (!voxel->observed) {
-      metrics.num_unobserved++;
-      continue;
+  // accumulate in node order so results don't depend on the number of threads
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& result = results[i];
+    metrics.node_gvd_distances.push_back(result.closest_distance);
+    switch (result.status) {
+      case GvdSummary::Status::MISSING:
+        metrics.num_missing++;
+        break;
+      case GvdSummary::Status::UNOBSERVED:
+        metrics.num_unobserved++;
+        break;
+      case GvdSummary::Status::VALID:
+        metrics.num_valid++;
+        metrics.gvd_distance_errors.push_back(
+            std::abs(result.gvd_distance - node_attrs[i]->distance));
+        break;
     }
-
-    metrics.num_valid++;
-    metrics.gvd_distance_errors.push_back(std::abs(voxel->distance - attrs.distance));
   }
 
   return metrics;
 }
 
+PlaceMetrics scorePlaces(const SceneGraphLayer& places,
+                         const GvdLayer& gvd,
+                         size_t min_gvd_basis) {
+  return scorePlaces(places, GvdSummary(gvd, min_gvd_basis));
+}
+
 /*
 nlohmann::json json_results = {
     {"missing", missing},
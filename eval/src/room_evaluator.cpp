@@ -36,7 +36,9 @@
 
 #include <glog/logging.h>
 
+#include "hydra/reconstruction/parallel_utilities.h"
 #include "hydra/reconstruction/voxel_types.h"
+#include "hydra/utils/graph_checkpoint.h"
 #include "hydra/utils/layer_io.h"
 
 namespace hydra::eval {
@@ -53,7 +55,13 @@ void RoomEvaluator::computeRoomIndices() {
     room_indices_[room_id] = {};
   }
 
-  for (const auto& block : *tsdf_) {
+  // each worker collects indices for its blocks separately to avoid locking
+  const auto blocks = tsdf_->allocatedBlockIndices();
+  std::vector<RoomIndices> worker_indices(
+      getNumWorkers(config.num_threads, blocks.size()));
+  parallelFor(blocks.size(), config.num_threads, [&](size_t i, size_t worker) {
+    const auto& block = tsdf_->getBlock(blocks[i]);
+    auto& indices = worker_indices[worker];
     for (size_t idx = 0; idx < block.numVoxels(); ++idx) {
       const auto& voxel = block.getVoxel(idx);
       if (voxel.weight < config.min_weight || voxel.distance < config.min_distance) {
@@ -66,9 +74,13 @@ void RoomEvaluator::computeRoomIndices() {
         continue;
       }
 
-      const auto global_index = block.getGlobalVoxelIndex(idx);
-      room_indices_[*room_id].insert(
-          {global_index.x(), global_index.y(), global_index.z()});
+      indices[*room_id].insert(block.getGlobalVoxelIndex(idx));
+    }
+  });
+
+  for (const auto& indices : worker_indices) {
+    for (const auto& [room_id, room] : indices) {
+      room_indices_[room_id].insert(room.begin(), room.end());
     }
   }
 }
@@ -76,7 +88,9 @@ void RoomEvaluator::computeRoomIndices() {
 const RoomIndices& RoomEvaluator::getRoomIndices() const { return room_indices_; }
 
 void RoomEvaluator::computeDsgIndices(const DynamicSceneGraph& graph,
-                                      RoomIndices& indices) const {
+                                      RoomIndices& indices,
+                                      int num_threads) const {
+  std::vector<const SceneGraphNode*> room_nodes;
   const auto& rooms = graph.getLayer(DsgLayers::ROOMS);
   for (auto&& [room, room_node] : rooms.nodes()) {
     if (room_node->children().size() < config.min_room_nodes) {
@@ -85,9 +99,13 @@ void RoomEvaluator::computeDsgIndices(const DynamicSceneGraph& graph,
       continue;
     }
 
-    indices[room] = {};
+    room_nodes.push_back(room_node.get());
+  }
 
-    for (const auto& child : room_node->children()) {
+  std::vector<GlobalIndexSet> room_indices(room_nodes.size());
+  parallelFor(room_nodes.size(), num_threads, [&](size_t i, size_t) {
+    auto& curr_indices = room_indices[i];
+    for (const auto& child : room_nodes[i]->children()) {
       const auto& place_node = graph.getNode(child);
       const auto& attrs = place_node.attributes<PlaceNodeAttributes>();
       const Point pos = attrs.position.cast<float>();
@@ -110,24 +128,49 @@ void RoomEvaluator::computeDsgIndices(const DynamicSceneGraph& graph,
             continue;
           }
         }
-        indices[room].insert({global_index.x(), global_index.y(), global_index.z()});
+        curr_indices.insert(global_index);
       }
     }
+  });
+
+  for (size_t i = 0; i < room_nodes.size(); ++i) {
+    indices[room_nodes[i]->id] = std::move(room_indices[i]);
   }
 }
 
-RoomMetrics RoomEvaluator::eval(const std::string& graph_filepath) const {
-  const auto graph = DynamicSceneGraph::load(graph_filepath);
+RoomMetrics RoomEvaluator::eval(const std::string& graph_filepath,
+                                int num_threads) const {
+  const auto graph = loadGraph(graph_filepath);
+  if (!graph) {
+    LOG(ERROR) << "Unable to load graph from: " << graph_filepath;
+    return {};
+  }
+
   if (!graph->hasLayer(DsgLayers::ROOMS)) {
     LOG(ERROR) << "Graph file: " << graph_filepath << " does not have rooms";
     return {};
   }
 
   RoomIndices est_indices;
-  computeDsgIndices(*graph, est_indices);
+  computeDsgIndices(*graph, est_indices, num_threads);
   return scoreRooms(room_indices_, est_indices);
 }
 
+std::vector<RoomMetrics> RoomEvaluator::eval(
+    const std::vector<std::string>& graph_filepaths) const {
+  std::vector<RoomMetrics> results(graph_filepaths.size());
+  if (graph_filepaths.size() == 1) {
+    // nothing to batch, so process the rooms of the single graph in parallel instead
+    results[0] = eval(graph_filepaths[0], config.num_threads);
+    return results;
+  }
+
+  parallelFor(graph_filepaths.size(), config.num_threads, [&](size_t i, size_t) {
+    results[i] = eval(graph_filepaths[i]);
+  });
+  return results;
+}
+
 GlobalIndices RoomEvaluator::getSphereAroundPoint(const TsdfLayer& layer,
                                                   const Point& center,
                                                   float radius) {
@@ -46,20 +46,31 @@ Eigen::MatrixXd computeOverlap(const RoomIndices& gt_rooms,
                                const RoomIndices& est_rooms) {
   Eigen::MatrixXd overlaps = Eigen::MatrixXd::Zero(gt_rooms.size(), est_rooms.size());
 
+  // invert the ground truth so every estimated index is a single hash lookup
+  GlobalIndexMap<std::vector<size_t>> gt_lookup;
   size_t gt_idx = 0;
   for (const auto& gt_room_pair : gt_rooms) {
-    size_t est_idx = 0;
-    for (const auto& est_room_pair : est_rooms) {
-      for (const auto& index : est_room_pair.second) {
-        if (gt_room_pair.second.count(index)) {
-          overlaps(gt_idx, est_idx) += 1.0;
-        }
+    for (const auto& index : gt_room_pair.second) {
+      gt_lookup[index].push_back(gt_idx);
+    }
+
+    ++gt_idx;
+  }
+
+  size_t est_idx = 0;
+  for (const auto& est_room_pair : est_rooms) {
+    for (const auto& index : est_room_pair.second) {
+      const auto iter = gt_lookup.find(index);
+      if (iter == gt_lookup.end()) {
+        continue;
       }
 
-      ++est_idx;
+      for (const auto row : iter->second) {
+        overlaps(row, est_idx) += 1.0;
+      }
     }
 
-    ++gt_idx;
+    ++est_idx;
   }
 
   return overlaps;
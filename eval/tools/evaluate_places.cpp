@@ -35,19 +35,39 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include <iostream>
+#include <sstream>
+
 #include "hydra/eval/place_evaluator.h"
 
 DEFINE_double(max_distance_m, 4.5, "max distance");
 DEFINE_string(tsdf_file, "", "tsdf file to read");
-DEFINE_string(dsg_file, "", "dsg file to read");
+DEFINE_string(dsg_file, "", "dsg file(s) to read (comma separated)");
 DEFINE_string(gvd_config, "", "gvd integrator config");
+DEFINE_int32(num_threads,
+             0,
+             "number of threads to use (defaults to hydra's default_num_threads)");
+
+std::vector<std::string> splitPaths(const std::string& paths) {
+  std::vector<std::string> result;
+  std::stringstream ss(paths);
+  std::string path;
+  while (std::getline(ss, path, ',')) {
+    if (!path.empty()) {
+      result.push_back(path);
+    }
+  }
+  return result;
+}
 
 int main(int argc, char* argv[]) {
   FLAGS_minloglevel = 3;
   FLAGS_logtostderr = 1;
   FLAGS_colorlogtostderr = 1;
 
-  google::SetUsageMessage("utility for comparing places graph to TSDF");
+  google::SetUsageMessage(
+      "utility for comparing places graph to TSDF\n"
+      "usage: evaluate_places [flags] [dsg_file ...]");
   google::ParseCommandLineFlags(&argc, &argv, true);
   google::InitGoogleLogging(argv[0]);
 
@@ -59,19 +79,34 @@ int main(int argc, char* argv[]) {
     LOG(FATAL) << "GVD config is required!";
   }
 
-  if (FLAGS_dsg_file == "") {
+  auto dsg_files = splitPaths(FLAGS_dsg_file);
+  for (int i = 1; i < argc; ++i) {
+    dsg_files.push_back(argv[i]);
+  }
+
+  if (dsg_files.empty()) {
     LOG(FATAL) << "DSG file is required!";
   }
 
-  auto evaluator =
-      hydra::eval::PlaceEvaluator::fromFile(FLAGS_gvd_config, FLAGS_tsdf_file);
+  const auto& global_config = hydra::GlobalInfo::instance().getConfig();
+  const int num_threads =
+      FLAGS_num_threads > 0 ? FLAGS_num_threads : global_config.default_num_threads;
+  auto evaluator = hydra::eval::PlaceEvaluator::fromFile(
+      FLAGS_gvd_config, FLAGS_tsdf_file, std::nullopt, num_threads);
   if (!evaluator) {
     LOG(FATAL) << "Unable to construct place evaluator.";
   }
 
-  const auto metrics = evaluator->eval(FLAGS_dsg_file);
-  if (!metrics.is_valid) {
-    LOG(FATAL) << "Unable to evaluate invalid graph!";
+  const auto results = evaluator->eval(dsg_files, num_threads);
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& metrics = results[i];
+    if (!metrics.is_valid) {
+      LOG(FATAL) << "Unable to evaluate invalid graph: " << dsg_files[i];
+    }
+
+    std::cout << dsg_files[i] << ": valid=" << metrics.num_valid
+              << ", missing=" << metrics.num_missing
+              << ", unobserved=" << metrics.num_unobserved << std::endl;
   }
 
   return 0;
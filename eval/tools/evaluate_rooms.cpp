@@ -36,24 +36,43 @@
 #include <glog/logging.h>
 
 #include <filesystem>
+#include <iostream>
+#include <sstream>
 
 #include "hydra/common/common.h"
 #include "hydra/eval/room_evaluator.h"
 
 DEFINE_string(tsdf_file, "", "tsdf file to read");
 DEFINE_string(bbox_file, "", "bounding box config file");
-DEFINE_string(dsg_file, "", "dsg file to read");
+DEFINE_string(dsg_file, "", "dsg file(s) to read (comma separated)");
 DEFINE_int32(min_room_nodes, 0, "minimum number of room nodes for evaluation");
 DEFINE_bool(only_labeled, true, "only compute metrics for labeled voxels");
+DEFINE_int32(num_threads,
+             0,
+             "number of threads to use (defaults to hydra's default_num_threads)");
 
 using namespace spark_dsg;
 
+std::vector<std::string> splitPaths(const std::string& paths) {
+  std::vector<std::string> result;
+  std::stringstream ss(paths);
+  std::string path;
+  while (std::getline(ss, path, ',')) {
+    if (!path.empty()) {
+      result.push_back(path);
+    }
+  }
+  return result;
+}
+
 int main(int argc, char* argv[]) {
   FLAGS_minloglevel = 0;
   FLAGS_logtostderr = 1;
   FLAGS_colorlogtostderr = 1;
 
-  google::SetUsageMessage("utility for comparing visualizing room bounding boxes");
+  google::SetUsageMessage(
+      "utility for comparing visualizing room bounding boxes\n"
+      "usage: evaluate_rooms [flags] [dsg_file ...]");
   google::ParseCommandLineFlags(&argc, &argv, true);
   google::InitGoogleLogging(argv[0]);
 
@@ -69,27 +88,53 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
-  std::filesystem::path dsg_path(FLAGS_dsg_file);
-  if (!std::filesystem::exists(dsg_path)) {
+  auto dsg_files = splitPaths(FLAGS_dsg_file);
+  for (int i = 1; i < argc; ++i) {
+    dsg_files.push_back(argv[i]);
+  }
+
+  if (dsg_files.empty()) {
     LOG(ERROR) << "DSG file is required!";
     return 1;
   }
 
+  for (const auto& dsg_file : dsg_files) {
+    if (!std::filesystem::exists(dsg_file)) {
+      LOG(ERROR) << "DSG file '" << dsg_file << "' does not exist!";
+      return 1;
+    }
+  }
+
   hydra::eval::RoomEvaluator::Config config;
   config.only_labeled = FLAGS_only_labeled;
   config.min_room_nodes = FLAGS_min_room_nodes;
+  if (FLAGS_num_threads > 0) {
+    config.num_threads = FLAGS_num_threads;
+  }
   auto evaluator = hydra::eval::RoomEvaluator::fromFile(config, bbox_path, tsdf_path);
   if (!evaluator) {
     LOG(ERROR) << "Unable to construct room evaluator.";
     return 1;
   }
 
-  const auto metrics = evaluator->eval(dsg_path);
-  if (!metrics.valid()) {
-    LOG(ERROR) << "Unable to evaluate invalid graph!";
-    return 1;
+  const auto results = evaluator->eval(dsg_files);
+  for (size_t i = 0; i < results.size(); ++i) {
+    if (!results[i].valid()) {
+      LOG(ERROR) << "Unable to evaluate invalid graph: " << dsg_files[i];
+      return 1;
+    }
   }
 
-  std::cout << metrics << std::endl;
+  if (results.size() == 1) {
+    std::cout << results.front() << std::endl;
+    return 0;
+  }
+
+  // one json object per graph, keyed by path, in the order the graphs were given
+  std::cout << "{";
+  for (size_t i = 0; i < results.size(); ++i) {
+    std::cout << (i ? ",\n" : "\n") << "\"" << dsg_files[i] << "\": " << results[i];
+  }
+  std::cout << "\n}" << std::endl;
   return 0;
 }
@@ -40,6 +40,7 @@
 #include <gtsam/sam/RangeFactor.h>
 #include <gtsam/slam/BoundingConstraint.h>
 #include <gtsam/slam/dataset.h>
+#include <hydra/utils/graph_checkpoint.h>
 #include <kimera_pgmo/deformation_graph.h>
 #include <spark_dsg/dynamic_scene_graph.h>
 #include <yaml-cpp/yaml.h>
@@ -149,10 +150,8 @@ void add_height(gtsam::NonlinearFactorGraph& factors,
 }
 
 std::vector<size_t> read_timestamps(const std::string& filepath) {
-  DynamicSceneGraph graph;
-  graph.load(filepath);
-
-  const auto& agents = graph.getLayer(DsgLayers::AGENTS, 'a');
+  const auto graph = hydra::loadGraph(filepath);
+  const auto& agents = graph->getLayer(DsgLayers::AGENTS, 'a');
 
   std::vector<size_t> times_ns;
   for (const auto& node : agents.nodes()) {
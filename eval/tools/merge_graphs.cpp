@@ -37,6 +37,7 @@
 #include <iostream>
 
 #include "hydra/eval/graph_utilities.h"
+#include "hydra/utils/graph_checkpoint.h"
 
 int main(int argc, char* argv[]) {
   if (argc < 2) {
@@ -49,7 +50,7 @@ int main(int argc, char* argv[]) {
   for (int i = 2; i < argc; ++i) {
     const std::string filename(argv[i]);
     std::cout << "Merging " << filename << std::endl;
-    input_graphs.push_back(spark_dsg::DynamicSceneGraph::load(filename));
+    input_graphs.push_back(hydra::loadGraph(filename));
   }
 
   const std::string output_path(argv[1]);
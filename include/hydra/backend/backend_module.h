@@ -37,13 +37,19 @@
 #include <kimera_pgmo/kimera_pgmo_interface.h>
 #include <spark_dsg/scene_graph_logger.h>
 
+#include <array>
+#include <condition_variable>
+#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
 
+#include "hydra/backend/incremental_solver.h"
 #include "hydra/backend/merge_tracker.h"
+#include "hydra/backend/mesh_deformation.h"
 #include "hydra/backend/pgmo_configs.h"
+#include "hydra/backend/place_deformation_graph.h"
 #include "hydra/backend/update_frontiers_functor.h"
 #include "hydra/backend/update_surface_places_functor.h"
 #include "hydra/common/common.h"
@@ -52,6 +58,8 @@
 #include "hydra/common/shared_dsg_info.h"
 #include "hydra/common/shared_module_state.h"
 #include "hydra/rooms/room_finder_config.h"
+#include "hydra/utils/graph_checkpoint.h"
+#include "hydra/utils/graph_stream.h"
 #include "hydra/utils/log_utilities.h"
 
 namespace spark_dsg {
@@ -87,6 +95,16 @@ class BackendModule : public kimera_pgmo::KimeraPgmoInterface, public Module {
     // dsg
     bool add_places_to_deformation_graph = true;
     bool optimize_on_lc = true;
+    //! Run optimization in a background thread instead of on every input
+    bool async_optimization = false;
+    //! Solve with an incremental solver between loop closures instead of re-solving
+    bool incremental_optimization = false;
+    IncrementalSolver::Config incremental_solver;
+    //! Deform the mesh with the cached, multi-threaded deformer instead of PGMO
+    bool parallel_mesh_deformation = false;
+    MeshDeformer::Config mesh_deformation;
+    //! Call update functors that touch disjoint layers concurrently
+    bool concurrent_layer_updates = false;
     bool enable_node_merging = true;
     bool use_mesh_subscribers = false;
     mutable std::map<LayerId, bool> merge_update_map{{DsgLayers::OBJECTS, false},
@@ -97,6 +115,8 @@ class BackendModule : public kimera_pgmo::KimeraPgmoInterface, public Module {
     double places_merge_pos_threshold_m = 0.4;
     double places_merge_distance_tolerance_m = 0.3;
     bool enable_merge_undos = false;
+    //! Drop merge records of nodes removed from the unmerged graph every N updates
+    size_t merge_compaction_period = 50;
     bool use_active_flag_for_updates = true;
     size_t num_neighbors_to_find_for_merge = 1;
     std::string zmq_send_url = "tcp://127.0.0.1:8001";
@@ -105,6 +125,10 @@ class BackendModule : public kimera_pgmo::KimeraPgmoInterface, public Module {
     size_t zmq_num_threads = 2;
     size_t zmq_poll_time_ms = 10;
     bool zmq_send_mesh = true;
+    //! Send delta-encoded updates instead of the full graph (requires delta receivers)
+    bool zmq_send_deltas = false;
+    std::string zmq_resync_url = "tcp://127.0.0.1:8003";
+    GraphDeltaEncoder::Config zmq_delta_encoder;
     bool use_2d_places = false;
     Update2dPlacesFunctor::Config places2d_config;
     UpdateFrontiersFunctor::Config frontier_config;
@@ -148,6 +172,8 @@ class BackendModule : public kimera_pgmo::KimeraPgmoInterface, public Module {
  protected:
   void setSolverParams();
 
+  void resetMeshDeformer();
+
   void addLoopClosure(const gtsam::Key& src,
                       const gtsam::Key& dest,
                       const gtsam::Pose3& src_T_dest,
@@ -163,12 +189,39 @@ class BackendModule : public kimera_pgmo::KimeraPgmoInterface, public Module {
 
   virtual bool updatePrivateDsg(size_t timestamp_ns, bool force_update = true);
 
+  void trackGraphChanges();
+
   virtual void addPlacesToDeformationGraph(size_t timestamp_ns);
 
+  void rebuildPlaceStructures(size_t timestamp_ns);
+
   virtual void updateAgentNodeMeasurements(const pose_graph_tools::PoseGraph& meas);
 
   virtual void optimize(size_t timestamp_ns);
 
+  virtual void optimizeAsync(size_t timestamp_ns);
+
+  void launchOptimization(size_t timestamp_ns);
+
+  void runOptimizer();
+
+  void stopOptimizer();
+
+  bool optimizerBusy() const;
+
+  void waitForOptimizer() const;
+
+  void callSinks(size_t timestamp_ns);
+
+  void applyPendingInputs();
+
+  void solve(size_t timestamp_ns,
+             bool new_loop_closure,
+             gtsam::Values& places_values,
+             gtsam::Values& pgmo_values);
+
+  gtsam::Values getOptimizedValues() const;
+
   virtual void updateDsgMesh(size_t timestamp_ns, bool force_mesh_update = false);
 
   virtual void resetBackendDsg(size_t timestamp_ns);
@@ -196,6 +249,7 @@ class BackendModule : public kimera_pgmo::KimeraPgmoInterface, public Module {
   std::atomic<bool> should_shutdown_{false};
   bool have_loopclosures_{false};
   bool have_new_loopclosures_{false};
+  bool have_new_factors_{false};
   bool have_new_mesh_{false};
   size_t prev_num_archived_vertices_{0};
   size_t num_archived_vertices_{0};
@@ -210,6 +264,7 @@ class BackendModule : public kimera_pgmo::KimeraPgmoInterface, public Module {
   std::vector<uint64_t> vertex_stamps_;
 
   MergeTracker merge_tracker;
+  size_t num_updates_since_compaction_ = 0;
   std::map<LayerId, UpdateFunctor::Ptr> layer_functors_;
   UpdateFunctor::Ptr agent_functor_;
 
@@ -228,10 +283,55 @@ class BackendModule : public kimera_pgmo::KimeraPgmoInterface, public Module {
   std::unique_ptr<std::thread> zmq_thread_;
   std::unique_ptr<spark_dsg::ZmqReceiver> zmq_receiver_;
   std::unique_ptr<spark_dsg::ZmqSender> zmq_sender_;
+  std::unique_ptr<GraphStreamPublisher> zmq_publisher_;
+  GraphCheckpointWriter checkpoint_writer_;
 
   // TODO(lschmid): This mutex currently simply locks all data for manipulation.
   std::mutex mutex_;
 
+  //! Solution computed by the background optimizer
+  struct OptimizationResult {
+    size_t timestamp_ns = 0;
+    gtsam::Values places_values;
+    gtsam::Values pgmo_values;
+    bool new_loop_closure = false;
+  };
+
+  // The optimizer thread owns the deformation graph while busy. Inputs that arrive in
+  // the meantime have their factors (and vertex recalculation requests) deferred until
+  // it is idle again, and results are double-buffered: the optimizer writes the back
+  // buffer while updates read the front buffer. Solves are launched at the end of an
+  // input, and sinks wait for a solve that is still running at the end of the next.
+  std::unique_ptr<std::thread> optimizer_thread_;
+  mutable std::mutex optimizer_mutex_;
+  mutable std::condition_variable optimizer_cv_;
+  bool optimizer_busy_{false};
+  bool stop_optimizer_{false};
+  size_t optimization_stamp_ns_{0};
+  size_t last_timestamp_ns_{0};
+  bool optimization_new_loop_closure_{false};
+  std::array<OptimizationResult, 2> results_;
+  size_t front_result_{0};
+  bool have_result_{false};
+  bool fresh_result_{false};
+  std::list<BackendInput> pending_inputs_;
+  bool pending_recalculate_vertices_{false};
+
+  // Only used with incremental optimization: between loop closures only the difference
+  // between the deformation graph and the solver is optimized.
+  std::unique_ptr<IncrementalSolver> incremental_solver_;
+
+  // Places are added to the deformation graph by diff. The incremental solver uses the
+  // place factors directly, and the temporary structures of the deformation graph are
+  // only rebuilt from them (when stale) before batch solves.
+  std::unique_ptr<PlaceDeformationGraph> place_graph_;
+  bool place_structures_stale_{false};
+  //! Active windows of the unmerged graph shared by the update functors
+  ActiveWindows active_windows_;
+
+  //! Only used with parallel mesh deformation
+  std::unique_ptr<MeshDeformer> mesh_deformer_;
+
   inline static const auto registration_ =
       config::RegistrationWithConfig<BackendModule,
                                      BackendModule,
@@ -0,0 +1,140 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <gtsam/nonlinear/ISAM2.h>
+#include <gtsam/nonlinear/NonlinearFactorGraph.h>
+#include <gtsam/nonlinear/Values.h>
+
+#include <memory>
+#include <unordered_map>
+
+namespace hydra {
+
+/**
+ * @brief iSAM2 wrapper that tracks the deformation graph between batch solves
+ *
+ * The solver is seeded from a batch (robust) solution and afterwards is only handed
+ * the factors and values that changed since the previous update. Factors are matched
+ * by identity first and by keys and measurement second, so temporary structures that
+ * are rebuilt with the same contents are not re-added.
+ */
+class IncrementalSolver {
+ public:
+  struct Config {
+    //! Minimum variable update before the variable is relinearized
+    double relinearize_threshold = 0.01;
+    //! Number of updates between relinearization checks
+    size_t relinearize_skip = 1;
+    //! Fraction of changed factors above which a batch solve is requested instead
+    double batch_threshold = 0.25;
+    //! Batch (GNC) weight below which a factor is treated as an outlier
+    double inlier_weight_threshold = 0.5;
+    //! Variance of the prior holding variables that lost all of their factors
+    double anchor_variance = 1.0e2;
+  } const config;
+
+  explicit IncrementalSolver(const Config& config);
+
+  /**
+   * @brief Re-seed the solver from a batch solution
+   * @param factors Permanent factors of the deformation graph
+   * @param values Optimized values for the permanent factors
+   * @param temp_factors Temporary (place) factors of the deformation graph
+   * @param temp_values Optimized values for the temporary factors
+   * @param weights Optional per-factor weights for the permanent factors
+   */
+  void reset(const gtsam::NonlinearFactorGraph& factors,
+             const gtsam::Values& values,
+             const gtsam::NonlinearFactorGraph& temp_factors,
+             const gtsam::Values& temp_values,
+             const gtsam::Vector& weights = gtsam::Vector());
+
+  /**
+   * @brief Add the difference between the current and tracked factors to the solver
+   * @returns false if the solver is not seeded or the change is large enough that a
+   * batch solve should be run instead (the solver state is untouched in that case)
+   */
+  bool update(const gtsam::NonlinearFactorGraph& factors,
+              const gtsam::Values& values,
+              const gtsam::NonlinearFactorGraph& temp_factors,
+              const gtsam::Values& temp_values);
+
+  void invalidate();
+
+  inline bool initialized() const { return initialized_; }
+
+  inline size_t numFactors() const { return factors_.size(); }
+
+  inline size_t numLastChanged() const { return num_last_changed_; }
+
+  inline const gtsam::Values& values() const { return values_; }
+
+  inline const gtsam::Values& tempValues() const { return temp_values_; }
+
+ private:
+  using FactorPtr = gtsam::NonlinearFactor::shared_ptr;
+
+  struct TrackedFactor {
+    FactorPtr factor;
+    size_t index;
+  };
+
+  void addKeyCounts(const gtsam::NonlinearFactor& factor, bool add);
+
+  void updateAnchors(const gtsam::KeyVector& keys,
+                     gtsam::NonlinearFactorGraph& new_factors,
+                     gtsam::FactorIndices& removed,
+                     std::vector<gtsam::Key>& new_anchors);
+
+  void updateEstimate(const gtsam::Values& values, const gtsam::Values& temp_values);
+
+  bool initialized_ = false;
+  size_t num_last_changed_ = 0;
+  std::unique_ptr<gtsam::ISAM2> isam_;
+  //! Factors currently in the solver indexed by address
+  std::unordered_map<const gtsam::NonlinearFactor*, TrackedFactor> factors_;
+  //! Factors rejected by the last batch solve
+  std::unordered_map<const gtsam::NonlinearFactor*, FactorPtr> rejected_;
+  //! Number of tracked factors touching each variable (anchors excluded)
+  std::unordered_map<gtsam::Key, size_t> key_counts_;
+  //! Solver index of the prior holding each orphaned variable
+  std::unordered_map<gtsam::Key, size_t> anchors_;
+  gtsam::Values values_;
+  gtsam::Values temp_values_;
+};
+
+void declare_config(IncrementalSolver::Config& config);
+
+}  // namespace hydra
@@ -33,22 +33,96 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include "hydra/backend/update_functions.h"
 
 namespace hydra {
 
+/**
+ * @brief Union-find over merged nodes
+ *
+ * Every set is rooted at its representative (the node that survives the merge).
+ * Lookups use path compression, so repeated lookups are O(1). Changes are pushed to a
+ * flattened node -> representative map (as used by DynamicSceneGraph::mergeGraph)
+ * lazily, touching only sets that changed since the last export.
+ */
+class MergeRegistry {
+ public:
+  //! Representative of the node (the node itself if it was never merged)
+  NodeId find(NodeId node) const;
+
+  //! Whether the node was merged into a different node
+  inline bool merged(NodeId node) const { return parents_.count(node); }
+
+  /**
+   * @brief Record that the set containing from was merged into the set containing to
+   * @returns False if both nodes already share a representative
+   */
+  bool merge(NodeId from, NodeId to);
+
+  //! Nodes merged into a representative
+  const std::vector<NodeId>& members(NodeId representative) const;
+
+  /**
+   * @brief Detach a merged node so that it becomes its own representative again
+   * @returns False if the node was not merged into another node
+   */
+  bool undo(NodeId node);
+
+  /**
+   * @brief Forget merged nodes that are no longer needed
+   * @param keep Whether a merged node is still needed (e.g., still in the graph)
+   * @returns Number of forgotten nodes
+   */
+  size_t compact(const std::function<bool(NodeId)>& keep);
+
+  //! Bring a flattened node -> representative map up to date
+  void exportMerges(std::map<NodeId, NodeId>& merges);
+
+  //! Number of merged (non-representative) nodes
+  inline size_t size() const { return parents_.size(); }
+
+  void clear();
+
+ private:
+  void flatten(NodeId representative);
+
+  mutable std::unordered_map<NodeId, NodeId> parents_;
+  std::unordered_map<NodeId, std::vector<NodeId>> members_;
+  std::unordered_set<NodeId> changed_sets_;
+  std::unordered_set<NodeId> removed_;
+};
+
 struct MergeTracker {
   void applyMerges(const DynamicSceneGraph& unmerged,
                    const MergeList& proposals,
                    SharedDsgInfo& dsg,
                    const MergeFunc& merge_attrs = MergeFunc());
 
+  /**
+   * @brief Undo a previous merge
+   *
+   * The node is dropped from the recorded merges, so that the next graph merge adds it
+   * back from the unmerged graph.
+   */
+  bool undoMerge(NodeId node, SharedDsgInfo& dsg);
+
+  /**
+   * @brief Drop merge records for nodes that are no longer in the unmerged graph
+   * @returns Number of dropped records
+   */
+  size_t compact(const DynamicSceneGraph& unmerged, SharedDsgInfo& dsg);
+
   void clear();
 
- private:
-  void updateParents(std::map<NodeId, NodeId>& prior_merges, const Merge& merge);
+  inline const MergeRegistry& registry() const { return registry_; }
 
-  std::map<NodeId, std::set<NodeId>> merge_sets_;
+ private:
+  MergeRegistry registry_;
 };
 
 }  // namespace hydra
@@ -0,0 +1,144 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <gtsam/geometry/Pose3.h>
+#include <gtsam/inference/Key.h>
+#include <gtsam/nonlinear/Values.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <spark_dsg/mesh.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "hydra/common/global_info.h"
+
+namespace hydra {
+
+/**
+ * @brief Embedded deformation of mesh vertices by the deformation graph control points
+ *
+ * Each vertex is deformed by its num_interp_pts nearest control points observed within
+ * interp_horizon of the vertex. Control point neighborhoods and weights are cached
+ * per vertex and are only recomputed while new control points can still fall inside
+ * the vertex's time window. Vertices whose control points did not move since the
+ * last deformation are skipped, and the remaining vertices are deformed in parallel
+ * chunks.
+ */
+class MeshDeformer {
+ public:
+  struct Config {
+    //! Number of threads used to deform vertices
+    int num_threads = GlobalInfo::instance().getConfig().default_num_threads;
+    //! Number of vertices handed to a thread at a time
+    size_t chunk_size = 2048;
+    //! Control point translation [m] below which dependent vertices are not updated
+    double min_control_translation = 1.0e-4;
+    //! Control point rotation [rad] below which dependent vertices are not updated
+    double min_control_rotation = 1.0e-4;
+  } const config;
+
+  MeshDeformer(const Config& config, size_t num_interp_pts, double interp_horizon_s);
+
+  /**
+   * @brief Register a control point with its initial position
+   * @returns false if the control point is already known
+   */
+  bool addControlPoint(gtsam::Key key, uint64_t stamp_ns, const Eigen::Vector3d& pos);
+
+  /**
+   * @brief Deform the mesh vertices from their original positions
+   * @param vertices Original (undeformed) vertex positions
+   * @param stamps Vertex timestamps
+   * @param values Optimized control point poses
+   * @param num_archived Number of archived vertices (only these are cached)
+   * @param mesh Mesh to write deformed vertex positions to
+   */
+  void deform(const pcl::PointCloud<pcl::PointXYZ>& vertices,
+              const std::vector<uint64_t>& stamps,
+              const gtsam::Values& values,
+              size_t num_archived,
+              spark_dsg::Mesh& mesh);
+
+  //! Recompute neighborhoods for and redeform every vertex on the next call
+  void invalidate();
+
+  inline size_t numControlPoints() const { return controls_.size(); }
+
+  inline size_t numLastDeformed() const { return num_last_deformed_; }
+
+ private:
+  struct ControlPoint {
+    gtsam::Key key;
+    uint64_t stamp_ns;
+    Eigen::Vector3d position;
+  };
+
+  void updateAppliedPoses(const gtsam::Values& values);
+
+  void updateNeighbors(size_t index,
+                       const Eigen::Vector3d& pos,
+                       uint64_t stamp_ns,
+                       bool archived,
+                       std::vector<std::pair<double, size_t>>& candidates);
+
+  Eigen::Vector3f deformVertex(size_t index, const Eigen::Vector3d& pos) const;
+
+  const size_t num_interp_pts_;
+  const uint64_t interp_horizon_ns_;
+  size_t num_last_deformed_ = 0;
+  bool invalidated_ = false;
+
+  std::vector<ControlPoint> controls_;
+  std::unordered_map<gtsam::Key, size_t> control_lookup_;
+  //! Control point indices sorted by timestamp
+  std::vector<size_t> by_stamp_;
+  uint64_t max_control_stamp_ns_ = 0;
+
+  //! Control point poses last applied to dependent vertices
+  std::vector<gtsam::Pose3> applied_poses_;
+  //! Whether each control point moved enough to redeform dependent vertices
+  std::vector<uint8_t> moved_;
+
+  // flat per-vertex cache: num_interp_pts_ slots per vertex
+  std::vector<uint8_t> vertex_final_;
+  std::vector<uint8_t> num_neighbors_;
+  std::vector<size_t> neighbors_;
+  std::vector<double> weights_;
+};
+
+void declare_config(MeshDeformer::Config& config);
+
+}  // namespace hydra
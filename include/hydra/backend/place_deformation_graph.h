@@ -0,0 +1,134 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <gtsam/linear/NoiseModel.h>
+#include <gtsam/nonlinear/NonlinearFactorGraph.h>
+#include <gtsam/nonlinear/Values.h>
+
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "hydra/common/dsg_types.h"
+#include "hydra/utils/minimum_spanning_tree.h"
+
+namespace hydra {
+
+/**
+ * @brief Place structures of the deformation graph, updated by diff
+ *
+ * Only places that were added or removed (or are still active) are looked at on each
+ * update. Places with siblings are connected by a minimum spanning forest over the
+ * place edges, and forest leaves are attached to the mesh vertices they are connected
+ * to. Factors are only rebuilt for places and forest edges that changed, so the
+ * factor graph can be handed to an incremental solver as is.
+ */
+class PlaceDeformationGraph {
+ public:
+  struct Place {
+    Eigen::Vector3d position;
+    //! Valid deformation graph vertex indices the place is connected to
+    std::vector<size_t> connections;
+    //! Whether the place is a forest leaf with valence factors
+    bool leaf = false;
+    std::vector<size_t> valence_slots;
+  };
+
+  PlaceDeformationGraph(char vertex_prefix, double mesh_variance, double edge_variance);
+
+  //! Register the initial position of a deformation graph vertex
+  void addVertex(size_t index, const Eigen::Vector3d& pos);
+
+  //! Mark a place (or the endpoint of a place edge) as added or changed
+  void markChanged(NodeId node);
+
+  //! Mark a node as removed (ignored if the node is not a tracked place)
+  void markRemoved(NodeId node);
+
+  /**
+   * @brief Apply changed places and check the active places for changes
+   * @returns true if the factors changed
+   */
+  bool update(const SceneGraphLayer& places);
+
+  inline const std::unordered_map<NodeId, Place>& places() const { return places_; }
+
+  inline const IncrementalSpanningForest& forest() const { return forest_; }
+
+  //! Place factors (removed factors leave empty slots)
+  inline const gtsam::NonlinearFactorGraph& factors() const { return factors_; }
+
+  //! Initial values of places in the forest
+  inline const gtsam::Values& values() const { return values_; }
+
+ private:
+  using Edge = IncrementalSpanningForest::Edge;
+
+  void updatePlace(const SceneGraphNode& node, bool& moved, bool& reconnected);
+
+  void updateEdges(const SceneGraphNode& node);
+
+  void updateFactors(NodeId node, bool refresh);
+
+  void updateEdgeFactor(const Edge& edge);
+
+  size_t addFactor(const gtsam::NonlinearFactor::shared_ptr& factor);
+
+  void removeFactor(size_t slot);
+
+  const char vertex_prefix_;
+  const gtsam::SharedNoiseModel mesh_noise_;
+  const gtsam::SharedNoiseModel edge_noise_;
+  bool modified_ = false;
+
+  std::unordered_map<NodeId, Place> places_;
+  std::unordered_set<NodeId> pending_;
+  std::unordered_set<NodeId> active_;
+  //! Places whose factors have to be rebuilt even if the place did not change
+  std::unordered_set<NodeId> refresh_;
+  IncrementalSpanningForest forest_;
+
+  std::unordered_map<size_t, Eigen::Vector3d> vertices_;
+  //! Leaves waiting on vertices that have not been received yet
+  std::unordered_map<size_t, std::unordered_set<NodeId>> waiting_;
+
+  gtsam::NonlinearFactorGraph factors_;
+  std::vector<size_t> free_slots_;
+  std::map<Edge, size_t> edge_slots_;
+  gtsam::Values values_;
+};
+
+}  // namespace hydra
@@ -35,14 +35,67 @@
 #pragma once
 #include <glog/logging.h>
 
+#include <unordered_map>
+#include <vector>
+
 #include "hydra/common/dsg_types.h"
 #include "hydra/frontend/place_2d_split_logic.h"
 
 namespace hydra::utils {
 
+//! Axis-aligned bounds of the interior {x : (x - c)^T A (x - c) < 1} of an ellipse
+struct EllipseBounds {
+  //! Get bounds of the ellipse (unbounded if A is not positive definite)
+  static EllipseBounds fromQuadric(const Eigen::Matrix2d& A, const Eigen::Vector2d& c);
+
+  bool intersects(const EllipseBounds& other) const;
+
+  bool bounded = false;
+  Eigen::Vector2d min = Eigen::Vector2d::Zero();
+  Eigen::Vector2d max = Eigen::Vector2d::Zero();
+};
+
+/**
+ * @brief Uniform 2D grid over ellipse bounds to find candidate place connections.
+ *
+ * The transverse overlap between two ellipses is only positive if they share an
+ * interior point, so only ellipses with intersecting bounds need to be checked.
+ * Unbounded ellipses are candidates for every query. Callers pass unbounded
+ * (default) bounds when the overlap threshold is negative, as disjoint ellipses can
+ * then still be connected.
+ */
+class EllipseGrid {
+ public:
+  explicit EllipseGrid(const std::vector<EllipseBounds>& bounds);
+
+  //! Get all indices j > i of ellipses whose bounds intersect ellipse i
+  void candidates(size_t i, std::vector<size_t>& result) const;
+
+  size_t size() const { return bounds_.size(); }
+
+ private:
+  using CellKey = uint64_t;
+
+  CellKey cellKey(int64_t x, int64_t y) const;
+  bool getCellRange(const EllipseBounds& bounds,
+                    Eigen::Matrix<int64_t, 2, 1>& lower,
+                    Eigen::Matrix<int64_t, 2, 1>& upper) const;
+
+  double cell_size_;
+  std::vector<EllipseBounds> bounds_;
+  std::vector<size_t> unbounded_;
+  std::unordered_map<CellKey, std::vector<size_t>> cells_;
+};
+
+//! Edge weights between split places, keyed by index pair into the flattened places
+using PlaceEdgeMap = std::unordered_map<uint64_t, double>;
+
+inline uint64_t placePairKey(size_t i, size_t j) {
+  return (static_cast<uint64_t>(i) << 32) | static_cast<uint32_t>(j);
+}
+
 void getPlace2dAndNeighors(const SceneGraphLayer& places_layer,
-                           std::vector<std::pair<NodeId, Place2d>>& place_2ds,
-                           std::map<NodeId, std::set<NodeId>>& node_neighbors);
+                           std::vector<std::pair<NodeId, Place2d>>& place_2ds);
 
 void getNecessaryUpdates(
     const spark_dsg::Mesh& mesh,
@@ -53,7 +106,7 @@ void getNecessaryUpdates(
     std::vector<std::pair<NodeId, Place2d>>& nodes_to_update,
     std::vector<std::pair<NodeId, std::vector<Place2d>>>& nodes_to_add);
 
-std::map<std::tuple<size_t, size_t, size_t, size_t>, double> buildEdgeMap(
+PlaceEdgeMap buildEdgeMap(
     const std::vector<std::pair<NodeId, std::vector<Place2d>>>& nodes_to_add,
     double place_overlap_threshold,
     double place_neighbor_z_diff);
@@ -67,13 +120,11 @@ NodeSymbol insertNewNodes(
     const double place_max_neighbor_z_diff,
     NodeSymbol next_node_symbol,
     DynamicSceneGraph& graph,
-    std::map<std::tuple<size_t, size_t>, NodeId>& new_id_map);
+    std::vector<NodeId>& new_ids);
 
-void addNewNodeEdges(
-    const std::vector<std::pair<NodeId, std::vector<Place2d>>> nodes_to_add,
-    const std::map<std::tuple<size_t, size_t, size_t, size_t>, double> edge_map,
-    const std::map<std::tuple<size_t, size_t>, NodeId> new_id_map,
-    DynamicSceneGraph& graph);
+void addNewNodeEdges(const PlaceEdgeMap& edge_map,
+                     const std::vector<NodeId>& new_ids,
+                     DynamicSceneGraph& graph);
 
 void reallocateMeshPoints(const std::vector<Place2d::PointT>& points,
                           Place2dNodeAttributes& attrs1,
@@ -38,6 +38,7 @@
 namespace hydra {
 
 struct UpdateAgentsFunctor : public UpdateFunctor {
+  LayerAccess access() const override;
   MergeList call(const DynamicSceneGraph&,
                  SharedDsgInfo& graph,
                  const UpdateInfo::ConstPtr& info) const override;
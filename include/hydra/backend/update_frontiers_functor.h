@@ -48,6 +48,7 @@ struct UpdateFrontiersFunctor : public UpdateFunctor {
 
   UpdateFrontiersFunctor(const Config& config) : config(config) {}
   Hooks hooks() const override;
+  LayerAccess access() const override;
   MergeList call(const DynamicSceneGraph& unmerged,
                  SharedDsgInfo&,
                  const UpdateInfo::ConstPtr&) const override;
@@ -35,8 +35,12 @@
 #pragma once
 #include <gtsam/nonlinear/Values.h>
 
+#include <set>
+#include <vector>
+
 #include "hydra/common/common.h"
 #include "hydra/common/shared_dsg_info.h"
+#include "hydra/utils/active_window_tracker.h"
 
 namespace hydra {
 
@@ -68,6 +72,8 @@ struct UpdateInfo {
   //! External merges (e.g., from GNC)
   LayerMerges given_merges;
   const gtsam::Values* complete_agent_values = nullptr;
+  //! Shared active windows of the unmerged graph (functors view every node if unset)
+  ActiveWindows* active_windows = nullptr;
 };
 
 using LayerUpdateFunc = std::function<MergeList(
@@ -77,6 +83,38 @@ using LayerCleanupFunc =
 using MergeFunc = std::function<NodeAttributes::Ptr(const DynamicSceneGraph&,
                                                     const std::vector<NodeId>&)>;
 
+/**
+ * @brief Layers that an update functor touches while being called
+ *
+ * Used to run functors that touch disjoint layers concurrently. Writes include any
+ * layer that the functor's proposed merges modify.
+ */
+struct LayerAccess {
+  std::set<LayerId> reads;
+  std::set<LayerId> writes;
+  //! Functor adds or removes nodes, which touches state shared by every layer
+  bool structural = false;
+  //! Functor may read and write any layer (i.e., access was not declared)
+  bool unknown = false;
+
+  //! Whether the functors must be called in their original order
+  bool conflictsWith(const LayerAccess& other) const;
+  //! Whether the functor can run at the same time as other functors
+  inline bool concurrent() const { return !structural && !unknown; }
+};
+
+/**
+ * @brief Group functors into stages that can be called one after another
+ *
+ * Functors within a stage either all run concurrently or the stage contains a single
+ * functor that has to run alone. Conflicting functors keep their relative order.
+ *
+ * @param accesses Declared access of each functor in call order
+ * @returns Indices of the functors in each stage
+ */
+std::vector<std::vector<size_t>> scheduleUpdateFunctors(
+    const std::vector<LayerAccess>& accesses);
+
 struct UpdateFunctor {
   using Ptr = std::shared_ptr<UpdateFunctor>;
 
@@ -88,6 +126,8 @@ struct UpdateFunctor {
 
   virtual ~UpdateFunctor() = default;
   virtual Hooks hooks() const;
+  //! Layers touched by call (defaults to unknown, i.e., always called alone)
+  virtual LayerAccess access() const;
   virtual MergeList call(const DynamicSceneGraph& unmerged,
                          SharedDsgInfo& dsg,
                          const UpdateInfo::ConstPtr& info) const = 0;
@@ -43,6 +43,7 @@ namespace hydra {
 struct UpdateObjectsFunctor : public UpdateFunctor {
   UpdateObjectsFunctor();
   Hooks hooks() const override;
+  LayerAccess access() const override;
   MergeList call(const DynamicSceneGraph& unmerged,
                  SharedDsgInfo& dsg,
                  const UpdateInfo::ConstPtr& info) const override;
@@ -50,6 +51,15 @@ struct UpdateObjectsFunctor : public UpdateFunctor {
   std::optional<NodeId> proposeMerge(const SceneGraphLayer& layer,
                                      const ObjectNodeAttributes& attrs) const;
 
+  //! Pick the first valid merge target out of the nearest neighbors of an object
+  std::optional<NodeId> selectMerge(const SceneGraphLayer& layer,
+                                    const ObjectNodeAttributes& attrs,
+                                    const std::vector<NodeId>& candidates) const;
+
+  //! Propose merges for every node with one batch query per semantic label
+  MergeList proposeMerges(const SceneGraphLayer& layer,
+                          const std::list<NodeId>& nodes) const;
+
   void mergeAttributes(const DynamicSceneGraph& layer, NodeId from, NodeId to) const;
 
   size_t num_merges_to_consider = 1;
@@ -42,6 +42,7 @@ namespace hydra {
 
 struct UpdatePlacesFunctor : public UpdateFunctor {
   UpdatePlacesFunctor(double pos_threshold, double distance_tolerance);
+  LayerAccess access() const override;
   MergeList call(const DynamicSceneGraph& unmerged,
                  SharedDsgInfo& dsg,
                  const UpdateInfo::ConstPtr& info) const override;
@@ -53,6 +54,15 @@ struct UpdatePlacesFunctor : public UpdateFunctor {
   std::optional<NodeId> proposeMerge(const SceneGraphLayer& layer,
                                      const SceneGraphNode& node) const;
 
+  //! Pick the first valid merge target out of the nearest neighbors of a node
+  std::optional<NodeId> selectMerge(const SceneGraphLayer& layer,
+                                    const SceneGraphNode& node,
+                                    const std::vector<NodeId>& candidates) const;
+
+  //! Propose merges for every node via a single batch neighbor query
+  MergeList proposeMerges(const SceneGraphLayer& layer,
+                          const std::vector<const SceneGraphNode*>& nodes) const;
+
   void filterMissing(DynamicSceneGraph& graph,
                      const std::list<NodeId> missing_nodes) const;
 
@@ -40,6 +40,7 @@ namespace hydra {
 
 struct UpdateRoomsFunctor : public UpdateFunctor {
   UpdateRoomsFunctor(const RoomFinderConfig& config);
+  LayerAccess access() const override;
   MergeList call(const DynamicSceneGraph& unmerged,
                  SharedDsgInfo& dsg,
                  const UpdateInfo::ConstPtr& info) const override;
@@ -51,6 +52,7 @@ struct UpdateRoomsFunctor : public UpdateFunctor {
 
 struct UpdateBuildingsFunctor : public UpdateFunctor {
   UpdateBuildingsFunctor(const Color& color, SemanticNodeAttributes::Label label);
+  LayerAccess access() const override;
   MergeList call(const DynamicSceneGraph& unmerged,
                  SharedDsgInfo& dsg,
                  const UpdateInfo::ConstPtr& info) const override;
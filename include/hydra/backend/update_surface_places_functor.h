@@ -58,6 +58,7 @@ struct Update2dPlacesFunctor : public UpdateFunctor {
 
   Update2dPlacesFunctor(const Config& config);
   Hooks hooks() const override;
+  LayerAccess access() const override;
   MergeList call(const DynamicSceneGraph& unmerged,
                  SharedDsgInfo& dsg,
                  const UpdateInfo::ConstPtr& info) const override;
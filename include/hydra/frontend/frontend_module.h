@@ -37,6 +37,7 @@
 #include <kimera_pgmo/hashing.h>
 #include <spark_dsg/scene_graph_logger.h>
 
+#include <map>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -53,6 +54,7 @@
 #include "hydra/frontend/surface_places_interface.h"
 #include "hydra/odometry/pose_graph_from_odom.h"
 #include "hydra/reconstruction/reconstruction_output.h"
+#include "hydra/utils/graph_checkpoint.h"
 #include "hydra/utils/log_utilities.h"
 
 namespace kimera_pgmo {
@@ -63,6 +65,8 @@ class MeshCompression;
 namespace hydra {
 
 class NearestNodeFinder;
+class PgmoMeshSnapshot;
+class PlaceMeshConnector;
 
 class FrontendModule : public Module {
  public:
@@ -153,6 +157,8 @@ class FrontendModule : public Module {
 
   void updatePlaceMeshMapping(const ReconstructionOutput& input);
 
+  void updateDeformationMapping(const kimera_pgmo::MeshDelta& delta);
+
  protected:
   using InputPtrCallback = std::function<void(const ReconstructionOutput::Ptr&)>;
 
@@ -169,6 +175,8 @@ class FrontendModule : public Module {
   SharedDsgInfo::Ptr dsg_;
   SharedModuleState::Ptr state_;
   kimera_pgmo::MeshDelta::Ptr last_mesh_update_;
+  std::shared_ptr<const PgmoMeshSnapshot> mesh_snapshot_;
+  GraphCheckpointWriter checkpoint_writer_;
 
   kimera_pgmo::Graph deformation_graph_;
   std::unique_ptr<kimera_pgmo::DeltaCompression> mesh_compression_;
@@ -181,6 +189,9 @@ class FrontendModule : public Module {
   std::unique_ptr<SurfacePlacesInterface> surface_places_;
   std::unique_ptr<FreespacePlacesInterface> freespace_places_;
   std::unique_ptr<FrontierPlacesInterface> frontier_places_;
+  std::unique_ptr<PlaceMeshConnector> place_mesh_connector_;
+  //! Deformation graph vertex of active mesh vertices (by mesh index)
+  std::map<size_t, size_t> vertex_deformation_;
 
   SceneGraphLogger frontend_graph_logger_;
   LogSetup::Ptr logs_;
@@ -0,0 +1,183 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "hydra/reconstruction/voxel_types.h"
+
+namespace hydra {
+
+/**
+ * @brief Flat lookup table from previous to current mesh vertex indices.
+ *
+ * Built once per mesh update from the deleted indices and the index remapping of
+ * the update. Indices outside the range touched by the update map to themselves.
+ */
+class VertexRemapping {
+ public:
+  inline static constexpr size_t DELETED = std::numeric_limits<size_t>::max();
+
+  VertexRemapping() = default;
+
+  template <typename Deleted, typename Mapping>
+  VertexRemapping(const Deleted& deleted, const Mapping& prev_to_curr);
+
+  //! Current index of a previous vertex index (or DELETED)
+  inline size_t operator()(size_t index) const {
+    if (index < offset_ || index - offset_ >= table_.size()) {
+      return index;
+    }
+
+    return table_[index - offset_];
+  }
+
+  //! Whether the remapping is the identity
+  inline bool empty() const { return table_.empty(); }
+
+  /**
+   * @brief Remap a list of indices in place, dropping deleted indices.
+   * @returns Whether any index was dropped
+   */
+  bool apply(std::vector<size_t>& indices) const;
+
+ private:
+  size_t offset_ = 0;
+  std::vector<size_t> table_;
+};
+
+/**
+ * @brief Euclidean clusters of a set of mesh vertices that persist between updates.
+ *
+ * Vertices are stored in a hash grid with cells the size of the cluster tolerance.
+ * Every update only re-clusters components that lost or moved a vertex or that are
+ * within tolerance of a new vertex; all other components keep their id.
+ */
+class IncrementalClusterer {
+ public:
+  struct Cluster {
+    //! Id of the cluster (stable while the cluster is unchanged)
+    size_t id;
+    //! Sorted mesh vertex indices of the cluster
+    std::vector<size_t> indices;
+  };
+
+  explicit IncrementalClusterer(double tolerance);
+
+  /**
+   * @brief Update the clustered vertices.
+   * @param remapping Index remapping from the previous update to the current mesh
+   * @param indices Mesh vertex indices to cluster
+   * @param points Current mesh vertex positions
+   */
+  void update(const VertexRemapping& remapping,
+              const std::vector<size_t>& indices,
+              const Mesh::Positions& points);
+
+  //! Clusters with [min_size, max_size] vertices in decreasing order of size
+  std::vector<Cluster> getClusters(size_t min_size, size_t max_size) const;
+
+  //! Number of clustered vertices
+  size_t numVertices() const { return vertex_to_slot_.size(); }
+
+  //! Number of clusters (regardless of size)
+  size_t numClusters() const { return clusters_.size(); }
+
+ private:
+  inline static constexpr size_t NO_CLUSTER = std::numeric_limits<size_t>::max();
+
+  struct Slot {
+    size_t vertex;
+    Mesh::Pos pos;
+    BlockIndex cell;
+    size_t cluster = NO_CLUSTER;
+    bool valid = false;
+  };
+
+  size_t addSlot(size_t vertex, const Mesh::Pos& pos);
+
+  void removeSlot(size_t slot);
+
+  template <typename Func>
+  void forEachNeighbor(const Slot& slot, const Func& func) const;
+
+  const float tolerance_;
+  const float tolerance_sq_;
+  std::vector<Slot> slots_;
+  std::vector<size_t> free_slots_;
+  std::unordered_map<size_t, size_t> vertex_to_slot_;
+  BlockIndexMap<std::vector<size_t>> grid_;
+  std::unordered_map<size_t, std::vector<size_t>> clusters_;
+  std::vector<size_t> dirty_clusters_;
+  size_t next_cluster_id_ = 0;
+};
+
+template <typename Deleted, typename Mapping>
+VertexRemapping::VertexRemapping(const Deleted& deleted, const Mapping& prev_to_curr) {
+  if (deleted.empty() && prev_to_curr.empty()) {
+    return;
+  }
+
+  size_t min_index = std::numeric_limits<size_t>::max();
+  size_t max_index = 0;
+  for (const auto idx : deleted) {
+    min_index = std::min<size_t>(min_index, idx);
+    max_index = std::max<size_t>(max_index, idx);
+  }
+
+  for (const auto& [prev, curr] : prev_to_curr) {
+    min_index = std::min<size_t>(min_index, prev);
+    max_index = std::max<size_t>(max_index, prev);
+  }
+
+  offset_ = min_index;
+  table_.resize(max_index - min_index + 1);
+  for (size_t i = 0; i < table_.size(); ++i) {
+    table_[i] = offset_ + i;
+  }
+
+  for (const auto& [prev, curr] : prev_to_curr) {
+    table_[prev - offset_] = curr;
+  }
+
+  // deletions take precedence over remapped indices
+  for (const auto idx : deleted) {
+    table_[idx - offset_] = DELETED;
+  }
+}
+
+}  // namespace hydra
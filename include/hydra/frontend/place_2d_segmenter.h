@@ -38,8 +38,11 @@
 #include <pcl/common/centroid.h>
 
 #include <memory>
+#include <unordered_map>
 
 #include "hydra/common/dsg_types.h"
+#include "hydra/common/global_info.h"
+#include "hydra/frontend/incremental_clusterer.h"
 #include "hydra/frontend/place_2d_split_logic.h"
 #include "hydra/frontend/surface_places_interface.h"
 
@@ -47,8 +50,8 @@ namespace hydra {
 
 class Place2dSegmenter : public SurfacePlacesInterface {
  public:
-  using IndicesVector = pcl::IndicesPtr::element_type;
-  using LabelIndices = std::map<uint32_t, pcl::IndicesPtr>;
+  using IndicesVector = std::vector<size_t>;
+  using LabelIndices = std::map<uint32_t, IndicesVector>;
   using MeshVertexCloud = Place2d::CloudT;
   using Places = std::vector<Place2d>;
   using LabelPlaces = std::map<uint32_t, Places>;
@@ -64,6 +67,7 @@ class Place2dSegmenter : public SurfacePlacesInterface {
     double place_max_neighbor_z_diff = 0.5;
     double connection_ellipse_scale_factor = 1;
     std::set<uint32_t> labels;
+    int num_threads = GlobalInfo::instance().getConfig().default_num_threads;
   } const config;
 
   explicit Place2dSegmenter(const Config& config);
@@ -83,10 +87,21 @@ class Place2dSegmenter : public SurfacePlacesInterface {
                                   const Place2dNodeAttributes& attrs2,
                                   EdgeAttributes& edge_weight);
 
+  //! Persistent clusters of a label and the final places of every cluster
+  struct LabelClusters {
+    explicit LabelClusters(double tolerance) : clusterer(tolerance) {}
+    IncrementalClusterer clusterer;
+    std::unordered_map<size_t, Places> cluster_places;
+  };
+
+  /**
+   * @brief Re-cluster the vertices of a label and decompose changed clusters.
+   * @returns Final places of every cluster of the label
+   */
   Places findPlaces(const Mesh::Positions& positions,
-                    const kimera_pgmo::MeshDelta& delta,
-                    const pcl::IndicesPtr& indices,
-                    double connection_ellipse_scale_factor) const;
+                    const VertexRemapping& remapping,
+                    const IndicesVector& indices,
+                    LabelClusters& clusters) const;
 
   std::set<NodeId> archiveOldObjects(const DynamicSceneGraph& graph,
                                      uint64_t latest_timestamp);
@@ -105,6 +120,7 @@ class Place2dSegmenter : public SurfacePlacesInterface {
 
  private:
   LabelPlaces detected_label_places_;
+  std::map<uint32_t, LabelClusters> label_clusters_;
 
   NodeSymbol next_node_id_;
 
@@ -3,6 +3,8 @@
 #include <pcl/pcl_base.h>
 #include <pcl/point_types.h>
 
+#include <vector>
+
 #include "hydra/common/dsg_types.h"
 #include "spark_dsg/dynamic_scene_graph.h"
 #include "spark_dsg/node_attributes.h"
@@ -25,9 +27,46 @@ struct Place2d {
   Eigen::Matrix2d ellipse_matrix_expand;
   Eigen::Vector2d ellipse_centroid;
   Eigen::Vector2d cut_plane;
-  bool can_split;
+  bool can_split = false;
+};
+
+//! Non-owning view of a contiguous range of mesh vertex indices
+struct IndexSpan {
+  IndexSpan(const std::vector<Place2d::Index>& indices)
+      : first(indices.data()), last(indices.data() + indices.size()) {}
+  IndexSpan(const Place2d::Index* first, const Place2d::Index* last)
+      : first(first), last(last) {}
+
+  const Place2d::Index* begin() const { return first; }
+  const Place2d::Index* end() const { return last; }
+  size_t size() const { return last - first; }
+  bool empty() const { return first == last; }
+
+  const Place2d::Index* first;
+  const Place2d::Index* last;
 };
 
+//! Oriented rectangle in the xy-plane, with sides oriented like cv::RotatedRect
+struct Rect2d {
+  Eigen::Vector2d center = Eigen::Vector2d::Zero();
+  //! Side at an angle in (0, 90] degrees (p3 - p0 of cv::RotatedRect::points)
+  Eigen::Vector2d width_ray = Eigen::Vector2d::Zero();
+  //! Width rotated clockwise by 90 degrees (p1 - p0 of cv::RotatedRect::points)
+  Eigen::Vector2d height_ray = Eigen::Vector2d::Zero();
+};
+
+/**
+ * @brief Compute the xy convex hull of a set of mesh vertices (monotone chain).
+ * @param hull Counter-clockwise mesh indices of the hull without collinear vertices,
+ * starting from the vertex with the largest x (then y) like cv::convexHull
+ */
+void convexHull2d(const Place2d::CloudT& points,
+                  IndexSpan indices,
+                  std::vector<Place2d::Index>& hull);
+
+//! Minimum-area xy bounding rectangle of a set of mesh vertices (rotating calipers)
+Rect2d minAreaRect2d(const Place2d::CloudT& points, IndexSpan indices);
+
 void addRectInfo(const Place2d::CloudT& points,
                  const double connection_ellipse_scale_factor,
                  Place2dNodeAttributes& attrs);
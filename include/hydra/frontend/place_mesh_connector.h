@@ -36,19 +36,56 @@
 
 #include <kimera_pgmo/mesh_delta.h>
 
+#include <map>
+#include <memory>
+#include <vector>
+
 #include "hydra/common/dsg_types.h"
 
 namespace hydra {
 
+/**
+ * @brief Maintains connections between active places and the active mesh.
+ *
+ * Active mesh vertices are kept in a persistent spatial index that is updated from
+ * the vertex add, move and archive events of every mesh update. Active places are
+ * only re-connected when their basis points or the vertices they connect to
+ * changed, or when a newly added vertex is closer than their current vertex.
+ */
 class PlaceMeshConnector {
  public:
-  using DeformationMapping = std::vector<size_t>;
+  //! Deformation graph vertex of mesh vertices (by mesh index)
+  using DeformationMapping = std::map<size_t, size_t>;
+
+  PlaceMeshConnector();
 
-  explicit PlaceMeshConnector(const kimera_pgmo::MeshDelta::Ptr& delta);
   ~PlaceMeshConnector();
 
-  size_t addConnections(const SceneGraphLayer& places,
-                        const DeformationMapping& mapping) const;
+  /**
+   * @brief Apply the vertex events of the latest mesh update to the vertex index.
+   * @param delta Latest mesh update (must be applied in order)
+   */
+  void updateVertices(const kimera_pgmo::MeshDelta::Ptr& delta);
+
+  /**
+   * @brief Update mesh vertex connections and labels of every active place.
+   * @returns Number of active places without basis points
+   */
+  size_t updateConnections(const SceneGraphLayer& places);
+
+  /**
+   * @brief Assign deformation graph connections to every active place.
+   * @param mapping Deformation graph vertex of mesh vertices (missing vertices are
+   * assigned an invalid connection)
+   */
+  void addDeformationConnections(const SceneGraphLayer& places,
+                                 const DeformationMapping& mapping) const;
+
+  //! Flags (by local mesh index) of every vertex connected to an active place
+  const std::vector<bool>& connectedVertices() const;
+
+  //! Number of vertices in the vertex index
+  size_t numVertices() const;
 
  protected:
   kimera_pgmo::MeshDelta::Ptr delta_;
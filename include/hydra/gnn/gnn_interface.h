@@ -47,6 +47,32 @@ using DynamicIndexMap = std::map<std::string, std::vector<size_t>>;
 
 struct GnnInterfaceImpl;
 
+/**
+ * \brief Threading options for the underlying inference session
+ */
+struct SessionConfig {
+  //! Number of threads used to parallelize a single operator
+  int intra_op_threads = 1;
+  //! Number of threads used to run independent operators concurrently
+  int inter_op_threads = 1;
+};
+
+/**
+ * \brief Get a named tensor with the requested shape and type
+ *
+ * Reuses the memory of an existing tensor with the same name and type if possible
+ *
+ * \param[in] tensors Map of reusable tensors
+ * \param[in] name Name of the tensor to get
+ * \param[in] dims Requested tensor dimensions
+ * \param[in] type Requested tensor type
+ * \returns Tensor with the requested shape (contents are unspecified)
+ */
+Tensor& getTensorBuffer(TensorMap& tensors,
+                        const std::string& name,
+                        const std::vector<int64_t>& dims,
+                        Tensor::Type type);
+
 class GnnInterface {
  public:
   // TODO(nathan) add actual config
@@ -54,6 +80,10 @@ class GnnInterface {
 
   GnnInterface(const std::string& model_path, const DynamicIndexMap& output_map);
 
+  GnnInterface(const std::string& model_path,
+               const DynamicIndexMap& output_map,
+               const SessionConfig& config);
+
   ~GnnInterface();
 
   /**
@@ -86,6 +116,28 @@ class GnnInterface {
   TensorMap operator()(const TensorMap& input,
                        const std::vector<int64_t>& output_sizes) const;
 
+  /**
+   * \brief Run inference, binding results to the provided output tensors
+   *
+   * Output tensors are reused if they already have the correct type, so repeated
+   * calls with similar sizes don't allocate new memory
+   *
+   * \param[in] input Map between input name and Tensor value
+   * \param[in,out] output Map between output name and (reusable) Tensor value
+   * \param[in] output_sizes Output sizes for dynamic output axes
+   */
+  void operator()(const TensorMap& input,
+                  TensorMap& output,
+                  const std::vector<int64_t>& output_sizes = {}) const;
+
+  /**
+   * \brief Check whether the model takes a specific input
+   *
+   * \param[in] name Name of the input
+   * \returns True if the model has the input
+   */
+  bool hasInput(const std::string& name) const;
+
  protected:
   std::unique_ptr<GnnInterfaceImpl> impl_;
 
@@ -60,6 +60,9 @@ struct FieldInfo {
 
   Tensor getTensor() const;
 
+  std::vector<int64_t> getDynamicDims(const std::vector<size_t>& dims_to_read,
+                                     const std::vector<int64_t>& output_dims) const;
+
   Tensor getDynamicTensor(const std::vector<size_t>& dims_to_read,
                           const std::vector<int64_t>& output_dims) const;
 };
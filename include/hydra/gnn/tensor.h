@@ -100,6 +100,16 @@ class Tensor {
 
   int64_t cols() const;
 
+  /**
+   * \brief Change the shape of the tensor, reusing the current allocation if possible
+   *
+   * Note that copies of a tensor share memory, so this affects the data (but not the
+   * shape) of any copies as well
+   *
+   * \param[in] dims New tensor dimensions
+   */
+  void resize(const std::vector<int64_t>& dims);
+
   template <typename T>
   const T* data(bool validate = true) const {
     if (validate && !matchesType<T>(type_)) {
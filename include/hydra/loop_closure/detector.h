@@ -46,6 +46,8 @@ struct GnnLcdConfig {
   double object_connection_radius_m;
   std::string object_model_path;
   std::string places_model_path;
+  int intra_op_threads = 1;
+  int inter_op_threads = 1;
   bool places_pos_in_feature = false;
   bool objects_pos_in_feature = false;
 };
@@ -58,7 +60,15 @@ struct LayerLcdConfig {
 struct LcdDetectorConfig {
   TeaserParams teaser_config;
   bool enable_agent_registration = true;
+  //! Number of registration candidates to verify concurrently
+  int registration_threads = 1;
+  //! Time budget across all registration candidates for a query (disabled if <= 0)
+  double registration_time_budget_s = 0.0;
   DescriptorMatchConfig agent_search_config;
+  //! Number of threads to use when constructing descriptors for new agent nodes
+  int descriptor_threads = 1;
+  //! Maximum number of descriptors per layer to construct at once (e.g., for GNNs)
+  size_t descriptor_batch_size = 1;
 
   // TODO(nathan) refactor this
   LayerLcdConfig objects;
@@ -113,8 +123,15 @@ class LcdDetector {
       const std::map<LayerId, DescriptorMatchConfig>& match_configs,
       const std::map<LayerId, LayerRegistrationConfig>& reg_configs);
 
-  bool addNewDescriptors(const DynamicSceneGraph& graph,
-                         const SceneGraphNode& agent_node);
+  struct RegistrationCandidate {
+    size_t level;
+    DsgRegistrationInput input;
+  };
+
+  RegistrationSolution verifyCandidates(
+      const DynamicSceneGraph& dsg,
+      const std::vector<RegistrationCandidate>& candidates,
+      NodeId agent_id) const;
 
   std::vector<RegistrationSolution> registerAndVerify(const DynamicSceneGraph& dsg,
                                                       const SearchResultMap& matches,
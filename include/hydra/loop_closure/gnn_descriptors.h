@@ -33,11 +33,30 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
+#include <mutex>
+
 #include "hydra/gnn/gnn_interface.h"
 #include "hydra/loop_closure/scene_graph_descriptors.h"
 
 namespace hydra::lcd {
 
+//! Thread-safe pool of reusable model inputs and outputs
+class InferenceBufferPool {
+ public:
+  struct Buffers {
+    gnn::TensorMap input;
+    gnn::TensorMap output;
+  };
+
+  std::unique_ptr<Buffers> acquire();
+
+  void release(std::unique_ptr<Buffers>&& buffers);
+
+ private:
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Buffers>> free_;
+};
+
 struct ObjectGnnDescriptor : DescriptorFactory {
   using LabelEmbeddings = std::map<uint8_t, Eigen::VectorXf>;
 
@@ -45,17 +64,34 @@ struct ObjectGnnDescriptor : DescriptorFactory {
                       const SubgraphConfig& config,
                       double max_edge_distance_m,
                       const LabelEmbeddings& label_embeddings,
-                      bool use_pos_in_feature = true);
+                      bool use_pos_in_feature = true,
+                      const gnn::SessionConfig& session_config = {});
 
   gnn::TensorMap makeInput(const DynamicSceneGraph& graph,
                            const std::set<NodeId>& nodes) const;
 
+  //! Pack several subgraphs into one disjoint graph (with a batch index if requested)
+  void makeBatchInput(const DynamicSceneGraph& graph,
+                      const std::vector<const std::set<NodeId>*>& subgraphs,
+                      gnn::TensorMap& input,
+                      bool add_batch_index) const;
+
   Descriptor::Ptr construct(const DynamicSceneGraph& graph,
-                            const DynamicSceneGraphNode& agent_node) const override;
+                            const SceneGraphNode& agent_node) const override;
+
+  Descriptor::Ptr constructWithCache(const DynamicSceneGraph& graph,
+                                     const SceneGraphNode& agent_node,
+                                     SubgraphCache& cache) const override;
+
+  std::vector<Descriptor::Ptr> constructBatch(
+      const DynamicSceneGraph& graph,
+      const std::vector<const SceneGraphNode*>& agent_nodes,
+      SubgraphCache& cache) const override;
 
  protected:
   const SubgraphConfig config_;
   std::unique_ptr<gnn::GnnInterface> model_;
+  mutable InferenceBufferPool buffers_;
 
   double max_edge_distance_m_;
   size_t label_embedding_size_;
@@ -66,18 +102,35 @@ struct ObjectGnnDescriptor : DescriptorFactory {
 struct PlaceGnnDescriptor : DescriptorFactory {
   PlaceGnnDescriptor(const std::string& model_path,
                      const SubgraphConfig& config,
-                     bool use_pos_in_feature = true);
+                     bool use_pos_in_feature = true,
+                     const gnn::SessionConfig& session_config = {});
 
   gnn::TensorMap makeInput(const DynamicSceneGraph& graph,
                            const std::set<NodeId>& nodes) const;
 
+  //! Pack several subgraphs into one disjoint graph (with a batch index if requested)
+  void makeBatchInput(const DynamicSceneGraph& graph,
+                      const std::vector<const std::set<NodeId>*>& subgraphs,
+                      gnn::TensorMap& input,
+                      bool add_batch_index) const;
+
   Descriptor::Ptr construct(const DynamicSceneGraph& graph,
-                            const DynamicSceneGraphNode& agent_node) const override;
+                            const SceneGraphNode& agent_node) const override;
+
+  Descriptor::Ptr constructWithCache(const DynamicSceneGraph& graph,
+                                     const SceneGraphNode& agent_node,
+                                     SubgraphCache& cache) const override;
+
+  std::vector<Descriptor::Ptr> constructBatch(
+      const DynamicSceneGraph& graph,
+      const std::vector<const SceneGraphNode*>& agent_nodes,
+      SubgraphCache& cache) const override;
 
  protected:
   const SubgraphConfig config_;
   const bool use_pos_in_feature_;
   std::unique_ptr<gnn::GnnInterface> model_;
+  mutable InferenceBufferPool buffers_;
 };
 
 ObjectGnnDescriptor::LabelEmbeddings loadLabelEmbeddings(const std::string& filename);
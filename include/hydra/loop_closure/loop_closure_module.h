@@ -42,6 +42,7 @@
 #include "hydra/common/shared_module_state.h"
 #include "hydra/loop_closure/detector.h"
 #include "hydra/loop_closure/loop_closure_config.h"
+#include "hydra/utils/graph_checkpoint.h"
 #include "hydra/utils/log_utilities.h"
 
 namespace hydra {
@@ -88,6 +89,7 @@ class LoopClosureModule : public Module {
 
   std::unique_ptr<lcd::LcdDetector> lcd_detector_;
   DynamicSceneGraph::Ptr lcd_graph_;
+  GraphCheckpointWriter checkpoint_writer_;
 };
 
 }  // namespace hydra
@@ -37,7 +37,9 @@
 #include <gtsam/geometry/Pose3.h>
 #include <teaser/registration.h>
 
+#include <list>
 #include <mutex>
+#include <optional>
 
 #include "hydra/common/common.h"
 #include "hydra/loop_closure/descriptor_matching.h"
@@ -62,6 +64,8 @@ struct DsgRegistrationInput {
   std::set<NodeId> match_nodes;
   NodeId query_root;
   NodeId match_root;
+  //! Optional upper bound on the time the solver should spend on this input
+  std::optional<double> time_limit_s = std::nullopt;
 };
 
 struct DsgRegistrationSolver {
@@ -69,6 +73,7 @@ struct DsgRegistrationSolver {
 
   virtual ~DsgRegistrationSolver() = default;
 
+  //! Note that solve may be called concurrently for different candidates
   virtual RegistrationSolution solve(const DynamicSceneGraph& dsg,
                                      const DsgRegistrationInput& match,
                                      NodeId query_agent_id) const = 0;
@@ -89,10 +94,24 @@ struct DsgTeaserSolver : DsgRegistrationSolver {
 
   LayerId layer_id;
   LayerRegistrationConfig config;
+  TeaserParams params;
   std::string timer_prefix;
   std::string log_prefix;
-  // registration call mutates the solver
-  mutable teaser::RobustRegistrationSolver solver;
+
+ private:
+  using TeaserSolverPtr = std::unique_ptr<teaser::RobustRegistrationSolver>;
+
+  RegistrationSolution solveImpl(const DynamicSceneGraph& dsg,
+                                 const DsgRegistrationInput& match,
+                                 NodeId query_agent_id) const;
+
+  TeaserSolverPtr acquireSolver(const DsgRegistrationInput& match) const;
+
+  void releaseSolver(TeaserSolverPtr&& solver) const;
+
+  // registration call mutates the solver, so each concurrent call checks one out
+  mutable std::mutex solver_mutex_;
+  mutable std::list<TeaserSolverPtr> solver_pool_;
 };
 
 using CorrespondenceFunc =
@@ -131,69 +150,96 @@ std::list<NodeId> pruneSet(const SceneGraphLayer& layer, NodeSet& nodes) {
   return pruned;
 }
 
+using RegistrationNodes = std::vector<const SceneGraphNode*>;
+using IndexCorrespondences = std::vector<std::pair<size_t, size_t>>;
+using CorrespondenceBuilder = std::function<IndexCorrespondences(
+    const RegistrationNodes&, const RegistrationNodes&)>;
+
+/**
+ * @brief Get all pairs of nodes that the correspondence function accepts
+ *
+ * Correspondences are ordered by source node and then by destination node.
+ */
+IndexCorrespondences getCorrespondences(const RegistrationNodes& src_nodes,
+                                        const RegistrationNodes& dest_nodes,
+                                        const CorrespondenceFunc& correspondence_func);
+
+/**
+ * @brief Get all pairs of nodes with the same semantic label
+ *
+ * Destination nodes are bucketed by label so the cost is proportional to the number
+ * of correspondences instead of the number of node pairs. Ordering matches
+ * getCorrespondences with a label equality check.
+ */
+IndexCorrespondences getSemanticCorrespondences(const RegistrationNodes& src_nodes,
+                                                const RegistrationNodes& dest_nodes);
+
+template <typename NodeSet>
+RegistrationNodes getRegistrationNodes(const SceneGraphLayer& layer,
+                                       const NodeSet& nodes) {
+  RegistrationNodes resolved;
+  resolved.reserve(nodes.size());
+  for (const auto& node_id : nodes) {
+    const auto node = layer.findNode(node_id);
+    CHECK(node);
+    resolved.push_back(node);
+  }
+
+  return resolved;
+}
+
 template <typename NodeSet>
 LayerRegistrationSolution registerDsgLayer(
     const LayerRegistrationConfig& config,
     teaser::RobustRegistrationSolver& solver,
     const LayerRegistrationProblem<NodeSet>& problem,
     const SceneGraphLayer& src,
-    const CorrespondenceFunc& correspondence_func) {
+    const CorrespondenceBuilder& correspondence_builder) {
   std::vector<std::pair<NodeId, NodeId>> correspondences;
-  correspondences.reserve(problem.src_nodes.size() * problem.dest_nodes.size());
-
-  if (problem.src_mutex) {
-    problem.src_mutex->lock();
-  }
+  Eigen::Matrix<double, 3, Eigen::Dynamic> src_points;
+  Eigen::Matrix<double, 3, Eigen::Dynamic> dest_points;
 
-  if (problem.dest_mutex) {
-    problem.dest_mutex->lock();
-  }
-
-  const SceneGraphLayer& dest = problem.dest_layer ? *problem.dest_layer : src;
-
-  const auto src_pruned = pruneSet(src, problem.src_nodes);
-  if (!src_pruned.empty()) {
-    VLOG(3) << "[DSG LCD] Found invalid source nodes in registration: "
-            << displayNodeSymbolContainer(src_pruned);
-  }
-
-  const auto dest_pruned = pruneSet(dest, problem.dest_nodes);
-  if (!dest_pruned.empty()) {
-    VLOG(3) << "[DSG LCD] Found invalid destination nodes in registration: "
-            << displayNodeSymbolContainer(dest_pruned);
-  }
+  {  // start critical section
+    std::unique_lock<std::mutex> src_lock;
+    if (problem.src_mutex) {
+      src_lock = std::unique_lock<std::mutex>(*problem.src_mutex);
+    }
 
-  for (const auto& src_id : problem.src_nodes) {
-    auto src_node_opt = src.findNode(src_id);
-    CHECK(src_node_opt);
-    const auto& src_node = *src_node_opt;
+    std::unique_lock<std::mutex> dest_lock;
+    if (problem.dest_mutex) {
+      dest_lock = std::unique_lock<std::mutex>(*problem.dest_mutex);
+    }
 
-    for (const auto& dest_id : problem.dest_nodes) {
-      auto dest_node_opt = dest.findNode(dest_id);
-      CHECK(dest_node_opt);
-      const auto& dest_node = *dest_node_opt;
+    const SceneGraphLayer& dest = problem.dest_layer ? *problem.dest_layer : src;
 
-      if (correspondence_func(src_node, dest_node)) {
-        correspondences.emplace_back(src_id, dest_id);
-      }
+    const auto src_pruned = pruneSet(src, problem.src_nodes);
+    if (!src_pruned.empty()) {
+      VLOG(3) << "[DSG LCD] Found invalid source nodes in registration: "
+              << displayNodeSymbolContainer(src_pruned);
     }
-  }
 
-  if (problem.src_mutex) {
-    problem.src_mutex->unlock();
-  }
-
-  if (problem.dest_mutex) {
-    problem.dest_mutex->unlock();
-  }
+    const auto dest_pruned = pruneSet(dest, problem.dest_nodes);
+    if (!dest_pruned.empty()) {
+      VLOG(3) << "[DSG LCD] Found invalid destination nodes in registration: "
+              << displayNodeSymbolContainer(dest_pruned);
+    }
 
-  Eigen::Matrix<double, 3, Eigen::Dynamic> src_points(3, correspondences.size());
-  Eigen::Matrix<double, 3, Eigen::Dynamic> dest_points(3, correspondences.size());
-  for (size_t i = 0; i < correspondences.size(); ++i) {
-    const auto correspondence = correspondences[i];
-    src_points.col(i) = src.getPosition(correspondence.first);
-    dest_points.col(i) = dest.getPosition(correspondence.second);
-  }
+    const auto src_nodes = getRegistrationNodes(src, problem.src_nodes);
+    const auto dest_nodes = getRegistrationNodes(dest, problem.dest_nodes);
+    const auto indices = correspondence_builder(src_nodes, dest_nodes);
+
+    // copy everything needed by the solver so the layers can be released
+    correspondences.reserve(indices.size());
+    src_points.resize(3, indices.size());
+    dest_points.resize(3, indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+      const auto& src_node = *src_nodes[indices[i].first];
+      const auto& dest_node = *dest_nodes[indices[i].second];
+      correspondences.emplace_back(src_node.id, dest_node.id);
+      src_points.col(i) = src_node.attributes().position;
+      dest_points.col(i) = dest_node.attributes().position;
+    }
+  }  // end critical section
 
   if (correspondences.size() < config.min_correspondences) {
     VLOG(2) << "not enough correspondences for registration at layer " << src.id << ": "
@@ -240,17 +286,25 @@ LayerRegistrationSolution registerDsgLayer(
 }
 
 template <typename NodeSet>
-LayerRegistrationSolution registerDsgLayerPairwise(
+LayerRegistrationSolution registerDsgLayer(
     const LayerRegistrationConfig& config,
     teaser::RobustRegistrationSolver& solver,
     const LayerRegistrationProblem<NodeSet>& problem,
-    const SceneGraphLayer& src) {
+    const SceneGraphLayer& src,
+    const CorrespondenceFunc& correspondence_func) {
   return registerDsgLayer(
-      config, solver, problem, src, [](const auto&, const auto&) { return true; });
+      config,
+      solver,
+      problem,
+      src,
+      [&correspondence_func](const RegistrationNodes& src_nodes,
+                             const RegistrationNodes& dest_nodes) {
+        return getCorrespondences(src_nodes, dest_nodes, correspondence_func);
+      });
 }
 
 template <typename NodeSet>
-LayerRegistrationSolution registerDsgLayerSemantic(
+LayerRegistrationSolution registerDsgLayerPairwise(
     const LayerRegistrationConfig& config,
     teaser::RobustRegistrationSolver& solver,
     const LayerRegistrationProblem<NodeSet>& problem,
@@ -260,10 +314,20 @@ LayerRegistrationSolution registerDsgLayerSemantic(
       solver,
       problem,
       src,
-      [](const SceneGraphNode& src_node, const SceneGraphNode& dest_node) {
-        return src_node.attributes<SemanticNodeAttributes>().semantic_label ==
-               dest_node.attributes<SemanticNodeAttributes>().semantic_label;
-      });
+      CorrespondenceFunc([](const auto&, const auto&) { return true; }));
+}
+
+template <typename NodeSet>
+LayerRegistrationSolution registerDsgLayerSemantic(
+    const LayerRegistrationConfig& config,
+    teaser::RobustRegistrationSolver& solver,
+    const LayerRegistrationProblem<NodeSet>& problem,
+    const SceneGraphLayer& src) {
+  return registerDsgLayer(config,
+                          solver,
+                          problem,
+                          src,
+                          CorrespondenceBuilder(&getSemanticCorrespondences));
 }
 
 }  // namespace hydra::lcd
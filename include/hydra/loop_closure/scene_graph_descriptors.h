@@ -57,6 +57,25 @@ struct DescriptorFactory {
 
   virtual Descriptor::Ptr construct(const DynamicSceneGraph& dsg,
                                     const SceneGraphNode& agent_node) const = 0;
+
+  //! Construct a descriptor, reusing place neighborhoods from the cache if possible
+  virtual Descriptor::Ptr constructWithCache(const DynamicSceneGraph& dsg,
+                                             const SceneGraphNode& agent_node,
+                                             SubgraphCache& /* cache */) const {
+    return construct(dsg, agent_node);
+  }
+
+  //! Construct descriptors for several agent nodes at once (e.g., to batch inference)
+  virtual std::vector<Descriptor::Ptr> constructBatch(
+      const DynamicSceneGraph& dsg,
+      const std::vector<const SceneGraphNode*>& agent_nodes,
+      SubgraphCache& cache) const {
+    std::vector<Descriptor::Ptr> descriptors;
+    for (const auto agent_node : agent_nodes) {
+      descriptors.push_back(constructWithCache(dsg, *agent_node, cache));
+    }
+    return descriptors;
+  }
 };
 
 struct AgentDescriptorFactory : DescriptorFactory {
@@ -74,6 +93,10 @@ struct ObjectDescriptorFactory : DescriptorFactory {
   Descriptor::Ptr construct(const DynamicSceneGraph& graph,
                             const SceneGraphNode& agent_node) const override;
 
+  Descriptor::Ptr constructWithCache(const DynamicSceneGraph& graph,
+                                     const SceneGraphNode& agent_node,
+                                     SubgraphCache& cache) const override;
+
   const SubgraphConfig config;
   const size_t num_classes;
 };
@@ -109,6 +132,10 @@ struct PlaceDescriptorFactory : DescriptorFactory {
   Descriptor::Ptr construct(const DynamicSceneGraph& graph,
                             const SceneGraphNode& agent_node) const override;
 
+  Descriptor::Ptr constructWithCache(const DynamicSceneGraph& graph,
+                                     const SceneGraphNode& agent_node,
+                                     SubgraphCache& cache) const override;
+
   const SubgraphConfig config;
   const HistogramConfig<double> histogram;
 };
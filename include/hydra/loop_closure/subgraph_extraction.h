@@ -33,6 +33,9 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
+#include <optional>
+#include <unordered_map>
+
 #include "hydra/common/dsg_types.h"
 
 namespace hydra {
@@ -53,4 +56,50 @@ std::set<NodeId> getSubgraphNodes(const SubgraphConfig& config,
                                   NodeId root_node,
                                   bool is_places);
 
+//! Everything about a place needed to extract and summarize subgraphs around it
+struct PlaceNeighborhood {
+  struct Child {
+    NodeId id;
+    Eigen::Vector3d position;
+    std::optional<SemanticNodeAttributes::Label> label;
+  };
+
+  Eigen::Vector3d position;
+  std::optional<double> distance;
+  std::vector<NodeId> siblings;
+  //! Static (non-agent) children of the place
+  std::vector<Child> children;
+};
+
+/**
+ * @brief Lazily populated lookup of place neighborhoods
+ *
+ * Subgraphs around nearby roots overlap heavily, so sharing a cache between queries
+ * avoids repeated scene graph lookups for the same places. The cache is not
+ * thread-safe and is only valid while the underlying graph is unchanged.
+ */
+class SubgraphCache {
+ public:
+  explicit SubgraphCache(const DynamicSceneGraph& graph);
+
+  //! Get the cached neighborhood of a place (nullptr if the place doesn't exist)
+  const PlaceNeighborhood* getPlace(NodeId place);
+
+  //! Get the semantic label of an object previously found through a cached place
+  std::optional<SemanticNodeAttributes::Label> getLabel(NodeId object) const;
+
+  size_t size() const { return places_.size(); }
+
+  const DynamicSceneGraph& graph;
+
+ private:
+  std::unordered_map<NodeId, std::optional<PlaceNeighborhood>> places_;
+  std::unordered_map<NodeId, SemanticNodeAttributes::Label> labels_;
+};
+
+std::set<NodeId> getSubgraphNodes(const SubgraphConfig& config,
+                                  SubgraphCache& cache,
+                                  NodeId root_node,
+                                  bool is_places);
+
 }  // namespace hydra
@@ -33,7 +33,10 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
+#include <array>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "hydra/places/gvd_voxel.h"
 
@@ -47,7 +50,65 @@ struct GvdVertexInfo {
   size_t ref_count = 0;
 };
 
-struct GvdParentTracker {
+/**
+ * @brief Set of basis parents for a GVD voxel
+ *
+ * Uniqueness is enforced by the caller (via the Voronoi parent check). The first few
+ * parents are stored inline, as almost all GVD voxels have only a handful of basis
+ * points.
+ */
+class GvdParentSet {
+ public:
+  static constexpr size_t kInlineSize = 4;
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const GlobalIndex* begin() const { return data(); }
+  const GlobalIndex* end() const { return data() + size_; }
+
+  void insert(const GlobalIndex& parent);
+
+ private:
+  const GlobalIndex* data() const {
+    return size_ <= kInlineSize ? inline_.data() : overflow_.data();
+  }
+
+  uint32_t size_ = 0;
+  std::array<GlobalIndex, kInlineSize> inline_;
+  //! All parents once there are more than kInlineSize
+  std::vector<GlobalIndex> overflow_;
+};
+
+/**
+ * @brief Parent information for the voxels of a single GVD block
+ *
+ * Entries are sorted by linear voxel index and only exist for GVD voxels (parents)
+ * and surface voxels used as parents (vertices).
+ */
+struct GvdParentBlock : public spatial_hash::Block {
+  using Ptr = std::shared_ptr<GvdParentBlock>;
+
+  GvdParentBlock(float block_size, const BlockIndex& index)
+      : spatial_hash::Block(block_size, index) {}
+
+  bool empty() const { return parents.empty() && vertices.empty(); }
+
+  std::vector<std::pair<uint32_t, GvdParentSet>> parents;
+  std::vector<std::pair<uint32_t, GvdVertexInfo>> vertices;
+};
+
+using GvdParentLayer = spatial_hash::BlockLayer<GvdParentBlock>;
+
+/**
+ * @brief Tracks the basis parents of GVD voxels and the surface vertices they map to
+ *
+ * Information is kept in a block layer aligned with the GVD so that it can be released
+ * with the corresponding GVD block when that block is archived.
+ */
+class GvdParentTracker {
+ public:
+  GvdParentTracker(float voxel_size, int voxels_per_side);
+
   uint8_t updateGvdParentMap(const GvdLayer& layer,
                              const VoronoiCheckConfig& config,
                              const GlobalIndex& voxel_index,
@@ -59,8 +120,22 @@ struct GvdParentTracker {
 
   void updateVertexMapping(const GvdLayer& layer);
 
-  GlobalIndexMap<GlobalIndexSet> parents;
-  GlobalIndexMap<GvdVertexInfo> parent_vertices;
+  //! Release all parent and vertex information stored for a block
+  void removeBlock(const BlockIndex& block_index);
+
+  //! Get the basis parents of a GVD voxel (or nullptr if the voxel has none tracked)
+  const GvdParentSet* getParents(const GlobalIndex& voxel_index) const;
+
+  //! Get the vertex information of a parent (or nullptr if it isn't tracked)
+  const GvdVertexInfo* getVertex(const GlobalIndex& parent) const;
+
+  size_t numBlocks() const { return layer_.numBlocks(); }
+
+ private:
+  std::pair<BlockIndex, uint32_t> getKey(const GlobalIndex& index) const;
+
+  const int voxels_per_side_;
+  GvdParentLayer layer_;
 };
 
 }  // namespace hydra::places
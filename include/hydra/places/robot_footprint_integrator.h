@@ -37,8 +37,10 @@
 
 #include <Eigen/Geometry>
 #include <memory>
+#include <vector>
 
 #include "hydra/common/dsg_types.h"
+#include "hydra/common/global_info.h"
 #include "hydra/reconstruction/volumetric_map.h"
 
 namespace hydra {
@@ -51,15 +53,44 @@ class RobotFootprintIntegrator {
     Eigen::Vector3f bbox_min = Eigen::Vector3f::Zero();
     Eigen::Vector3f bbox_max = Eigen::Vector3f::Zero();
     double tsdf_weight = 1.0e-5;
+    int num_threads = GlobalInfo::instance().getConfig().default_num_threads;
+  };
+
+  //! Contiguous x-range of voxels [x_min, x_max] covered by the footprint in a block
+  struct VoxelRun {
+    int y;
+    int z;
+    int x_min;
+    int x_max;
   };
 
   RobotFootprintIntegrator(const Config& config);
 
   virtual ~RobotFootprintIntegrator();
 
+  /**
+   * @brief Mark voxels whose centers fall inside the footprint as free
+   *
+   * Blocks are only allocated if the footprint covers at least one of their voxels.
+   */
   void addFreespaceFootprint(const Eigen::Isometry3f& world_T_body,
                              VolumetricMap& map) const;
 
+  //! Get all blocks that the footprint could intersect
+  BlockIndices getCandidateBlocks(const Eigen::Isometry3f& world_T_body,
+                                  float block_size) const;
+
+  /**
+   * @brief Compute the voxel runs inside the footprint for a block
+   *
+   * Each row of voxels along x is intersected analytically with the footprint, so
+   * the cost is one interval computation per row instead of a transform per voxel.
+   */
+  std::vector<VoxelRun> rasterizeBlock(const Eigen::Isometry3f& body_T_world,
+                                       const BlockIndex& block_index,
+                                       float voxel_size,
+                                       int voxels_per_side) const;
+
  public:
   const Config config;
   const BoundingBox bbox;
@@ -33,6 +33,7 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
+#include <array>
 #include <bitset>
 #include <iostream>
 
@@ -55,6 +56,8 @@ struct CubeFlagExtractor {
   /**
    * @brief Extract a 3x3 grid of voxels in the offset iteration
    * order of spatial_hash
+   *
+   * Voxels are read directly from the blocks that the grid overlaps
    */
   static std::bitset<27> extract(const GvdLayer& layer,
                                  const GlobalIndex& index,
@@ -67,11 +70,32 @@ struct CubeFlagExtractor {
   static std::bitset<27> rotate(const IndexRotation& rotation,
                                 const std::bitset<27>& flags_sh);
 
+  /**
+   * @brief Get the position of an offset (in [-1, 1]^3) in the offset iteration order
+   */
+  static size_t offsetIndex(const GlobalIndex& offset);
+
   /**
    * @brief Offset iteration order
    */
   const static std::vector<GlobalIndex> sh_offsets;
-  const static spatial_hash::IndexHashMap<size_t> sh_offset_lookup;
+};
+
+/**
+ * @brief Permutation of the bits of a 3x3 grid of voxels
+ *
+ * The permutation is applied with one lookup per 9-bit chunk of the input
+ */
+struct CubeBitPermutation {
+  //! Construct from the destination bit of every input bit
+  explicit CubeBitPermutation(const std::array<size_t, 27>& destinations);
+
+  uint32_t operator()(uint32_t flags) const {
+    return table[0][flags & 0x1FF] | table[1][(flags >> 9) & 0x1FF] |
+           table[2][(flags >> 18) & 0x1FF];
+  }
+
+  std::array<std::array<uint32_t, 512>, 3> table;
 };
 
 struct GvdCornerTemplate {
@@ -95,14 +119,22 @@ struct CornerFinder {
 
   ~CornerFinder() = default;
 
+  //! Check whether any template matches via the precomputed match table
   bool match(std::bitset<27> values) const;
 
+  //! Check whether any template matches by evaluating every template
+  bool matchTemplates(std::bitset<27> values) const;
+
   GvdCornerTemplate negative_x_template;
   GvdCornerTemplate positive_x_template;
   GvdCornerTemplate negative_y_template;
   GvdCornerTemplate positive_y_template;
   GvdCornerTemplate negative_z_template;
   GvdCornerTemplate positive_z_template;
+
+ private:
+  //! For each 9-bit chunk of the grid: which template rotations the chunk agrees with
+  std::array<std::array<uint32_t, 512>, 3> match_table_;
 };
 
 }  // namespace hydra::places
@@ -0,0 +1,97 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+
+#include <algorithm>
+#include <future>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "hydra/reconstruction/index_getter.h"
+
+namespace hydra {
+
+/**
+ * @brief Get the number of workers to use for a number of items
+ * @param num_threads Requested number of threads (negative uses all cores)
+ * @param num_items Number of items to process
+ */
+inline size_t getNumWorkers(int num_threads, size_t num_items) {
+  const size_t requested = num_threads < 0 ? std::thread::hardware_concurrency()
+                                           : static_cast<size_t>(num_threads);
+  return std::max<size_t>(std::min(num_items, requested), 1);
+}
+
+/**
+ * @brief Call func(item_index, worker_index) for every item, spread over workers
+ *
+ * Items are handed out one at a time through an IndexGetter so that uneven items
+ * balance across workers. Worker indices are in [0, getNumWorkers(num_threads,
+ * num_items)) and can be used to address per-worker scratch space.
+ */
+template <typename Func>
+void parallelFor(size_t num_items, int num_threads, const Func& func) {
+  if (num_items == 0) {
+    return;
+  }
+
+  const size_t num_workers = getNumWorkers(num_threads, num_items);
+  std::vector<size_t> items(num_items);
+  std::iota(items.begin(), items.end(), 0);
+  IndexGetter<size_t> index_getter(items);
+  auto process = [&](size_t worker) {
+    size_t item;
+    while (index_getter.getNextIndex(item)) {
+      func(item, worker);
+    }
+  };
+
+  if (num_workers == 1) {
+    process(0);
+    return;
+  }
+
+  std::vector<std::future<void>> workers;
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers.emplace_back(std::async(std::launch::async, process, i));
+  }
+
+  for (auto& worker : workers) {
+    worker.get();
+  }
+}
+
+}  // namespace hydra
@@ -34,6 +34,7 @@
  * -------------------------------------------------------------------------- */
 #pragma once
 #include "hydra/common/dsg_types.h"
+#include "hydra/utils/csr_graph.h"
 
 namespace hydra {
 
@@ -65,7 +66,15 @@ ClusterResults clusterGraphByModularity(const SceneGraphLayer& layer,
                                         size_t max_iters = 5,
                                         double gamma = 1.0);
 
+ClusterResults clusterGraphByModularity(const CsrGraph& graph,
+                                        const InitialClusters& initial_clusters,
+                                        size_t max_iters = 5,
+                                        double gamma = 1.0);
+
 ClusterResults clusterGraphByNeighbors(const SceneGraphLayer& layer,
                                        const InitialClusters& initial_clusters);
 
+ClusterResults clusterGraphByNeighbors(const CsrGraph& graph,
+                                       const InitialClusters& initial_clusters);
+
 }  // namespace hydra
@@ -34,6 +34,7 @@
  * -------------------------------------------------------------------------- */
 #pragma once
 #include "hydra/common/dsg_types.h"
+#include "hydra/utils/csr_graph.h"
 #include "hydra/utils/disjoint_set.h"
 
 namespace hydra {
@@ -89,6 +90,23 @@ Filtration getGraphFiltration(const SceneGraphLayer& layer,
                               const ComponentCallback& count_components,
                               bool include_nodes = true);
 
+//! Get the distance of every place in dense index order
+std::vector<double> getNodeDistances(const CsrGraph& graph,
+                                     const SceneGraphLayer& layer);
+
+/**
+ * @brief Compute the filtration of a compact snapshot of a places layer
+ *
+ * Equivalent to the callback version when the callback counts components with at
+ * least min_component_size nodes, but tracks the component count incrementally.
+ */
+Filtration getGraphFiltration(const CsrGraph& graph,
+                              const std::vector<double>& node_distances,
+                              BarcodeTracker& tracker,
+                              double diff_threshold_m,
+                              size_t min_component_size,
+                              bool include_nodes = true);
+
 std::pair<size_t, size_t> getTrimmedFiltration(const Filtration& old_filtration,
                                                double min_dilation_m,
                                                double max_dilation_m,
@@ -66,7 +66,8 @@ class RoomFinder {
   void fillClusterMap(const SceneGraphLayer& places, ClusterMap& assignments) const;
 
  protected:
-  InitialClusters getBestComponents(const SceneGraphLayer& places) const;
+  InitialClusters getBestComponents(const SceneGraphLayer& places,
+                                    const CsrGraph& graph) const;
 
   SceneGraphLayer::Ptr makeRoomLayer(const SceneGraphLayer& places);
 
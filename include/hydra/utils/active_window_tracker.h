@@ -33,24 +33,172 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include "hydra/common/dsg_types.h"
-#include "spark_dsg/layer_view.h"
 
 namespace hydra {
 
 /**
- * @brief class that exposes an iterator over nodes that are active or have just been
- * archived
+ * @brief Iterable list of nodes (sorted by id) from a layer
+ */
+class ActiveWindowView {
+ public:
+  using Nodes = std::vector<const SceneGraphNode*>;
+
+  struct Iterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = SceneGraphNode;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const SceneGraphNode*;
+    using reference = const SceneGraphNode&;
+
+    inline reference operator*() const { return **iter; }
+    inline pointer operator->() const { return *iter; }
+    inline Iterator& operator++() {
+      ++iter;
+      return *this;
+    }
+    inline bool operator==(const Iterator& other) const { return iter == other.iter; }
+    inline bool operator!=(const Iterator& other) const { return iter != other.iter; }
+
+    Nodes::const_iterator iter;
+  };
+
+  ActiveWindowView() = default;
+
+  //! View over every node in the layer
+  explicit ActiveWindowView(const SceneGraphLayer& layer);
+
+  explicit ActiveWindowView(Nodes&& nodes) : nodes_(std::move(nodes)) {}
+
+  inline Iterator begin() const { return {nodes_.begin()}; }
+  inline Iterator end() const { return {nodes_.end()}; }
+  inline size_t size() const { return nodes_.size(); }
+  inline bool empty() const { return nodes_.empty(); }
+
+ private:
+  Nodes nodes_;
+};
+
+/**
+ * @brief Index of the active window of a layer (active nodes plus nodes archived since
+ * the window was last cleared)
+ *
+ * The index is driven by the new and removed node notifications of the graph, and
+ * only window members are checked for archival, so updating and iterating the window
+ * is O(window). Members are kept sorted by id as they are added. The index can be
+ * shared between the trackers of every functor that looks at the same layer: archived
+ * nodes are only dropped once every tracker has cleared the window.
+ */
+class ActiveWindowIndex {
+ public:
+  using Ptr = std::shared_ptr<ActiveWindowIndex>;
+
+  //! Add a node to the window (e.g., a new or reactivated node)
+  void activate(NodeId node);
+  //! Mark a node as archived (it stays in the window until the window is cleared)
+  void archive(NodeId node);
+  //! Drop a node from the index
+  void remove(NodeId node);
+
+  /**
+   * @brief Apply node notifications and archive members that are no longer active
+   * @param layer Layer the index tracks
+   * @param new_nodes Nodes added since the last update (other layers are ignored)
+   * @param removed_nodes Nodes removed since the last update
+   */
+  void update(const SceneGraphLayer& layer,
+              const std::vector<NodeId>& new_nodes,
+              const std::vector<NodeId>& removed_nodes);
+
+  //! Nodes in the window that are present in the layer
+  ActiveWindowView view(const SceneGraphLayer& layer) const;
+
+  //! Number of nodes in the window
+  inline size_t size() const { return members_.size(); }
+
+  //! Whether the node is in the window
+  bool contains(NodeId node) const;
+
+  void reset();
+
+ private:
+  friend struct ActiveWindowTracker;
+
+  void dropArchived();
+  void compact();
+  bool hasConsumers() const;
+  size_t addConsumer();
+  void removeConsumer(size_t consumer);
+  void clear(size_t consumer);
+
+  //! Window members and whether they are still active
+  std::unordered_map<NodeId, bool> members_;
+  //! Window members sorted by id (removed members are dropped lazily)
+  std::vector<NodeId> window_;
+  size_t num_archived_ = 0;
+  size_t num_stale_ = 0;
+
+  // consumers that have not cleared the current window yet
+  std::vector<bool> consumers_;
+  std::vector<bool> pending_clear_;
+};
+
+/**
+ * @brief Shared active window indices for every layer of a graph
+ */
+class ActiveWindows {
+ public:
+  /**
+   * @brief Apply new and removed node notifications of the graph to every index
+   *
+   * Indices are created for every layer of the graph so that no notification is
+   * missed before a tracker first looks at the layer.
+   */
+  void update(const DynamicSceneGraph& graph,
+              const std::vector<NodeId>& new_nodes,
+              const std::vector<NodeId>& removed_nodes);
+
+  //! Index of a layer (created if missing)
+  const ActiveWindowIndex::Ptr& index(LayerId layer);
+
+ private:
+  std::map<LayerId, ActiveWindowIndex::Ptr> indices_;
+};
+
+/**
+ * @brief Per-functor handle that exposes an iterator over nodes that are active or have
+ * just been archived
  */
 struct ActiveWindowTracker {
-  using Ptr = std::unique_ptr<ActiveWindowTracker>;
+  //! Tracker without an index (every node of a layer is in the window)
+  ActiveWindowTracker() = default;
+  //! Tracker that shares an index with other trackers of the same layer
+  explicit ActiveWindowTracker(const ActiveWindowIndex::Ptr& index);
+  ActiveWindowTracker(const ActiveWindowTracker& other);
+  ActiveWindowTracker& operator=(const ActiveWindowTracker& other);
+  ~ActiveWindowTracker();
+
+  //! Share an index with other trackers (no-op if already using the index)
+  void bind(const ActiveWindowIndex::Ptr& index);
 
   /**
    * @brief Get iterator over active window (active nodes plus just-archived nodes)
    */
-  spark_dsg::LayerView view(const SceneGraphLayer& layer) const;
+  ActiveWindowView view(const SceneGraphLayer& layer) const;
   /**
-   * @brief Remove all archived nodes from iteration
+   * @brief Get iterator over the window of the layer in the shared active windows
+   *
+   * Falls back to every node of the layer if there are no active windows
+   */
+  ActiveWindowView view(const SceneGraphLayer& layer, ActiveWindows* windows);
+  /**
+   * @brief Remove all archived nodes from iteration (once every tracker sharing the
+   * index has cleared)
    */
   void clear();
   /**
@@ -58,10 +206,11 @@ struct ActiveWindowTracker {
    */
   void reset();
 
+  inline const ActiveWindowIndex::Ptr& index() const { return index_; }
+
  private:
-  bool isActive(const SceneGraphNode& node) const;
-  mutable std::set<NodeId> to_clear_;
-  mutable std::set<NodeId> prev_active_;
+  ActiveWindowIndex::Ptr index_;
+  size_t consumer_ = 0;
 };
 
 }  // namespace hydra
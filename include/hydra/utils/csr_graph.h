@@ -0,0 +1,98 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <optional>
+
+#include "hydra/common/dsg_types.h"
+
+namespace hydra {
+
+/**
+ * @brief Compact (compressed sparse row) snapshot of a scene graph layer
+ *
+ * Nodes are assigned dense indices in ascending order of their node ID and the
+ * neighbors of each node are stored contiguously (also in ascending order), so
+ * iteration order matches iterating over the layer through ordered containers.
+ * Every undirected edge is stored twice (once per endpoint).
+ */
+struct CsrGraph {
+  using WeightFunc = std::function<double(const SceneGraphLayer&, NodeId, NodeId)>;
+  using NodeFilter = std::function<bool(size_t)>;
+  using EdgeFilter = std::function<bool(size_t, size_t, double)>;
+  using Components = std::vector<std::vector<size_t>>;
+
+  CsrGraph();
+
+  //! Build a snapshot using the edge weights stored in the layer
+  explicit CsrGraph(const SceneGraphLayer& layer);
+
+  //! Build a snapshot using the provided weight function for every edge direction
+  CsrGraph(const SceneGraphLayer& layer, const WeightFunc& weight_func);
+
+  inline size_t numNodes() const { return ids.size(); }
+
+  inline size_t numEdges() const { return neighbors.size() / 2; }
+
+  inline size_t degree(size_t index) const {
+    return offsets[index + 1] - offsets[index];
+  }
+
+  std::optional<size_t> getIndex(NodeId node) const;
+
+  /**
+   * @brief Get the connected components of the graph
+   * @param node_filter Optional filter on node indices (true if node is valid)
+   * @param edge_filter Optional filter on edges (true if edge is valid)
+   * @returns Dense indices of every component in order of discovery
+   */
+  Components getComponents(const NodeFilter& node_filter = {},
+                           const EdgeFilter& edge_filter = {}) const;
+
+  //! Dense index to node ID
+  std::vector<NodeId> ids;
+  //! Node ID to dense index
+  std::unordered_map<NodeId, size_t> indices;
+  //! Start of the neighbors for every node (size is number of nodes + 1)
+  std::vector<size_t> offsets;
+  //! Dense indices of the neighbors of every node
+  std::vector<size_t> neighbors;
+  //! Weight of the edge to every neighbor
+  std::vector<double> weights;
+
+ private:
+  void init(const SceneGraphLayer& layer, const WeightFunc& weight_func);
+};
+
+}  // namespace hydra
@@ -33,6 +33,7 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
+#include <limits>
 #include <optional>
 
 #include "hydra/common/dsg_types.h"
@@ -59,4 +60,32 @@ struct DisjointSet {
   std::unordered_map<NodeId, size_t> sizes;
 };
 
+/**
+ * @brief Disjoint set over dense indices [0, N) (e.g., from a CsrGraph)
+ *
+ * Elements have to be added via addSet before they are part of any set. Union
+ * decisions mirror DisjointSet (by size, with optional external tie-breaking).
+ */
+struct DenseDisjointSet {
+  explicit DenseDisjointSet(size_t num_elements = 0);
+
+  inline bool hasSet(size_t index) const { return parents[index] != kInvalid; }
+
+  size_t findSet(size_t index);
+
+  bool addSet(size_t index);
+
+  std::optional<size_t> doUnion(size_t lhs, size_t rhs, bool rhs_better = false);
+
+  inline size_t size(size_t root) const { return sizes[root]; }
+
+  inline size_t numSets() const { return num_sets; }
+
+  static constexpr size_t kInvalid = std::numeric_limits<size_t>::max();
+
+  std::vector<size_t> parents;
+  std::vector<size_t> sizes;
+  size_t num_sets = 0;
+};
+
 }  // namespace hydra
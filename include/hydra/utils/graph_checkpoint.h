@@ -0,0 +1,158 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hydra/common/dsg_types.h"
+
+namespace hydra {
+
+struct GraphCheckpointOptions {
+  //! Whether to write the mesh (if the graph has one)
+  bool include_mesh = true;
+  //! Whether to compress chunks (ignored when built without zlib)
+  bool compress = true;
+  //! zlib compression level (1 is fastest, 9 is smallest)
+  int compression_level = 1;
+  //! Number of mesh vertices (or faces) per chunk
+  size_t chunk_size = 65536;
+};
+
+/**
+ * @brief Consistent copy of a scene graph that can be written to a checkpoint
+ *
+ * The graph is stored in serialized form (which is also what ends up in the
+ * checkpoint) and the mesh is copied, so that the snapshot can be written by another
+ * thread while the original graph keeps changing.
+ */
+struct GraphSnapshot {
+  using Ptr = std::shared_ptr<GraphSnapshot>;
+  GraphSnapshot(const DynamicSceneGraph& graph, bool include_mesh);
+
+  std::vector<uint8_t> graph_bytes;
+  std::shared_ptr<spark_dsg::Mesh> mesh;
+};
+
+/**
+ * @brief Write a scene graph and mesh to a binary checkpoint file
+ *
+ * Checkpoints consist of a short header and a sequence of chunks (the serialized
+ * graph, the mesh info, vertex chunks and face chunks). Each chunk is encoded,
+ * optionally compressed and written to disk before the next one is encoded.
+ * @returns True if the checkpoint was written successfully
+ */
+bool writeGraphCheckpoint(const std::string& filepath,
+                          const DynamicSceneGraph& graph,
+                          const GraphCheckpointOptions& options = {});
+
+//! Write a previously taken snapshot to a binary checkpoint file
+bool writeGraphCheckpoint(const std::string& filepath,
+                          const GraphSnapshot& snapshot,
+                          const GraphCheckpointOptions& options = {});
+
+/**
+ * @brief Read a scene graph (and mesh) from a binary checkpoint file
+ * @returns The graph or nullptr if the checkpoint could not be read
+ */
+DynamicSceneGraph::Ptr readGraphCheckpoint(const std::string& filepath);
+
+//! Check whether a file starts with a checkpoint header
+bool isGraphCheckpoint(const std::string& filepath);
+
+//! Load a graph from either a binary checkpoint or any format spark_dsg supports
+DynamicSceneGraph::Ptr loadGraph(const std::string& filepath);
+
+/**
+ * @brief Convert a binary checkpoint to the spark_dsg json format
+ * @returns True if the checkpoint could be read
+ */
+bool convertCheckpointToJson(const std::string& checkpoint_path,
+                             const std::string& json_path,
+                             bool include_mesh = true);
+
+/**
+ * @brief Write checkpoints on a background thread
+ *
+ * Saving only takes a snapshot of the graph on the calling thread, so the caller
+ * only needs to hold the graph lock while the graph is serialized and the mesh is
+ * copied. Pending checkpoints are always finished before the writer is destroyed.
+ */
+class GraphCheckpointWriter {
+ public:
+  explicit GraphCheckpointWriter(const GraphCheckpointOptions& options = {});
+
+  ~GraphCheckpointWriter();
+
+  GraphCheckpointWriter(const GraphCheckpointWriter&) = delete;
+
+  GraphCheckpointWriter& operator=(const GraphCheckpointWriter&) = delete;
+
+  //! Snapshot the graph and queue it to be written to the filepath
+  void save(const DynamicSceneGraph& graph, const std::string& filepath);
+
+  //! Snapshot the graph and queue it to be written with non-default options
+  void save(const DynamicSceneGraph& graph,
+            const std::string& filepath,
+            const GraphCheckpointOptions& options);
+
+  //! Block until all queued checkpoints have been written
+  void wait();
+
+  const GraphCheckpointOptions options;
+
+ private:
+  struct Job {
+    std::string filepath;
+    GraphCheckpointOptions options;
+    GraphSnapshot::Ptr snapshot;
+  };
+
+  void spin();
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Job> jobs_;
+  bool writing_ = false;
+  bool should_shutdown_ = false;
+  std::thread thread_;
+};
+
+}  // namespace hydra
@@ -0,0 +1,167 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <set>
+#include <vector>
+
+#include "hydra/common/dsg_types.h"
+
+namespace hydra {
+
+//! Kind of message in a delta-encoded scene graph stream
+enum class GraphDeltaType : uint8_t { KEYFRAME = 0, DELTA = 1 };
+
+struct GraphDeltaHeader {
+  GraphDeltaType type = GraphDeltaType::KEYFRAME;
+  //! Sequence number of this message
+  uint64_t sequence = 0;
+  //! Sequence number of the message this delta applies to
+  uint64_t base_sequence = 0;
+};
+
+/**
+ * @brief Read the header of an encoded keyframe or delta
+ * @returns false if the buffer does not start with a valid header
+ */
+bool readGraphDeltaHeader(const uint8_t* data,
+                          size_t length,
+                          GraphDeltaHeader& header);
+
+/**
+ * @brief Encode a scene graph as a stream of keyframes and deltas
+ *
+ * Keyframes contain the full graph and mesh. Deltas contain the nodes and edges that
+ * were added, changed or removed since the previous message and the mesh blocks that
+ * changed. New and removed nodes and edges are taken from the notifications of the
+ * graph, while changes to attributes and mesh contents have to be marked by the
+ * caller; the encoder never compares the graph or mesh against what it sent. Every
+ * message carries a sequence number so that receivers can detect gaps and request a
+ * resync.
+ */
+class GraphDeltaEncoder {
+ public:
+  struct Config {
+    //! Send a keyframe every N messages (0 only sends keyframes when requested)
+    size_t keyframe_period = 50;
+    //! Number of mesh vertices (or faces) per mesh block
+    size_t mesh_block_size = 2048;
+  } const config;
+
+  explicit GraphDeltaEncoder(const Config& config);
+
+  /**
+   * @brief Encode the changes to the graph since the last encoded message
+   * @param graph Graph to encode (new and removed node and edge notifications are
+   * cleared)
+   * @param include_mesh Whether to include (changed) mesh blocks
+   * @param buffer Output buffer for the encoded message
+   * @returns Header of the encoded message
+   */
+  GraphDeltaHeader encode(DynamicSceneGraph& graph,
+                          bool include_mesh,
+                          std::vector<uint8_t>& buffer);
+
+  //! Make the next encoded message a keyframe
+  void requestKeyframe();
+
+  //! Mark the attributes of a node as changed
+  void markNode(NodeId node);
+
+  //! Mark the attributes of an edge as changed
+  void markEdge(NodeId source, NodeId target);
+
+  //! Mark mesh vertices in [begin, end) as changed (appended vertices are implicit)
+  void markVertices(size_t begin, size_t end);
+
+  //! Mark mesh faces in [begin, end) as changed (appended faces are implicit)
+  void markFaces(size_t begin, size_t end);
+
+  inline uint64_t sequence() const { return sequence_; }
+
+ private:
+  uint64_t sequence_ = 0;
+  bool need_keyframe_ = true;
+  size_t messages_since_keyframe_ = 0;
+
+  // changes since the last message
+  std::set<NodeId> nodes_;
+  std::set<NodeId> removed_nodes_;
+  std::set<EdgeKey> edges_;
+  std::set<EdgeKey> removed_edges_;
+  std::set<size_t> vertex_blocks_;
+  std::set<size_t> face_blocks_;
+
+  // mesh as of the last message that included it
+  bool sent_mesh_ = false;
+  uint8_t mesh_flags_ = 0;
+  size_t num_vertices_ = 0;
+  size_t num_faces_ = 0;
+};
+
+/**
+ * @brief Apply encoded keyframes and deltas to a receiver-side graph
+ */
+class GraphDeltaApplier {
+ public:
+  enum class Status {
+    //! Message was applied
+    APPLIED,
+    //! Message does not follow the last applied message and a keyframe is required
+    NEEDS_KEYFRAME,
+    //! Message could not be decoded
+    INVALID,
+  };
+
+  Status apply(const uint8_t* data, size_t length);
+
+  inline Status apply(const std::vector<uint8_t>& buffer) {
+    return apply(buffer.data(), buffer.size());
+  }
+
+  inline bool synced() const { return synced_; }
+
+  inline uint64_t sequence() const { return sequence_; }
+
+  inline DynamicSceneGraph::Ptr graph() const { return graph_; }
+
+ private:
+  bool synced_ = false;
+  uint64_t sequence_ = 0;
+  DynamicSceneGraph::Ptr graph_;
+};
+
+void declare_config(GraphDeltaEncoder::Config& config);
+
+}  // namespace hydra
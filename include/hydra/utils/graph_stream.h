@@ -0,0 +1,123 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#pragma once
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "hydra/utils/graph_delta.h"
+
+namespace hydra {
+
+/**
+ * @brief Publish a scene graph as a delta-encoded stream over ZMQ
+ *
+ * Messages are sent on a PUB socket. Subscribers that miss a message (or join late)
+ * request a keyframe over a separate PULL socket.
+ */
+class GraphStreamPublisher {
+ public:
+  struct Config {
+    std::string url = "tcp://127.0.0.1:8001";
+    //! Url to receive keyframe requests from subscribers on
+    std::string resync_url = "tcp://127.0.0.1:8003";
+    size_t num_threads = 2;
+    GraphDeltaEncoder::Config encoder;
+  } const config;
+
+  explicit GraphStreamPublisher(const Config& config);
+
+  ~GraphStreamPublisher();
+
+  /**
+   * @brief Encode and send the graph
+   * @returns Header of the sent message
+   */
+  GraphDeltaHeader publish(DynamicSceneGraph& graph, bool include_mesh = true);
+
+  //! Encoder to mark changed nodes, edges and mesh regions with
+  inline GraphDeltaEncoder& encoder() { return encoder_; }
+
+ private:
+  struct Sockets;
+  std::unique_ptr<Sockets> sockets_;
+  GraphDeltaEncoder encoder_;
+  std::vector<uint8_t> buffer_;
+};
+
+/**
+ * @brief Receive a delta-encoded scene graph stream over ZMQ
+ */
+class GraphStreamSubscriber {
+ public:
+  struct Config {
+    std::string url = "tcp://127.0.0.1:8001";
+    //! Url to send keyframe requests to the publisher on
+    std::string resync_url = "tcp://127.0.0.1:8003";
+    size_t num_threads = 2;
+    //! Minimum time between keyframe requests
+    size_t resync_period_ms = 500;
+  } const config;
+
+  explicit GraphStreamSubscriber(const Config& config);
+
+  ~GraphStreamSubscriber();
+
+  /**
+   * @brief Wait for and apply the next message
+   * @param timeout_ms Time to wait for a message
+   * @returns True if a message was received and applied to the graph
+   */
+  bool recv(size_t timeout_ms);
+
+  inline bool synced() const { return applier_.synced(); }
+
+  inline DynamicSceneGraph::Ptr graph() const { return applier_.graph(); }
+
+ private:
+  void requestKeyframe();
+
+  struct Sockets;
+  std::unique_ptr<Sockets> sockets_;
+  GraphDeltaApplier applier_;
+  std::chrono::steady_clock::time_point last_resync_;
+  bool requested_resync_ = false;
+};
+
+void declare_config(GraphStreamPublisher::Config& config);
+
+void declare_config(GraphStreamSubscriber::Config& config);
+
+}  // namespace hydra
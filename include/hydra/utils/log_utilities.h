@@ -52,6 +52,10 @@ struct LogConfig {
   // names. If false create separate directories for separators '/' (default).
   bool log_raw_timers_to_single_dir = false;
 
+  // If true also save scene graphs as binary checkpoints (dsg.hdck) next to the json
+  // files, which are written in the background and include the mesh.
+  bool save_graph_checkpoints = false;
+
   static LogConfig fromString(const std::string& output_path) {
     LogConfig config;
     config.log_dir = output_path;
@@ -50,6 +50,10 @@ bool updateObjectGeometry(const spark_dsg::Mesh& mesh,
                           const std::vector<size_t>* indices = nullptr,
                           std::optional<BoundingBox::Type> type = std::nullopt);
                           
+//! Get the updated blocks of the mesh layer that are not archived
+BlockIndices getActiveBlocks(const MeshLayer& mesh_layer,
+                             const BlockIndices& archived_blocks);
+
 MeshLayer::Ptr getActiveMesh(const MeshLayer& mesh_layer,
                              const BlockIndices& archived_blocks);
 
@@ -33,6 +33,12 @@
  * purposes notwithstanding any copyright notation herein.
  * -------------------------------------------------------------------------- */
 #pragma once
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #include "hydra/common/dsg_types.h"
 
 namespace hydra {
@@ -65,4 +71,68 @@ MinimumSpanningTreeInfo getMinimumSpanningEdges(const SceneGraphLayer& layer);
 MinimumSpanningTreeInfo getMinimumSpanningEdges(const SceneGraphLayer& layer,
                                                 const EdgeFilter& func);
 
+/**
+ * @brief Minimum spanning forest that is updated one edge at a time
+ *
+ * Inserting an edge swaps out the heaviest edge on the tree path between its endpoints
+ * and removing a tree edge reconnects the two halves with the lightest edge leaving
+ * the smaller half, so updates only explore the trees that contain the edge. Ties
+ * between edge weights are broken by node ids.
+ */
+class IncrementalSpanningForest {
+ public:
+  //! Undirected edge (smaller node id first)
+  using Edge = std::pair<NodeId, NodeId>;
+  using Neighbors = std::unordered_map<NodeId, double>;
+
+  //! Add an edge or update the weight of an existing edge
+  void addEdge(NodeId source, NodeId target, double weight);
+
+  void removeEdge(NodeId source, NodeId target);
+
+  //! Remove every edge touching the node
+  void removeNode(NodeId node);
+
+  //! Whether the edge was added (regardless of whether it is part of the forest)
+  bool hasEdge(NodeId source, NodeId target) const;
+
+  bool inForest(NodeId source, NodeId target) const;
+
+  //! Number of forest edges touching the node
+  size_t degree(NodeId node) const;
+
+  //! All added edges touching the node
+  const Neighbors& neighbors(NodeId node) const;
+
+  //! Forest edges touching the node
+  const Neighbors& forestNeighbors(NodeId node) const;
+
+  //! Forest edges
+  std::vector<MinimalEdge> edges() const;
+
+  /**
+   * @brief Get forest edges that were added or removed since the last call
+   *
+   * Edges that were removed and added back (e.g., to update their weight) are not
+   * reported.
+   */
+  void popChanges(std::vector<Edge>& added, std::vector<Edge>& removed);
+
+  void clear();
+
+ private:
+  bool findPath(NodeId source, NodeId target, std::vector<NodeId>& path) const;
+
+  std::unordered_set<NodeId> getSmallerTree(NodeId lhs, NodeId rhs) const;
+
+  void link(NodeId source, NodeId target, double weight);
+
+  void cut(NodeId source, NodeId target);
+
+  std::unordered_map<NodeId, Neighbors> graph_;
+  std::unordered_map<NodeId, Neighbors> forest_;
+  std::set<Edge> added_;
+  std::set<Edge> removed_;
+};
+
 }  // namespace hydra
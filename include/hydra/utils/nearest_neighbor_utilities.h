@@ -41,11 +41,45 @@
 
 namespace hydra {
 
+/**
+ * @brief Dense results of a batch k-nearest-neighbor query.
+ *
+ * Results are stored row-major by query: neighbor j of query i lives at entry
+ * `i * k + j` and only the first `num_found[i]` entries of each row are valid.
+ * Distances are squared. Reusing the same instance across queries avoids
+ * reallocating the result arrays.
+ */
+template <typename Scalar>
+struct NeighborBatch {
+  //! Maximum number of neighbors stored per query
+  size_t k = 0;
+  //! Number of valid neighbors for every query
+  std::vector<size_t> num_found;
+  //! Indices into the search data of every neighbor
+  std::vector<size_t> indices;
+  //! Squared distance to every neighbor
+  std::vector<Scalar> distances;
+
+  size_t size() const { return num_found.size(); }
+
+  size_t index(size_t query, size_t n) const { return indices[query * k + n]; }
+
+  Scalar distance(size_t query, size_t n) const { return distances[query * k + n]; }
+
+  void resize(size_t num_queries, size_t new_k) {
+    k = new_k;
+    num_found.assign(num_queries, 0);
+    indices.resize(num_queries * k);
+    distances.resize(num_queries * k);
+  }
+};
+
 class NearestNodeFinder {
  public:
   using Callback = std::function<void(NodeId, size_t, double)>;
   using Filter = std::function<bool(const SceneGraphNode&)>;
   using Ptr = std::unique_ptr<NearestNodeFinder>;
+  using Queries = Eigen::Matrix<double, 3, Eigen::Dynamic>;
 
   NearestNodeFinder(const SceneGraphLayer& layer, const std::vector<NodeId>& nodes);
 
@@ -66,6 +100,37 @@ class NearestNodeFinder {
                     bool skip_first,
                     const Callback& callback);
 
+  /**
+   * @brief Find the nearest nodes to every column of a matrix of query positions.
+   *
+   * Queries are split into chunks that are processed in parallel. Result indices
+   * can be mapped back to node IDs via nodeId().
+   *
+   * @param positions Query positions (one per column)
+   * @param num_to_find Number of neighbors to find per query
+   * @param skip_first Drop the closest neighbor of every query
+   * @param result Output neighbors for every query
+   * @param num_threads Number of threads to use (-1 uses all available threads)
+   */
+  void findBatch(const Eigen::Ref<const Queries>& positions,
+                 size_t num_to_find,
+                 bool skip_first,
+                 NeighborBatch<double>& result,
+                 int num_threads = 1) const;
+
+  /**
+   * @brief Find the nearest nodes to every query, skipping the closest neighbor
+   * only for queries where skip_first is set.
+   */
+  void findBatch(const Eigen::Ref<const Queries>& positions,
+                 size_t num_to_find,
+                 const std::vector<bool>& skip_first,
+                 NeighborBatch<double>& result,
+                 int num_threads = 1) const;
+
+  //! Get the node ID corresponding to an index returned by a query
+  NodeId nodeId(size_t index) const;
+
   const size_t num_nodes;
 
  private:
@@ -86,6 +151,8 @@ size_t makeSemanticNodeFinders(const SceneGraphLayer& layer,
  */
 class PointNeighborSearch {
  public:
+  using Queries = Eigen::Matrix<float, 3, Eigen::Dynamic>;
+
   explicit PointNeighborSearch(const std::vector<Eigen::Vector3f>& points);
   virtual ~PointNeighborSearch();
 
@@ -101,6 +168,18 @@ class PointNeighborSearch {
               float& distance_squared,
               size_t& index) const;
 
+  /**
+   * @brief Find the k nearest neighbors of every column of a matrix of query points.
+   * @param query_points Query points (one per column)
+   * @param k Number of neighbors to find per query
+   * @param result Output neighbors (indices into the tree data) for every query
+   * @param num_threads Number of threads to use (-1 uses all available threads)
+   */
+  void searchBatch(const Eigen::Ref<const Queries>& query_points,
+                   size_t k,
+                   NeighborBatch<float>& result,
+                   int num_threads = 1) const;
+
  private:
   struct Detail;
   std::unique_ptr<Detail> internals_;
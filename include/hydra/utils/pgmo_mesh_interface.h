@@ -36,10 +36,34 @@
 
 #include <kimera_pgmo/utils/mesh_interface.h>
 
+#include <memory>
+#include <vector>
+
 #include "hydra/reconstruction/voxel_types.h"
 
 namespace hydra {
 
+/**
+ * @brief Contiguous read-only view of the vertex arrays of a mesh (block).
+ */
+struct MeshBlockView {
+  MeshBlockView() = default;
+
+  explicit MeshBlockView(const Mesh& mesh);
+
+  //! Convert a vertex to PGMO format
+  pcl::PointXYZRGBA vertex(size_t index) const;
+
+  //! Number of vertices
+  size_t size = 0;
+  const Mesh::Pos* points = nullptr;
+  //! Vertex colors (nullptr if the mesh has fewer colors than vertices)
+  const Color* colors = nullptr;
+  //! Vertex labels (only the first num_labels vertices have a label)
+  const uint32_t* labels = nullptr;
+  size_t num_labels = 0;
+};
+
 /**
  * @brief Interface for PGMO to access a mesh layer.
  */
@@ -63,7 +87,7 @@ struct PgmoMeshLayerInterface : public kimera_pgmo::MeshInterface {
  private:
   const MeshLayer& mesh_;
   BlockIndices block_indices_;
-  mutable MeshBlock::ConstPtr active_mesh_;
+  mutable MeshBlockView active_view_;
 };
 
 /**
@@ -89,6 +113,79 @@ struct PgmoMeshInterface : public kimera_pgmo::MeshInterface {
  private:
   const Mesh& mesh_;
   BlockIndices block_indices_;
+  MeshBlockView view_;
+};
+
+/**
+ * @brief Vertices of a mesh layer converted once to PGMO format.
+ *
+ * The vertices of every block are packed into contiguous arrays so that several
+ * compression passes over the same mesh (i.e., the mesh delta and the deformation
+ * graph) can share a single traversal of the mesh layer.
+ */
+class PgmoMeshSnapshot {
+ public:
+  using Ptr = std::shared_ptr<const PgmoMeshSnapshot>;
+
+  struct BlockRange {
+    size_t offset = 0;
+    size_t size = 0;
+    size_t num_labels = 0;
+  };
+
+  //! Pack every allocated block of the mesh layer
+  explicit PgmoMeshSnapshot(const MeshLayer& mesh);
+
+  //! Pack the specified blocks of the mesh layer
+  PgmoMeshSnapshot(const MeshLayer& mesh, const BlockIndices& blocks);
+
+  const BlockIndices& blockIndices() const { return block_indices_; }
+
+  const BlockRange* findBlock(const BlockIndex& block) const;
+
+  bool hasSemantics() const { return has_semantics_; }
+
+  size_t numVertices() const { return vertices_.size(); }
+
+  const pcl::PointXYZRGBA& vertex(size_t index) const { return vertices_[index]; }
+
+  uint32_t label(size_t index) const { return labels_[index]; }
+
+ private:
+  BlockIndices block_indices_;
+  BlockIndexMap<BlockRange> blocks_;
+  bool has_semantics_ = false;
+  std::vector<pcl::PointXYZRGBA> vertices_;
+  std::vector<uint32_t> labels_;
+};
+
+/**
+ * @brief Interface for PGMO to access (a subset of the blocks of) a mesh snapshot.
+ */
+struct PgmoMeshSnapshotInterface : public kimera_pgmo::MeshInterface {
+  explicit PgmoMeshSnapshotInterface(const PgmoMeshSnapshot::Ptr& snapshot);
+
+  PgmoMeshSnapshotInterface(const PgmoMeshSnapshot::Ptr& snapshot,
+                            const BlockIndices& blocks);
+
+  const BlockIndices& blockIndices() const override;
+
+  void markBlockActive(const BlockIndex& block) const override;
+
+  size_t activeBlockSize() const override;
+
+  pcl::PointXYZRGBA getActiveVertex(size_t index) const override;
+
+  bool hasSemantics() const override;
+
+  std::optional<uint32_t> getActiveSemantics(size_t index) const override;
+
+  kimera_pgmo::MeshInterface::Ptr clone() const override;
+
+ private:
+  PgmoMeshSnapshot::Ptr snapshot_;
+  BlockIndices block_indices_;
+  mutable PgmoMeshSnapshot::BlockRange active_block_;
 };
 
 }  // namespace hydra
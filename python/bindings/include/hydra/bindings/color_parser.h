@@ -44,7 +44,8 @@ struct ColorParser {
 
   virtual ~ColorParser() = default;
 
-  virtual cv::Vec3b read(const PythonImage& img, size_t row, size_t col) const = 0;
+  //! Convert a row of the image into the provided output buffer (of length cols)
+  virtual void readRow(const PythonImage& img, size_t row, cv::Vec3b* output) const = 0;
 
   static Ptr create(const PythonImage& img);
 };
@@ -44,7 +44,8 @@ struct DepthParser {
 
   virtual ~DepthParser() = default;
 
-  virtual float read(const PythonImage& img, size_t row, size_t col) const = 0;
+  //! Convert a row of the image into the provided output buffer (of length cols)
+  virtual void readRow(const PythonImage& img, size_t row, float* output) const = 0;
 
   static Ptr create(const PythonImage& img);
 };
@@ -44,7 +44,8 @@ struct LabelParser {
 
   virtual ~LabelParser() = default;
 
-  virtual int32_t read(const PythonImage& img, size_t row, size_t col) const = 0;
+  //! Convert a row of the image into the provided output buffer (of length cols)
+  virtual void readRow(const PythonImage& img, size_t row, int32_t* output) const = 0;
 
   static Ptr create(const PythonImage& img);
 };
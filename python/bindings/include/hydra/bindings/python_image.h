@@ -35,7 +35,10 @@
 #pragma once
 #include <pybind11/pybind11.h>
 
+#include <cstdint>
+#include <cstring>
 #include <opencv2/core/mat.hpp>
+#include <vector>
 
 namespace hydra::python {
 
@@ -66,7 +69,51 @@ class PythonImage {
 
   const std::string& format() const { return img_.format; }
 
+  //! Whether the channels of every pixel in a row are densely packed
+  bool rowContiguous() const {
+    const size_t itemsize = img_.itemsize;
+    return col_stride_ == channels_ * itemsize &&
+           (channels_ == 1 || channel_stride_ == itemsize);
+  }
+
+  //! Whether the image is densely packed in row-major order (i.e., C-contiguous)
+  bool contiguous() const {
+    return rowContiguous() && row_stride_ == cols_ * col_stride_;
+  }
+
+  /**
+   * @brief Get the interleaved channel values of a row as a contiguous array.
+   *
+   * Points directly into the buffer when the row is contiguous and aligned, and
+   * otherwise copies the values into the provided scratch space.
+   */
+  template <typename T>
+  const T* row(size_t r, std::vector<T>& scratch) const {
+    const auto row_ptr = ptr(r, 0);
+    if (rowContiguous() && reinterpret_cast<uintptr_t>(row_ptr) % alignof(T) == 0) {
+      return reinterpret_cast<const T*>(row_ptr);
+    }
+
+    scratch.resize(cols_ * channels_);
+    for (size_t c = 0; c < cols_; ++c) {
+      for (size_t i = 0; i < channels_; ++i) {
+        std::memcpy(&scratch[c * channels_ + i], ptr(r, c, i), sizeof(T));
+      }
+    }
+
+    return scratch.data();
+  }
+
+  /**
+   * @brief Wrap the buffer in a cv::Mat without copying.
+   *
+   * The python object exporting the buffer is kept alive for as long as the
+   * returned matrix (or any copy of it) exists. Requires a contiguous image.
+   */
+  cv::Mat wrap(int mat_type) const;
+
  protected:
+  const pybind11::buffer buffer_;
   const pybind11::buffer_info img_;
   bool valid_;
   size_t rows_;
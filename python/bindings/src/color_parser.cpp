@@ -42,70 +42,57 @@ namespace hydra::python {
 
 template <typename T>
 struct MonoParserImpl : ColorParser {
-  cv::Vec3b read(const PythonImage& img, size_t row, size_t col) const override;
+  void readRow(const PythonImage& img, size_t row, cv::Vec3b* output) const override {
+    const auto values = img.row(row, scratch_);
+    for (size_t c = 0; c < img.cols(); ++c) {
+      const auto value = toIntensity(values[c]);
+      output[c] = {value, value, value};
+    }
+  }
+
+  static uint8_t toIntensity(T value);
+
+  mutable std::vector<T> scratch_;
 };
 
 template <>
-cv::Vec3b MonoParserImpl<uint8_t>::read(const PythonImage& img,
-                                        size_t row,
-                                        size_t col) const {
-  uint8_t value;
-  std::memcpy(&value, img.ptr(row, col), sizeof(value));
-  return {value, value, value};
+uint8_t MonoParserImpl<uint8_t>::toIntensity(uint8_t value) {
+  return value;
 }
 
 template <>
-cv::Vec3b MonoParserImpl<uint16_t>::read(const PythonImage& img,
-                                         size_t row,
-                                         size_t col) const {
-  uint16_t value;
-  std::memcpy(&value, img.ptr(row, col), sizeof(value));
-  const auto int_value = cv::saturate_cast<uint8_t>(value / 255);
-  return {int_value, int_value, int_value};
+uint8_t MonoParserImpl<uint16_t>::toIntensity(uint16_t value) {
+  return cv::saturate_cast<uint8_t>(value / 255);
 }
 
 template <>
-cv::Vec3b MonoParserImpl<float>::read(const PythonImage& img,
-                                      size_t row,
-                                      size_t col) const {
-  float value;
-  std::memcpy(&value, img.ptr(row, col), sizeof(value));
-  const auto int_value = cv::saturate_cast<uint8_t>(value * 255);
-  return {int_value, int_value, int_value};
+uint8_t MonoParserImpl<float>::toIntensity(float value) {
+  return cv::saturate_cast<uint8_t>(value * 255);
 }
 
 template <typename T>
 struct RgbParserImpl : ColorParser {
-  cv::Vec3b read(const PythonImage& img, size_t row, size_t col) const override;
-};
+  void readRow(const PythonImage& img, size_t row, cv::Vec3b* output) const override;
 
-template <typename T>
-T readPixelChannel(const PythonImage& img, size_t row, size_t col, size_t channel) {
-  T value;
-  std::memcpy(&value, img.ptr(row, col, channel), sizeof(value));
-  return value;
-}
+  mutable std::vector<T> scratch_;
+};
 
 template <>
-cv::Vec3b RgbParserImpl<uint8_t>::read(const PythonImage& img,
-                                       size_t row,
-                                       size_t col) const {
-  cv::Vec3b pixel;
-  pixel[0] = readPixelChannel<uint8_t>(img, row, col, 0);
-  pixel[1] = readPixelChannel<uint8_t>(img, row, col, 1);
-  pixel[2] = readPixelChannel<uint8_t>(img, row, col, 2);
-  return pixel;
+void RgbParserImpl<uint8_t>::readRow(const PythonImage& img,
+                                     size_t row,
+                                     cv::Vec3b* output) const {
+  std::memcpy(output, img.row(row, scratch_), 3 * img.cols());
 }
 
 template <>
-cv::Vec3b RgbParserImpl<float>::read(const PythonImage& img,
-                                     size_t row,
-                                     size_t col) const {
-  cv::Vec3b p;
-  p[0] = cv::saturate_cast<uint8_t>(255 * readPixelChannel<float>(img, row, col, 0));
-  p[1] = cv::saturate_cast<uint8_t>(255 * readPixelChannel<float>(img, row, col, 1));
-  p[2] = cv::saturate_cast<uint8_t>(255 * readPixelChannel<float>(img, row, col, 2));
-  return p;
+void RgbParserImpl<float>::readRow(const PythonImage& img,
+                                   size_t row,
+                                   cv::Vec3b* output) const {
+  const auto values = img.row(row, scratch_);
+  auto out = reinterpret_cast<uint8_t*>(output);
+  for (size_t i = 0; i < 3 * img.cols(); ++i) {
+    out[i] = cv::saturate_cast<uint8_t>(255 * values[i]);
+  }
 }
 
 ColorParser::Ptr ColorParser::create(const PythonImage& img) {
@@ -36,35 +36,35 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+
 namespace py = pybind11;
 
 namespace hydra::python {
 
 template <typename T>
 struct DepthParserImpl : DepthParser {
-  float read(const PythonImage& img, size_t row, size_t col) const override;
+  void readRow(const PythonImage& img, size_t row, float* output) const override;
+
+  mutable std::vector<T> scratch_;
 };
 
 template <>
-float DepthParserImpl<float>::read(const PythonImage& img,
-                                   size_t row,
-                                   size_t col) const {
-  float value;
-  std::memcpy(&value, img.ptr(row, col), sizeof(value));
-  return value;
+void DepthParserImpl<float>::readRow(const PythonImage& img,
+                                     size_t row,
+                                     float* output) const {
+  std::copy_n(img.row(row, scratch_), img.cols(), output);
 }
 
 template <>
-float DepthParserImpl<uint16_t>::read(const PythonImage& img,
-                                      size_t row,
-                                      size_t col) const {
-  uint16_t value;
-  std::memcpy(&value, img.ptr(row, col), sizeof(value));
-  if (value == 0) {
-    return std::numeric_limits<float>::quiet_NaN();
+void DepthParserImpl<uint16_t>::readRow(const PythonImage& img,
+                                        size_t row,
+                                        float* output) const {
+  const auto values = img.row(row, scratch_);
+  for (size_t c = 0; c < img.cols(); ++c) {
+    output[c] =
+        values[c] == 0 ? std::numeric_limits<float>::quiet_NaN() : 1.0e-3f * values[c];
   }
-
-  return 1.0e-3f * value;
 }
 
 DepthParser::Ptr DepthParser::create(const PythonImage& img) {
@@ -36,17 +36,22 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+
 namespace py = pybind11;
 
 namespace hydra::python {
 
 template <typename T>
 struct LabelParserImpl : LabelParser {
-  int32_t read(const PythonImage& img, size_t row, size_t col) const override {
-    T value;
-    std::memcpy(&value, img.ptr(row, col), sizeof(value));
-    return static_cast<int32_t>(value);
+  void readRow(const PythonImage& img, size_t row, int32_t* output) const override {
+    const auto values = img.row(row, scratch_);
+    std::transform(values, values + img.cols(), output, [](T value) {
+      return static_cast<int32_t>(value);
+    });
   }
+
+  mutable std::vector<T> scratch_;
 };
 
 LabelParser::Ptr LabelParser::create(const PythonImage& img) {
@@ -37,6 +37,8 @@
 #include <glog/logging.h>
 #include <pybind11/stl.h>
 
+#include <mutex>
+
 #include "hydra/bindings/color_parser.h"
 #include "hydra/bindings/depth_parser.h"
 #include "hydra/bindings/label_parser.h"
@@ -60,10 +62,88 @@ std::string getShapeStr(const std::vector<ssize_t>& shape) {
   return ss.str();
 }
 
+namespace {
+
+// Ties the lifetime of wrapped matrices to the python object that exports the
+// buffer (the same approach the OpenCV python bindings use for numpy arrays).
+// Matrices released by threads that do not hold the GIL queue the object, which
+// is then released the next time a buffer is wrapped.
+class PythonBufferAllocator : public cv::MatAllocator {
+ public:
+  cv::UMatData* allocate(int dims,
+                         const int* sizes,
+                         int type,
+                         void* data,
+                         size_t* step,
+                         cv::AccessFlag flags,
+                         cv::UMatUsageFlags usage) const override {
+    return cv::Mat::getStdAllocator()->allocate(
+        dims, sizes, type, data, step, flags, usage);
+  }
+
+  bool allocate(cv::UMatData* data,
+                cv::AccessFlag flags,
+                cv::UMatUsageFlags usage) const override {
+    return cv::Mat::getStdAllocator()->allocate(data, flags, usage);
+  }
+
+  void deallocate(cv::UMatData* data) const override {
+    if (!data) {
+      return;
+    }
+
+    auto obj = static_cast<PyObject*>(data->userdata);
+    if (PyGILState_Check()) {
+      Py_XDECREF(obj);
+    } else {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_.push_back(obj);
+    }
+
+    delete data;
+  }
+
+  // requires the GIL
+  cv::UMatData* track(const py::handle& obj, uint8_t* data, size_t size) const {
+    releasePending();
+    auto u = new cv::UMatData(this);
+    u->data = data;
+    u->origdata = data;
+    u->size = size;
+    u->userdata = obj.inc_ref().ptr();
+    return u;
+  }
+
+ private:
+  void releasePending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto obj : pending_) {
+      Py_XDECREF(obj);
+    }
+    pending_.clear();
+  }
+
+  mutable std::mutex mutex_;
+  mutable std::vector<PyObject*> pending_;
+};
+
+PythonBufferAllocator& bufferAllocator() {
+  // intentionally leaked so matrices can be released during shutdown
+  static auto allocator = new PythonBufferAllocator();
+  return *allocator;
+}
+
+}  // namespace
+
 PythonImage::PythonImage() : valid_(false), rows_(0), cols_(0), channels_(0) {}
 
 PythonImage::PythonImage(const pybind11::buffer& img)
-    : img_(img.request()), valid_(false), rows_(0), cols_(0), channels_(0) {
+    : buffer_(img),
+      img_(img.request()),
+      valid_(false),
+      rows_(0),
+      cols_(0),
+      channels_(0) {
   std::vector<ssize_t> shape;
   std::vector<ssize_t> indices;
   for (ssize_t i = 0; i < img_.ndim; ++i) {
@@ -90,6 +170,18 @@ PythonImage::PythonImage(const pybind11::buffer& img)
   valid_ = true;
 }
 
+cv::Mat PythonImage::wrap(int mat_type) const {
+  CHECK(valid_ && contiguous()) << "only contiguous images can be wrapped";
+  CHECK_EQ(static_cast<size_t>(CV_ELEM_SIZE(mat_type)), col_stride_);
+  auto data = const_cast<uint8_t*>(ptr(0, 0));
+  cv::Mat mat(rows_, cols_, mat_type, data, row_stride_);
+  auto& allocator = bufferAllocator();
+  mat.u = allocator.track(buffer_, data, rows_ * row_stride_);
+  mat.allocator = &allocator;
+  mat.addref();
+  return mat;
+}
+
 template <typename Parser>
 cv::Mat getImage(const PythonImage& img) {
   if (!img) {
@@ -102,11 +194,16 @@ cv::Mat getImage(const PythonImage& img) {
     return {};
   }
 
+  // buffers that already match the output layout are shared instead of copied
+  using Channel = typename cv::DataType<typename Parser::Element>::channel_type;
+  if (img.contiguous() && img.channels() == CV_MAT_CN(Parser::MatType) &&
+      img.format() == py::format_descriptor<Channel>::format()) {
+    return img.wrap(Parser::MatType);
+  }
+
   cv::Mat mat(img.rows(), img.cols(), Parser::MatType);
   for (size_t r = 0; r < img.rows(); ++r) {
-    for (size_t c = 0; c < img.cols(); ++c) {
-      mat.at<typename Parser::Element>(r, c) = parser->read(img, r, c);
-    }
+    parser->readRow(img, r, mat.ptr<typename Parser::Element>(r));
   }
 
   return mat;
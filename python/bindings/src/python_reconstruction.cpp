@@ -54,6 +54,7 @@
 #include "hydra/bindings/python_config.h"
 #include "hydra/bindings/python_image.h"
 #include "hydra/bindings/python_sensor_input.h"
+#include "hydra/utils/graph_stream.h"
 #include "hydra/utils/mesh_utilities.h"
 #include "hydra/utils/pgmo_mesh_interface.h"
 #include "hydra/utils/pgmo_mesh_traits.h"
@@ -64,6 +65,9 @@ struct PythonReconstructionConfig {
   int verbosity = 1;
   bool visualize_mesh = true;
   std::string zmq_url = "tcp://127.0.0.1:8001";
+  //! Stream delta-encoded updates instead of the full graph every step
+  bool zmq_send_deltas = false;
+  std::string zmq_resync_url = "tcp://127.0.0.1:8003";
 };
 
 void declare_config(PythonReconstructionConfig& conf) {
@@ -72,15 +76,23 @@ void declare_config(PythonReconstructionConfig& conf) {
   field(conf.verbosity, "verbosity");
   field(conf.visualize_mesh, "visualize_mesh");
   field(conf.zmq_url, "zmq_url");
+  field(conf.zmq_send_deltas, "zmq_send_deltas");
+  field(conf.zmq_resync_url, "zmq_resync_url");
 }
 
 struct MeshUpdater {
-  MeshUpdater(double voxel_size, const std::string& url)
-      : compression(voxel_size / 4.0),
-        queue(new ReconstructionModule::OutputQueue()),
-        zmq_sender(url, 2) {
+  MeshUpdater(double voxel_size, const PythonReconstructionConfig& config)
+      : compression(voxel_size / 4.0), queue(new ReconstructionModule::OutputQueue()) {
     graph.reset(new DynamicSceneGraph(DynamicSceneGraph::LayerIds{2, 3, 4, 5}));
     graph->setMesh(std::make_shared<Mesh>());
+    if (config.zmq_send_deltas) {
+      GraphStreamPublisher::Config stream_config;
+      stream_config.url = config.zmq_url;
+      stream_config.resync_url = config.zmq_resync_url;
+      zmq_publisher = std::make_unique<GraphStreamPublisher>(stream_config);
+    } else {
+      zmq_sender = std::make_unique<ZmqSender>(config.zmq_url, 2);
+    }
   }
 
   void spin() {
@@ -100,15 +112,18 @@ struct MeshUpdater {
       return;
     }
 
-    auto mesh = getActiveMesh(msg->map().getMeshLayer(), msg->archived_blocks);
-    if (!mesh) {
-      return;
-    }
-
-    auto interface = PgmoMeshLayerInterface(*mesh);
+    // pack the active blocks directly instead of copying them into a new layer
+    const auto& mesh_layer = msg->map().getMeshLayer();
+    const auto blocks = getActiveBlocks(mesh_layer, msg->archived_blocks);
+    auto interface = PgmoMeshSnapshotInterface(
+        std::make_shared<PgmoMeshSnapshot>(mesh_layer, blocks));
     const auto delta = compression.update(interface, msg->timestamp_ns);
     delta->updateMesh(*graph->mesh());
-    zmq_sender.send(*graph, true);
+    if (zmq_publisher) {
+      zmq_publisher->publish(*graph, true);
+    } else {
+      zmq_sender->send(*graph, true);
+    }
   }
 
  public:
@@ -117,7 +132,8 @@ struct MeshUpdater {
   std::shared_ptr<spark_dsg::DynamicSceneGraph> graph;
   std::vector<uint64_t> mesh_timestamps;
   ReconstructionModule::OutputQueue::Ptr queue;
-  ZmqSender zmq_sender;
+  std::unique_ptr<ZmqSender> zmq_sender;
+  std::unique_ptr<GraphStreamPublisher> zmq_publisher;
 };
 
 PythonReconstruction::PythonReconstruction(const PipelineConfig& hydra_config,
@@ -133,7 +149,7 @@ PythonReconstruction::PythonReconstruction(const PipelineConfig& hydra_config,
 
   ReconstructionModule::OutputQueue::Ptr queue;
   if (py_config.visualize_mesh) {
-    mesh_updater_.reset(new MeshUpdater(map_config.voxel_size, py_config.zmq_url));
+    mesh_updater_.reset(new MeshUpdater(map_config.voxel_size, py_config));
     mesh_thread_.reset(new std::thread(&MeshUpdater::spin, mesh_updater_.get()));
     queue = mesh_updater_->queue;
   }
@@ -38,6 +38,8 @@
 #include <pybind11/eigen.h>
 #include <pybind11/stl.h>
 
+#include <cstring>
+
 namespace hydra::python {
 
 std::string showDim(const PythonImage& img) {
@@ -90,28 +92,21 @@ PythonSensorInput::PythonSensorInput(uint64_t timestamp_ns,
     labels_empty = true;
   }
 
-  points = cv::Mat(1, pos_vec.cols(), CV_32FC3);
+  // eigen matrices are column-major, so each point (color) is contiguous and the
+  // matrices map directly onto the interleaved channels of a single-row cv::Mat
+  const auto num_points = pos_vec.cols();
+  points = cv::Mat(1, num_points, CV_32FC3);
+  Eigen::Map<Eigen::Matrix3Xf>(points.ptr<float>(), 3, num_points) =
+      pos_vec.cast<float>();
+
   if (!colors_empty) {
-    color = cv::Mat(1, pos_vec.cols(), CV_8UC3);
-  }
-  if (!labels_empty) {
-    labels = cv::Mat(1, pos_vec.cols(), CV_32SC1);
+    color = cv::Mat(1, num_points, CV_8UC3);
+    std::memcpy(color.data, color_vec.data(), 3 * num_points);
   }
 
-  for (int i = 0; i < pos_vec.cols(); ++i) {
-    const auto& point = pos_vec.block<3, 1>(0, i);
-    points.at<cv::Vec3f>(0, i) = {static_cast<float>(point.x()),
-                                  static_cast<float>(point.y()),
-                                  static_cast<float>(point.z())};
-
-    if (!colors_empty) {
-      const auto& rgb = color_vec.block<3, 1>(0, i);
-      color.at<cv::Vec3b>(0, i) = {rgb.x(), rgb.y(), rgb.z()};
-    }
-
-    if (!labels_empty) {
-      labels.at<int32_t>(0, i) = label_vec(0, i);
-    }
+  if (!labels_empty) {
+    labels = cv::Mat(1, num_points, CV_32SC1);
+    std::memcpy(labels.data, label_vec.data(), sizeof(int32_t) * num_points);
   }
 }
 
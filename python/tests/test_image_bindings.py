@@ -135,3 +135,42 @@ def test_unsqueeze_tensor():
         np.newaxis,
     ]
     assert (_get_color_image(valid_image) == expected).all()
+
+
+def test_strided_parsing():
+    """Test that non-contiguous images are parsed correctly."""
+    labels_in = np.arange(200, dtype=np.int32).reshape((10, 20))[::2, 1::2]
+    assert (np.array(_get_label_image(labels_in)) == labels_in).all()
+
+    depth_in = (np.arange(200, dtype=np.uint16).reshape((10, 20)) + 1).T
+    depth_out = np.array(_get_depth_image(depth_in))
+    assert depth_out.shape == (20, 10)
+    assert depth_out == pytest.approx(depth_in * 1.0e-3)
+
+    bgr = np.stack(
+        (_get_img(np.uint8) + 1, _get_img(np.uint8) + 2, _get_img(np.uint8) + 3),
+        axis=-1,
+    )
+    rgb_in = bgr[:, :, ::-1]
+    assert (np.array(_get_color_image(rgb_in)) == rgb_in).all()
+
+    mono_in = np.arange(200, dtype=np.uint8).reshape((10, 20))[:, ::4]
+    expected = np.stack((mono_in, mono_in, mono_in), axis=-1)
+    assert (np.array(_get_color_image(mono_in)) == expected).all()
+
+
+def test_zero_copy_parsing():
+    """Test that images already in the right format share memory with the input."""
+    depth_in = np.arange(50, dtype=np.float32).reshape((5, 10))
+    depth_out = np.asarray(_get_depth_image(depth_in))
+    depth_in[0, 0] = 100.0
+    assert depth_out[0, 0] == pytest.approx(100.0)
+
+    # the wrapped image keeps the input buffer alive
+    depth_out = np.asarray(_get_depth_image(np.ones((5, 10), dtype=np.float32)))
+    assert depth_out == pytest.approx(np.ones((5, 10)))
+
+    labels_in = np.arange(50, dtype=np.int32).reshape((5, 10))
+    labels_out = np.asarray(_get_label_image(labels_in))
+    labels_in[1, 1] = -5
+    assert labels_out[1, 1] == -5
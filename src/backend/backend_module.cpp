@@ -45,6 +45,9 @@
 #include <spark_dsg/scene_graph_types.h>
 #include <spark_dsg/zmq_interface.h>
 
+#include <algorithm>
+#include <future>
+
 #include "hydra/backend/backend_utilities.h"
 #include "hydra/backend/update_agents_functor.h"
 #include "hydra/backend/update_frontiers_functor.h"
@@ -54,7 +57,6 @@
 #include "hydra/common/config_utilities.h"
 #include "hydra/common/global_info.h"
 #include "hydra/rooms/room_finder.h"
-#include "hydra/utils/minimum_spanning_tree.h"
 #include "hydra/utils/pgmo_mesh_traits.h"
 #include "hydra/utils/timing_utilities.h"
 
@@ -78,10 +80,16 @@ void declare_config(BackendModule::Config& config) {
   field(config.pgmo, "pgmo");
   field(config.use_2d_places, "use_2d_places");
   field(config.places2d_config, "places2d_config");
+  field(config.incremental_solver, "incremental_solver");
+  field(config.mesh_deformation, "mesh_deformation");
 
   enter_namespace("dsg");
   field(config.add_places_to_deformation_graph, "add_places_to_deformation_graph");
   field(config.optimize_on_lc, "optimize_on_lc");
+  field(config.async_optimization, "async_optimization");
+  field(config.incremental_optimization, "incremental_optimization");
+  field(config.parallel_mesh_deformation, "parallel_mesh_deformation");
+  field(config.concurrent_layer_updates, "concurrent_layer_updates");
   field(config.enable_node_merging, "enable_node_merging");
   field<LayerMapConversion<bool>>(config.merge_update_map, "merge_update_map");
   field(config.merge_update_dynamic, "merge_update_dynamic");
@@ -89,6 +97,7 @@ void declare_config(BackendModule::Config& config) {
   field(config.places_merge_distance_tolerance_m, "places_merge_distance_tolerance_m");
   field(config.use_mesh_subscribers, "use_mesh_subscribers");
   field(config.enable_merge_undos, "enable_merge_undos");
+  field(config.merge_compaction_period, "merge_compaction_period");
   field(config.use_active_flag_for_updates, "use_active_flag_for_updates");
   field(config.num_neighbors_to_find_for_merge, "num_neighbors_to_find_for_merge");
   field(config.zmq_send_url, "zmq_send_url");
@@ -97,6 +106,9 @@ void declare_config(BackendModule::Config& config) {
   field(config.zmq_num_threads, "zmq_num_threads");
   field(config.zmq_poll_time_ms, "zmq_poll_time_ms");
   field(config.zmq_send_mesh, "zmq_send_mesh");
+  field(config.zmq_send_deltas, "zmq_send_deltas");
+  field(config.zmq_resync_url, "zmq_resync_url");
+  field(config.zmq_delta_encoder, "zmq_delta_encoder");
 }
 
 BackendModule::BackendModule(const Config& config,
@@ -137,11 +149,34 @@ BackendModule::BackendModule(const Config& config,
 
   setupDefaultFunctors();
 
+  place_graph_ = std::make_unique<PlaceDeformationGraph>(
+      GlobalInfo::instance().getRobotPrefix().vertex_key,
+      config.pgmo.place_mesh_variance,
+      config.pgmo.place_edge_variance);
+
+  if (config.incremental_optimization) {
+    incremental_solver_ =
+        std::make_unique<IncrementalSolver>(config.incremental_solver);
+  }
+
+  if (config.parallel_mesh_deformation) {
+    resetMeshDeformer();
+  }
+
   if (config.use_zmq_interface) {
     zmq_receiver_.reset(
         new spark_dsg::ZmqReceiver(config.zmq_recv_url, config.zmq_num_threads));
-    zmq_sender_.reset(
-        new spark_dsg::ZmqSender(config.zmq_send_url, config.zmq_num_threads));
+    if (config.zmq_send_deltas) {
+      GraphStreamPublisher::Config stream_config;
+      stream_config.url = config.zmq_send_url;
+      stream_config.resync_url = config.zmq_resync_url;
+      stream_config.num_threads = config.zmq_num_threads;
+      stream_config.encoder = config.zmq_delta_encoder;
+      zmq_publisher_ = std::make_unique<GraphStreamPublisher>(stream_config);
+    } else {
+      zmq_sender_.reset(
+          new spark_dsg::ZmqSender(config.zmq_send_url, config.zmq_num_threads));
+    }
   }
 }
 
@@ -150,6 +185,10 @@ BackendModule::~BackendModule() { stopImpl(); }
 void BackendModule::start() {
   spin_thread_.reset(new std::thread(&BackendModule::spin, this));
 
+  if (config.optimize_on_lc && config.async_optimization) {
+    optimizer_thread_.reset(new std::thread(&BackendModule::runOptimizer, this));
+  }
+
   if (config.use_zmq_interface) {
     zmq_thread_.reset(new std::thread(&BackendModule::runZmqUpdates, this));
   }
@@ -166,6 +205,8 @@ void BackendModule::stopImpl() {
     VLOG(2) << "[Hydra Backend] stopped!";
   }
 
+  stopOptimizer();
+
   if (zmq_thread_) {
     VLOG(2) << "[Hydra Backend] joining zmq thread and stopping";
     zmq_thread_->join();
@@ -180,10 +221,17 @@ void BackendModule::stop() { stopImpl(); }
 
 void BackendModule::save(const LogSetup& log_setup) {
   std::lock_guard<std::mutex> lock(mutex_);
+  waitForOptimizer();
+  // factors deferred while optimizing are part of the saved deformation graph
+  applyPendingInputs();
   const auto backend_path = log_setup.getLogDir("backend");
   const auto pgmo_path = log_setup.getLogDir("backend/pgmo");
   private_dsg_->graph->save(backend_path + "/dsg.json", false);
   private_dsg_->graph->save(backend_path + "/dsg_with_mesh.json");
+  if (log_setup.config().save_graph_checkpoints) {
+    // graph and mesh are written in the background from a snapshot
+    checkpoint_writer_.save(*private_dsg_->graph, backend_path + "/dsg.hdck");
+  }
   savePoseGraphSparseMapping(pgmo_path + "/sparsification_mapping.txt");
 
   const auto& prefix = GlobalInfo::instance().getRobotPrefix();
@@ -267,8 +315,16 @@ void BackendModule::spinOnce(const BackendInput& input, bool force_update) {
   std::lock_guard<std::mutex> lock(mutex_);
 
   ScopedTimer timer("backend/update", input.timestamp_ns);
-  updateFactorGraph(input);
-  updateFromLcdQueue();
+  last_timestamp_ns_ = input.timestamp_ns;
+  if (optimizer_thread_ && optimizerBusy()) {
+    // the optimizer owns the deformation graph until it finishes
+    pending_inputs_.push_back(input);
+  } else {
+    applyPendingInputs();
+    updateFactorGraph(input);
+    updateFromLcdQueue();
+  }
+
   status_.total_loop_closures = num_loop_closures_;
 
   if (!config.use_mesh_subscribers) {
@@ -286,7 +342,11 @@ void BackendModule::spinOnce(const BackendInput& input, bool force_update) {
 
   timer.reset("backend/spin"); 
   if (config.optimize_on_lc && have_loopclosures_) {
-    optimize(input.timestamp_ns);
+    if (optimizer_thread_) {
+      optimizeAsync(input.timestamp_ns);
+    } else {
+      optimize(input.timestamp_ns);
+    }
   } else {
     updateDsgMesh(input.timestamp_ns);
     callUpdateFunctions(input.timestamp_ns);
@@ -299,12 +359,21 @@ void BackendModule::spinOnce(const BackendInput& input, bool force_update) {
   if (zmq_sender_) {
     zmq_sender_->send(*private_dsg_->graph, config.zmq_send_mesh);
   }
-  ScopedTimer sink_timer("backend/sinks", input.timestamp_ns);
-  Sink::callAll(sinks_, input.timestamp_ns, *private_dsg_->graph, *deformation_graph_);
+
+  if (zmq_publisher_) {
+    zmq_publisher_->publish(*private_dsg_->graph, config.zmq_send_mesh);
+  }
+
+  callSinks(input.timestamp_ns);
+  if (optimizer_thread_ && config.optimize_on_lc && have_loopclosures_) {
+    // launched after the sinks so that the solve overlaps the next input
+    launchOptimization(input.timestamp_ns);
+  }
 }
 
 void BackendModule::loadState(const std::string& state_path,
                               const std::string& dgrf_path) {
+  std::lock_guard<std::mutex> lock(mutex_);
   const std::string mesh_path = state_path + "/mesh.ply";
 
   auto mesh = std::make_shared<spark_dsg::Mesh>();
@@ -312,11 +381,52 @@ void BackendModule::loadState(const std::string& state_path,
   private_dsg_->graph->setMesh(mesh);
   have_new_mesh_ = true;
 
+  waitForOptimizer();
   loadDeformationGraphFromFile(dgrf_path);
+  if (incremental_solver_) {
+    incremental_solver_->invalidate();
+  }
+
+  // the loaded graph has no place structures
+  place_structures_stale_ = true;
+  const auto vertex_key = GlobalInfo::instance().getRobotPrefix().vertex_key;
+  const auto positions = deformation_graph_->getInitialPositionsVertices(vertex_key);
+  for (size_t i = 0; i < positions.size(); ++i) {
+    place_graph_->addVertex(i, positions[i]);
+  }
+
+  if (mesh_deformer_) {
+    resetMeshDeformer();
+  }
+
   LOG(WARNING) << "Loaded " << deformation_graph_->getNumVertices()
                << " vertices for deformation graph";
 }
 
+void BackendModule::resetMeshDeformer() {
+  mesh_deformer_ =
+      std::make_unique<MeshDeformer>(config.mesh_deformation,
+                                     KimeraPgmoInterface::config_.num_interp_pts,
+                                     KimeraPgmoInterface::config_.interp_horizon);
+  if (!deformation_graph_->getNumVertices()) {
+    return;
+  }
+
+  // mesh graph nodes are keyed by their index, so control points can be rebuilt
+  // from the initial vertex positions and stamps of the deformation graph
+  const auto vertex_key = GlobalInfo::instance().getRobotPrefix().vertex_key;
+  const auto positions = deformation_graph_->getInitialPositionsVertices(vertex_key);
+  const auto stamps = deformation_graph_->getVertexStamps(vertex_key);
+  CHECK_EQ(positions.size(), stamps.size());
+  for (size_t i = 0; i < positions.size(); ++i) {
+    mesh_deformer_->addControlPoint(
+        gtsam::Symbol(vertex_key, i), stamps[i], positions[i]);
+  }
+
+  VLOG(1) << "[Hydra Backend] registered " << mesh_deformer_->numControlPoints()
+          << " control points for mesh deformation";
+}
+
 void BackendModule::addSink(const Sink::Ptr& sink) {
   if (sink) {
     sinks_.push_back(sink);
@@ -373,6 +483,7 @@ inline bool hasLoopClosure(const PoseGraph& graph) {
 void BackendModule::updateFactorGraph(const BackendInput& input) {
   ScopedTimer timer("backend/process_factors", input.timestamp_ns);
   const size_t prev_loop_closures = num_loop_closures_;
+  const size_t prev_new_factors = status_.new_factors;
 
   if (!input.deformation_graph) {
     LOG(WARNING) << "[Hydra Backend] Received invalid deformation graph";
@@ -390,6 +501,15 @@ void BackendModule::updateFactorGraph(const BackendInput& input) {
     throw std::logic_error(e.what());
   }
 
+  const auto vertex_key = GlobalInfo::instance().getRobotPrefix().vertex_key;
+  for (const auto& node : input.deformation_graph->nodes) {
+    place_graph_->addVertex(node.key, node.pose.translation());
+    if (mesh_deformer_) {
+      mesh_deformer_->addControlPoint(
+          gtsam::Symbol(vertex_key, node.key), node.stamp_ns, node.pose.translation());
+    }
+  }
+
   for (const auto& msg : input.agent_updates.pose_graphs) {
     status_.new_factors += msg->edges.size();
 
@@ -420,6 +540,10 @@ void BackendModule::updateFactorGraph(const BackendInput& input) {
     have_loopclosures_ = true;
   }
 
+  if (status_.new_factors > prev_new_factors || have_new_loopclosures_) {
+    have_new_factors_ = true;
+  }
+
   status_.trajectory_len = trajectory_.size();
   status_.total_factors = deformation_graph_->getGtsamFactors().size();
   status_.total_values = deformation_graph_->getGtsamValues().size();
@@ -445,6 +569,7 @@ bool BackendModule::updateFromLcdQueue() {
     added_new_loop_closure = true;
     have_loopclosures_ = true;
     have_new_loopclosures_ = true;
+    have_new_factors_ = true;
     num_loop_closures_++;
     status_.new_loop_closures++;
   }
@@ -459,7 +584,14 @@ void BackendModule::copyMeshDelta(const BackendInput& input) {
     return;
   }
 
-  input.mesh_update->updateMesh(*private_dsg_->graph->mesh());
+  auto& mesh = *private_dsg_->graph->mesh();
+  input.mesh_update->updateMesh(mesh);
+  if (zmq_publisher_) {
+    auto& encoder = zmq_publisher_->encoder();
+    encoder.markVertices(input.mesh_update->vertex_start, mesh.numVertices());
+    encoder.markFaces(input.mesh_update->face_start, mesh.numFaces());
+  }
+
   kimera_pgmo::StampedCloud<pcl::PointXYZ> cloud_out{*original_vertices_,
                                                      vertex_stamps_};
   input.mesh_update->updateVertices(cloud_out);
@@ -485,6 +617,8 @@ bool BackendModule::updatePrivateDsg(size_t timestamp_ns, bool force_update) {
     unmerged_graph_->mergeGraph(*shared_dsg.graph);
   }  // end joint critical section
 
+  trackGraphChanges();
+
   if (logs_) {
     backend_graph_logger_.logGraph(private_dsg_->graph);
   }
@@ -492,6 +626,38 @@ bool BackendModule::updatePrivateDsg(size_t timestamp_ns, bool force_update) {
   return true;
 }
 
+void BackendModule::trackGraphChanges() {
+  const auto new_nodes = unmerged_graph_->getNewNodes(true);
+  const auto removed_nodes = unmerged_graph_->getRemovedNodes(true);
+  auto edges = unmerged_graph_->getNewEdges(true);
+  const auto removed_edges = unmerged_graph_->getRemovedEdges(true);
+  active_windows_.update(*unmerged_graph_, new_nodes, removed_nodes);
+  if (!config.add_places_to_deformation_graph) {
+    return;
+  }
+
+  const auto& places = unmerged_graph_->getLayer(DsgLayers::PLACES);
+  for (const auto node : new_nodes) {
+    if (places.hasNode(node)) {
+      place_graph_->markChanged(node);
+    }
+  }
+
+  for (const auto node : removed_nodes) {
+    place_graph_->markRemoved(node);
+  }
+
+  // new and removed edges change the siblings of their endpoints
+  edges.insert(edges.end(), removed_edges.begin(), removed_edges.end());
+  for (const auto& edge : edges) {
+    for (const auto node : {edge.k1, edge.k2}) {
+      if (places.hasNode(node)) {
+        place_graph_->markChanged(node);
+      }
+    }
+  }
+}
+
 void BackendModule::addPlacesToDeformationGraph(size_t timestamp_ns) {
   const auto& places = unmerged_graph_->getLayer(DsgLayers::PLACES);
   if (places.nodes().empty()) {
@@ -500,71 +666,61 @@ void BackendModule::addPlacesToDeformationGraph(size_t timestamp_ns) {
   }
 
   ScopedTimer timer("backend/add_places", timestamp_ns);
-  const auto& prefix = GlobalInfo::instance().getRobotPrefix();
-
-  deformation_graph_->clearTemporaryStructures();
-
-  MinimumSpanningTreeInfo mst_info;
-  {  // start timing scope
-    ScopedTimer mst_timer("backend/places_mst", timestamp_ns);
-    mst_info = getMinimumSpanningEdges(places);
-  }  // end timing scope
-
-  {  // start timing scope
-    ScopedTimer add_timer("backend/add_places_nodes", timestamp_ns);
+  if (place_graph_->update(places)) {
+    place_structures_stale_ = true;
+  }
 
-    std::vector<gtsam::Key> place_nodes;
-    std::vector<gtsam::Pose3> place_node_poses;
-    std::vector<std::vector<size_t>> place_node_valences;
+  VLOG(2) << "[Hydra Backend] tracking " << place_graph_->values().size()
+          << " places in the deformation graph";
+}
 
-    for (const auto& id_node_pair : places.nodes()) {
-      const auto& node = *id_node_pair.second;
-      const auto& attrs = node.attributes<PlaceNodeAttributes>();
+void BackendModule::rebuildPlaceStructures(size_t timestamp_ns) {
+  if (!place_structures_stale_) {
+    return;
+  }
 
-      if (!node.hasSiblings()) {
-        continue;
-      }
+  ScopedTimer timer("backend/rebuild_places", timestamp_ns, true, 0, false);
+  place_structures_stale_ = false;
+  deformation_graph_->clearTemporaryStructures();
 
-      place_nodes.push_back(node.id);
-      place_node_poses.push_back(gtsam::Pose3(gtsam::Rot3(), attrs.position));
+  const auto& places = place_graph_->places();
+  std::vector<gtsam::Key> place_nodes;
+  for (const auto& [node, place] : places) {
+    if (place_graph_->forest().degree(node)) {
+      place_nodes.push_back(node);
+    }
+  }
 
-      if (mst_info.leaves.count(node.id)) {
-        std::vector<size_t> valid_connections;
-        for (const auto& idx : attrs.deformation_connections) {
-          if (idx == std::numeric_limits<size_t>::max()) {
-            continue;
-          }
-          valid_connections.push_back(idx);
-        }
+  std::sort(place_nodes.begin(), place_nodes.end());
+  std::vector<gtsam::Pose3> place_node_poses;
+  std::vector<std::vector<size_t>> place_node_valences;
+  for (const auto node : place_nodes) {
+    const auto& place = places.at(node);
+    place_node_poses.push_back(gtsam::Pose3(gtsam::Rot3(), place.position));
+    place_node_valences.push_back(place.leaf ? place.connections
+                                             : std::vector<size_t>{});
+  }
 
-        place_node_valences.push_back(valid_connections);
-      } else {
-        place_node_valences.push_back(std::vector<size_t>{});
-      }
-    }
+  deformation_graph_->addNewTempNodesValences(
+      place_nodes,
+      place_node_poses,
+      place_node_valences,
+      GlobalInfo::instance().getRobotPrefix().vertex_key,
+      false,
+      config.pgmo.place_mesh_variance);
+
+  PoseGraph mst_edges;
+  for (const auto& edge : place_graph_->forest().edges()) {
+    gtsam::Pose3 source(gtsam::Rot3(), places.at(edge.source).position);
+    gtsam::Pose3 target(gtsam::Rot3(), places.at(edge.target).position);
+    pose_graph_tools::PoseGraphEdge mst_e;
+    mst_e.key_from = edge.source;
+    mst_e.key_to = edge.target;
+    mst_e.pose = source.between(target).matrix();
+    mst_edges.edges.push_back(mst_e);
+  }
 
-    deformation_graph_->addNewTempNodesValences(place_nodes,
-                                                place_node_poses,
-                                                place_node_valences,
-                                                prefix.vertex_key,
-                                                false,
-                                                config.pgmo.place_mesh_variance);
-  }  // end timing scope
-
-  {  // start timing scope
-    ScopedTimer between_timer("backend/add_places_between", timestamp_ns);
-    PoseGraph mst_edges;
-    for (const auto& edge : mst_info.edges) {
-      gtsam::Pose3 source(gtsam::Rot3(), places.getPosition(edge.source));
-      gtsam::Pose3 target(gtsam::Rot3(), places.getPosition(edge.target));
-      pose_graph_tools::PoseGraphEdge mst_e;
-      mst_e.key_from = edge.source;
-      mst_e.key_to = edge.target;
-      mst_e.pose = source.between(target).matrix();
-      mst_edges.edges.push_back(mst_e);
-    }
-    deformation_graph_->addNewTempEdges(mst_edges, config.pgmo.place_edge_variance);
-  }  // end timing scope
+  deformation_graph_->addNewTempEdges(mst_edges, config.pgmo.place_edge_variance);
 }
 
 void BackendModule::addLoopClosure(const gtsam::Key& src,
@@ -647,13 +803,30 @@ void BackendModule::updateDsgMesh(size_t timestamp_ns, bool force_mesh_update) {
 
   ScopedTimer timer("backend/mesh_deformation", timestamp_ns);
   VLOG(2) << "Deforming mesh with " << mesh->numVertices() << " vertices";
+  if (zmq_publisher_) {
+    // only vertices that were active as of the last deformation move
+    const auto num_archived =
+        std::min(prev_num_archived_vertices_, num_archived_vertices_);
+    zmq_publisher_->encoder().markVertices(force_mesh_update ? 0 : num_archived,
+                                           mesh->numVertices());
+  }
+
+  if (mesh_deformer_) {
+    mesh_deformer_->deform(*original_vertices_,
+                           vertex_stamps_,
+                           getOptimizedValues(),
+                           num_archived_vertices_,
+                           *mesh);
+    prev_num_archived_vertices_ = num_archived_vertices_;
+    return;
+  }
 
   kimera_pgmo::ConstStampedCloud<pcl::PointXYZ> cloud_in{*original_vertices_,
                                                          vertex_stamps_};
   deformation_graph_->deformPoints(*private_dsg_->graph->mesh(),
                                    cloud_in,
                                    GlobalInfo::instance().getRobotPrefix().vertex_key,
-                                   deformation_graph_->getGtsamValues(),
+                                   getOptimizedValues(),
                                    KimeraPgmoInterface::config_.num_interp_pts,
                                    KimeraPgmoInterface::config_.interp_horizon,
                                    nullptr,
@@ -679,18 +852,232 @@ void BackendModule::optimize(size_t timestamp_ns) {
     addPlacesToDeformationGraph(timestamp_ns);
   }
 
+  gtsam::Values places_values;
+  gtsam::Values pgmo_values;
+  solve(timestamp_ns, have_new_loopclosures_, places_values, pgmo_values);
+
+  updateDsgMesh(timestamp_ns, true);
+
+  callUpdateFunctions(timestamp_ns, places_values, pgmo_values, have_new_loopclosures_);
+  have_new_loopclosures_ = false;
+  have_new_factors_ = false;
+}
+
+void BackendModule::optimizeAsync(size_t timestamp_ns) {
+  std::unique_lock<std::mutex> lock(optimizer_mutex_);
+  const bool idle = !optimizer_busy_;
+  const bool fresh = fresh_result_;
+  const bool have_result = have_result_;
+  fresh_result_ = false;
+  // the optimizer only writes the back buffer, and can only be relaunched from this
+  // thread, so the front buffer stays valid until the end of this call
+  const auto& result = results_[front_result_];
+  lock.unlock();
+
+  if (idle) {
+    // the deformation graph is only safe to touch while the optimizer is idle. mesh
+    // deformation is deferred while optimizing and catches up with the next solution
+    applyPendingInputs();
+    updateFromLcdQueue();
+    updateDsgMesh(timestamp_ns, fresh);
+  }
+
+  if (!have_result) {
+    callUpdateFunctions(timestamp_ns);
+    return;
+  }
+
+  callUpdateFunctions(timestamp_ns,
+                      result.places_values,
+                      result.pgmo_values,
+                      fresh && result.new_loop_closure);
+}
+
+void BackendModule::launchOptimization(size_t timestamp_ns) {
+  if (optimizerBusy()) {
+    return;
+  }
+
+  applyPendingInputs();
+  updateFromLcdQueue();
+  if (!have_new_factors_) {
+    return;
+  }
+
+  // requests that arrive while optimizing are coalesced into this launch
+  if (config.add_places_to_deformation_graph) {
+    addPlacesToDeformationGraph(timestamp_ns);
+  }
+
+  {  // start critical section
+    std::lock_guard<std::mutex> lock(optimizer_mutex_);
+    optimization_stamp_ns_ = timestamp_ns;
+    optimization_new_loop_closure_ = have_new_loopclosures_;
+    optimizer_busy_ = true;
+  }  // end critical section
+
+  have_new_loopclosures_ = false;
+  have_new_factors_ = false;
+  optimizer_cv_.notify_all();
+}
+
+void BackendModule::runOptimizer() {
+  while (true) {
+    size_t timestamp_ns;
+    bool new_loop_closure;
+    size_t back_index;
+    {  // start critical section
+      std::unique_lock<std::mutex> lock(optimizer_mutex_);
+      optimizer_cv_.wait(lock, [this] { return optimizer_busy_ || stop_optimizer_; });
+      if (!optimizer_busy_) {
+        return;
+      }
+
+      timestamp_ns = optimization_stamp_ns_;
+      new_loop_closure = optimization_new_loop_closure_;
+      back_index = 1 - front_result_;
+    }  // end critical section
+
+    auto& result = results_[back_index];
+    solve(timestamp_ns, new_loop_closure, result.places_values, result.pgmo_values);
+    result.timestamp_ns = timestamp_ns;
+    result.new_loop_closure = new_loop_closure;
+
+    {  // start critical section
+      std::lock_guard<std::mutex> lock(optimizer_mutex_);
+      front_result_ = back_index;
+      have_result_ = true;
+      fresh_result_ = true;
+      optimizer_busy_ = false;
+    }  // end critical section
+
+    optimizer_cv_.notify_all();
+  }
+}
+
+void BackendModule::stopOptimizer() {
+  if (!optimizer_thread_) {
+    return;
+  }
+
+  VLOG(2) << "[Hydra Backend] joining background optimizer";
+  {  // start critical section
+    std::lock_guard<std::mutex> lock(optimizer_mutex_);
+    stop_optimizer_ = true;
+  }  // end critical section
+
+  optimizer_cv_.notify_all();
+  optimizer_thread_->join();
+  optimizer_thread_.reset();
+
+  // the final state includes factors deferred while optimizing and the last solution
+  std::lock_guard<std::mutex> lock(mutex_);
+  applyPendingInputs();
+  updateFromLcdQueue();
+  if (!config.optimize_on_lc || !have_loopclosures_) {
+    return;
+  }
+
+  const size_t timestamp_ns = last_timestamp_ns_;
+  if (have_new_factors_) {
+    optimize(timestamp_ns);
+  } else if (fresh_result_) {
+    fresh_result_ = false;
+    const auto& result = results_[front_result_];
+    updateDsgMesh(timestamp_ns, true);
+    callUpdateFunctions(timestamp_ns,
+                        result.places_values,
+                        result.pgmo_values,
+                        result.new_loop_closure);
+  } else {
+    return;
+  }
+
+  callSinks(timestamp_ns);
+}
+
+void BackendModule::callSinks(size_t timestamp_ns) {
+  if (sinks_.empty()) {
+    return;
+  }
+
+  // sinks read the deformation graph, which the optimizer writes while solving.
+  // this only waits when a solve takes longer than the input it overlaps with
+  waitForOptimizer();
+  ScopedTimer sink_timer("backend/sinks", timestamp_ns);
+  Sink::callAll(sinks_, timestamp_ns, *private_dsg_->graph, *deformation_graph_);
+}
+
+bool BackendModule::optimizerBusy() const {
+  std::lock_guard<std::mutex> lock(optimizer_mutex_);
+  return optimizer_busy_;
+}
+
+void BackendModule::waitForOptimizer() const {
+  std::unique_lock<std::mutex> lock(optimizer_mutex_);
+  optimizer_cv_.wait(lock, [this] { return !optimizer_busy_; });
+}
+
+void BackendModule::applyPendingInputs() {
+  for (const auto& input : pending_inputs_) {
+    updateFactorGraph(input);
+  }
+
+  pending_inputs_.clear();
+  if (pending_recalculate_vertices_) {
+    deformation_graph_->setRecalculateVertices();
+    pending_recalculate_vertices_ = false;
+  }
+}
+
+void BackendModule::solve(size_t timestamp_ns,
+                          bool new_loop_closure,
+                          gtsam::Values& places_values,
+                          gtsam::Values& pgmo_values) {
+  // loop closures always go through the robust batch solver for outlier rejection
+  if (incremental_solver_ && !new_loop_closure) {
+    ScopedTimer timer("backend/incremental_optimization", timestamp_ns, true, 0, false);
+    if (incremental_solver_->update(deformation_graph_->getGtsamFactors(),
+                                    deformation_graph_->getGtsamValues(),
+                                    place_graph_->factors(),
+                                    place_graph_->values())) {
+      places_values = incremental_solver_->tempValues();
+      pgmo_values = incremental_solver_->values();
+      return;
+    }
+
+    VLOG(1) << "[Hydra Backend] " << incremental_solver_->numLastChanged()
+            << " changed factors: falling back to batch optimization";
+  }
+
+  rebuildPlaceStructures(timestamp_ns);
   {  // timer scope
     ScopedTimer timer("backend/optimization", timestamp_ns, true, 0, false);
     deformation_graph_->optimize();
   }  // timer scope
 
-  updateDsgMesh(timestamp_ns, true);
+  places_values = deformation_graph_->getGtsamTempValues();
+  pgmo_values = deformation_graph_->getGtsamValues();
+  if (!incremental_solver_) {
+    return;
+  }
 
-  callUpdateFunctions(timestamp_ns,
-                      deformation_graph_->getGtsamTempValues(),
-                      deformation_graph_->getGtsamValues(),
-                      have_new_loopclosures_);
-  have_new_loopclosures_ = false;
+  ScopedTimer timer("backend/incremental_reset", timestamp_ns, true, 0, false);
+  // the solver tracks the place factors by address, so it is seeded with the
+  // factors that later updates are handed
+  incremental_solver_->reset(deformation_graph_->getGtsamFactors(),
+                             pgmo_values,
+                             place_graph_->factors(),
+                             places_values,
+                             deformation_graph_->getGncWeights());
+}
+
+gtsam::Values BackendModule::getOptimizedValues() const {
+  if (incremental_solver_ && incremental_solver_->initialized()) {
+    return incremental_solver_->values();
+  }
+
+  return deformation_graph_->getGtsamValues();
 }
 
 void BackendModule::resetBackendDsg(size_t timestamp_ns) {
@@ -705,7 +1092,20 @@ void BackendModule::resetBackendDsg(size_t timestamp_ns) {
   private_dsg_->graph->mergeGraph(*unmerged_graph_);
   private_dsg_->merges.clear();
   merge_tracker.clear();
-  deformation_graph_->setRecalculateVertices();
+  if (optimizer_thread_ && optimizerBusy()) {
+    pending_recalculate_vertices_ = true;
+  } else {
+    deformation_graph_->setRecalculateVertices();
+  }
+
+  if (mesh_deformer_) {
+    mesh_deformer_->invalidate();
+  }
+
+  if (zmq_publisher_) {
+    zmq_publisher_->encoder().requestKeyframe();
+  }
+
   reset_backend_dsg_ = false;
 }
 
@@ -745,28 +1145,94 @@ void BackendModule::callUpdateFunctions(size_t timestamp_ns,
                                            timestamp_ns,
                                            enable_merging,
                                            given_merges,
-                                           &complete_agent_values});
+                                           &complete_agent_values,
+                                           &active_windows_});
 
   // merge topological changes to private dsg, respecting merges
   // attributes may be overwritten, but ideally we don't bother
-  GraphMergeConfig config;
-  config.previous_merges = &private_dsg_->merges;
-  config.update_dynamic_attributes = false;
-  private_dsg_->graph->mergeGraph(*unmerged_graph_, config);
+  GraphMergeConfig merge_config;
+  merge_config.previous_merges = &private_dsg_->merges;
+  merge_config.update_dynamic_attributes = false;
+  private_dsg_->graph->mergeGraph(*unmerged_graph_, merge_config);
+
+  if (zmq_publisher_) {
+    // functors update the active windows (or every node after a loop closure)
+    auto& encoder = zmq_publisher_->encoder();
+    if (new_loop_closure) {
+      encoder.requestKeyframe();
+    } else {
+      for (const auto& [layer_id, layer] : unmerged_graph_->layers()) {
+        for (const auto& node : active_windows_.index(layer_id)->view(*layer)) {
+          encoder.markNode(node.id);
+        }
+      }
+    }
+  }
 
+  std::vector<UpdateFunctor::Ptr> functors;
   if (agent_functor_) {
-    agent_functor_->call(*unmerged_graph_, *private_dsg_, info);
+    functors.push_back(agent_functor_);
   }
 
-  std::list<LayerCleanupFunc> cleanup_hooks;
   for (const auto& [layer, functor] : layer_functors_) {
-    if (!functor) {
-      continue;
+    if (functor) {
+      functors.push_back(functor);
     }
+  }
+
+  // unknown access forces every functor to run alone and in order
+  LayerAccess unknown_access;
+  unknown_access.unknown = true;
+  std::vector<LayerAccess> accesses;
+  for (const auto& functor : functors) {
+    accesses.push_back(config.concurrent_layer_updates ? functor->access()
+                                                       : unknown_access);
+  }
+
+  std::vector<MergeList> merges(functors.size());
+  for (const auto& stage : scheduleUpdateFunctors(accesses)) {
+    if (stage.size() == 1) {
+      const auto idx = stage.front();
+      merges[idx] = functors[idx]->call(*unmerged_graph_, *private_dsg_, info);
+    } else {
+      std::vector<std::future<MergeList>> futures;
+      for (const auto idx : stage) {
+        futures.push_back(std::async(std::launch::async, [&, idx]() {
+          return functors[idx]->call(*unmerged_graph_, *private_dsg_, info);
+        }));
+      }
 
-    const auto merges = functor->call(*unmerged_graph_, *private_dsg_, info);
+      for (size_t i = 0; i < stage.size(); ++i) {
+        merges[stage[i]] = futures[i].get();
+      }
+    }
+
+    // merges modify the graph, so they're applied one functor at a time after the
+    // stage (the schedule is deterministic, so merges are always applied in the same
+    // order)
+    for (const auto idx : stage) {
+      const auto hooks = functors[idx]->hooks();
+      merge_tracker.applyMerges(
+          *unmerged_graph_, merges[idx], *private_dsg_, hooks.merge);
+      if (zmq_publisher_) {
+        for (const auto& merge : merges[idx]) {
+          zmq_publisher_->encoder().markNode(merge.to);
+        }
+      }
+    }
+  }
+
+  if (config.merge_compaction_period > 0 &&
+      ++num_updates_since_compaction_ >= config.merge_compaction_period) {
+    num_updates_since_compaction_ = 0;
+    const auto num_removed = merge_tracker.compact(*unmerged_graph_, *private_dsg_);
+    VLOG(2) << "[Hydra Backend] dropped " << num_removed << " merge record(s), "
+            << merge_tracker.registry().size() << " remaining";
+  }
+
+  std::list<LayerCleanupFunc> cleanup_hooks;
+  for (const auto& functor : functors) {
     const auto hooks = functor->hooks();
-    merge_tracker.applyMerges(*unmerged_graph_, merges, *private_dsg_, hooks.merge);
     if (hooks.cleanup) {
       cleanup_hooks.push_back(hooks.cleanup);
     }
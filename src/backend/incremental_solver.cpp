@@ -0,0 +1,337 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "hydra/backend/incremental_solver.h"
+
+#include <config_utilities/config.h>
+#include <config_utilities/validation.h>
+#include <glog/logging.h>
+#include <gtsam/geometry/Pose3.h>
+#include <gtsam/slam/PriorFactor.h>
+
+#include <algorithm>
+#include <map>
+#include <unordered_set>
+
+namespace hydra {
+
+void declare_config(IncrementalSolver::Config& config) {
+  using namespace config;
+  name("IncrementalSolverConfig");
+  field(config.relinearize_threshold, "relinearize_threshold");
+  field(config.relinearize_skip, "relinearize_skip");
+  field(config.batch_threshold, "batch_threshold");
+  field(config.inlier_weight_threshold, "inlier_weight_threshold");
+  field(config.anchor_variance, "anchor_variance");
+  check(config.relinearize_threshold, GT, 0.0, "relinearize_threshold");
+  check(config.relinearize_skip, GT, 0, "relinearize_skip");
+  check(config.batch_threshold, GT, 0.0, "batch_threshold");
+  check(config.anchor_variance, GT, 0.0, "anchor_variance");
+}
+
+IncrementalSolver::IncrementalSolver(const Config& config)
+    : config(config::checkValid(config)) {}
+
+void IncrementalSolver::invalidate() {
+  initialized_ = false;
+  num_last_changed_ = 0;
+  isam_.reset();
+  factors_.clear();
+  rejected_.clear();
+  key_counts_.clear();
+  anchors_.clear();
+  values_.clear();
+  temp_values_.clear();
+}
+
+void IncrementalSolver::reset(const gtsam::NonlinearFactorGraph& factors,
+                              const gtsam::Values& values,
+                              const gtsam::NonlinearFactorGraph& temp_factors,
+                              const gtsam::Values& temp_values,
+                              const gtsam::Vector& weights) {
+  invalidate();
+
+  gtsam::ISAM2Params params;
+  params.relinearizeThreshold = config.relinearize_threshold;
+  params.relinearizeSkip = static_cast<int>(config.relinearize_skip);
+  isam_ = std::make_unique<gtsam::ISAM2>(params);
+
+  const bool use_weights = static_cast<size_t>(weights.size()) == factors.size();
+  gtsam::NonlinearFactorGraph new_factors;
+  for (size_t i = 0; i < factors.size(); ++i) {
+    const auto& factor = factors[i];
+    if (!factor) {
+      continue;
+    }
+
+    if (use_weights && weights(i) < config.inlier_weight_threshold) {
+      rejected_[factor.get()] = factor;
+      continue;
+    }
+
+    new_factors.push_back(factor);
+  }
+
+  for (const auto& factor : temp_factors) {
+    if (factor) {
+      new_factors.push_back(factor);
+    }
+  }
+
+  gtsam::Values theta;
+  for (const auto& factor : new_factors) {
+    for (const auto key : factor->keys()) {
+      if (theta.exists(key)) {
+        continue;
+      }
+
+      if (values.exists(key)) {
+        theta.insert(key, values.at(key));
+      } else if (temp_values.exists(key)) {
+        theta.insert(key, temp_values.at(key));
+      } else {
+        LOG(WARNING) << "[Incremental Solver] missing value for "
+                     << gtsam::DefaultKeyFormatter(key) << " when seeding";
+        invalidate();
+        return;
+      }
+    }
+  }
+
+  gtsam::ISAM2Result result;
+  try {
+    result = isam_->update(new_factors, theta);
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "[Incremental Solver] failed to seed solver: " << e.what();
+    invalidate();
+    return;
+  }
+
+  for (size_t i = 0; i < new_factors.size(); ++i) {
+    const auto& factor = new_factors[i];
+    factors_[factor.get()] = {factor, result.newFactorsIndices.at(i)};
+    addKeyCounts(*factor, true);
+  }
+
+  values_ = values;
+  temp_values_ = temp_values;
+  initialized_ = true;
+}
+
+bool IncrementalSolver::update(const gtsam::NonlinearFactorGraph& factors,
+                               const gtsam::Values& values,
+                               const gtsam::NonlinearFactorGraph& temp_factors,
+                               const gtsam::Values& temp_values) {
+  if (!initialized_) {
+    return false;
+  }
+
+  // factors that are still referenced are untouched, everything else is new or stale
+  std::unordered_set<const gtsam::NonlinearFactor*> seen;
+  std::vector<FactorPtr> unmatched;
+  for (const auto* graph : {&factors, &temp_factors}) {
+    for (const auto& factor : *graph) {
+      if (!factor || rejected_.count(factor.get())) {
+        continue;
+      }
+
+      if (factors_.count(factor.get())) {
+        seen.insert(factor.get());
+      } else {
+        unmatched.push_back(factor);
+      }
+    }
+  }
+
+  std::multimap<gtsam::KeyVector, const gtsam::NonlinearFactor*> stale;
+  for (const auto& ptr_factor_pair : factors_) {
+    if (!seen.count(ptr_factor_pair.first)) {
+      stale.emplace(ptr_factor_pair.second.factor->keys(), ptr_factor_pair.first);
+    }
+  }
+
+  // rebuilt copies of stale factors keep the stale factor's slot in the solver
+  std::vector<std::pair<FactorPtr, const gtsam::NonlinearFactor*>> renamed;
+  std::vector<FactorPtr> added;
+  for (const auto& factor : unmatched) {
+    auto range = stale.equal_range(factor->keys());
+    auto iter = range.first;
+    for (; iter != range.second; ++iter) {
+      if (factors_.at(iter->second).factor->equals(*factor)) {
+        break;
+      }
+    }
+
+    if (iter == range.second) {
+      added.push_back(factor);
+    } else {
+      renamed.emplace_back(factor, iter->second);
+      stale.erase(iter);
+    }
+  }
+
+  num_last_changed_ = added.size() + stale.size();
+  const double max_changed =
+      config.batch_threshold * std::max<size_t>(factors_.size(), 1);
+  if (num_last_changed_ > max_changed) {
+    VLOG(2) << "[Incremental Solver] " << num_last_changed_ << " changed factors of "
+            << factors_.size() << " exceeds batch threshold";
+    return false;
+  }
+
+  gtsam::Values new_theta;
+  for (const auto& factor : added) {
+    for (const auto key : factor->keys()) {
+      if (isam_->valueExists(key) || new_theta.exists(key)) {
+        continue;
+      }
+
+      if (values.exists(key)) {
+        new_theta.insert(key, values.at(key));
+      } else if (temp_values.exists(key)) {
+        new_theta.insert(key, temp_values.at(key));
+      } else {
+        VLOG(2) << "[Incremental Solver] missing value for "
+                << gtsam::DefaultKeyFormatter(key);
+        return false;
+      }
+    }
+  }
+
+  gtsam::NonlinearFactorGraph new_factors;
+  gtsam::FactorIndices removed;
+  gtsam::KeyVector touched;
+  for (const auto& keys_ptr_pair : stale) {
+    const auto& tracked = factors_.at(keys_ptr_pair.second);
+    removed.push_back(tracked.index);
+    addKeyCounts(*tracked.factor, false);
+    const auto& keys = keys_ptr_pair.first;
+    touched.insert(touched.end(), keys.begin(), keys.end());
+    factors_.erase(keys_ptr_pair.second);
+  }
+
+  for (const auto& new_old_pair : renamed) {
+    const auto index = factors_.at(new_old_pair.second).index;
+    factors_.erase(new_old_pair.second);
+    factors_[new_old_pair.first.get()] = {new_old_pair.first, index};
+  }
+
+  for (const auto& factor : added) {
+    new_factors.push_back(factor);
+    addKeyCounts(*factor, true);
+    touched.insert(touched.end(), factor->keys().begin(), factor->keys().end());
+  }
+
+  std::vector<gtsam::Key> new_anchors;
+  updateAnchors(touched, new_factors, removed, new_anchors);
+
+  gtsam::ISAM2Result result;
+  try {
+    result = isam_->update(new_factors, new_theta, removed);
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "[Incremental Solver] update failed: " << e.what();
+    invalidate();
+    return false;
+  }
+
+  for (size_t i = 0; i < added.size(); ++i) {
+    factors_[added[i].get()] = {added[i], result.newFactorsIndices.at(i)};
+  }
+
+  for (size_t i = 0; i < new_anchors.size(); ++i) {
+    anchors_[new_anchors[i]] = result.newFactorsIndices.at(added.size() + i);
+  }
+
+  updateEstimate(values, temp_values);
+  return true;
+}
+
+void IncrementalSolver::addKeyCounts(const gtsam::NonlinearFactor& factor, bool add) {
+  for (const auto key : factor.keys()) {
+    if (add) {
+      ++key_counts_[key];
+      continue;
+    }
+
+    auto iter = key_counts_.find(key);
+    if (iter != key_counts_.end() && --iter->second == 0) {
+      key_counts_.erase(iter);
+    }
+  }
+}
+
+void IncrementalSolver::updateAnchors(const gtsam::KeyVector& keys,
+                                      gtsam::NonlinearFactorGraph& new_factors,
+                                      gtsam::FactorIndices& removed,
+                                      std::vector<gtsam::Key>& new_anchors) {
+  const auto noise = gtsam::noiseModel::Isotropic::Variance(6, config.anchor_variance);
+  std::unordered_set<gtsam::Key> visited;
+  for (const auto key : keys) {
+    if (!visited.insert(key).second) {
+      continue;
+    }
+
+    const bool has_factors = key_counts_.count(key);
+    auto iter = anchors_.find(key);
+    if (has_factors && iter != anchors_.end()) {
+      removed.push_back(iter->second);
+      anchors_.erase(iter);
+      continue;
+    }
+
+    if (!has_factors && iter == anchors_.end() && isam_->valueExists(key)) {
+      // the solver cannot drop variables, so hold orphans at their last estimate
+      const auto pose = isam_->calculateEstimate<gtsam::Pose3>(key);
+      new_factors.emplace_shared<gtsam::PriorFactor<gtsam::Pose3>>(key, pose, noise);
+      new_anchors.push_back(key);
+    }
+  }
+}
+
+void IncrementalSolver::updateEstimate(const gtsam::Values& values,
+                                       const gtsam::Values& temp_values) {
+  const auto estimate = isam_->calculateEstimate();
+  values_.clear();
+  for (const auto key : values.keys()) {
+    values_.insert(key, estimate.exists(key) ? estimate.at(key) : values.at(key));
+  }
+
+  temp_values_.clear();
+  for (const auto key : temp_values.keys()) {
+    temp_values_.insert(key,
+                        estimate.exists(key) ? estimate.at(key) : temp_values.at(key));
+  }
+}
+
+}  // namespace hydra
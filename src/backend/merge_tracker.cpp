@@ -36,18 +36,149 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+
 namespace hydra {
 
+NodeId MergeRegistry::find(NodeId node) const {
+  NodeId root = node;
+  auto iter = parents_.find(root);
+  while (iter != parents_.end()) {
+    root = iter->second;
+    iter = parents_.find(root);
+  }
+
+  // path compression
+  iter = parents_.find(node);
+  while (iter != parents_.end() && iter->second != root) {
+    const auto next = iter->second;
+    iter->second = root;
+    iter = parents_.find(next);
+  }
+
+  return root;
+}
+
+bool MergeRegistry::merge(NodeId from, NodeId to) {
+  const auto from_root = find(from);
+  const auto to_root = find(to);
+  if (from_root == to_root) {
+    return false;
+  }
+
+  parents_[from_root] = to_root;
+  removed_.erase(from_root);
+
+  auto& to_members = members_[to_root];
+  auto from_iter = members_.find(from_root);
+  if (from_iter != members_.end()) {
+    // move the larger list and copy the smaller one
+    if (from_iter->second.size() > to_members.size()) {
+      std::swap(from_iter->second, to_members);
+    }
+
+    to_members.insert(
+        to_members.end(), from_iter->second.begin(), from_iter->second.end());
+    members_.erase(from_iter);
+  }
+
+  to_members.push_back(from_root);
+  changed_sets_.erase(from_root);
+  changed_sets_.insert(to_root);
+  return true;
+}
+
+const std::vector<NodeId>& MergeRegistry::members(NodeId representative) const {
+  static const std::vector<NodeId> empty;
+  auto iter = members_.find(representative);
+  return iter == members_.end() ? empty : iter->second;
+}
+
+bool MergeRegistry::undo(NodeId node) {
+  if (!parents_.count(node)) {
+    return false;
+  }
+
+  // other members may point to the root through the node
+  const auto root = find(node);
+  flatten(root);
+  parents_.erase(node);
+
+  auto& members = members_.at(root);
+  members.erase(std::remove(members.begin(), members.end(), node), members.end());
+  if (members.empty()) {
+    members_.erase(root);
+  }
+
+  removed_.insert(node);
+  return true;
+}
+
+size_t MergeRegistry::compact(const std::function<bool(NodeId)>& keep) {
+  size_t num_removed = 0;
+  auto iter = members_.begin();
+  while (iter != members_.end()) {
+    flatten(iter->first);
+    auto& members = iter->second;
+    auto last = std::remove_if(members.begin(), members.end(), [&](NodeId node) {
+      if (keep(node)) {
+        return false;
+      }
+
+      parents_.erase(node);
+      removed_.insert(node);
+      ++num_removed;
+      return true;
+    });
+    members.erase(last, members.end());
+
+    if (members.empty()) {
+      changed_sets_.erase(iter->first);
+      iter = members_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+
+  return num_removed;
+}
+
+void MergeRegistry::exportMerges(std::map<NodeId, NodeId>& merges) {
+  for (const auto node : removed_) {
+    merges.erase(node);
+  }
+
+  for (const auto root : changed_sets_) {
+    for (const auto node : members(root)) {
+      merges[node] = root;
+    }
+  }
+
+  removed_.clear();
+  changed_sets_.clear();
+}
+
+void MergeRegistry::clear() {
+  parents_.clear();
+  members_.clear();
+  changed_sets_.clear();
+  removed_.clear();
+}
+
+void MergeRegistry::flatten(NodeId representative) {
+  for (const auto node : members(representative)) {
+    parents_[node] = representative;
+  }
+}
+
 void MergeTracker::applyMerges(const DynamicSceneGraph& unmerged,
                                const MergeList& proposals,
                                SharedDsgInfo& dsg,
                                const MergeFunc& merge_attrs) {
-  auto& prior_merges = dsg.merges;
-
   auto& graph = *dsg.graph;
   std::set<NodeId> to_update;
   for (const auto& orig_merge : proposals) {
-    const auto merge = orig_merge.remap(prior_merges);
+    const Merge merge{registry_.find(orig_merge.from), registry_.find(orig_merge.to)};
     if (merge.from == merge.to) {
       VLOG(10) << "Found present merge: " << orig_merge;
       to_update.insert(merge.to);
@@ -64,61 +195,48 @@ void MergeTracker::applyMerges(const DynamicSceneGraph& unmerged,
     VLOG(5) << "Applied merge: " << merge << " (original: " << orig_merge << ")";
 
     to_update.insert(merge.to);
-    updateParents(prior_merges, merge);
+    registry_.merge(merge.from, merge.to);
   }
 
+  registry_.exportMerges(dsg.merges);
   if (!merge_attrs) {
     return;
   }
 
   for (const auto& node : to_update) {
-    auto iter = merge_sets_.find(node);
-    if (iter == merge_sets_.end()) {
+    const auto& members = registry_.members(node);
+    if (members.empty()) {
       continue;
     }
 
-    auto child_iter = iter->second.begin();
-    while (child_iter != iter->second.end()) {
-      if (!unmerged.hasNode(*child_iter)) {
-        child_iter = iter->second.erase(child_iter);
-      } else {
-        ++child_iter;
+    std::vector<NodeId> nodes{node};
+    for (const auto child : members) {
+      if (unmerged.hasNode(child)) {
+        nodes.push_back(child);
       }
     }
 
-    std::vector<NodeId> nodes{node};
-    nodes.insert(nodes.end(), iter->second.begin(), iter->second.end());
+    std::sort(nodes.begin() + 1, nodes.end());
     graph.setNodeAttributes(node, merge_attrs(unmerged, nodes));
   }
 }
 
-void MergeTracker::clear() { merge_sets_.clear(); }
-
-void MergeTracker::updateParents(std::map<NodeId, NodeId>& prior_merges,
-                                 const Merge& merge) {
-  // look up (and maybe initialize new parent)
-  auto to_iter = merge_sets_.find(merge.to);
-  if (to_iter == merge_sets_.end()) {
-    to_iter = merge_sets_.emplace(merge.to, std::set<NodeId>()).first;
+bool MergeTracker::undoMerge(NodeId node, SharedDsgInfo& dsg) {
+  if (!registry_.undo(node)) {
+    return false;
   }
 
-  // record merge parent
-  to_iter->second.insert(merge.from);
-  prior_merges[merge.from] = merge.to;
-
-  // find prior merges
-  auto from_iter = merge_sets_.find(merge.from);
-  if (from_iter == merge_sets_.end()) {
-    return;  // no previous merges
-  }
-
-  // rewire old merges
-  for (const auto& child : from_iter->second) {
-    prior_merges[child] = merge.to;
-    to_iter->second.insert(child);
-  }
+  registry_.exportMerges(dsg.merges);
+  return true;
+}
 
-  merge_sets_.erase(from_iter);
+size_t MergeTracker::compact(const DynamicSceneGraph& unmerged, SharedDsgInfo& dsg) {
+  const auto num_removed =
+      registry_.compact([&](NodeId node) { return unmerged.hasNode(node); });
+  registry_.exportMerges(dsg.merges);
+  return num_removed;
 }
 
+void MergeTracker::clear() { registry_.clear(); }
+
 }  // namespace hydra
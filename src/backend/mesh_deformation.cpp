@@ -0,0 +1,253 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "hydra/backend/mesh_deformation.h"
+
+#include <config_utilities/config.h>
+#include <config_utilities/validation.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include "hydra/common/config_utilities.h"
+#include "hydra/reconstruction/parallel_utilities.h"
+
+namespace hydra {
+
+void declare_config(MeshDeformer::Config& config) {
+  using namespace config;
+  name("MeshDeformerConfig");
+  field<ThreadNumConversion>(config.num_threads, "num_threads");
+  field(config.chunk_size, "chunk_size");
+  field(config.min_control_translation, "min_control_translation");
+  field(config.min_control_rotation, "min_control_rotation");
+  check(config.num_threads, GT, 0, "num_threads");
+  check(config.chunk_size, GT, 0, "chunk_size");
+  check(config.min_control_translation, GE, 0.0, "min_control_translation");
+  check(config.min_control_rotation, GE, 0.0, "min_control_rotation");
+}
+
+MeshDeformer::MeshDeformer(const Config& config,
+                           size_t num_interp_pts,
+                           double interp_horizon_s)
+    : config(config::checkValid(config)),
+      num_interp_pts_(num_interp_pts),
+      interp_horizon_ns_(static_cast<uint64_t>(interp_horizon_s * 1.0e9)) {
+  CHECK_LE(num_interp_pts, std::numeric_limits<uint8_t>::max());
+}
+
+bool MeshDeformer::addControlPoint(gtsam::Key key,
+                                   uint64_t stamp_ns,
+                                   const Eigen::Vector3d& pos) {
+  if (control_lookup_.count(key)) {
+    return false;
+  }
+
+  const size_t index = controls_.size();
+  controls_.push_back({key, stamp_ns, pos});
+  control_lookup_[key] = index;
+
+  auto iter = std::upper_bound(
+      by_stamp_.begin(), by_stamp_.end(), stamp_ns, [this](uint64_t stamp, size_t c) {
+        return stamp < controls_[c].stamp_ns;
+      });
+  by_stamp_.insert(iter, index);
+  max_control_stamp_ns_ = std::max(max_control_stamp_ns_, stamp_ns);
+  return true;
+}
+
+void MeshDeformer::invalidate() { invalidated_ = true; }
+
+void MeshDeformer::deform(const pcl::PointCloud<pcl::PointXYZ>& vertices,
+                          const std::vector<uint64_t>& stamps,
+                          const gtsam::Values& values,
+                          size_t num_archived,
+                          spark_dsg::Mesh& mesh) {
+  const size_t num_vertices =
+      std::min({vertices.size(), stamps.size(), mesh.numVertices()});
+  if (vertices.size() != mesh.numVertices() || stamps.size() != mesh.numVertices()) {
+    LOG(WARNING) << "[Mesh Deformation] mismatched sizes: " << vertices.size()
+                 << " original vertices, " << stamps.size() << " stamps and "
+                 << mesh.numVertices() << " mesh vertices";
+  }
+
+  updateAppliedPoses(values);
+
+  const size_t k = num_interp_pts_;
+  vertex_final_.resize(num_vertices, 0);
+  num_neighbors_.resize(num_vertices, 0);
+  neighbors_.resize(num_vertices * k);
+  weights_.resize(num_vertices * k);
+
+  const size_t num_chunks = (num_vertices + config.chunk_size - 1) / config.chunk_size;
+  const size_t num_workers = getNumWorkers(config.num_threads, num_chunks);
+  // per-worker scratch space for neighbor search and deformation counts
+  std::vector<std::vector<std::pair<double, size_t>>> candidates(num_workers);
+  std::vector<size_t> num_deformed(num_workers, 0);
+  parallelFor(num_chunks, config.num_threads, [&](size_t chunk, size_t worker) {
+    const size_t start = chunk * config.chunk_size;
+    const size_t end = std::min(num_vertices, start + config.chunk_size);
+    for (size_t i = start; i < end; ++i) {
+      const auto& p = vertices[i];
+      const Eigen::Vector3d pos(p.x, p.y, p.z);
+      bool dirty = invalidated_ || !vertex_final_[i];
+      if (dirty) {
+        updateNeighbors(i, pos, stamps[i], i < num_archived, candidates[worker]);
+      } else {
+        for (size_t j = 0; j < num_neighbors_[i]; ++j) {
+          if (moved_[neighbors_[i * k + j]]) {
+            dirty = true;
+            break;
+          }
+        }
+      }
+
+      if (!dirty) {
+        continue;
+      }
+
+      mesh.setPos(i, deformVertex(i, pos));
+      ++num_deformed[worker];
+    }
+  });
+
+  invalidated_ = false;
+  num_last_deformed_ = 
+      std::accumulate(num_deformed.begin(), num_deformed.end(), size_t(0));
+  VLOG(2) << "[Mesh Deformation] deformed " << num_last_deformed_ << " of "
+          << num_vertices << " vertices";
+}
+
+void MeshDeformer::updateAppliedPoses(const gtsam::Values& values) {
+  const size_t num_applied = applied_poses_.size();
+  applied_poses_.resize(controls_.size());
+  moved_.assign(controls_.size(), 0);
+  for (size_t c = 0; c < controls_.size(); ++c) {
+    const auto& control = controls_[c];
+    // control points without a solution are left in place
+    const auto pose = values.exists(control.key)
+                          ? values.at<gtsam::Pose3>(control.key)
+                          : gtsam::Pose3(gtsam::Rot3(), control.position);
+    if (c < num_applied) {
+      const auto& prev = applied_poses_[c];
+      const double translation = (pose.translation() - prev.translation()).norm();
+      const double rotation =
+          gtsam::Rot3::Logmap(prev.rotation().between(pose.rotation())).norm();
+      if (translation <= config.min_control_translation &&
+          rotation <= config.min_control_rotation) {
+        continue;
+      }
+    }
+
+    applied_poses_[c] = pose;
+    moved_[c] = 1;
+  }
+}
+
+void MeshDeformer::updateNeighbors(size_t index,
+                                   const Eigen::Vector3d& pos,
+                                   uint64_t stamp_ns,
+                                   bool archived,
+                                   std::vector<std::pair<double, size_t>>& candidates) {
+  const uint64_t lower =
+      stamp_ns > interp_horizon_ns_ ? stamp_ns - interp_horizon_ns_ : 0;
+  const uint64_t upper = stamp_ns + interp_horizon_ns_;
+
+  candidates.clear();
+  auto iter = std::lower_bound(
+      by_stamp_.begin(), by_stamp_.end(), lower, [this](size_t c, uint64_t stamp) {
+        return controls_[c].stamp_ns < stamp;
+      });
+  for (; iter != by_stamp_.end() && controls_[*iter].stamp_ns <= upper; ++iter) {
+    candidates.emplace_back((controls_[*iter].position - pos).norm(), *iter);
+  }
+
+  // weights follow embedded deformation: (1 - d / d_max)^2 where d_max is the
+  // distance to the first control point past the used neighbors
+  const size_t k = num_interp_pts_;
+  const size_t num_used = std::min(k, candidates.size());
+  const size_t num_sorted = std::min(k + 1, candidates.size());
+  std::partial_sort(
+      candidates.begin(), candidates.begin() + num_sorted, candidates.end());
+
+  double* weights = weights_.data() + index * k;
+  size_t* neighbors = neighbors_.data() + index * k;
+  double total = 0.0;
+  const double d_max = candidates.size() > k ? candidates[k].first : 0.0;
+  for (size_t j = 0; j < num_used; ++j) {
+    neighbors[j] = candidates[j].second;
+    const double w = d_max > 0.0 ? 1.0 - candidates[j].first / d_max : 0.0;
+    weights[j] = w * w;
+    total += weights[j];
+  }
+
+  if (total <= 0.0) {
+    // not enough control points to compute falloff weights
+    std::fill(weights, weights + num_used, 1.0);
+    total = num_used;
+  }
+
+  for (size_t j = 0; j < num_used; ++j) {
+    weights[j] /= total;
+  }
+
+  num_neighbors_[index] = num_used;
+  // control points arrive in time order, so archived vertices whose time window has
+  // passed will not see any new neighbors
+  vertex_final_[index] = archived && max_control_stamp_ns_ > upper;
+}
+
+Eigen::Vector3f MeshDeformer::deformVertex(size_t index,
+                                           const Eigen::Vector3d& pos) const {
+  const size_t k = num_interp_pts_;
+  const size_t num_neighbors = num_neighbors_[index];
+  if (!num_neighbors) {
+    return pos.cast<float>();
+  }
+
+  Eigen::Vector3d result = Eigen::Vector3d::Zero();
+  for (size_t j = 0; j < num_neighbors; ++j) {
+    const auto c = neighbors_[index * k + j];
+    const auto& pose = applied_poses_[c];
+    const Eigen::Vector3d local = pos - controls_[c].position;
+    const Eigen::Vector3d deformed = pose.rotation().rotate(local) + pose.translation();
+    result += weights_[index * k + j] * deformed;
+  }
+
+  return result.cast<float>();
+}
+
+}  // namespace hydra
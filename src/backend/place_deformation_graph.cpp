@@ -0,0 +1,314 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "hydra/backend/place_deformation_graph.h"
+
+#include <glog/logging.h>
+#include <gtsam/inference/Symbol.h>
+#include <gtsam/slam/BetweenFactor.h>
+#include <kimera_pgmo/deformation_graph.h>
+
+#include <limits>
+#include <set>
+
+namespace hydra {
+
+namespace {
+
+inline gtsam::Pose3 toPose(const Eigen::Vector3d& pos) {
+  return gtsam::Pose3(gtsam::Rot3(), pos);
+}
+
+}  // namespace
+
+PlaceDeformationGraph::PlaceDeformationGraph(char vertex_prefix,
+                                             double mesh_variance,
+                                             double edge_variance)
+    : vertex_prefix_(vertex_prefix),
+      mesh_noise_(gtsam::noiseModel::Isotropic::Variance(3, mesh_variance)),
+      edge_noise_(gtsam::noiseModel::Isotropic::Variance(6, edge_variance)) {}
+
+void PlaceDeformationGraph::addVertex(size_t index, const Eigen::Vector3d& pos) {
+  vertices_[index] = pos;
+  auto iter = waiting_.find(index);
+  if (iter == waiting_.end()) {
+    return;
+  }
+
+  refresh_.insert(iter->second.begin(), iter->second.end());
+  waiting_.erase(iter);
+}
+
+void PlaceDeformationGraph::markChanged(NodeId node) { pending_.insert(node); }
+
+void PlaceDeformationGraph::markRemoved(NodeId node) {
+  if (places_.count(node)) {
+    pending_.insert(node);
+  } else {
+    pending_.erase(node);
+  }
+}
+
+bool PlaceDeformationGraph::update(const SceneGraphLayer& places) {
+  modified_ = false;
+
+  // active places can change without being re-added
+  std::unordered_set<NodeId> changed(pending_.begin(), pending_.end());
+  changed.insert(active_.begin(), active_.end());
+  changed.insert(refresh_.begin(), refresh_.end());
+  std::unordered_set<NodeId> refresh = std::move(refresh_);
+  pending_.clear();
+  refresh_.clear();
+
+  std::vector<NodeId> moved;
+  for (const auto node_id : changed) {
+    const auto node = places.findNode(node_id);
+    if (node) {
+      bool was_moved, reconnected;
+      updatePlace(*node, was_moved, reconnected);
+      if (was_moved) {
+        moved.push_back(node_id);
+      }
+
+      if (was_moved || reconnected) {
+        refresh.insert(node_id);
+      }
+
+      continue;
+    }
+
+    auto iter = places_.find(node_id);
+    if (iter == places_.end()) {
+      continue;
+    }
+
+    for (const auto slot : iter->second.valence_slots) {
+      removeFactor(slot);
+    }
+
+    places_.erase(iter);
+    active_.erase(node_id);
+    forest_.removeNode(node_id);
+    if (values_.exists(node_id)) {
+      values_.erase(node_id);
+      modified_ = true;
+    }
+  }
+
+  // edge weights depend on the (updated) positions of both endpoints
+  for (const auto node_id : changed) {
+    const auto node = places.findNode(node_id);
+    if (node) {
+      updateEdges(*node);
+    }
+  }
+
+  std::vector<Edge> added, removed;
+  forest_.popChanges(added, removed);
+  std::unordered_set<NodeId> touched(changed);
+  for (const auto& edge : removed) {
+    auto iter = edge_slots_.find(edge);
+    if (iter != edge_slots_.end()) {
+      removeFactor(iter->second);
+      edge_slots_.erase(iter);
+    }
+
+    touched.insert(edge.first);
+    touched.insert(edge.second);
+  }
+
+  std::set<Edge> to_update(added.begin(), added.end());
+  for (const auto& edge : added) {
+    touched.insert(edge.first);
+    touched.insert(edge.second);
+  }
+
+  for (const auto node_id : moved) {
+    for (const auto& id_weight_pair : forest_.forestNeighbors(node_id)) {
+      const auto neighbor = id_weight_pair.first;
+      to_update.insert(node_id < neighbor ? Edge(node_id, neighbor)
+                                          : Edge(neighbor, node_id));
+    }
+  }
+
+  for (const auto& edge : to_update) {
+    updateEdgeFactor(edge);
+  }
+
+  for (const auto node_id : touched) {
+    updateFactors(node_id, refresh.count(node_id));
+  }
+
+  return modified_;
+}
+
+void PlaceDeformationGraph::updatePlace(const SceneGraphNode& node,
+                                        bool& moved,
+                                        bool& reconnected) {
+  const auto& attrs = node.attributes<PlaceNodeAttributes>();
+  std::vector<size_t> connections;
+  for (const auto idx : attrs.deformation_connections) {
+    if (idx != std::numeric_limits<size_t>::max()) {
+      connections.push_back(idx);
+    }
+  }
+
+  const auto [iter, inserted] = places_.emplace(node.id, Place());
+  auto& place = iter->second;
+  moved = inserted || place.position != attrs.position;
+  reconnected = inserted || place.connections != connections;
+  place.position = attrs.position;
+  place.connections = std::move(connections);
+  if (attrs.is_active) {
+    active_.insert(node.id);
+  } else {
+    active_.erase(node.id);
+  }
+}
+
+void PlaceDeformationGraph::updateEdges(const SceneGraphNode& node) {
+  const auto& siblings = node.siblings();
+  std::vector<NodeId> removed;
+  for (const auto& id_weight_pair : forest_.neighbors(node.id)) {
+    if (!siblings.count(id_weight_pair.first)) {
+      removed.push_back(id_weight_pair.first);
+    }
+  }
+
+  for (const auto neighbor : removed) {
+    forest_.removeEdge(node.id, neighbor);
+  }
+
+  const auto& pos = places_.at(node.id).position;
+  for (const auto sibling : siblings) {
+    auto iter = places_.find(sibling);
+    if (iter == places_.end()) {
+      continue;  // added once the sibling is tracked
+    }
+
+    forest_.addEdge(node.id, sibling, (pos - iter->second.position).norm());
+  }
+}
+
+void PlaceDeformationGraph::updateFactors(NodeId node, bool refresh) {
+  auto iter = places_.find(node);
+  if (iter == places_.end()) {
+    return;
+  }
+
+  auto& place = iter->second;
+  const auto degree = forest_.degree(node);
+  if (!degree) {
+    if (values_.exists(node)) {
+      values_.erase(node);
+      modified_ = true;
+    }
+  } else if (!values_.exists(node)) {
+    values_.insert(node, toPose(place.position));
+    modified_ = true;
+  } else if (refresh) {
+    values_.update(node, toPose(place.position));
+  }
+
+  // only forest leaves are attached to the mesh
+  const bool leaf = degree == 1;
+  if (leaf == place.leaf && (!leaf || !refresh)) {
+    return;
+  }
+
+  for (const auto slot : place.valence_slots) {
+    removeFactor(slot);
+  }
+
+  place.valence_slots.clear();
+  place.leaf = leaf;
+  if (!leaf) {
+    return;
+  }
+
+  const auto node_pose = toPose(place.position);
+  for (const auto idx : place.connections) {
+    auto vertex = vertices_.find(idx);
+    if (vertex == vertices_.end()) {
+      waiting_[idx].insert(node);
+      continue;
+    }
+
+    const gtsam::Symbol key(vertex_prefix_, idx);
+    place.valence_slots.push_back(addFactor(gtsam::NonlinearFactor::shared_ptr(
+        new kimera_pgmo::DeformationEdgeFactor(
+            node, key, node_pose, vertex->second, mesh_noise_))));
+    place.valence_slots.push_back(addFactor(gtsam::NonlinearFactor::shared_ptr(
+        new kimera_pgmo::DeformationEdgeFactor(
+            key, node, toPose(vertex->second), place.position, mesh_noise_))));
+  }
+}
+
+void PlaceDeformationGraph::updateEdgeFactor(const Edge& edge) {
+  const auto source = toPose(places_.at(edge.first).position);
+  const auto target = toPose(places_.at(edge.second).position);
+  gtsam::NonlinearFactor::shared_ptr factor(new gtsam::BetweenFactor<gtsam::Pose3>(
+      edge.first, edge.second, source.between(target), edge_noise_));
+
+  auto iter = edge_slots_.find(edge);
+  if (iter == edge_slots_.end()) {
+    edge_slots_.emplace(edge, addFactor(factor));
+    return;
+  }
+
+  factors_.replace(iter->second, factor);
+  modified_ = true;
+}
+
+size_t PlaceDeformationGraph::addFactor(
+    const gtsam::NonlinearFactor::shared_ptr& factor) {
+  modified_ = true;
+  if (free_slots_.empty()) {
+    factors_.push_back(factor);
+    return factors_.size() - 1;
+  }
+
+  const auto slot = free_slots_.back();
+  free_slots_.pop_back();
+  factors_.replace(slot, factor);
+  return slot;
+}
+
+void PlaceDeformationGraph::removeFactor(size_t slot) {
+  modified_ = true;
+  factors_.remove(slot);
+  free_slots_.push_back(slot);
+}
+
+}  // namespace hydra
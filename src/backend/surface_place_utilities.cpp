@@ -34,11 +34,130 @@
  * -------------------------------------------------------------------------- */
 #include "hydra/backend/surface_place_utilities.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace hydra::utils {
 
+EllipseBounds EllipseBounds::fromQuadric(const Eigen::Matrix2d& A,
+                                         const Eigen::Vector2d& c) {
+  // the quadratic form only depends on the symmetric part of A
+  const Eigen::Matrix2d S = 0.5 * (A + A.transpose());
+  const double det = S.determinant();
+  EllipseBounds bounds;
+  if (!(det > 0.0) || !(S(0, 0) > 0.0) || !c.allFinite()) {
+    return bounds;
+  }
+
+  // half-extents of the ellipse are the square roots of the diagonal of S^-1
+  const Eigen::Vector2d extent(std::sqrt(S(1, 1) / det), std::sqrt(S(0, 0) / det));
+  if (!extent.allFinite()) {
+    return bounds;
+  }
+
+  bounds.bounded = true;
+  bounds.min = c - extent;
+  bounds.max = c + extent;
+  return bounds;
+}
+
+bool EllipseBounds::intersects(const EllipseBounds& other) const {
+  if (!bounded || !other.bounded) {
+    return true;
+  }
+
+  return (min.array() <= other.max.array()).all() &&
+         (other.min.array() <= max.array()).all();
+}
+
+EllipseGrid::EllipseGrid(const std::vector<EllipseBounds>& bounds)
+    : cell_size_(0.0), bounds_(bounds) {
+  size_t num_bounded = 0;
+  for (const auto& b : bounds_) {
+    if (b.bounded) {
+      cell_size_ += (b.max - b.min).maxCoeff();
+      ++num_bounded;
+    }
+  }
+
+  // cells roughly the size of an average ellipse keep both the number of cells per
+  // ellipse and the number of ellipses per cell small
+  cell_size_ = num_bounded ? std::max(cell_size_ / num_bounded, 1.0e-3) : 1.0;
+
+  Eigen::Matrix<int64_t, 2, 1> lower, upper;
+  for (size_t i = 0; i < bounds_.size(); ++i) {
+    if (!getCellRange(bounds_[i], lower, upper)) {
+      unbounded_.push_back(i);
+      continue;
+    }
+
+    for (int64_t x = lower.x(); x <= upper.x(); ++x) {
+      for (int64_t y = lower.y(); y <= upper.y(); ++y) {
+        cells_[cellKey(x, y)].push_back(i);
+      }
+    }
+  }
+}
+
+void EllipseGrid::candidates(size_t i, std::vector<size_t>& result) const {
+  result.clear();
+  const auto& query = bounds_.at(i);
+  Eigen::Matrix<int64_t, 2, 1> lower, upper;
+  if (!getCellRange(query, lower, upper)) {
+    for (size_t j = i + 1; j < bounds_.size(); ++j) {
+      result.push_back(j);
+    }
+
+    return;
+  }
+
+  for (int64_t x = lower.x(); x <= upper.x(); ++x) {
+    for (int64_t y = lower.y(); y <= upper.y(); ++y) {
+      const auto iter = cells_.find(cellKey(x, y));
+      if (iter == cells_.end()) {
+        continue;
+      }
+
+      for (const auto j : iter->second) {
+        if (j > i && query.intersects(bounds_[j])) {
+          result.push_back(j);
+        }
+      }
+    }
+  }
+
+  for (const auto j : unbounded_) {
+    if (j > i) {
+      result.push_back(j);
+    }
+  }
+
+  // ellipses spanning multiple cells are found once per shared cell
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
+EllipseGrid::CellKey EllipseGrid::cellKey(int64_t x, int64_t y) const {
+  return (static_cast<uint64_t>(x) << 32) | static_cast<uint32_t>(y);
+}
+
+bool EllipseGrid::getCellRange(const EllipseBounds& bounds,
+                               Eigen::Matrix<int64_t, 2, 1>& lower,
+                               Eigen::Matrix<int64_t, 2, 1>& upper) const {
+  // ellipses that would cover too many cells are treated as unbounded
+  constexpr double max_cells_per_axis = 64.0;
+  if (!bounds.bounded ||
+      ((bounds.max - bounds.min) / cell_size_).maxCoeff() > max_cells_per_axis) {
+    return false;
+  }
+
+  lower = (bounds.min / cell_size_).array().floor().cast<int64_t>();
+  upper = (bounds.max / cell_size_).array().floor().cast<int64_t>();
+  return true;
+}
+
 void getPlace2dAndNeighors(const SceneGraphLayer& places_layer,
-                           std::vector<std::pair<NodeId, Place2d>>& place_2ds,
-                           std::map<NodeId, std::set<NodeId>>& node_neighbors) {
+                           std::vector<std::pair<NodeId, Place2d>>& place_2ds) {
   for (auto& id_node_pair : places_layer.nodes()) {
     auto& attrs = id_node_pair.second->attributes<Place2dNodeAttributes>();
     if (attrs.need_finish_merge) {
@@ -47,7 +166,6 @@ void getPlace2dAndNeighors(const SceneGraphLayer& places_layer,
                        attrs.pcl_mesh_connections.begin(),
                        attrs.pcl_mesh_connections.end());
       place_2ds.push_back(std::pair(id_node_pair.first, p));
-      node_neighbors.insert({id_node_pair.first, id_node_pair.second->siblings()});
     }
   }
 }
@@ -90,30 +208,41 @@ void getNecessaryUpdates(
   }
 }
 
-std::map<std::tuple<size_t, size_t, size_t, size_t>, double> buildEdgeMap(
+PlaceEdgeMap buildEdgeMap(
     const std::vector<std::pair<NodeId, std::vector<Place2d>>>& nodes_to_add,
     double place_overlap_threshold,
     double place_neighbor_z_diff) {
-  std::map<std::tuple<size_t, size_t, size_t, size_t>, double> edge_map;
   // compute which pairs of new nodes will need to have an edge added
-  // Currently checks all split merged nodes. Maybe just check neighbors-of-neighbors?
-  for (size_t og_ix = 0; og_ix < nodes_to_add.size(); ++og_ix) {
-    for (size_t split_ix = 0; split_ix < nodes_to_add.at(og_ix).second.size();
-         ++split_ix) {
-      Place2d p1 = nodes_to_add.at(og_ix).second.at(split_ix);
-      for (size_t og_jx = 0; og_jx <= og_ix; ++og_jx) {
-        for (size_t split_jx = 0; split_jx < nodes_to_add.at(og_jx).second.size();
-             ++split_jx) {
-          Place2d p2 = nodes_to_add.at(og_jx).second.at(split_jx);
-          double weight;
-          bool connected = shouldAddPlaceConnection(
-              p1, p2, place_overlap_threshold, place_neighbor_z_diff, weight);
-          edge_map.insert({std::make_tuple(og_ix, split_ix, og_jx, split_jx),
-                           connected ? weight : 0});
-        }
+  std::vector<const Place2d*> places;
+  std::vector<EllipseBounds> bounds;
+  for (const auto& id_places_pair : nodes_to_add) {
+    for (const auto& place : id_places_pair.second) {
+      places.push_back(&place);
+      bounds.push_back(place_overlap_threshold < 0
+                           ? EllipseBounds()
+                           : EllipseBounds::fromQuadric(place.ellipse_matrix_expand,
+                                                        place.ellipse_centroid));
+    }
+  }
+
+  PlaceEdgeMap edge_map;
+  const EllipseGrid grid(bounds);
+  std::vector<size_t> candidates;
+  for (size_t i = 0; i < places.size(); ++i) {
+    grid.candidates(i, candidates);
+    for (const auto j : candidates) {
+      double weight;
+      if (shouldAddPlaceConnection(*places[j],
+                                   *places[i],
+                                   place_overlap_threshold,
+                                   place_neighbor_z_diff,
+                                   weight) &&
+          weight > 0) {
+        edge_map.emplace(placePairKey(i, j), weight);
       }
     }
   }
+
   return edge_map;
 }
 
@@ -154,15 +283,13 @@ NodeSymbol insertNewNodes(
     const double place_max_neighbor_z_diff,
     NodeSymbol next_node_symbol,
     DynamicSceneGraph& graph,
-    std::map<std::tuple<size_t, size_t>, NodeId>& new_id_map) {
+    std::vector<NodeId>& new_ids) {
   // insert new nodes that needed to be split
-  int og_ix = 0;
   for (auto& id_places_pair : nodes_to_add) {
     const auto& node = graph.getNode(id_places_pair.first);
     auto& attrs_og = node.attributes<Place2dNodeAttributes>();
 
-    int split_ix = 0;
-    for (Place2d place : id_places_pair.second) {
+    for (const Place2d& place : id_places_pair.second) {
       NodeSymbol node_id_for_place = next_node_symbol++;
       Place2dNodeAttributes::Ptr attrs = std::make_unique<Place2dNodeAttributes>();
       pcl::PointXYZ centroid;
@@ -194,7 +321,7 @@ NodeSymbol insertNewNodes(
       attrs->need_finish_merge = false;
 
       graph.emplaceNode(DsgLayers::MESH_PLACES, node_id_for_place, std::move(attrs));
-      new_id_map.insert({std::make_tuple(og_ix, split_ix), node_id_for_place});
+      new_ids.push_back(node_id_for_place);
 
       auto& attrs_added =
           graph.getNode(node_id_for_place).attributes<Place2dNodeAttributes>();
@@ -218,43 +345,21 @@ NodeSymbol insertNewNodes(
       for (const auto& [source, target] : edges_to_add) {
         graph.insertEdge(source, target);  // TODO add edge attributes
       }
-
-      ++split_ix;
     }
 
-    ++og_ix;
     graph.removeNode(id_places_pair.first);
   }
   return next_node_symbol;
 }
 
-void addNewNodeEdges(
-    const std::vector<std::pair<NodeId, std::vector<Place2d>>> nodes_to_add,
-    const std::map<std::tuple<size_t, size_t, size_t, size_t>, double> edge_map,
-    const std::map<std::tuple<size_t, size_t>, NodeId> new_id_map,
-    DynamicSceneGraph& graph) {
-  // It looks like this loop would take a long time, but all of these sizes should be
-  // extremely small (e.g. 2ish)
-  for (size_t og_ix = 0; og_ix < nodes_to_add.size(); ++og_ix) {
-    for (size_t split_ix = 0; split_ix < nodes_to_add.at(og_ix).second.size();
-         ++split_ix) {
-      Place2d p1 = nodes_to_add.at(og_ix).second.at(split_ix);
-      for (size_t og_jx = 0; og_jx <= og_ix; ++og_jx) {
-        for (size_t split_jx = 0; split_jx < nodes_to_add.at(og_jx).second.size();
-             ++split_jx) {
-          double weight =
-              edge_map.at(std::make_tuple(og_ix, split_ix, og_jx, split_jx));
-          if (weight > 0) {
-            NodeId n1 = new_id_map.at(std::make_tuple(og_ix, split_ix));
-            NodeId n2 = new_id_map.at(std::make_tuple(og_jx, split_jx));
-            EdgeAttributes ea;
-            ea.weight = weight;
-            ea.weighted = true;
-            graph.insertEdge(n1, n2, ea.clone());
-          }
-        }
-      }
-    }
+void addNewNodeEdges(const PlaceEdgeMap& edge_map,
+                     const std::vector<NodeId>& new_ids,
+                     DynamicSceneGraph& graph) {
+  for (const auto& [key, weight] : edge_map) {
+    EdgeAttributes ea;
+    ea.weight = weight;
+    ea.weighted = true;
+    graph.insertEdge(new_ids.at(key >> 32), new_ids.at(key & 0xFFFFFFFF), ea.clone());
   }
 }
 
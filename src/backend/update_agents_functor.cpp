@@ -43,6 +43,13 @@ namespace hydra {
 
 using timing::ScopedTimer;
 
+LayerAccess UpdateAgentsFunctor::access() const {
+  LayerAccess my_access;
+  my_access.reads = {DsgLayers::AGENTS};
+  my_access.writes = {DsgLayers::AGENTS};
+  return my_access;
+}
+
 MergeList UpdateAgentsFunctor::call(const DynamicSceneGraph&,
                                     SharedDsgInfo& dsg,
                                     const UpdateInfo::ConstPtr& info) const {
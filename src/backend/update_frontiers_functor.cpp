@@ -53,6 +53,11 @@ UpdateFunctor::Hooks UpdateFrontiersFunctor::hooks() const {
   return my_hooks;
 }
 
+LayerAccess UpdateFrontiersFunctor::access() const {
+  // frontiers are only updated during cleanup
+  return {};
+}
+
 MergeList UpdateFrontiersFunctor::call(const DynamicSceneGraph&,
                                        SharedDsgInfo&,
                                        const UpdateInfo::ConstPtr&) const {
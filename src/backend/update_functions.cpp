@@ -34,6 +34,8 @@
  * -------------------------------------------------------------------------- */
 #include "hydra/backend/update_functions.h"
 
+#include <algorithm>
+
 namespace hydra {
 
 namespace {
@@ -43,6 +45,24 @@ inline NodeId getRemappedNode(const std::map<NodeId, NodeId>& remapping, NodeId
   return iter == remapping.end() ? node : iter->second;
 }
 
+inline bool intersects(const std::set<LayerId>& lhs, const std::set<LayerId>& rhs) {
+  auto liter = lhs.begin();
+  auto riter = rhs.begin();
+  while (liter != lhs.end() && riter != rhs.end()) {
+    if (*liter == *riter) {
+      return true;
+    }
+
+    if (*liter < *riter) {
+      ++liter;
+    } else {
+      ++riter;
+    }
+  }
+
+  return false;
+}
+
 }  // namespace
 
 Merge Merge::remap(const std::map<NodeId, NodeId>& remapping) const {
@@ -55,6 +75,62 @@ std::ostream& operator<<(std::ostream& out, const Merge& merge) {
   return out;
 }
 
+bool LayerAccess::conflictsWith(const LayerAccess& other) const {
+  if (unknown || other.unknown) {
+    return true;
+  }
+
+  return intersects(writes, other.writes) || intersects(writes, other.reads) ||
+         intersects(reads, other.writes);
+}
+
+std::vector<std::vector<size_t>> scheduleUpdateFunctors(
+    const std::vector<LayerAccess>& accesses) {
+  // each functor runs one level after the last functor it conflicts with
+  std::vector<size_t> levels(accesses.size(), 0);
+  size_t num_levels = 0;
+  for (size_t i = 0; i < accesses.size(); ++i) {
+    for (size_t j = 0; j < i; ++j) {
+      if (accesses[i].conflictsWith(accesses[j])) {
+        levels[i] = std::max(levels[i], levels[j] + 1);
+      }
+    }
+
+    num_levels = std::max(num_levels, levels[i] + 1);
+  }
+
+  // concurrent functors in a level share a stage, other functors follow one by one
+  std::vector<std::vector<size_t>> stages;
+  for (size_t level = 0; level < num_levels; ++level) {
+    std::vector<size_t> batch;
+    std::vector<size_t> exclusive;
+    for (size_t i = 0; i < accesses.size(); ++i) {
+      if (levels[i] != level) {
+        continue;
+      }
+
+      auto& stage = accesses[i].concurrent() ? batch : exclusive;
+      stage.push_back(i);
+    }
+
+    if (!batch.empty()) {
+      stages.push_back(batch);
+    }
+
+    for (const auto idx : exclusive) {
+      stages.push_back({idx});
+    }
+  }
+
+  return stages;
+}
+
+LayerAccess UpdateFunctor::access() const {
+  LayerAccess my_access;
+  my_access.unknown = true;
+  return my_access;
+}
+
 UpdateFunctor::Hooks UpdateFunctor::hooks() const {
   Hooks my_hooks;
   my_hooks.update = [this](const DynamicSceneGraph& unmerged,
@@ -37,6 +37,7 @@
 #include <glog/logging.h>
 
 #include "hydra/backend/backend_utilities.h"
+#include "hydra/common/global_info.h"
 #include "hydra/utils/mesh_utilities.h"
 #include "hydra/utils/timing_utilities.h"
 
@@ -86,6 +87,13 @@ UpdateFunctor::Hooks UpdateObjectsFunctor::hooks() const {
   return my_hooks;
 }
 
+LayerAccess UpdateObjectsFunctor::access() const {
+  LayerAccess my_access;
+  my_access.reads = {DsgLayers::OBJECTS};
+  my_access.writes = {DsgLayers::OBJECTS};
+  return my_access;
+}
+
 MergeList UpdateObjectsFunctor::call(const DynamicSceneGraph& unmerged,
                                      SharedDsgInfo& dsg,
                                      const UpdateInfo::ConstPtr& info) const {
@@ -102,7 +110,9 @@ MergeList UpdateObjectsFunctor::call(const DynamicSceneGraph& unmerged,
   const auto& objects = unmerged.getLayer(DsgLayers::OBJECTS);
   makeSemanticNodeFinders(objects, node_finders);
   // we want to iterate over the unmerged graph
-  LayerView view = new_loopclosure ? LayerView(objects) : active_tracker.view(objects);
+  const auto view = new_loopclosure
+                        ? ActiveWindowView(objects)
+                        : active_tracker.view(objects, info->active_windows);
 
   // apply updates to every attribute that may have changed since the last call
   size_t num_changed = 0;
@@ -139,16 +149,7 @@ MergeList UpdateObjectsFunctor::call(const DynamicSceneGraph& unmerged,
     return {};
   }
 
-  MergeList proposals;
-  for (const auto& node_id : seen_nodes) {
-    const auto& attrs = unmerged.getNode(node_id).attributes<ObjectNodeAttributes>();
-    const auto proposed = proposeMerge(objects, attrs);
-    if (proposed) {
-      proposals.push_back({node_id, *proposed});
-    }
-  }
-
-  return proposals;
+  return proposeMerges(objects, seen_nodes);
 }
 
 MergeId UpdateObjectsFunctor::proposeMerge(const SceneGraphLayer& layer,
@@ -161,7 +162,7 @@ MergeId UpdateObjectsFunctor::proposeMerge(const SceneGraphLayer& layer,
 
   // we skip the first entry if the node attributes aren't active (to avoid returning
   // the same node)
-  std::list<NodeId> candidates;
+  std::vector<NodeId> candidates;
   (*iter).second->find(attrs.position,
                        num_merges_to_consider,
                        !attrs.is_active,
@@ -169,6 +170,12 @@ MergeId UpdateObjectsFunctor::proposeMerge(const SceneGraphLayer& layer,
                          candidates.push_back(object_id);
                        });
 
+  return selectMerge(layer, attrs, candidates);
+}
+
+MergeId UpdateObjectsFunctor::selectMerge(const SceneGraphLayer& layer,
+                                          const ObjectNodeAttributes& attrs,
+                                          const std::vector<NodeId>& candidates) const {
   for (const auto& id : candidates) {
     const auto& candiate = layer.getNode(id).attributes<ObjectNodeAttributes>();
     if (attrs.bounding_box.contains(candiate.position) ||
@@ -180,4 +187,56 @@ MergeId UpdateObjectsFunctor::proposeMerge(const SceneGraphLayer& layer,
   return std::nullopt;
 }
 
+MergeList UpdateObjectsFunctor::proposeMerges(const SceneGraphLayer& layer,
+                                              const std::list<NodeId>& nodes) const {
+  std::vector<const ObjectNodeAttributes*> node_attrs;
+  std::map<SemanticLabel, std::vector<size_t>> label_queries;
+  for (const auto& node_id : nodes) {
+    const auto& attrs = layer.getNode(node_id).attributes<ObjectNodeAttributes>();
+    label_queries[attrs.semantic_label].push_back(node_attrs.size());
+    node_attrs.push_back(&attrs);
+  }
+
+  // results are stored by query order so proposals match the per-node ordering
+  std::vector<MergeId> proposed(node_attrs.size());
+  const auto num_threads = GlobalInfo::instance().getConfig().default_num_threads;
+  NeighborBatch<double> neighbors;
+  std::vector<NodeId> candidates;
+  for (const auto& [label, queries] : label_queries) {
+    const auto iter = node_finders.find(label);
+    if (iter == node_finders.end()) {
+      continue;
+    }
+
+    const auto& finder = *iter->second;
+    NearestNodeFinder::Queries positions(3, queries.size());
+    std::vector<bool> skip_first(queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+      positions.col(i) = node_attrs[queries[i]]->position;
+      skip_first[i] = !node_attrs[queries[i]]->is_active;
+    }
+
+    finder.findBatch(
+        positions, num_merges_to_consider, skip_first, neighbors, num_threads);
+    for (size_t i = 0; i < queries.size(); ++i) {
+      candidates.clear();
+      for (size_t n = 0; n < neighbors.num_found[i]; ++n) {
+        candidates.push_back(finder.nodeId(neighbors.index(i, n)));
+      }
+
+      proposed[queries[i]] = selectMerge(layer, *node_attrs[queries[i]], candidates);
+    }
+  }
+
+  MergeList proposals;
+  auto node_iter = nodes.begin();
+  for (size_t i = 0; i < proposed.size(); ++i, ++node_iter) {
+    if (proposed[i]) {
+      proposals.push_back({*node_iter, *proposed[i]});
+    }
+  }
+
+  return proposals;
+}
+
 }  // namespace hydra
@@ -38,6 +38,7 @@
 #include <glog/logging.h>
 #include <gtsam/geometry/Pose3.h>
 
+#include "hydra/common/global_info.h"
 #include "hydra/utils/timing_utilities.h"
 
 namespace hydra {
@@ -65,7 +66,7 @@ void UpdatePlacesFunctor::updatePlace(const gtsam::Values& values,
 MergeId UpdatePlacesFunctor::proposeMerge(const SceneGraphLayer& layer,
                                           const SceneGraphNode& from_node) const {
   const auto& from_attrs = from_node.attributes<PlaceNodeAttributes>();
-  std::list<NodeId> candidates;
+  std::vector<NodeId> candidates;
   node_finder->find(from_attrs.position,
                     num_merges_to_consider,
                     !from_attrs.is_active,
@@ -73,6 +74,13 @@ MergeId UpdatePlacesFunctor::proposeMerge(const SceneGraphLayer& layer,
                       candidates.push_back(place_id);
                     });
 
+  return selectMerge(layer, from_node, candidates);
+}
+
+MergeId UpdatePlacesFunctor::selectMerge(const SceneGraphLayer& layer,
+                                         const SceneGraphNode& from_node,
+                                         const std::vector<NodeId>& candidates) const {
+  const auto& from_attrs = from_node.attributes<PlaceNodeAttributes>();
   for (const auto& id : candidates) {
     // TODO(nathan) reconsider this
     if (from_node.siblings().count(id)) {
@@ -94,6 +102,42 @@ MergeId UpdatePlacesFunctor::proposeMerge(const SceneGraphLayer& layer,
   return std::nullopt;
 }
 
+MergeList UpdatePlacesFunctor::proposeMerges(
+    const SceneGraphLayer& layer,
+    const std::vector<const SceneGraphNode*>& nodes) const {
+  NearestNodeFinder::Queries positions(3, nodes.size());
+  // we skip the first entry for archived nodes (to avoid returning the same node)
+  std::vector<bool> skip_first(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const auto& attrs = nodes[i]->attributes<PlaceNodeAttributes>();
+    positions.col(i) = attrs.position;
+    skip_first[i] = !attrs.is_active;
+  }
+
+  NeighborBatch<double> neighbors;
+  node_finder->findBatch(positions,
+                         num_merges_to_consider,
+                         skip_first,
+                         neighbors,
+                         GlobalInfo::instance().getConfig().default_num_threads);
+
+  MergeList proposals;
+  std::vector<NodeId> candidates;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    candidates.clear();
+    for (size_t n = 0; n < neighbors.num_found[i]; ++n) {
+      candidates.push_back(node_finder->nodeId(neighbors.index(i, n)));
+    }
+
+    const auto proposed = selectMerge(layer, *nodes[i], candidates);
+    if (proposed) {
+      proposals.push_back({nodes[i]->id, *proposed});
+    }
+  }
+
+  return proposals;
+}
+
 // drops any isolated place nodes that would cause an inderminate system error
 void UpdatePlacesFunctor::filterMissing(DynamicSceneGraph& graph,
                                         const std::list<NodeId> missing_nodes) const {
@@ -117,6 +161,15 @@ void UpdatePlacesFunctor::filterMissing(DynamicSceneGraph& graph,
   }
 }
 
+LayerAccess UpdatePlacesFunctor::access() const {
+  LayerAccess my_access;
+  my_access.reads = {DsgLayers::PLACES};
+  my_access.writes = {DsgLayers::PLACES};
+  // isolated places that fail to update are removed
+  my_access.structural = true;
+  return my_access;
+}
+
 MergeList UpdatePlacesFunctor::call(const DynamicSceneGraph& unmerged,
                                     SharedDsgInfo& dsg,
                                     const UpdateInfo::ConstPtr& info) const {
@@ -147,11 +200,12 @@ MergeList UpdatePlacesFunctor::call(const DynamicSceneGraph& unmerged,
   });
 
   // we want to iterate over the unmerged graph
-  LayerView view;
+  ActiveWindowView view;
   if (info->loop_closure_detected) {
-    view = LayerView(unmerged.getLayer(DsgLayers::PLACES));
+    view = ActiveWindowView(unmerged.getLayer(DsgLayers::PLACES));
   } else {
-    view = active_tracker.view(unmerged.getLayer(DsgLayers::PLACES));
+    view = active_tracker.view(unmerged.getLayer(DsgLayers::PLACES),
+                               info->active_windows);
   }
 
   size_t num_changed = 0;
@@ -173,12 +227,12 @@ MergeList UpdatePlacesFunctor::call(const DynamicSceneGraph& unmerged,
   filterMissing(*dsg.graph, missing_nodes);
 
   if (!has_given_merges && node_finder) {
+    std::vector<const SceneGraphNode*> nodes;
     for (const auto& node : view) {
-      const auto proposed = proposeMerge(places, node);
-      if (proposed) {
-        proposals.push_back({node.id, *proposed});
-      }
+      nodes.push_back(&node);
     }
+
+    proposals.splice(proposals.end(), proposeMerges(places, nodes));
   }
 
   active_tracker.clear();
@@ -72,6 +72,15 @@ void UpdateRoomsFunctor::rewriteRooms(const SceneGraphLayer* new_rooms,
   }
 }
 
+LayerAccess UpdateRoomsFunctor::access() const {
+  LayerAccess my_access;
+  my_access.reads = {DsgLayers::PLACES, DsgLayers::ROOMS};
+  // room-place edges change the parents of places
+  my_access.writes = {DsgLayers::PLACES, DsgLayers::ROOMS};
+  my_access.structural = true;
+  return my_access;
+}
+
 MergeList UpdateRoomsFunctor::call(const DynamicSceneGraph&,
                                    SharedDsgInfo& dsg,
                                    const UpdateInfo::ConstPtr& info) const {
@@ -95,6 +104,15 @@ MergeList UpdateRoomsFunctor::call(const DynamicSceneGraph&,
 UpdateBuildingsFunctor::UpdateBuildingsFunctor(const Color& color, SemanticLabel label)
     : building_color(color), building_semantic_label(label) {}
 
+LayerAccess UpdateBuildingsFunctor::access() const {
+  LayerAccess my_access;
+  my_access.reads = {DsgLayers::ROOMS, DsgLayers::BUILDINGS};
+  // building-room edges change the parents of rooms
+  my_access.writes = {DsgLayers::ROOMS, DsgLayers::BUILDINGS};
+  my_access.structural = true;
+  return my_access;
+}
+
 MergeList UpdateBuildingsFunctor::call(const DynamicSceneGraph&,
                                        SharedDsgInfo& dsg,
                                        const UpdateInfo::ConstPtr& info) const {
@@ -163,13 +163,12 @@ MergeId Update2dPlacesFunctor::proposeMerge(const SceneGraphLayer& layer,
 }
 
 void Update2dPlacesFunctor::cleanup(SharedDsgInfo& dsg) const {
-  std::map<NodeId, std::set<NodeId>> node_neighbors;
   std::vector<std::pair<NodeId, Place2d>> place_2ds;
 
   // Get/copy info for places that need cleanup
   std::unique_lock<std::mutex> lock(dsg.mutex);
   const SceneGraphLayer& places_layer = dsg.graph->getLayer(DsgLayers::MESH_PLACES);
-  utils::getPlace2dAndNeighors(places_layer, place_2ds, node_neighbors);
+  utils::getPlace2dAndNeighors(places_layer, place_2ds);
   lock.unlock();
 
   // Decide which places need to be split and which just need to be updated
@@ -198,18 +197,29 @@ void Update2dPlacesFunctor::cleanup(SharedDsgInfo& dsg) const {
 
   // Insert new nodes that are formed by splitting existing nodes (and delete
   // previous node)
-  std::map<std::tuple<size_t, size_t>, NodeId> new_id_map;
+  std::vector<NodeId> new_ids;
   next_node_id_ = utils::insertNewNodes(nodes_to_add,
                                         config_.connection_overlap_threshold,
                                         config_.connection_max_delta_z,
                                         next_node_id_,
                                         graph,
-                                        new_id_map);
+                                        new_ids);
 
   // Add edges between new nodes
-  utils::addNewNodeEdges(nodes_to_add, edge_map, new_id_map, graph);
+  utils::addNewNodeEdges(edge_map, new_ids, graph);
+
+  // nodes to reconnect (and whether they can be finalized) in the order they are found
+  std::vector<std::pair<NodeId, bool>> checked_nodes;
+  std::unordered_map<NodeId, size_t> checked_lookup;
+  const auto check_node = [&](NodeId id, bool finalize) {
+    const auto [iter, inserted] = checked_lookup.emplace(id, checked_nodes.size());
+    if (inserted) {
+      checked_nodes.emplace_back(id, finalize);
+    } else if (finalize) {
+      checked_nodes[iter->second].second = true;
+    }
+  };
 
-  std::unordered_map<NodeId, bool> checked_nodes;
   // Clean up places that are far enough away from the active window
   // Far enough means that none of a node's neighbors or the node itself have
   // active mesh vertices
@@ -227,15 +237,11 @@ void Update2dPlacesFunctor::cleanup(SharedDsgInfo& dsg) const {
           break;
         }
       }
-      checked_nodes[id_node_pair.first] =
-          !has_active_neighbor && !attrs.has_active_mesh_indices;
+      check_node(id_node_pair.first,
+                 !has_active_neighbor && !attrs.has_active_mesh_indices);
       for (NodeId nid : id_node_pair.second->siblings()) {
         auto& neighbor_attrs = graph.getNode(nid).attributes<Place2dNodeAttributes>();
-
-        auto search = checked_nodes.find(nid);
-        if (search == checked_nodes.end()) {
-          checked_nodes.insert({nid, false});
-        }
+        check_node(nid, false);
 
         if (neighbor_attrs.is_active) {
           continue;
@@ -260,30 +266,39 @@ void Update2dPlacesFunctor::cleanup(SharedDsgInfo& dsg) const {
     addBoundaryInfo(mesh->points, attrs);
   }
 
-  std::vector<std::pair<NodeId, NodeId>> edges_to_remove;
-  std::map<NodeId, NodeId> extra_edges_to_check;
-  for (auto& id_finalize : checked_nodes) {
-    NodeId id = id_finalize.first;
-    bool finalize = id_finalize.second;
-    auto& attrs1 = graph.getNode(id).attributes<Place2dNodeAttributes>();
-
-    for (auto& neighbor_id_final : checked_nodes) {
-      NodeId nid = neighbor_id_final.first;
-      auto& neighbor_node = graph.getNode(nid);
-      auto& attrs2 = neighbor_node.attributes<Place2dNodeAttributes>();
+  // only places with overlapping ellipse bounds can be connected
+  std::vector<Place2dNodeAttributes*> checked_attrs;
+  std::vector<utils::EllipseBounds> bounds;
+  for (const auto& [id, finalize] : checked_nodes) {
+    auto& attrs = graph.getNode(id).attributes<Place2dNodeAttributes>();
+    checked_attrs.push_back(&attrs);
+    bounds.push_back(config_.connection_overlap_threshold < 0
+                         ? utils::EllipseBounds()
+                         : utils::EllipseBounds::fromQuadric(
+                               attrs.ellipse_matrix_compress,
+                               attrs.ellipse_centroid.head<2>()));
+  }
+
+  const utils::EllipseGrid grid(bounds);
+  std::vector<size_t> candidates;
+  for (size_t i = 0; i < checked_nodes.size(); ++i) {
+    const auto& [id, finalize] = checked_nodes[i];
+    auto& attrs1 = *checked_attrs[i];
+
+    grid.candidates(i, candidates);
+    for (const auto j : candidates) {
       EdgeAttributes ea;
-      if (!shouldAddPlaceConnection(attrs1,
-                                    attrs2,
-                                    config_.connection_overlap_threshold,
-                                    config_.connection_max_delta_z,
-                                    ea)) {
-        graph.removeEdge(id, nid);
-      } else {
-        graph.insertEdge(id, nid, ea.clone());
+      if (shouldAddPlaceConnection(attrs1,
+                                   *checked_attrs[j],
+                                   config_.connection_overlap_threshold,
+                                   config_.connection_max_delta_z,
+                                   ea)) {
+        graph.insertEdge(id, checked_nodes[j].first, ea.clone());
       }
     }
 
-    std::vector<std::pair<NodeId, NodeId>> sibs_edges_to_remove;
+    // remove any existing edges that are no longer valid
+    std::vector<NodeId> sibs_to_remove;
     for (auto& nid : graph.getNode(id).siblings()) {
       auto neighbor_node = graph.findNode(nid);
       Place2dNodeAttributes& attrs2 =
@@ -294,12 +309,12 @@ void Update2dPlacesFunctor::cleanup(SharedDsgInfo& dsg) const {
                                     config_.connection_overlap_threshold,
                                     config_.connection_max_delta_z,
                                     ea)) {
-        sibs_edges_to_remove.push_back({id, nid});
+        sibs_to_remove.push_back(nid);
       }
     }
 
-    for (auto n1_n2 : sibs_edges_to_remove) {
-      graph.removeEdge(n1_n2.first, n1_n2.second);
+    for (const auto nid : sibs_to_remove) {
+      graph.removeEdge(id, nid);
     }
 
     if (finalize) {
@@ -324,6 +339,14 @@ UpdateFunctor::Hooks Update2dPlacesFunctor::hooks() const {
   return my_hooks;
 }
 
+LayerAccess Update2dPlacesFunctor::access() const {
+  // splitting and reconnecting places only happens during cleanup
+  LayerAccess my_access;
+  my_access.reads = {layer_id_};
+  my_access.writes = {layer_id_};
+  return my_access;
+}
+
 MergeList Update2dPlacesFunctor::call(const DynamicSceneGraph& unmerged,
                                       SharedDsgInfo& dsg,
                                       const UpdateInfo::ConstPtr& info) const {
@@ -336,7 +359,9 @@ MergeList Update2dPlacesFunctor::call(const DynamicSceneGraph& unmerged,
   const auto new_loopclosure = info->loop_closure_detected;
   const auto& layer = unmerged.getLayer(layer_id_);
   makeSemanticNodeFinders(layer, node_finders);
-  const auto view = new_loopclosure ? LayerView(layer) : active_tracker.view(layer);
+  const auto view = new_loopclosure
+                        ? ActiveWindowView(layer)
+                        : active_tracker.view(layer, info->active_windows);
 
   size_t num_changed = 0;
   for (const auto& node : view) {
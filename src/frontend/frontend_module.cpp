@@ -103,6 +103,7 @@ FrontendModule::FrontendModule(const Config& config,
       surface_places_(config.surface_places.create()),
       freespace_places_(config.freespace_places.create()),
       frontier_places_(config.frontier_places.create()),
+      place_mesh_connector_(new PlaceMeshConnector()),
       sinks_(Sink::instantiate(config.sinks)) {
   if (!config.use_frontiers) {
     frontier_places_.reset();
@@ -187,6 +188,10 @@ void FrontendModule::save(const LogSetup& log_setup) {
   const auto output_path = log_setup.getLogDir("frontend");
   dsg_->graph->save(output_path + "/dsg.json", false);
   dsg_->graph->save(output_path + "/dsg_with_mesh.json");
+  if (log_setup.config().save_graph_checkpoints) {
+    // graph and mesh are written in the background from a snapshot
+    checkpoint_writer_.save(*dsg_->graph, output_path + "/dsg.hdck");
+  }
 
   const auto mesh = dsg_->graph->mesh();
   if (mesh && !mesh->empty()) {
@@ -341,6 +346,15 @@ void FrontendModule::updateImpl(const ReconstructionOutput::Ptr& msg) {
     }
   }
 
+  {  // start timing scope
+    // the mesh delta and the deformation graph share one traversal of the active
+    // (updated and not archived) mesh blocks
+    ScopedTimer timer("frontend/mesh_snapshot", msg->timestamp_ns, true, 1, false);
+    const auto& mesh = msg->map().getMeshLayer();
+    mesh_snapshot_ = std::make_shared<PgmoMeshSnapshot>(
+        mesh, getActiveBlocks(mesh, msg->archived_blocks));
+  }  // end timing scope
+
   {  // start timing scope
     ScopedTimer timer("frontend/launch_callbacks", msg->timestamp_ns, true, 1, false);
     launchCallbacks(input_dispatches_, msg);
@@ -360,13 +374,12 @@ void FrontendModule::updateMesh(const ReconstructionOutput& input) {
 
   // TODO(nathan) prune archived blocks from input?
 
-  const auto& input_mesh = input.map().getMeshLayer();
   {
     ScopedTimer timer("frontend/mesh_compression", input.timestamp_ns, true, 1, false);
     mesh_remapping_ = std::make_shared<kimera_pgmo::HashedIndexMapping>();
-    auto mesh = getActiveMesh(input_mesh, input.archived_blocks);
-    VLOG(5) << "[Hydra Frontend] Updating mesh with " << mesh->numBlocks() << " blocks";
-    auto interface = PgmoMeshLayerInterface(*mesh);
+    auto interface = PgmoMeshSnapshotInterface(mesh_snapshot_);
+    VLOG(5) << "[Hydra Frontend] Updating mesh with "
+            << interface.blockIndices().size() << " blocks";
     last_mesh_update_ =
         mesh_compression_->update(interface, input.timestamp_ns, mesh_remapping_.get());
   }  // end timing scope
@@ -411,7 +424,7 @@ void FrontendModule::updateDeformationGraph(const ReconstructionOutput& input) {
   const auto time_ns = std::chrono::nanoseconds(input.timestamp_ns);
   double time_s =
       std::chrono::duration_cast<std::chrono::duration<double>>(time_ns).count();
-  auto interface = PgmoMeshLayerInterface(input.map().getMeshLayer());
+  auto interface = PgmoMeshSnapshotInterface(mesh_snapshot_);
 
   PgmoCloud new_vertices;
   std::vector<size_t> new_indices;
@@ -716,16 +729,28 @@ void FrontendModule::addPlaceObjectEdges(uint64_t timestamp_ns) {
   }
 
   // TODO(nathan) fix active window behavior for objects and places
-  for (const auto& object_id : segmenter_->getActiveNodes()) {
+  const auto active_objects = segmenter_->getActiveNodes();
+  std::vector<NodeId> object_ids;
+  NearestNodeFinder::Queries positions(3, active_objects.size());
+  for (const auto& object_id : active_objects) {
     const auto node = dsg_->graph->findNode(object_id);
     if (!node) {
       continue;
     }
 
-    places_nn_finder_->find(
-        node->attributes().position, 1, false, [&](NodeId place_id, size_t, double) {
-          dsg_->graph->insertParentEdge(place_id, object_id);
-        });
+    positions.col(object_ids.size()) = node->attributes().position;
+    object_ids.push_back(object_id);
+  }
+
+  NeighborBatch<double> neighbors;
+  const auto num_threads = GlobalInfo::instance().getConfig().default_num_threads;
+  places_nn_finder_->findBatch(
+      positions.leftCols(object_ids.size()), 1, false, neighbors, num_threads);
+  for (size_t i = 0; i < object_ids.size(); ++i) {
+    if (neighbors.num_found[i] > 0) {
+      const auto place_id = places_nn_finder_->nodeId(neighbors.index(i, 0));
+      dsg_->graph->insertParentEdge(place_id, object_ids[i]);
+    }
   }
 }
 
@@ -735,6 +760,8 @@ void FrontendModule::addPlaceAgentEdges(uint64_t timestamp_ns) {
     return;  // haven't received places yet
   }
 
+  NeighborBatch<double> neighbors;
+  const auto num_threads = GlobalInfo::instance().getConfig().default_num_threads;
   for (const auto& pair : dsg_->graph->dynamicLayersOfType(DsgLayers::AGENTS)) {
     const LayerPrefix prefix = pair.first;
     const auto& layer = *pair.second;
@@ -749,6 +776,8 @@ void FrontendModule::addPlaceAgentEdges(uint64_t timestamp_ns) {
       curr_active.insert(i);
     }
 
+    std::vector<size_t> agent_indices;
+    NearestNodeFinder::Queries positions(3, curr_active.size());
     auto iter = curr_active.begin();
     while (iter != curr_active.end()) {
       const auto& node = layer.getNodeByIndex(*iter);
@@ -762,60 +791,95 @@ void FrontendModule::addPlaceAgentEdges(uint64_t timestamp_ns) {
         }
       }
 
-      places_nn_finder_->find(
-          node.attributes().position, 1, false, [&](NodeId place_id, size_t, double) {
-            const auto agent_id = prefix.makeId(*iter);
-            dsg_->graph->insertParentEdge(place_id, agent_id);
-          });
-
+      positions.col(agent_indices.size()) = node.attributes().position;
+      agent_indices.push_back(*iter);
       ++iter;
     }
 
+    places_nn_finder_->findBatch(
+        positions.leftCols(agent_indices.size()), 1, false, neighbors, num_threads);
+    for (size_t i = 0; i < agent_indices.size(); ++i) {
+      if (neighbors.num_found[i] > 0) {
+        const auto place_id = places_nn_finder_->nodeId(neighbors.index(i, 0));
+        dsg_->graph->insertParentEdge(place_id, prefix.makeId(agent_indices[i]));
+      }
+    }
+
     last_agent_edge_index_[prefix] = layer.numNodes();
   }
 }
 
 void FrontendModule::updatePlaceMeshMapping(const ReconstructionOutput& input) {
+  ScopedTimer timer("frontend/place_mesh_mapping", input.timestamp_ns, true, 1);
+  if (last_mesh_update_) {
+    // vertex events have to be applied for every update to keep the index and the
+    // deformation mapping valid
+    place_mesh_connector_->updateVertices(last_mesh_update_);
+    updateDeformationMapping(*last_mesh_update_);
+  }
+
   const auto& places = dsg_->graph->getLayer(DsgLayers::PLACES);
   if (places.numNodes() == 0) {
-    // avoid doing work by making the kdtree lookup if we don't have places
+    // avoid doing work if we don't have places
     return;
   }
 
-  ScopedTimer timer("frontend/place_mesh_mapping", input.timestamp_ns, true, 1);
   CHECK(last_mesh_update_);
+  const auto num_missing = place_mesh_connector_->updateConnections(places);
+  place_mesh_connector_->addDeformationConnections(places, vertex_deformation_);
+
+  VLOG_IF(1, num_missing > 0) << "[Frontend] " << num_missing
+                              << " places missing basis points @ " << input.timestamp_ns
+                              << " [ns]";
+}
+
+void FrontendModule::updateDeformationMapping(const kimera_pgmo::MeshDelta& delta) {
   CHECK(mesh_remapping_);
+  // deleted and remapped vertices are given by their previous index
+  for (const auto idx : delta.deleted_indices) {
+    vertex_deformation_.erase(idx);
+  }
+
+  std::vector<std::pair<size_t, size_t>> moved;
+  for (const auto& [prev, curr] : delta.prev_to_curr) {
+    const auto iter = vertex_deformation_.find(prev);
+    if (iter == vertex_deformation_.end() || prev == curr) {
+      continue;
+    }
+
+    moved.emplace_back(curr, iter->second);
+    vertex_deformation_.erase(iter);
+  }
+
+  for (const auto& [curr, vertex] : moved) {
+    vertex_deformation_[curr] = vertex;
+  }
+
+  // vertices before the start of the update were archived and can't be connected
+  vertex_deformation_.erase(vertex_deformation_.begin(),
+                            vertex_deformation_.lower_bound(delta.vertex_start));
 
-  // TODO(nathan) we can maybe put this somewhere else
-  const auto num_active = last_mesh_update_->vertex_updates->size();
-  std::vector<size_t> deformation_mapping(num_active,
-                                          std::numeric_limits<size_t>::max());
+  // only vertices of blocks in the update were (re)assigned mesh indices
   for (const auto& [block, indices] : *mesh_remapping_) {
     const auto block_iter = deformation_remapping_.find(block);
     if (block_iter == deformation_remapping_.end()) {
       LOG(WARNING) << "Missing block " << block.transpose() << " from graph mapping!";
-      continue;
     }
 
-    const auto& block_mapping = block_iter->second;
     for (const auto& [block_idx, mesh_idx] : indices) {
-      const auto vertex_iter = block_mapping.find(block_idx);
-      if (vertex_iter == block_mapping.end()) {
+      if (block_iter == deformation_remapping_.end()) {
+        vertex_deformation_.erase(mesh_idx);
         continue;
       }
 
-      const auto local_idx = last_mesh_update_->getLocalIndex(mesh_idx);
-      CHECK_LT(local_idx, num_active);
-      deformation_mapping[local_idx] = vertex_iter->second;
+      const auto vertex_iter = block_iter->second.find(block_idx);
+      if (vertex_iter == block_iter->second.end()) {
+        vertex_deformation_.erase(mesh_idx);
+      } else {
+        vertex_deformation_[mesh_idx] = vertex_iter->second;
+      }
     }
   }
-
-  PlaceMeshConnector connector(last_mesh_update_);
-  const auto num_missing = connector.addConnections(places, deformation_mapping);
-
-  VLOG_IF(1, num_missing > 0) << "[Frontend] " << num_missing
-                              << " places missing basis points @ " << input.timestamp_ns
-                              << " [ns]";
 }
 
 }  // namespace hydra
@@ -0,0 +1,279 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "hydra/frontend/incremental_clusterer.h"
+
+#include <glog/logging.h>
+
+#include <deque>
+
+namespace hydra {
+
+bool VertexRemapping::apply(std::vector<size_t>& indices) const {
+  if (empty()) {
+    return false;
+  }
+
+  auto out = indices.begin();
+  for (const auto idx : indices) {
+    const auto new_idx = (*this)(idx);
+    if (new_idx != DELETED) {
+      *out = new_idx;
+      ++out;
+    }
+  }
+
+  const bool dropped = out != indices.end();
+  indices.erase(out, indices.end());
+  return dropped;
+}
+
+IncrementalClusterer::IncrementalClusterer(double tolerance)
+    : tolerance_(tolerance), tolerance_sq_(tolerance * tolerance) {
+  CHECK_GT(tolerance, 0.0) << "cluster tolerance must be positive";
+}
+
+size_t IncrementalClusterer::addSlot(size_t vertex, const Mesh::Pos& pos) {
+  size_t index;
+  if (free_slots_.empty()) {
+    index = slots_.size();
+    slots_.emplace_back();
+  } else {
+    index = free_slots_.back();
+    free_slots_.pop_back();
+  }
+
+  auto& slot = slots_[index];
+  slot.vertex = vertex;
+  slot.pos = pos;
+  slot.cell = spatial_hash::indexFromPoint<BlockIndex>(pos, 1.0f / tolerance_);
+  slot.cluster = NO_CLUSTER;
+  slot.valid = true;
+  grid_[slot.cell].push_back(index);
+  return index;
+}
+
+void IncrementalClusterer::removeSlot(size_t index) {
+  auto& slot = slots_[index];
+  auto cell_iter = grid_.find(slot.cell);
+  if (cell_iter != grid_.end()) {
+    auto& cell = cell_iter->second;
+    auto iter = std::find(cell.begin(), cell.end(), index);
+    if (iter != cell.end()) {
+      *iter = cell.back();
+      cell.pop_back();
+    }
+
+    if (cell.empty()) {
+      grid_.erase(cell_iter);
+    }
+  }
+
+  if (slot.cluster != NO_CLUSTER) {
+    dirty_clusters_.push_back(slot.cluster);
+  }
+
+  slot.cluster = NO_CLUSTER;
+  slot.valid = false;
+  free_slots_.push_back(index);
+}
+
+template <typename Func>
+void IncrementalClusterer::forEachNeighbor(const Slot& slot, const Func& func) const {
+  for (int dx = -1; dx <= 1; ++dx) {
+    for (int dy = -1; dy <= 1; ++dy) {
+      for (int dz = -1; dz <= 1; ++dz) {
+        const auto iter = grid_.find(slot.cell + BlockIndex(dx, dy, dz));
+        if (iter == grid_.end()) {
+          continue;
+        }
+
+        for (const auto other : iter->second) {
+          if ((slots_[other].pos - slot.pos).squaredNorm() <= tolerance_sq_) {
+            func(other);
+          }
+        }
+      }
+    }
+  }
+}
+
+void IncrementalClusterer::update(const VertexRemapping& remapping,
+                                  const std::vector<size_t>& indices,
+                                  const Mesh::Positions& points) {
+  dirty_clusters_.clear();
+
+  if (!remapping.empty()) {
+    std::unordered_map<size_t, size_t> remapped;
+    remapped.reserve(vertex_to_slot_.size());
+    for (const auto& [vertex, index] : vertex_to_slot_) {
+      const auto new_vertex = remapping(vertex);
+      if (new_vertex == VertexRemapping::DELETED) {
+        removeSlot(index);
+        continue;
+      }
+
+      slots_[index].vertex = new_vertex;
+      remapped.emplace(new_vertex, index);
+    }
+
+    vertex_to_slot_ = std::move(remapped);
+  }
+
+  std::vector<bool> seen(slots_.size(), false);
+  std::vector<size_t> added;
+  for (const auto vertex : indices) {
+    if (vertex >= points.size()) {
+      LOG(ERROR) << "bad index " << vertex << " (of " << points.size() << ")";
+      continue;
+    }
+
+    const auto& pos = points[vertex];
+    auto iter = vertex_to_slot_.find(vertex);
+    if (iter != vertex_to_slot_.end()) {
+      if (slots_[iter->second].pos == pos) {
+        seen[iter->second] = true;
+        continue;
+      }
+
+      // moved vertices are re-inserted
+      removeSlot(iter->second);
+      vertex_to_slot_.erase(iter);
+    }
+
+    const auto index = addSlot(vertex, pos);
+    vertex_to_slot_[vertex] = index;
+    if (index >= seen.size()) {
+      seen.resize(index + 1, false);
+    }
+
+    seen[index] = true;
+    added.push_back(index);
+  }
+
+  for (size_t i = 0; i < seen.size(); ++i) {
+    if (slots_[i].valid && !seen[i]) {
+      vertex_to_slot_.erase(slots_[i].vertex);
+      removeSlot(i);
+    }
+  }
+
+  // clusters within tolerance of a new vertex may merge
+  for (const auto index : added) {
+    forEachNeighbor(slots_[index], [&](size_t other) {
+      if (slots_[other].cluster != NO_CLUSTER) {
+        dirty_clusters_.push_back(slots_[other].cluster);
+      }
+    });
+  }
+
+  std::sort(dirty_clusters_.begin(), dirty_clusters_.end());
+  dirty_clusters_.erase(std::unique(dirty_clusters_.begin(), dirty_clusters_.end()),
+                        dirty_clusters_.end());
+
+  std::vector<size_t> seeds = added;
+  for (const auto cluster : dirty_clusters_) {
+    auto iter = clusters_.find(cluster);
+    if (iter == clusters_.end()) {
+      continue;
+    }
+
+    for (const auto index : iter->second) {
+      // skip removed members and slots reused since the cluster was formed
+      auto& slot = slots_[index];
+      if (slot.valid && slot.cluster == cluster) {
+        slot.cluster = NO_CLUSTER;
+        seeds.push_back(index);
+      }
+    }
+
+    clusters_.erase(iter);
+  }
+
+  std::deque<size_t> frontier;
+  for (const auto seed : seeds) {
+    if (slots_[seed].cluster != NO_CLUSTER) {
+      continue;
+    }
+
+    const auto cluster = next_cluster_id_++;
+    auto& members = clusters_[cluster];
+    slots_[seed].cluster = cluster;
+    frontier.push_back(seed);
+    while (!frontier.empty()) {
+      const auto index = frontier.front();
+      frontier.pop_front();
+      members.push_back(index);
+      forEachNeighbor(slots_[index], [&](size_t other) {
+        auto& slot = slots_[other];
+        if (slot.cluster == NO_CLUSTER) {
+          slot.cluster = cluster;
+          frontier.push_back(other);
+        }
+      });
+    }
+  }
+
+  dirty_clusters_.clear();
+}
+
+std::vector<IncrementalClusterer::Cluster> IncrementalClusterer::getClusters(
+    size_t min_size, size_t max_size) const {
+  std::vector<Cluster> clusters;
+  for (const auto& [id, members] : clusters_) {
+    if (members.size() < min_size || members.size() > max_size) {
+      continue;
+    }
+
+    auto& cluster = clusters.emplace_back();
+    cluster.id = id;
+    cluster.indices.reserve(members.size());
+    for (const auto index : members) {
+      cluster.indices.push_back(slots_[index].vertex);
+    }
+
+    std::sort(cluster.indices.begin(), cluster.indices.end());
+  }
+
+  std::sort(clusters.begin(), clusters.end(), [](const auto& lhs, const auto& rhs) {
+    if (lhs.indices.size() != rhs.indices.size()) {
+      return lhs.indices.size() > rhs.indices.size();
+    }
+
+    return lhs.id < rhs.id;
+  });
+  return clusters;
+}
+
+}  // namespace hydra
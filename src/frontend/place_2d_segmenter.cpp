@@ -41,14 +41,12 @@
 #include <kimera_pgmo/mesh_delta.h>
 
 #include <memory>
-#define PCL_NO_PRECOMPILE
-#include <pcl/segmentation/extract_clusters.h>
-#undef PCL_NO_PRECOMPILE
 #include <spark_dsg/bounding_box_extraction.h>
 
 #include "hydra/common/global_info.h"
 #include "hydra/common/semantic_color_map.h"
 #include "hydra/frontend/place_2d_split_logic.h"
+#include "hydra/reconstruction/parallel_utilities.h"
 #include "hydra/utils/place_2d_ellipsoid_math.h"
 
 namespace hydra {
@@ -58,7 +56,6 @@ using LabelPlaces = Place2dSegmenter::LabelPlaces;
 using LabelIndices = Place2dSegmenter::LabelIndices;
 using IndicesVector = Place2dSegmenter::IndicesVector;
 using OptPosition = std::optional<Eigen::Vector3d>;
-using KdTreeT = pcl::search::KdTree<pcl::PointXYZRGBA>;
 
 void mergeList(std::vector<size_t>& lhs, const std::vector<int>& rhs) {
   std::unordered_set<size_t> seen(lhs.begin(), lhs.end());
@@ -72,6 +69,24 @@ void mergeList(std::vector<size_t>& lhs, const std::vector<int>& rhs) {
   }
 }
 
+namespace {
+
+void remapPlace(const VertexRemapping& remapping, Place2d& place) {
+  // cached places only contain unchanged vertices, so no index is ever dropped
+  remapping.apply(place.indices);
+  remapping.apply(place.boundary_indices);
+  if (place.indices.empty()) {
+    return;
+  }
+
+  const auto [min_iter, max_iter] =
+      std::minmax_element(place.indices.begin(), place.indices.end());
+  place.min_mesh_index = *min_iter;
+  place.max_mesh_index = *max_iter;
+}
+
+}  // namespace
+
 template <typename T>
 std::string printLabels(const std::set<T>& labels) {
   std::stringstream ss;
@@ -93,110 +108,117 @@ Place2dSegmenter::Place2dSegmenter(const Config& config)
   VLOG(1) << "[Hydra Frontend] Detecting 2d places: " << printLabels(config.labels);
   for (const auto& label : config.labels) {
     active_places_[label] = std::set<NodeId>();
+    label_clusters_.emplace(label, LabelClusters(config.cluster_tolerance));
   }
 }
 
 Places Place2dSegmenter::findPlaces(const Mesh::Positions& points,
-                                    const kimera_pgmo::MeshDelta& delta,
-                                    const pcl::IndicesPtr& cloud_indices,
-                                    double connection_ellipse_scale_factor) const {
-  pcl::IndicesPtr inds(new pcl::Indices());
-  inds->resize(cloud_indices->size());
-  for (size_t ix = 0; ix < cloud_indices->size(); ++ix) {
-    inds->at(ix) = delta.getLocalIndex(cloud_indices->at(ix));
-  }
-
-  KdTreeT::Ptr tree(new KdTreeT());
-  tree->setInputCloud(delta.vertex_updates, inds);
-
-  pcl::EuclideanClusterExtraction<pcl::PointXYZRGBA> estimator;
-  estimator.setClusterTolerance(config.cluster_tolerance);
-  estimator.setMinClusterSize(config.min_cluster_size);
-  estimator.setMaxClusterSize(config.max_cluster_size);
-  estimator.setSearchMethod(tree);
-  estimator.setInputCloud(delta.vertex_updates);
-  estimator.setIndices(inds);
-
-  std::vector<pcl::PointIndices> cluster_indices;
-  estimator.extract(cluster_indices);
-
+                                    const VertexRemapping& remapping,
+                                    const IndicesVector& indices,
+                                    LabelClusters& label_clusters) const {
+  auto& clusterer = label_clusters.clusterer;
+  clusterer.update(remapping, indices, points);
+  const auto clusters =
+      clusterer.getClusters(config.min_cluster_size, config.max_cluster_size);
+
+  size_t num_reused = 0;
   Places places;
-  places.resize(cluster_indices.size());
-  for (size_t k = 0; k < places.size(); ++k) {
-    for (const auto& ind : cluster_indices.at(k).indices) {
-      places.at(k).indices.push_back(static_cast<size_t>(delta.getGlobalIndex(ind)));
+  std::unordered_map<size_t, Places> cluster_places;
+  for (const auto& cluster : clusters) {
+    Places final_places;
+    auto iter = label_clusters.cluster_places.find(cluster.id);
+    if (iter != label_clusters.cluster_places.end()) {
+      final_places = std::move(iter->second);
+      if (!remapping.empty()) {
+        for (auto& place : final_places) {
+          remapPlace(remapping, place);
+        }
+      }
+
+      ++num_reused;
+    } else {
+      Place2d initial_place;
+      initial_place.indices = cluster.indices;
+      addRectInfo(points, config.connection_ellipse_scale_factor, initial_place);
+      final_places = decomposePlaces(points,
+                                     {initial_place},
+                                     config.pure_final_place_size,
+                                     config.min_final_place_points,
+                                     config.connection_ellipse_scale_factor);
     }
 
-    addRectInfo(points, connection_ellipse_scale_factor, places.at(k));
+    places.insert(places.end(), final_places.begin(), final_places.end());
+    cluster_places.emplace(cluster.id, std::move(final_places));
   }
 
+  VLOG(5) << "[Places 2d Segmenter] got " << clusters.size() << " clusters ("
+          << num_reused << " unchanged) from " << clusterer.numVertices()
+          << " vertices";
+  label_clusters.cluster_places = std::move(cluster_places);
   return places;
 }
 
-pcl::IndicesPtr getActivePlaceIndices(
-    const pcl::IndicesPtr& indices,
+IndicesVector getActivePlaceIndices(
+    const pcl::Indices& indices,
+    const VertexRemapping& remapping,
     const std::map<uint32_t, std::set<NodeId>>& active_places,
-    const kimera_pgmo::MeshDelta& delta,
     const DynamicSceneGraph& graph,
-    size_t& num_archived_vertices,
+    size_t num_archived_vertices,
     std::list<NodeId>& empty_nodes) {
-  pcl::IndicesPtr active_indices;
-  active_indices.reset(new IndicesVector());
-  active_indices->reserve(indices->size());
+  VLOG(5) << "[Places 2d Segmenter] n original active indices: " << indices.size();
+  size_t min_active = std::numeric_limits<size_t>::max();
+  size_t max_active = 0;
+  for (const auto idx : indices) {
+    min_active = std::min<size_t>(min_active, idx);
+    max_active = std::max<size_t>(max_active, idx);
+  }
 
-  num_archived_vertices = delta.getTotalArchivedVertices();
+  // flags of every active index that belongs to a place with an archived vertex
+  std::vector<bool> frozen;
+  if (!indices.empty()) {
+    frozen.resize(max_active - min_active + 1, false);
+  }
 
-  VLOG(5) << "[Places 2d Segmenter] n original active indices: " << indices->size();
-  std::unordered_set<size_t> frozen_indices;
-  for (auto kv : active_places) {
-    std::set<NodeId> nodes = kv.second;
-    for (auto nid : nodes) {
+  size_t num_frozen = 0;
+  for (const auto& kv : active_places) {
+    for (const auto nid : kv.second) {
       auto& attrs = graph.getNode(nid).attributes<Place2dNodeAttributes>();
+      remapping.apply(attrs.pcl_mesh_connections);
       size_t min_index = std::numeric_limits<size_t>::max();
       size_t max_index = 0;
-      auto iter = attrs.pcl_mesh_connections.begin();
-      while (iter != attrs.pcl_mesh_connections.end()) {
-        if (delta.deleted_indices.count(*iter)) {
-          iter = attrs.pcl_mesh_connections.erase(iter);
-          continue;
-        }
-
-        auto map_iter = delta.prev_to_curr.find(*iter);
-        if (map_iter != delta.prev_to_curr.end()) {
-          *iter = map_iter->second;
-        }
-
-        min_index = std::min(min_index, *iter);
-        max_index = std::max(max_index, *iter);
-        ++iter;
+      for (const auto idx : attrs.pcl_mesh_connections) {
+        min_index = std::min(min_index, idx);
+        max_index = std::max(max_index, idx);
       }
 
       attrs.pcl_min_index = min_index;
       attrs.pcl_max_index = max_index;
 
-      const auto prev_boundary = attrs.boundary;
-      const auto prev_boundary_connections = attrs.pcl_boundary_connections;
-      attrs.boundary.clear();
-      attrs.pcl_boundary_connections.clear();
-      for (size_t i = 0; i < prev_boundary.size(); ++i) {
-        if (delta.deleted_indices.count(prev_boundary_connections.at(i))) {
-          continue;
+      if (!remapping.empty()) {
+        size_t num_valid = 0;
+        auto& boundary_indices = attrs.pcl_boundary_connections;
+        for (size_t i = 0; i < boundary_indices.size(); ++i) {
+          const auto new_idx = remapping(boundary_indices[i]);
+          if (new_idx == VertexRemapping::DELETED) {
+            continue;
+          }
+
+          attrs.boundary[num_valid] = attrs.boundary[i];
+          boundary_indices[num_valid] = new_idx;
+          ++num_valid;
         }
 
-        auto map_iter = delta.prev_to_curr.find(prev_boundary_connections.at(i));
-        if (map_iter != delta.prev_to_curr.end()) {
-          attrs.boundary.push_back(prev_boundary.at(i));
-          attrs.pcl_boundary_connections.push_back(map_iter->second);
-        } else {
-          attrs.boundary.push_back(prev_boundary.at(i));
-          attrs.pcl_boundary_connections.push_back(prev_boundary_connections.at(i));
-        }
+        attrs.boundary.resize(num_valid);
+        boundary_indices.resize(num_valid);
       }
 
       if (attrs.pcl_min_index < num_archived_vertices) {
         // ^ this means that the place contains an archived vertex
-        for (auto mi : attrs.pcl_mesh_connections) {
-          frozen_indices.insert(mi);
+        for (const auto mi : attrs.pcl_mesh_connections) {
+          if (mi >= min_active && mi <= max_active && !frozen[mi - min_active]) {
+            frozen[mi - min_active] = true;
+            ++num_frozen;
+          }
         }
       }
 
@@ -208,15 +230,17 @@ pcl::IndicesPtr getActivePlaceIndices(
     }
   }
 
-  VLOG(5) << "[Places 2d Segmenter] n frozen indices: " << frozen_indices.size();
+  VLOG(5) << "[Places 2d Segmenter] n frozen indices: " << num_frozen;
 
-  for (const size_t idx : *indices) {
-    if (!frozen_indices.count(idx)) {
-      active_indices->push_back(idx);
+  IndicesVector active_indices;
+  active_indices.reserve(indices.size());
+  for (const auto idx : indices) {
+    if (!frozen[idx - min_active]) {
+      active_indices.push_back(idx);
     }
   }
 
-  VLOG(5) << "[Places 2d Segmenter] n final active indices: " << active_indices->size();
+  VLOG(5) << "[Places 2d Segmenter] n final active indices: " << active_indices.size();
   return active_indices;
 }
 
@@ -232,63 +256,45 @@ void Place2dSegmenter::detect(const ReconstructionOutput&,
                               const kimera_pgmo::MeshDelta& mesh_delta,
                               const DynamicSceneGraph& graph) {
   VLOG(5) << "[Places 2d Segmenter] detect called";
-  const auto active_indices = getActivePlaceIndices(mesh_delta.getActiveIndices(),
+  // remap every index touched by the update in bulk instead of per lookup
+  const VertexRemapping remapping(mesh_delta.deleted_indices, mesh_delta.prev_to_curr);
+  num_archived_vertices_ = mesh_delta.getTotalArchivedVertices();
+  const auto active_indices = getActivePlaceIndices(*mesh_delta.getActiveIndices(),
+                                                    remapping,
                                                     active_places_,
-                                                    mesh_delta,
                                                     graph,
                                                     num_archived_vertices_,
                                                     nodes_to_remove_);
-
-  LabelPlaces label_places;
-
-  if (active_indices->empty()) {
+  if (active_indices.empty()) {
     VLOG(5) << "[Places 2d Segmenter] No active indices in mesh";
-    detected_label_places_ = label_places;
-    return;
   }
 
   const auto& mesh = *CHECK_NOTNULL(graph.mesh());
-  LabelIndices label_indices = getLabelIndices(mesh.labels, *active_indices);
-  if (label_indices.empty()) {
-    VLOG(5) << "[Places 2d Segmenter] No vertices found matching desired labels";
-    detected_label_places_ = label_places;
-    return;
+  // every label is updated (even without vertices) to keep its clusters in sync
+  const LabelIndices label_indices = getLabelIndices(mesh.labels, active_indices);
+  const std::vector<uint32_t> labels(config.labels.begin(), config.labels.end());
+  std::vector<Places> places(labels.size());
+  parallelFor(labels.size(), config.num_threads, [&](size_t i, size_t) {
+    places[i] = findPlaces(mesh.points,
+                           remapping,
+                           label_indices.at(labels[i]),
+                           label_clusters_.at(labels[i]));
+  });
+
+  detected_label_places_.clear();
+  for (size_t i = 0; i < labels.size(); ++i) {
+    VLOG(5) << "[Places 2d Segmenter]  - Found " << places[i].size()
+            << " final places of label " << static_cast<int>(labels[i]);
+    detected_label_places_.emplace(labels[i], std::move(places[i]));
   }
-
-  for (const auto label : config.labels) {
-    if (!label_indices.count(label)) {
-      continue;
-    }
-
-    if (label_indices.at(label)->size() < config.min_cluster_size) {
-      continue;
-    }
-
-    const auto initial_places = findPlaces(mesh.points,
-                                           mesh_delta,
-                                           label_indices.at(label),
-                                           config.connection_ellipse_scale_factor);
-
-    VLOG(5) << "[Places 2d Segmenter] got " << initial_places.size()
-            << " initial places";
-    std::vector<Place2d> final_places =
-        decomposePlaces(mesh.points,
-                        initial_places,
-                        config.pure_final_place_size,
-                        config.min_final_place_points,
-                        config.connection_ellipse_scale_factor);
-
-    VLOG(5) << "[Places 2d Segmenter]  - Found " << final_places.size()
-            << " final places of label " << static_cast<int>(label);
-    label_places.insert({label, final_places});
-  }
-
-  detected_label_places_ = label_places;
 }
 
 LabelIndices Place2dSegmenter::getLabelIndices(const Mesh::Labels& labels,
                                                const IndicesVector& indices) const {
   LabelIndices label_indices;
+  for (const auto label : config.labels) {
+    label_indices[label] = IndicesVector();
+  }
 
   std::set<uint32_t> seen_labels;
   for (const auto idx : indices) {
@@ -304,11 +310,7 @@ LabelIndices Place2dSegmenter::getLabelIndices(const Mesh::Labels& labels,
       continue;
     }
 
-    if (!label_indices.count(label)) {
-      label_indices[label] = pcl::IndicesPtr(new IndicesVector());
-    }
-
-    label_indices[label]->push_back(idx);
+    label_indices[label].push_back(idx);
   }
 
   VLOG(5) << "[Places 2d Segmenter] Seen labels: " << printLabels(seen_labels);
@@ -493,6 +495,8 @@ void declare_config(Place2dSegmenter::Config& config) {
   field(config.place_max_neighbor_z_diff, "place_max_neighbor_z_diff");
   field(config.connection_ellipse_scale_factor, "connection_ellipse_scale_factor");
   config.labels = GlobalInfo::instance().getLabelSpaceConfig().surface_places_labels;
+  field<ThreadNumConversion>(config.num_threads, "num_threads");
+  check(config.num_threads, GT, 0, "num_threads");
 }
 
 }  // namespace hydra
@@ -3,47 +3,226 @@
 #include <spark_dsg/dynamic_scene_graph.h>
 #include <spark_dsg/node_attributes.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
 #include "hydra/utils/place_2d_ellipsoid_math.h"
-#include "opencv2/imgproc.hpp"
 
 namespace hydra {
 
+namespace {
+
+// scratch buffers reused between calls so that fitting doesn't allocate per place
+thread_local std::vector<Place2d::Index> sorted_buffer;
+thread_local std::vector<Place2d::Index> hull_buffer;
+thread_local std::vector<Eigen::Vector2d> hull_points_buffer;
+thread_local std::vector<Place2d::Index> split_buffer;
+
+inline Eigen::Vector2d getPoint2d(const Place2d::CloudT& points, Place2d::Index idx) {
+  return Eigen::Vector2d(points[idx].x(), points[idx].y());
+}
+
+inline double cross(const Eigen::Vector2d& o,
+                    const Eigen::Vector2d& a,
+                    const Eigen::Vector2d& b) {
+  return (a.x() - o.x()) * (b.y() - o.y()) - (a.y() - o.y()) * (b.x() - o.x());
+}
+
+inline double getSide(const Place2d::CloudT& points,
+                      Place2d::Index idx,
+                      const Eigen::Vector2d& centroid,
+                      const Eigen::Vector2d& cut_plane) {
+  return (getPoint2d(points, idx) - centroid).dot(cut_plane);
+}
+
+// Assign the two perpendicular sides of a rectangle following cv::RotatedRect: the
+// width lies along the side whose direction angle is in (0, 90] degrees and the
+// height is the width direction rotated clockwise, so that height_ray and width_ray
+// equal p1 - p0 and p3 - p0 of cv::RotatedRect::points
+void setRectSides(const Eigen::Vector2d& side1,
+                  const Eigen::Vector2d& side2,
+                  Rect2d& rect) {
+  Eigen::Vector2d dir = side1.normalized();
+  if (dir.x() < 0.0 || (dir.x() == 0.0 && dir.y() < 0.0)) {
+    dir = -dir;
+  }
+
+  double width = side1.norm();
+  double height = side2.norm();
+  if (dir.y() <= 0.0) {
+    // side1 is at an angle in (-90, 0] degrees, so side2 is the width
+    dir = Eigen::Vector2d(-dir.y(), dir.x());
+    std::swap(width, height);
+  }
+
+  rect.width_ray = width * dir;
+  rect.height_ray = height * Eigen::Vector2d(dir.y(), -dir.x());
+}
+
+}  // namespace
+
+void convexHull2d(const Place2d::CloudT& points,
+                  IndexSpan indices,
+                  std::vector<Place2d::Index>& hull) {
+  hull.clear();
+  if (indices.empty()) {
+    return;
+  }
+
+  auto& sorted = sorted_buffer;
+  sorted.assign(indices.begin(), indices.end());
+  std::sort(sorted.begin(), sorted.end(), [&](const auto lhs, const auto rhs) {
+    const auto& p1 = points[lhs];
+    const auto& p2 = points[rhs];
+    if (p1.x() != p2.x()) {
+      return p1.x() < p2.x();
+    }
+
+    if (p1.y() != p2.y()) {
+      return p1.y() < p2.y();
+    }
+
+    return lhs < rhs;
+  });
+
+  const size_t n = sorted.size();
+  hull.resize(2 * n);
+  size_t k = 0;
+  const auto is_turn = [&](size_t idx) {
+    return cross(getPoint2d(points, hull[k - 2]),
+                 getPoint2d(points, hull[k - 1]),
+                 getPoint2d(points, idx)) > 0.0;
+  };
+
+  // lower hull
+  for (size_t i = 0; i < n; ++i) {
+    while (k >= 2 && !is_turn(sorted[i])) {
+      --k;
+    }
+
+    hull[k++] = sorted[i];
+  }
+
+  // upper hull
+  const size_t lower_size = k + 1;
+  for (size_t i = n - 1; i > 0; --i) {
+    while (k >= lower_size && !is_turn(sorted[i - 1])) {
+      --k;
+    }
+
+    hull[k++] = sorted[i - 1];
+  }
+
+  // the last vertex repeats the first
+  hull.resize(std::max<size_t>(k - 1, 1));
+  if (hull.size() == 2 && getPoint2d(points, hull[0]) == getPoint2d(points, hull[1])) {
+    hull.resize(1);
+  }
+
+  // start from the rightmost vertex (the end of the lower hull) like cv::convexHull
+  if (hull.size() > 1) {
+    std::rotate(hull.begin(), hull.begin() + (lower_size - 2), hull.end());
+  }
+}
+
+Rect2d minAreaRect2d(const Place2d::CloudT& points, IndexSpan indices) {
+  Rect2d rect;
+  auto& hull = hull_buffer;
+  convexHull2d(points, indices, hull);
+  if (hull.empty()) {
+    return rect;
+  }
+
+  const size_t h = hull.size();
+  auto& hp = hull_points_buffer;
+  hp.resize(h);
+  for (size_t i = 0; i < h; ++i) {
+    hp[i] = getPoint2d(points, hull[i]);
+  }
+
+  if (h == 1) {
+    rect.center = hp[0];
+    return rect;
+  }
+
+  if (h == 2) {
+    // matches cv::minAreaRect, which doesn't normalize the angle of a segment
+    rect.center = (hp[0] + hp[1]) / 2.0;
+    rect.width_ray = hp[1] - hp[0];
+    return rect;
+  }
+
+  // rotating calipers: the hull is counter-clockwise, so the inward normal of every
+  // edge is to its left. k, j and m track the vertices with maximum projection along
+  // the edge, maximum distance from the edge and minimum projection along the edge
+  const auto at = [&](size_t i) -> const Eigen::Vector2d& { return hp[i % h]; };
+  size_t k = 1;
+  size_t j = 1;
+  size_t m = 1;
+  double best_area = std::numeric_limits<double>::infinity();
+  Eigen::Vector2d best_side1 = Eigen::Vector2d::Zero();
+  Eigen::Vector2d best_side2 = Eigen::Vector2d::Zero();
+  for (size_t i = 0; i < h; ++i) {
+    const Eigen::Vector2d u = (at(i + 1) - at(i)).normalized();
+    const Eigen::Vector2d n(-u.y(), u.x());
+
+    k = std::max(k, i + 1);
+    while (k < i + h && (at(k + 1) - at(k)).dot(u) > 0.0) {
+      ++k;
+    }
+
+    j = std::max(j, k);
+    while (j < i + h && (at(j + 1) - at(j)).dot(n) > 0.0) {
+      ++j;
+    }
+
+    m = std::max(m, j);
+    while (m < i + h && (at(m + 1) - at(m)).dot(u) < 0.0) {
+      ++m;
+    }
+
+    const double u_min = at(m).dot(u);
+    const double u_max = at(k).dot(u);
+    const double n_min = at(i).dot(n);
+    const double n_max = at(j).dot(n);
+    const double area = (u_max - u_min) * (n_max - n_min);
+    if (area < best_area) {
+      best_area = area;
+      rect.center = u * (u_min + u_max) / 2.0 + n * (n_min + n_max) / 2.0;
+      best_side1 = u * (u_max - u_min);
+      best_side2 = n * (n_max - n_min);
+    }
+  }
+
+  setRectSides(best_side1, best_side2, rect);
+  return rect;
+}
+
 void addRectInfo(const Place2d::CloudT& points,
-                 const std::vector<Place2d::Index> mindices,
+                 IndexSpan mindices,
                  const double connection_ellipse_scale_factor,
                  Eigen::Vector2d& ellipse_centroid,
                  Eigen::Matrix2d& m_expand,
                  Eigen::Matrix2d& m_compress,
                  Eigen::Vector2d& cut_plane) {
-  std::vector<cv::Point2f> region;
-  for (auto midx : mindices) {
-    region.push_back(cv::Point2f(points[midx].x(), points[midx].y()));
-  }
-  cv::RotatedRect box = cv::minAreaRect(region);
-
-  cv::Point2f box_pts[4];
-  box.points(box_pts);
+  const auto box = minAreaRect2d(points, mindices);
 
   // Get rays along two sides of bounding box
-  cv::Point2f e1_ray = box_pts[1] - box_pts[0];
-  cv::Point2f e2_ray = box_pts[3] - box_pts[0];
+  const Eigen::Vector2d& e1_ray = box.height_ray;
+  const Eigen::Vector2d& e2_ray = box.width_ray;
+  const Eigen::Vector2d& long_ray = e1_ray.norm() > e2_ray.norm() ? e1_ray : e2_ray;
 
-  cv::Point2f long_ray = cv::norm(e1_ray) > cv::norm(e2_ray) ? e1_ray : e2_ray;
+  ellipse_centroid = box.center;
 
-  cv::Point2f box_center = (box_pts[0] + box_pts[1] + box_pts[2] + box_pts[3]) / 4;
-  ellipse_centroid(0) = box_center.x;
-  ellipse_centroid(1) = box_center.y;
-
-  m_expand(0, 0) = connection_ellipse_scale_factor * sqrt(2) * (e1_ray.x / 2);
-  m_expand(1, 0) = connection_ellipse_scale_factor * sqrt(2) * (e1_ray.y / 2);
-  m_expand(0, 1) = connection_ellipse_scale_factor * sqrt(2) * (e2_ray.x / 2);
-  m_expand(1, 1) = connection_ellipse_scale_factor * sqrt(2) * (e2_ray.y / 2);
+  m_expand.col(0) = connection_ellipse_scale_factor * std::sqrt(2) * (e1_ray / 2);
+  m_expand.col(1) = connection_ellipse_scale_factor * std::sqrt(2) * (e2_ray / 2);
 
   Eigen::Matrix2d minv = m_expand.inverse();
   m_compress = minv.transpose() * minv;
 
-  cut_plane(0) = long_ray.x;
-  cut_plane(1) = long_ray.y;
+  cut_plane = long_ray;
 }
 
 void addRectInfo(const Place2d::CloudT& points,
@@ -75,30 +254,22 @@ void addRectInfo(const Place2d::CloudT& points,
 }
 
 void addBoundaryInfo(const Place2d::CloudT& points,
-                     const std::vector<Place2d::Index>& mindices,
+                     IndexSpan mindices,
                      Place2d::CentroidT& centroid,
                      std::vector<Eigen::Vector3d>& boundary,
                      std::vector<Place2d::Index>& boundary_mindices) {
-  std::vector<cv::Point2f> region_pts;
-  std::vector<Place2d::Index> region_to_cloud_index;
   centroid = Place2d::CentroidT();
   for (auto midx : mindices) {
-    region_to_cloud_index.push_back(midx);
-    region_pts.push_back(cv::Point2f(points[midx].x(), points[midx].y()));
     centroid.add(pcl::PointXYZ(points[midx].x(), points[midx].y(), points[midx].z()));
   }
 
   // compute convex hull for each place
-  std::vector<int> ch;
-  cv::convexHull(region_pts, ch);
+  convexHull2d(points, mindices, boundary_mindices);
   boundary.clear();
-  boundary_mindices.clear();
-  for (int pix : ch) {
-    auto cloud_ix = region_to_cloud_index.at(pix);
-    Place2d::PointT p = points[cloud_ix];
-    Eigen::Vector3d v = {p.x(), p.y(), p.z()};
-    boundary.push_back(v);
-    boundary_mindices.push_back(cloud_ix);
+  boundary.reserve(boundary_mindices.size());
+  for (const auto cloud_ix : boundary_mindices) {
+    const auto& p = points[cloud_ix];
+    boundary.emplace_back(p.x(), p.y(), p.z());
   }
 }
 
@@ -132,8 +303,7 @@ std::pair<Place2d, Place2d> splitPlace(const Place2d::CloudT& points,
   size_t max_ix_2 = 0;
 
   for (auto midx : place.indices) {
-    Eigen::Vector2d pt(points[midx].x(), points[midx].y());
-    double side = (pt - place.ellipse_centroid).dot(place.cut_plane);
+    const double side = getSide(points, midx, place.ellipse_centroid, place.cut_plane);
     if (side >= 0) {
       new_place_1.indices.push_back(midx);
       min_ix_1 = std::min(min_ix_1, midx);
@@ -164,52 +334,122 @@ std::vector<Place2d> decomposePlaces(const Place2d::CloudT& cloud,
                                      size_t min_points,
                                      const double connection_ellipse_scale_factor) {
   std::vector<Place2d> final_places;
-  for (auto p : initial_places) {
+  for (const auto& p : initial_places) {
     // Recursively decompose initial place into smaller places
     std::vector<Place2d> sub_places =
         decomposePlace(cloud, p, min_size, min_points, connection_ellipse_scale_factor);
 
-    for (Place2d sp : sub_places) {
+    for (auto& sp : sub_places) {
       addBoundaryInfo(cloud, sp);
-      final_places.push_back(sp);
+      final_places.push_back(std::move(sp));
     }
   }
 
   return final_places;
 }
 
+namespace {
+
+struct DecompositionParams {
+  const Place2d::CloudT& points;
+  const double min_size;
+  const size_t min_points;
+  const double connection_ellipse_scale_factor;
+};
+
+void decomposeChild(const DecompositionParams& params,
+                    Place2d::Index* begin,
+                    Place2d::Index* end,
+                    std::vector<Place2d>& descendants);
+
+/**
+ * Split [begin, end) in place into the vertices on either side of the cut plane.
+ * Vertices on the cut plane belong to both children (as with splitPlace), so the
+ * second child is copied out of the range in the (rare) case that they exist.
+ */
+void decomposeRange(const DecompositionParams& params,
+                    Place2d::Index* begin,
+                    Place2d::Index* end,
+                    const Eigen::Vector2d& centroid,
+                    const Eigen::Vector2d& cut_plane,
+                    std::vector<Place2d>& descendants) {
+  const auto& points = params.points;
+  auto zero_begin = std::partition(begin, end, [&](auto idx) {
+    return getSide(points, idx, centroid, cut_plane) > 0.0;
+  });
+  auto zero_end = std::partition(zero_begin, end, [&](auto idx) {
+    return getSide(points, idx, centroid, cut_plane) == 0.0;
+  });
+
+  if (zero_begin == zero_end) {
+    decomposeChild(params, begin, zero_end, descendants);
+    decomposeChild(params, zero_begin, end, descendants);
+    return;
+  }
+
+  std::vector<Place2d::Index> second(zero_begin, end);
+  decomposeChild(params, begin, zero_end, descendants);
+  decomposeChild(params, second.data(), second.data() + second.size(), descendants);
+}
+
+void decomposeChild(const DecompositionParams& params,
+                    Place2d::Index* begin,
+                    Place2d::Index* end,
+                    std::vector<Place2d>& descendants) {
+  Eigen::Vector2d centroid;
+  Eigen::Vector2d cut_plane;
+  Eigen::Matrix2d m_expand;
+  Eigen::Matrix2d m_compress;
+  addRectInfo(params.points,
+              IndexSpan(begin, end),
+              params.connection_ellipse_scale_factor,
+              centroid,
+              m_expand,
+              m_compress,
+              cut_plane);
+
+  const size_t num_points = end - begin;
+  if (num_points > params.min_points && cut_plane.norm() > params.min_size) {
+    decomposeRange(params, begin, end, centroid, cut_plane, descendants);
+    return;
+  }
+
+  auto& place = descendants.emplace_back();
+  place.indices.assign(begin, end);
+  place.min_mesh_index = std::numeric_limits<size_t>::max();
+  place.max_mesh_index = 0;
+  for (const auto idx : place.indices) {
+    place.min_mesh_index = std::min(place.min_mesh_index, idx);
+    place.max_mesh_index = std::max(place.max_mesh_index, idx);
+  }
+
+  place.ellipse_centroid = centroid;
+  place.ellipse_matrix_expand = m_expand;
+  place.ellipse_matrix_compress = m_compress;
+  place.cut_plane = cut_plane;
+}
+
+}  // namespace
+
 std::vector<Place2d> decomposePlace(const Place2d::CloudT& cloud_pts,
                                     const Place2d& place,
                                     const double min_size,
                                     const size_t min_points,
                                     const double connection_ellipse_scale_factor) {
-  std::pair<Place2d, Place2d> children =
-      splitPlace(cloud_pts, place, connection_ellipse_scale_factor);
+  const DecompositionParams params{
+      cloud_pts, min_size, min_points, connection_ellipse_scale_factor};
 
-  std::vector<Place2d> descendants;
-  if (children.first.indices.size() > min_points &&
-      children.first.cut_plane.norm() > min_size) {
-    descendants = decomposePlace(cloud_pts,
-                                 children.first,
-                                 min_size,
-                                 min_points,
-                                 connection_ellipse_scale_factor);
-  } else {
-    descendants.push_back(children.first);
-  }
-
-  if (children.second.indices.size() > min_points &&
-      children.second.cut_plane.norm() > min_size) {
-    std::vector<Place2d> temp = decomposePlace(cloud_pts,
-                                               children.second,
-                                               min_size,
-                                               min_points,
-                                               connection_ellipse_scale_factor);
-    descendants.insert(descendants.end(), temp.begin(), temp.end());
-  } else {
-    descendants.push_back(children.second);
-  }
+  // children are partitioned in place within a single reused copy of the indices
+  auto& indices = split_buffer;
+  indices.assign(place.indices.begin(), place.indices.end());
 
+  std::vector<Place2d> descendants;
+  decomposeRange(params,
+                 indices.data(),
+                 indices.data() + indices.size(),
+                 place.ellipse_centroid,
+                 place.cut_plane,
+                 descendants);
   return descendants;
 }
 
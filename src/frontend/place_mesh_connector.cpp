@@ -37,24 +37,33 @@
 #include <glog/logging.h>
 #include <glog/stl_logging.h>
 
+#include <algorithm>
+#include <limits>
 #include <nanoflann.hpp>
+#include <unordered_map>
+
+#include "hydra/utils/nearest_neighbor_utilities.h"
 
 namespace hydra {
 
-using nanoflann::KDTreeSingleIndexAdaptor;
+using nanoflann::KDTreeSingleIndexDynamicAdaptor;
 using nanoflann::L2_Simple_Adaptor;
 
-struct MeshDeltaAdaptor {
-  MeshDeltaAdaptor(const kimera_pgmo::MeshDelta& delta)
-      : delta(delta), indices(*delta.getActiveIndices()) {}
+namespace {
+
+inline constexpr size_t kInvalidIndex = std::numeric_limits<size_t>::max();
+//! Minimum number of removed vertices before the vertex index is compacted
+inline constexpr size_t kMinRemovedToCompact = 1024;
 
-  inline size_t kdtree_get_point_count() const { return indices.size(); }
+}  // namespace
+
+// Contiguous vertex coordinates indexed by slot. Slots are never reused (until the
+// index is compacted) so a valid slot always refers to the same vertex position
+struct VertexSlotAdaptor {
+  inline size_t kdtree_get_point_count() const { return coords.size() / 3; }
 
   inline double kdtree_get_pt(const size_t idx, const size_t dim) const {
-    const auto cloud_idx = delta.getLocalIndex(indices.at(idx));
-    CHECK_LT(cloud_idx, delta.vertex_updates->size());
-    const auto& p = delta.vertex_updates->at(cloud_idx);
-    return dim == 0 ? p.x : (dim == 1 ? p.y : p.z);
+    return coords[3 * idx + dim];
   }
 
   template <class T>
@@ -62,44 +71,260 @@ struct MeshDeltaAdaptor {
     return false;
   }
 
-  const kimera_pgmo::MeshDelta& delta;
-  pcl::Indices indices;
+  std::vector<double> coords;
 };
 
 struct PlaceMeshConnector::Detail {
-  using Dist = L2_Simple_Adaptor<double, MeshDeltaAdaptor>;
-  using KDTree = KDTreeSingleIndexAdaptor<Dist, MeshDeltaAdaptor, 3, size_t>;
+  using Dist = L2_Simple_Adaptor<double, VertexSlotAdaptor>;
+  using KDTree = KDTreeSingleIndexDynamicAdaptor<Dist, VertexSlotAdaptor, 3, size_t>;
 
-  Detail(const kimera_pgmo::MeshDelta& delta) : adaptor(delta) {
-    kdtree.reset(new KDTree(3, adaptor));
-    kdtree->buildIndex();
-  }
+  // Nearest vertex of every basis point of a place as of the last update
+  struct PlaceCache {
+    std::vector<double> basis_points;
+    std::vector<size_t> slots;
+    std::vector<double> distances;
+    //! Mesh connections last written to the place attributes
+    std::vector<size_t> assigned;
+    size_t last_update = 0;
+  };
+
+  Detail() { resetTree(); }
 
   ~Detail() = default;
 
-  std::optional<size_t> find(const Eigen::Vector3d& position) const {
-    size_t index;
-    double distance;
-    size_t num_found = kdtree->knnSearch(position.data(), 1, &index, &distance);
-    if (!num_found) {
-      return std::nullopt;
-    }
+  void resetTree() {
+    kdtree.reset(new KDTree(3, adaptor, nanoflann::KDTreeSingleIndexAdaptorParams(10)));
+  }
 
-    return adaptor.indices.at(index);
+  inline Eigen::Map<const Eigen::Vector3d> slotPosition(size_t slot) const {
+    return Eigen::Map<const Eigen::Vector3d>(adaptor.coords.data() + 3 * slot);
   }
 
-  MeshDeltaAdaptor adaptor;
+  inline bool validSlot(size_t slot) const {
+    return slot != kInvalidIndex && slot_vertices[slot] != kInvalidIndex;
+  }
+
+  size_t addSlot(size_t vertex, const Eigen::Vector3d& pos) {
+    const size_t slot = slot_vertices.size();
+    adaptor.coords.insert(adaptor.coords.end(), pos.data(), pos.data() + 3);
+    slot_vertices.push_back(vertex);
+    return slot;
+  }
+
+  void removeSlot(size_t slot) {
+    slot_vertices[slot] = kInvalidIndex;
+    kdtree->removePoint(slot);
+    ++num_removed;
+  }
+
+  void update(const kimera_pgmo::MeshDelta& delta);
+
+  void compact();
+
+  void findNearest(const double* pos, size_t& slot, double& distance) const;
+
+  void updateNearest(PlaceCache& cache, size_t i) const;
+
+  VertexSlotAdaptor adaptor;
   std::unique_ptr<KDTree> kdtree;
+  //! Mesh vertex of every slot (invalid for removed slots)
+  std::vector<size_t> slot_vertices;
+  size_t num_removed = 0;
+  //! Slot of every active mesh vertex
+  std::unordered_map<size_t, size_t> vertex_slots;
+
+  //! Slots added by the last update and a search structure over them
+  std::vector<size_t> added_slots;
+  std::unique_ptr<PointNeighborSearch> added_search;
+
+  size_t num_updates = 0;
+  std::unordered_map<NodeId, PlaceCache> places;
+  std::vector<bool> connected;
 };
 
-PlaceMeshConnector::PlaceMeshConnector(const kimera_pgmo::MeshDelta::Ptr& delta)
-    : delta_(delta), internals_(new Detail(*CHECK_NOTNULL(delta))) {}
+void PlaceMeshConnector::Detail::update(const kimera_pgmo::MeshDelta& delta) {
+  // remap previously active vertices to their new indices
+  std::unordered_map<size_t, size_t> prev_slots;
+  prev_slots.reserve(vertex_slots.size());
+  for (const auto& [vertex, slot] : vertex_slots) {
+    if (delta.deleted_indices.count(vertex)) {
+      removeSlot(slot);
+      continue;
+    }
+
+    const auto iter = delta.prev_to_curr.find(vertex);
+    const size_t curr = iter == delta.prev_to_curr.end() ? vertex : iter->second;
+    if (!prev_slots.emplace(curr, slot).second) {
+      removeSlot(slot);
+      continue;
+    }
+
+    slot_vertices[slot] = curr;
+  }
+
+  vertex_slots.clear();
+  added_slots.clear();
+  const auto active = delta.getActiveIndices();
+  vertex_slots.reserve(active->size());
+  for (const auto idx : *active) {
+    const size_t vertex = idx;
+    const auto local_idx = delta.getLocalIndex(vertex);
+    CHECK_LT(local_idx, delta.vertex_updates->size());
+    const auto& p = delta.vertex_updates->at(local_idx);
+    const Eigen::Vector3d pos(p.x, p.y, p.z);
+
+    const auto iter = prev_slots.find(vertex);
+    if (iter != prev_slots.end()) {
+      const size_t slot = iter->second;
+      prev_slots.erase(iter);
+      if (slotPosition(slot) == pos) {
+        vertex_slots.emplace(vertex, slot);
+        continue;
+      }
+
+      // moved vertices are re-inserted under a new slot
+      removeSlot(slot);
+    }
+
+    const size_t slot = addSlot(vertex, pos);
+    vertex_slots.emplace(vertex, slot);
+    added_slots.push_back(slot);
+  }
+
+  // anything left over is no longer active (i.e., archived)
+  for (const auto& [vertex, slot] : prev_slots) {
+    removeSlot(slot);
+  }
+
+  if (!added_slots.empty()) {
+    kdtree->addPoints(added_slots.front(), added_slots.back());
+  }
+
+  if (num_removed > kMinRemovedToCompact && num_removed > vertex_slots.size()) {
+    compact();
+  }
+
+  added_search.reset();
+  if (!added_slots.empty()) {
+    std::vector<Eigen::Vector3f> added_points;
+    added_points.reserve(added_slots.size());
+    for (const auto slot : added_slots) {
+      added_points.push_back(slotPosition(slot).cast<float>());
+    }
+
+    added_search = std::make_unique<PointNeighborSearch>(added_points);
+  }
+}
+
+void PlaceMeshConnector::Detail::compact() {
+  std::vector<size_t> new_slots(slot_vertices.size(), kInvalidIndex);
+  std::vector<double> coords;
+  std::vector<size_t> vertices;
+  coords.reserve(3 * vertex_slots.size());
+  vertices.reserve(vertex_slots.size());
+  for (size_t slot = 0; slot < slot_vertices.size(); ++slot) {
+    if (slot_vertices[slot] == kInvalidIndex) {
+      continue;
+    }
+
+    new_slots[slot] = vertices.size();
+    vertices.push_back(slot_vertices[slot]);
+    const auto pos = slotPosition(slot);
+    coords.insert(coords.end(), pos.data(), pos.data() + 3);
+  }
+
+  VLOG(5) << "[Place Mesh Connector] compacted vertex index from "
+          << slot_vertices.size() << " to " << vertices.size() << " slots";
+  adaptor.coords = std::move(coords);
+  slot_vertices = std::move(vertices);
+  num_removed = 0;
+
+  auto remap = [&new_slots](size_t& slot) {
+    slot = slot == kInvalidIndex ? kInvalidIndex : new_slots[slot];
+  };
+  for (auto& [vertex, slot] : vertex_slots) {
+    remap(slot);
+  }
+
+  for (auto& slot : added_slots) {
+    remap(slot);
+  }
+
+  for (auto& [node_id, cache] : places) {
+    for (auto& slot : cache.slots) {
+      remap(slot);
+    }
+  }
+
+  resetTree();
+  if (!slot_vertices.empty()) {
+    kdtree->addPoints(0, slot_vertices.size() - 1);
+  }
+}
+
+void PlaceMeshConnector::Detail::findNearest(const double* pos,
+                                             size_t& slot,
+                                             double& distance) const {
+  nanoflann::KNNResultSet<double, size_t> result(1);
+  result.init(&slot, &distance);
+  kdtree->findNeighbors(result, pos);
+  if (!result.size()) {
+    slot = kInvalidIndex;
+    distance = std::numeric_limits<double>::infinity();
+  }
+}
+
+void PlaceMeshConnector::Detail::updateNearest(PlaceCache& cache, size_t i) const {
+  const double* pos = cache.basis_points.data() + 3 * i;
+  auto& slot = cache.slots[i];
+  auto& distance = cache.distances[i];
+  if (!validSlot(slot)) {
+    findNearest(pos, slot, distance);
+    return;
+  }
+
+  // the current vertex is still the closest of all previous vertices, so only
+  // vertices added since the last update can be closer
+  if (!added_search) {
+    return;
+  }
+
+  float added_distance;
+  size_t added_idx;
+  const Eigen::Vector3f query = Eigen::Map<const Eigen::Vector3d>(pos).cast<float>();
+  if (!added_search->search(query, added_distance, added_idx)) {
+    return;
+  }
+
+  const auto candidate = added_slots.at(added_idx);
+  const double candidate_distance =
+      (slotPosition(candidate) - Eigen::Map<const Eigen::Vector3d>(pos)).squaredNorm();
+  if (candidate_distance < distance) {
+    slot = candidate;
+    distance = candidate_distance;
+  }
+}
+
+PlaceMeshConnector::PlaceMeshConnector() : internals_(new Detail()) {}
 
 PlaceMeshConnector::~PlaceMeshConnector() {}
 
-size_t PlaceMeshConnector::addConnections(const SceneGraphLayer& places,
-                                          const DeformationMapping& mapping) const {
+void PlaceMeshConnector::updateVertices(const kimera_pgmo::MeshDelta::Ptr& delta) {
+  CHECK(delta);
+  if (delta == delta_) {
+    return;  // vertex events can only be applied once
+  }
+
+  delta_ = delta;
+  internals_->update(*delta_);
+}
+
+size_t PlaceMeshConnector::updateConnections(const SceneGraphLayer& places) {
+  CHECK(delta_) << "vertices must be updated before connecting places";
+  auto& detail = *internals_;
   const auto has_labels = delta_->hasSemantics();
+  const auto update_id = ++detail.num_updates;
+  detail.connected.assign(delta_->vertex_updates->size(), false);
 
   size_t num_missing = 0;
   for (const auto& id_node_pair : places.nodes()) {
@@ -109,29 +334,51 @@ size_t PlaceMeshConnector::addConnections(const SceneGraphLayer& places,
       continue;
     }
 
-    attrs.deformation_connections.clear();
+    auto& cache = detail.places[id_node_pair.first];
+    cache.last_update = update_id;
+
+    auto& connections = attrs.voxblox_mesh_connections;
+    bool basis_changed = cache.basis_points.size() != 3 * connections.size() ||
+                         cache.assigned != attrs.pcl_mesh_connections;
+    for (size_t i = 0; !basis_changed && i < connections.size(); ++i) {
+      const double* prev_pos = cache.basis_points.data() + 3 * i;
+      basis_changed = !std::equal(prev_pos, prev_pos + 3, connections[i].voxel_pos);
+    }
+
+    if (basis_changed) {
+      cache.basis_points.resize(3 * connections.size());
+      for (size_t i = 0; i < connections.size(); ++i) {
+        std::copy_n(connections[i].voxel_pos, 3, cache.basis_points.data() + 3 * i);
+      }
+
+      cache.slots.assign(connections.size(), kInvalidIndex);
+      cache.distances.assign(connections.size(),
+                             std::numeric_limits<double>::infinity());
+    }
+
     attrs.pcl_mesh_connections.clear();
     attrs.mesh_vertex_labels.clear();
-
-    if (attrs.voxblox_mesh_connections.empty()) {
+    if (connections.empty()) {
       ++num_missing;
+      cache.assigned.clear();
       continue;
     }
 
-    for (auto& vertex : attrs.voxblox_mesh_connections) {
-      const Eigen::Vector3d pos = Eigen::Map<const Eigen::Vector3d>(vertex.voxel_pos);
-      const auto nearest = internals_->find(pos);
-      if (!nearest) {
+    for (size_t i = 0; i < connections.size(); ++i) {
+      detail.updateNearest(cache, i);
+      const auto slot = cache.slots[i];
+      if (slot == kInvalidIndex) {
         continue;
       }
 
-      const auto local_idx = delta_->getLocalIndex(*nearest);
+      auto& vertex = connections[i];
+      const auto mesh_idx = detail.slot_vertices[slot];
+      const auto local_idx = delta_->getLocalIndex(mesh_idx);
+      CHECK_LT(local_idx, detail.connected.size());
       // assign mesh vertex to relevant fields
-      vertex.vertex = *nearest;
-      attrs.pcl_mesh_connections.push_back(*nearest);
-
-      // assign (potentially valid) deformation connection
-      attrs.deformation_connections.push_back(mapping.at(local_idx));
+      vertex.vertex = mesh_idx;
+      attrs.pcl_mesh_connections.push_back(mesh_idx);
+      detail.connected[local_idx] = true;
 
       if (has_labels) {
         const auto label = delta_->semantic_updates.at(local_idx);
@@ -139,9 +386,47 @@ size_t PlaceMeshConnector::addConnections(const SceneGraphLayer& places,
         vertex.label = label;
       }
     }
+
+    cache.assigned = attrs.pcl_mesh_connections;
+  }
+
+  // drop places that were archived or removed
+  auto iter = detail.places.begin();
+  while (iter != detail.places.end()) {
+    if (iter->second.last_update != update_id) {
+      iter = detail.places.erase(iter);
+    } else {
+      ++iter;
+    }
   }
 
   return num_missing;
 }
 
+void PlaceMeshConnector::addDeformationConnections(
+    const SceneGraphLayer& places, const DeformationMapping& mapping) const {
+  for (const auto& id_node_pair : places.nodes()) {
+    auto& attrs = id_node_pair.second->attributes<PlaceNodeAttributes>();
+    if (!attrs.is_active) {
+      continue;
+    }
+
+    // assign (potentially valid) deformation connections
+    attrs.deformation_connections.clear();
+    for (const auto mesh_idx : attrs.pcl_mesh_connections) {
+      const auto iter = mapping.find(mesh_idx);
+      attrs.deformation_connections.push_back(iter == mapping.end() ? kInvalidIndex
+                                                                    : iter->second);
+    }
+  }
+}
+
+const std::vector<bool>& PlaceMeshConnector::connectedVertices() const {
+  return internals_->connected;
+}
+
+size_t PlaceMeshConnector::numVertices() const {
+  return internals_->vertex_slots.size();
+}
+
 }  // namespace hydra
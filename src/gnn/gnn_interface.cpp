@@ -40,18 +40,37 @@
 
 namespace hydra::gnn {
 
-struct GnnInterfaceImpl {
-  explicit GnnInterfaceImpl(const std::string& model_path)
-      : GnnInterfaceImpl(model_path, {}) {}
+Tensor& getTensorBuffer(TensorMap& tensors,
+                        const std::string& name,
+                        const std::vector<int64_t>& dims,
+                        Tensor::Type type) {
+  auto iter = tensors.find(name);
+  if (iter == tensors.end() || iter->second.type() != type) {
+    auto& tensor = tensors[name];
+    tensor = Tensor(dims, type);
+    return tensor;
+  }
 
-  GnnInterfaceImpl(const std::string& model_path, const DynamicIndexMap& output_map)
+  iter->second.resize(dims);
+  return iter->second;
+}
+
+struct GnnInterfaceImpl {
+  GnnInterfaceImpl(const std::string& model_path,
+                   const DynamicIndexMap& output_map,
+                   const SessionConfig& config)
       : model_path(model_path),
         output_map(output_map),
         mem_info(Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator,
                                             OrtMemType::OrtMemTypeDefault)) {
     env.reset(new Ort::Env(ORT_LOGGING_LEVEL_WARNING, "hydra_gnn_interface"));
     Ort::SessionOptions options;
-    options.SetIntraOpNumThreads(1).SetInterOpNumThreads(1);
+    options.SetIntraOpNumThreads(config.intra_op_threads)
+        .SetInterOpNumThreads(config.inter_op_threads);
+    if (config.inter_op_threads > 1) {
+      options.SetExecutionMode(ExecutionMode::ORT_PARALLEL);
+    }
+
     session.reset(new Ort::Session(*env, model_path.c_str(), options));
     allocator.reset(new Ort::AllocatorWithDefaultOptions());
     mem_info = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator,
@@ -68,9 +87,14 @@ struct GnnInterfaceImpl {
     }
   }
 
-  TensorMap operator()(const TensorMap& tensors,
-                       const std::vector<int64_t>& output_dimensions) const {
-    std::vector<Ort::Value> input_values;
+  void operator()(const TensorMap& tensors,
+                  TensorMap& tensor_outputs,
+                  const std::vector<int64_t>& output_dimensions) const {
+    // values only wrap tensor memory, but have to outlive the call to Run
+    std::vector<Ort::Value> values;
+    values.reserve(inputs.size() + outputs.size());
+
+    Ort::IoBinding binding(*session);
     for (const auto& input : inputs) {
       const auto iter = tensors.find(input.name);
       if (iter == tensors.end()) {
@@ -79,34 +103,41 @@ struct GnnInterfaceImpl {
         throw std::invalid_argument(ss.str());
       }
 
-      input_values.push_back(input.makeOrtValue(mem_info, iter->second));
+      values.push_back(input.makeOrtValue(mem_info, iter->second));
+      binding.BindInput(input.name.c_str(), values.back());
     }
 
-    TensorMap tensor_outputs;
-    std::vector<Ort::Value> output_values;
     for (const auto& output : outputs) {
       const auto iter = output_map.find(output.name);
-
-      Tensor tensor;
+      auto prev = tensor_outputs.find(output.name);
+      const bool reusable =
+          prev != tensor_outputs.end() && output.tensorMatchesType(prev->second);
       if (iter == output_map.end()) {
-        tensor = output.getTensor();
+        if (!reusable) {
+          tensor_outputs[output.name] = output.getTensor();
+        }
+      } else if (!reusable) {
+        tensor_outputs[output.name] =
+            output.getDynamicTensor(iter->second, output_dimensions);
       } else {
-        tensor = output.getDynamicTensor(iter->second, output_dimensions);
+        prev->second.resize(output.getDynamicDims(iter->second, output_dimensions));
       }
 
-      tensor_outputs[output.name] = tensor;
-      output_values.push_back(output.makeOrtValue(mem_info, tensor));
+      values.push_back(output.makeOrtValue(mem_info, tensor_outputs.at(output.name)));
+      binding.BindOutput(output.name.c_str(), values.back());
     }
 
-    session->Run(Ort::RunOptions(nullptr),
-                 input_names.data(),
-                 input_values.data(),
-                 input_names.size(),
-                 output_names.data(),
-                 output_values.data(),
-                 output_names.size());
+    session->Run(Ort::RunOptions(nullptr), binding);
+  }
+
+  bool hasInput(const std::string& name) const {
+    for (const auto& input : inputs) {
+      if (input.name == name) {
+        return true;
+      }
+    }
 
-    return tensor_outputs;
+    return false;
   }
 
   std::string model_path;
@@ -159,24 +190,40 @@ GnnInterface::GnnInterface(const std::string& model_path)
 
 GnnInterface::GnnInterface(const std::string& model_path,
                            const DynamicIndexMap& output_map)
+    : GnnInterface(model_path, output_map, SessionConfig()) {}
+
+GnnInterface::GnnInterface(const std::string& model_path,
+                           const DynamicIndexMap& output_map,
+                           const SessionConfig& config)
     : model_path_(model_path) {
-  impl_.reset(new GnnInterfaceImpl(model_path, output_map));
+  impl_.reset(new GnnInterfaceImpl(model_path, output_map, config));
 }
 
 GnnInterface::~GnnInterface() {}
 
 Tensor GnnInterface::operator()(const Tensor& x, const Tensor& edge_index) const {
-  auto map = (*impl_)({{"x", x}, {"edge_index", edge_index}}, {});
-  return map.at("output");
+  return (*this)({{"x", x}, {"edge_index", edge_index}}, {}).at("output");
 }
 
 TensorMap GnnInterface::operator()(const TensorMap& input) const {
-  return (*impl_)(input, {});
+  return (*this)(input, std::vector<int64_t>());
 }
 
 TensorMap GnnInterface::operator()(const TensorMap& input,
                                    const std::vector<int64_t>& output_sizes) const {
-  return (*impl_)(input, output_sizes);
+  TensorMap output;
+  (*impl_)(input, output, output_sizes);
+  return output;
+}
+
+void GnnInterface::operator()(const TensorMap& input,
+                              TensorMap& output,
+                              const std::vector<int64_t>& output_sizes) const {
+  (*impl_)(input, output, output_sizes);
+}
+
+bool GnnInterface::hasInput(const std::string& name) const {
+  return impl_->hasInput(name);
 }
 
 std::ostream& operator<<(std::ostream& out, const GnnInterface& gnn) {
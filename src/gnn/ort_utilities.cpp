@@ -202,8 +202,9 @@ Tensor FieldInfo::getTensor() const {
   return Tensor(dims, *tensor_type);
 }
 
-Tensor FieldInfo::getDynamicTensor(const std::vector<size_t>& dims_to_read,
-                                   const std::vector<int64_t>& output_dims) const {
+std::vector<int64_t> FieldInfo::getDynamicDims(
+    const std::vector<size_t>& dims_to_read,
+    const std::vector<int64_t>& output_dims) const {
   size_t dynamic_index = 0;
   std::vector<int64_t> new_dims;
   for (size_t i = 0; i < dims.size(); ++i) {
@@ -236,6 +237,12 @@ Tensor FieldInfo::getDynamicTensor(const std::vector<size_t>& dims_to_read,
     new_dims.push_back(new_dim);
   }
 
+  return new_dims;
+}
+
+Tensor FieldInfo::getDynamicTensor(const std::vector<size_t>& dims_to_read,
+                                   const std::vector<int64_t>& output_dims) const {
+  const auto new_dims = getDynamicDims(dims_to_read, output_dims);
   auto tensor_type = OrtToTensorType(type);
   if (!tensor_type) {
     std::stringstream ss;
@@ -76,13 +76,16 @@ Tensor::Tensor(int64_t rows, int64_t cols)
 Tensor::Tensor(int64_t rows, int64_t cols, Tensor::Type type)
     : Tensor({rows, cols}, type) {}
 
-Tensor::Tensor(const std::vector<int64_t>& dims, Type type) : type_(type), dims_(dims) {
+size_t getNumElements(const std::vector<int64_t>& dims) {
   if (dims.size() == 0) {
-    size_ = 0;
-  } else {
-    size_ = std::accumulate(dims.begin(), dims.end(), 1, std::multiplies<size_t>());
+    return 0;
   }
 
+  return std::accumulate(dims.begin(), dims.end(), 1, std::multiplies<size_t>());
+}
+
+Tensor::Tensor(const std::vector<int64_t>& dims, Type type) : type_(type), dims_(dims) {
+  size_ = getNumElements(dims);
   memory_.reset(new std::vector<char>(size_ * getTypeSize(type)));
 }
 
@@ -112,6 +115,13 @@ int64_t Tensor::cols() const {
   return dims_[1];
 }
 
+void Tensor::resize(const std::vector<int64_t>& dims) {
+  dims_ = dims;
+  size_ = getNumElements(dims);
+  // std::vector keeps its capacity when shrinking, so this only allocates on growth
+  memory_->resize(size_ * getTypeSize(type_));
+}
+
 std::string getTensorTypeStr(Tensor::Type type) {
   switch (type) {
     case Tensor::Type::FLOAT32:
@@ -136,14 +136,17 @@ bool convertLabels(InputData& data) {
 
   LabelRemapper label_remapper = GlobalInfo::instance().getLabelRemapper();
   if (!label_remapper.empty()) {
+    // remap into a new image: the input may share its buffer with the caller
+    cv::Mat remapped(data.label_image.size(), CV_32SC1);
     for (int r = 0; r < data.label_image.rows; ++r) {
+      const auto input_row = data.label_image.ptr<int32_t>(r);
+      auto output_row = remapped.ptr<int32_t>(r);
       for (int c = 0; c < data.label_image.cols; ++c) {
-        // TODO(marcus): any reason to cache image and reassign with a new one?
-        const auto& pixel = data.label_image.at<int32_t>(r, c);
-        data.label_image.at<int32_t>(r, c) =
-            label_remapper.remapLabel(pixel).value_or(-1);
+        output_row[c] = label_remapper.remapLabel(input_row[c]).value_or(-1);
       }
     }
+
+    data.label_image = remapped;
   }
 
   const auto label_type = data.label_image.type();
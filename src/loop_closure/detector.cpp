@@ -41,8 +41,10 @@
 
 #include <glog/logging.h>
 
+#include <atomic>
 #include <fstream>
 
+#include "hydra/reconstruction/parallel_utilities.h"
 #include "hydra/utils/timing_utilities.h"
 
 namespace hydra::lcd {
@@ -82,6 +84,10 @@ void configureDescriptorFactories(lcd::LcdDetector& detector,
     embeddings = loadLabelEmbeddings(config.gnn_lcd.label_embeddings_file);
   }
 
+  gnn::SessionConfig session_config;
+  session_config.intra_op_threads = config.gnn_lcd.intra_op_threads;
+  session_config.inter_op_threads = config.gnn_lcd.inter_op_threads;
+
   LcdDetector::FactoryMap factories;
   factories.emplace(
       DsgLayers::OBJECTS,
@@ -89,12 +95,14 @@ void configureDescriptorFactories(lcd::LcdDetector& detector,
                                             config.object_extraction,
                                             config.gnn_lcd.object_connection_radius_m,
                                             embeddings,
-                                            config.gnn_lcd.objects_pos_in_feature));
+                                            config.gnn_lcd.objects_pos_in_feature,
+                                            session_config));
   factories.emplace(
       DsgLayers::PLACES,
       std::make_unique<PlaceGnnDescriptor>(config.gnn_lcd.places_model_path,
                                            config.places_extraction,
-                                           config.gnn_lcd.places_pos_in_feature));
+                                           config.gnn_lcd.places_pos_in_feature,
+                                           session_config));
   detector.setDescriptorFactories(std::move(factories));
 }
 #else
@@ -261,39 +269,6 @@ void LcdDetector::resetLayerAssignments(const SearchConfigMap& search_configs,
   }
 }
 
-bool LcdDetector::addNewDescriptors(const DynamicSceneGraph& graph,
-                                    const SceneGraphNode& agent_node) {
-  auto parent = agent_node.getParent();
-  if (!parent) {
-    return false;
-  }
-
-  if (!root_leaf_map_.count(*parent)) {
-    root_leaf_map_[*parent] = std::set<NodeId>();
-  }
-
-  root_leaf_map_[*parent].insert(agent_node.id);
-
-  if (!leaf_cache_.count(*parent)) {
-    leaf_cache_[*parent] = DescriptorCache();
-  }
-
-  leaf_cache_[*parent][agent_node.id] = agent_factory_->construct(graph, agent_node);
-
-  for (const auto& prefix_func_pair : layer_factories_) {
-    if (cache_map_[prefix_func_pair.first].count(*parent)) {
-      continue;
-    }
-
-    // guaranteed to exist by constructor
-    Descriptor::Ptr layer_descriptor =
-        prefix_func_pair.second->construct(graph, agent_node);
-    cache_map_[prefix_func_pair.first][*parent] = std::move(layer_descriptor);
-  }
-
-  return true;
-}
-
 void LcdDetector::updateDescriptorCache(
     const DynamicSceneGraph& dsg,
     const std::unordered_set<NodeId>& archived_places,
@@ -316,12 +291,123 @@ void LcdDetector::updateDescriptorCache(
     }
   }
 
+  // agent descriptors and bookkeeping are cheap and order-dependent, so they stay
+  // serial; layer descriptors are only built for the first new agent of each root
+  std::map<LayerId, std::vector<const SceneGraphNode*>> layer_agents;
+  std::set<NodeId> seen_roots;
   for (const auto& agent_node : new_agent_nodes) {
     const auto& node = dsg.getNode(agent_node);
-    addNewDescriptors(dsg, node);
+    auto parent = node.getParent();
+    if (!parent) {
+      continue;
+    }
+
+    root_leaf_map_[*parent].insert(agent_node);
+    leaf_cache_[*parent][agent_node] = agent_factory_->construct(dsg, node);
+    if (!seen_roots.insert(*parent).second) {
+      continue;
+    }
+
+    for (const auto& prefix_func_pair : layer_factories_) {
+      if (!cache_map_[prefix_func_pair.first].count(*parent)) {
+        layer_agents[prefix_func_pair.first].push_back(&node);
+      }
+    }
+  }
+
+  // batches of consecutive agents (and therefore nearby roots) for a single layer
+  struct DescriptorBatch {
+    LayerId layer;
+    std::vector<const SceneGraphNode*> agents;
+    std::vector<Descriptor::Ptr> descriptors;
+  };
+
+  const size_t batch_size = std::max(config_.descriptor_batch_size, size_t(1));
+  std::vector<DescriptorBatch> batches;
+  for (const auto& [layer, agents] : layer_agents) {
+    for (size_t start = 0; start < agents.size(); start += batch_size) {
+      const size_t end = std::min(start + batch_size, agents.size());
+      batches.push_back({layer, {agents.begin() + start, agents.begin() + end}, {}});
+    }
+  }
+
+  if (batches.empty()) {
+    return;
+  }
+
+  // each worker keeps its own subgraph cache: neighboring roots share most of their
+  // places, so later descriptors only pay for the places that are new to the worker
+  const int num_threads = std::max(config_.descriptor_threads, 1);
+  std::vector<SubgraphCache> caches(getNumWorkers(num_threads, batches.size()),
+                                    SubgraphCache(dsg));
+  parallelFor(batches.size(), num_threads, [&](size_t i, size_t worker) {
+    auto& batch = batches[i];
+    const auto& factory = layer_factories_.at(batch.layer);
+    batch.descriptors = factory->constructBatch(dsg, batch.agents, caches[worker]);
+  });
+
+  for (auto& batch : batches) {
+    auto& cache = cache_map_[batch.layer];
+    for (size_t i = 0; i < batch.agents.size(); ++i) {
+      cache[*batch.agents[i]->getParent()] = std::move(batch.descriptors[i]);
+    }
   }
 }
 
+RegistrationSolution LcdDetector::verifyCandidates(
+    const DynamicSceneGraph& dsg,
+    const std::vector<RegistrationCandidate>& candidates,
+    NodeId agent_id) const {
+  if (candidates.empty()) {
+    return {};
+  }
+
+  using Clock = std::chrono::steady_clock;
+  const auto start = Clock::now();
+  const double budget_s = config_.registration_time_budget_s;
+
+  // candidates after the earliest accepted candidate can be skipped, but earlier
+  // candidates still have to be checked to match the serial result
+  std::atomic<size_t> best_index(candidates.size());
+  std::vector<RegistrationSolution> solutions(candidates.size());
+
+  const int num_threads = std::max(config_.registration_threads, 1);
+  parallelFor(candidates.size(), num_threads, [&](size_t i, size_t) {
+    if (i > best_index.load()) {
+      return;
+    }
+
+    const auto& candidate = candidates[i];
+    auto input = candidate.input;
+    if (budget_s > 0.0) {
+      const std::chrono::duration<double> elapsed = Clock::now() - start;
+      const double remaining_s = budget_s - elapsed.count();
+      if (remaining_s <= 0.0) {
+        VLOG(2) << "[DSG LCD] Registration budget of " << budget_s
+                << " [s] exceeded: skipping candidate " << i;
+        return;
+      }
+
+      input.time_limit_s = remaining_s;
+    }
+
+    auto solution =
+        registration_solvers_.at(candidate.level)->solve(dsg, input, agent_id);
+    solution.level = static_cast<int64_t>(candidate.level);
+    if (!solution.valid) {
+      return;
+    }
+
+    solutions[i] = solution;
+    size_t prev_best = best_index.load();
+    while (i < prev_best && !best_index.compare_exchange_weak(prev_best, i)) {
+    }
+  });
+
+  const size_t best = best_index.load();
+  return best < candidates.size() ? solutions[best] : RegistrationSolution();
+}
+
 std::vector<RegistrationSolution> LcdDetector::registerAndVerify(
     const DynamicSceneGraph& dsg,
     const std::map<size_t, LayerSearchResults>& matches,
@@ -329,10 +415,10 @@ std::vector<RegistrationSolution> LcdDetector::registerAndVerify(
     uint64_t timestamp) const {
   ScopedTimer timer("lcd/register", timestamp, true, 2, false);
 
-  RegistrationSolution registration_result;
-
-  size_t idx;
-  for (idx = 0; idx < max_internal_index_; ++idx) {
+  // candidates are ordered by level and then by score (i.e., the order that they
+  // would be tried in serially)
+  std::vector<RegistrationCandidate> candidates;
+  for (size_t idx = 0; idx < max_internal_index_; ++idx) {
     if (!registration_solvers_.count(idx)) {
       continue;
     }
@@ -357,23 +443,16 @@ std::vector<RegistrationSolution> LcdDetector::registerAndVerify(
       CHECK(dsg.hasNode(match.query_root))
           << "Invalid query root: " << NodeSymbol(match.query_root).getLabel();
 
-      DsgRegistrationInput registration_input = {match.query_nodes,
-                                                 match.match_nodes[i],
-                                                 match.query_root,
-                                                 match.match_root[i]};
-      registration_result =
-          registration_solvers_.at(idx)->solve(dsg, registration_input, agent_id);
-      registration_result.level = static_cast<int64_t>(idx);
-      if (registration_result.valid) {
-        break;
-      }
-    }
-
-    if (registration_result.valid) {
-      break;
+      candidates.push_back({idx,
+                            {match.query_nodes,
+                             match.match_nodes[i],
+                             match.query_root,
+                             match.match_root[i]}});
     }
   }
 
+  const auto registration_result = verifyCandidates(dsg, candidates, agent_id);
+
   // TODO(nathan) fix validation
   // size_t vidx = idx;
   /*++vidx;  // start validation at next layer up*/
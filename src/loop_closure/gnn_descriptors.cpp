@@ -38,17 +38,129 @@
 #include <yaml-cpp/yaml.h>
 
 #include <deque>
+#include <functional>
+#include <numeric>
 
 namespace hydra::lcd {
 
 using Dsg = DynamicSceneGraph;
-using DsgNode = DynamicSceneGraphNode;
+using EdgeList = std::vector<std::pair<int64_t, int64_t>>;
+using Subgraphs = std::vector<const std::set<NodeId>*>;
+using InputFunc = std::function<void(const Subgraphs&, gnn::TensorMap&, bool)>;
+
+namespace {
+
+// finds all ordered pairs of nodes in [start, end) within the distance threshold in
+// the same order as a dense all-pairs loop, but by sweeping along the x-axis instead
+void addProximityEdges(const std::vector<Eigen::Vector3d>& positions,
+                       size_t start,
+                       size_t end,
+                       double max_distance_m,
+                       EdgeList& edges) {
+  std::vector<size_t> order(end - start);
+  std::iota(order.begin(), order.end(), start);
+  std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+    return positions[lhs].x() < positions[rhs].x();
+  });
+
+  const size_t first_edge = edges.size();
+  for (size_t i = 0; i < order.size(); ++i) {
+    const auto& source = positions[order[i]];
+    for (size_t j = i + 1; j < order.size(); ++j) {
+      const auto& target = positions[order[j]];
+      if (target.x() - source.x() > max_distance_m) {
+        break;
+      }
+
+      if ((source - target).norm() > max_distance_m) {
+        continue;
+      }
+
+      edges.push_back({order[i], order[j]});
+      edges.push_back({order[j], order[i]});
+    }
+  }
+
+  std::sort(edges.begin() + first_edge, edges.end());
+}
+
+void fillEdgeIndex(const EdgeList& edges, gnn::TensorMap& input) {
+  // note that edges is built in an undirected manner, so edges.size() = 2 * |E|
+  const int64_t num_edges = edges.size();
+  auto edge_map = gnn::getTensorBuffer(
+                      input, "edge_index", {2, num_edges}, gnn::Tensor::Type::INT64)
+                      .map<int64_t>();
+  for (size_t edge_idx = 0; edge_idx < edges.size(); ++edge_idx) {
+    edge_map(0, edge_idx) = edges[edge_idx].first;
+    edge_map(1, edge_idx) = edges[edge_idx].second;
+  }
+}
+
+// runs inference for every non-empty descriptor, either as a single disjoint graph (if
+// the model takes a batch index) or one subgraph at a time, reusing the same buffers
+void inferDescriptors(const gnn::GnnInterface& model,
+                      InferenceBufferPool& pool,
+                      const std::vector<Descriptor*>& descriptors,
+                      const InputFunc& make_input) {
+  if (descriptors.empty()) {
+    return;
+  }
+
+  const bool batched = model.hasInput("batch");
+  auto buffers = pool.acquire();
+  size_t start = 0;
+  while (start < descriptors.size()) {
+    const size_t end = batched ? descriptors.size() : start + 1;
+    Subgraphs subgraphs;
+    for (size_t i = start; i < end; ++i) {
+      subgraphs.push_back(&descriptors[i]->nodes);
+    }
+
+    make_input(subgraphs, buffers->input, batched);
+    VLOG(20) << "Inputs:";
+    VLOG(20) << "  - x: " << std::endl << buffers->input.at("x").map<float>();
+    VLOG(20) << "  - edge_index: " << std::endl
+             << buffers->input.at("edge_index").map<int64_t>();
+
+    const int64_t num_graphs = subgraphs.size();
+    model(buffers->input, buffers->output, {num_graphs});
+    auto output = buffers->output.at("output").map<float>();
+    VLOG(20) << "--------------------------------------";
+    VLOG(20) << "Output:" << std::endl << output;
+    for (size_t i = start; i < end; ++i) {
+      descriptors[i]->values = output.row(i - start).transpose();
+    }
+
+    start = end;
+  }
+
+  pool.release(std::move(buffers));
+}
+
+}  // namespace
+
+std::unique_ptr<InferenceBufferPool::Buffers> InferenceBufferPool::acquire() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (free_.empty()) {
+    return std::make_unique<Buffers>();
+  }
+
+  auto buffers = std::move(free_.back());
+  free_.pop_back();
+  return buffers;
+}
+
+void InferenceBufferPool::release(std::unique_ptr<Buffers>&& buffers) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_.push_back(std::move(buffers));
+}
 
 ObjectGnnDescriptor::ObjectGnnDescriptor(const std::string& model_path,
                                          const SubgraphConfig& config,
                                          double max_edge_distance_m,
                                          const LabelEmbeddings& label_embeddings,
-                                         bool use_pos_in_feature)
+                                         bool use_pos_in_feature,
+                                         const gnn::SessionConfig& session_config)
     : config_(config),
       max_edge_distance_m_(max_edge_distance_m),
       label_embeddings_(label_embeddings),
@@ -69,213 +181,261 @@ ObjectGnnDescriptor::ObjectGnnDescriptor(const std::string& model_path,
     }
   }
 
-  model_.reset(new gnn::GnnInterface(model_path));
+  model_.reset(new gnn::GnnInterface(model_path, {{"output", {0}}}, session_config));
 }
 
 gnn::TensorMap ObjectGnnDescriptor::makeInput(const DynamicSceneGraph& graph,
                                               const std::set<NodeId>& nodes) const {
-  const size_t feature_size = label_embedding_size_ + (use_pos_in_feature_ ? 6 : 3);
-  gnn::Tensor x(nodes.size(), feature_size, gnn::Tensor::Type::FLOAT32);
-  auto x_map = x.map<float>();
+  gnn::TensorMap input;
+  makeBatchInput(graph, {&nodes}, input, false);
+  return input;
+}
+
+void ObjectGnnDescriptor::makeBatchInput(const DynamicSceneGraph& graph,
+                                         const Subgraphs& subgraphs,
+                                         gnn::TensorMap& input,
+                                         bool add_batch_index) const {
+  int64_t num_nodes = 0;
+  for (const auto nodes : subgraphs) {
+    num_nodes += nodes->size();
+  }
+
+  using Type = gnn::Tensor::Type;
+  const int64_t feature_size = label_embedding_size_ + (use_pos_in_feature_ ? 6 : 3);
+  auto x_map =
+      gnn::getTensorBuffer(input, "x", {num_nodes, feature_size}, Type::FLOAT32)
+          .map<float>();
 
   gnn::Tensor pos;
   if (!use_pos_in_feature_) {
-    pos = gnn::Tensor(nodes.size(), 3, gnn::Tensor::Type::FLOAT32);
+    pos = gnn::getTensorBuffer(input, "pos", {num_nodes, 3}, Type::FLOAT32);
   }
   auto pos_map = pos.map<float>();
 
-  size_t index = 0;
-  std::map<NodeId, size_t> index_mapping;
-  for (const auto node : nodes) {
-    const auto& attrs = graph.getNode(node)->get().attributes<SemanticNodeAttributes>();
-
-    size_t start_idx = 0;
-    if (use_pos_in_feature_) {
-      start_idx = 3;
-      x_map.block(index, 0, 1, 3) = attrs.position.cast<float>().transpose();
-    } else {
-      pos_map.block(index, 0, 1, 3) = attrs.position.cast<float>().transpose();
-    }
-
-    x_map.block(index, start_idx, 1, 3) = attrs.bounding_box.world_P_center.transpose();
+  gnn::Tensor batch;
+  if (add_batch_index) {
+    batch = gnn::getTensorBuffer(input, "batch", {num_nodes}, Type::INT64);
+  }
 
-    auto iter = label_embeddings_.find(attrs.semantic_label);
-    if (iter != label_embeddings_.end()) {
-      x_map.block(index, start_idx + 3, 1, label_embedding_size_) =
-          iter->second.transpose();
-    } else {
-      x_map.block(index, start_idx + 3, 1, label_embedding_size_).setZero();
-    }
+  size_t index = 0;
+  EdgeList edges;
+  std::vector<Eigen::Vector3d> positions(num_nodes);
+  for (size_t b = 0; b < subgraphs.size(); ++b) {
+    const size_t start = index;
+    for (const auto node : *subgraphs[b]) {
+      const auto& attrs = graph.getNode(node).attributes<SemanticNodeAttributes>();
+      positions[index] = attrs.position;
+
+      size_t start_idx = 0;
+      if (use_pos_in_feature_) {
+        start_idx = 3;
+        x_map.block(index, 0, 1, 3) = attrs.position.cast<float>().transpose();
+      } else {
+        pos_map.block(index, 0, 1, 3) = attrs.position.cast<float>().transpose();
+      }
 
-    index_mapping[node] = index;
-    ++index;
-  }
+      x_map.block(index, start_idx, 1, 3) =
+          attrs.bounding_box.world_P_center.transpose();
 
-  std::list<std::pair<int64_t, int64_t>> edges;
-  for (const auto& source : nodes) {
-    const auto source_position = graph.getPosition(source);
-    for (const auto& target : nodes) {
-      if (source == target) {
-        continue;
+      auto iter = label_embeddings_.find(attrs.semantic_label);
+      if (iter != label_embeddings_.end()) {
+        x_map.block(index, start_idx + 3, 1, label_embedding_size_) =
+            iter->second.transpose();
+      } else {
+        x_map.block(index, start_idx + 3, 1, label_embedding_size_).setZero();
       }
 
-      const auto target_position = graph.getPosition(target);
-      if ((source_position - target_position).norm() > max_edge_distance_m_) {
-        continue;
+      if (add_batch_index) {
+        batch.data<int64_t>()[index] = b;
       }
 
-      edges.push_back({index_mapping[source], index_mapping[target]});
+      ++index;
     }
-  }
 
-  // note that edges is built in an undirected manner, so edges.size() = 2 * |E|
-  gnn::Tensor edge_index(2, edges.size(), gnn::Tensor::Type::INT64);
-  auto edge_map = edge_index.map<int64_t>();
-  size_t edge_idx = 0;
-  for (const auto& edge : edges) {
-    edge_map(0, edge_idx) = edge.first;
-    edge_map(1, edge_idx) = edge.second;
-    ++edge_idx;
+    addProximityEdges(positions, start, index, max_edge_distance_m_, edges);
   }
 
-  if (use_pos_in_feature_) {
-    return {{"x", x}, {"edge_index", edge_index}};
-  } else {
-    return {{"x", x}, {"edge_index", edge_index}, {"pos", pos}};
-  }
+  fillEdgeIndex(edges, input);
 }
 
 Descriptor::Ptr ObjectGnnDescriptor::construct(const Dsg& graph,
-                                               const DsgNode& agent_node) const {
-  auto parent = agent_node.getParent();
-  if (!parent) {
-    return nullptr;
-  }
+                                               const SceneGraphNode& agent_node) const {
+  SubgraphCache cache(graph);
+  return constructWithCache(graph, agent_node, cache);
+}
 
-  auto descriptor = std::make_unique<Descriptor>();
-  descriptor->normalized = false;
-  descriptor->nodes = getSubgraphNodes(config_, graph, *parent, false);
-  descriptor->root_node = *parent;
-  descriptor->root_position = graph.getPosition(*parent);
-  descriptor->timestamp = agent_node.timestamp;
+Descriptor::Ptr ObjectGnnDescriptor::constructWithCache(
+    const Dsg& graph, const SceneGraphNode& agent_node, SubgraphCache& cache) const {
+  auto descriptors = constructBatch(graph, {&agent_node}, cache);
+  return std::move(descriptors.front());
+}
 
-  if (descriptor->nodes.empty()) {
-    descriptor->is_null = true;
-    return descriptor;
-  }
+std::vector<Descriptor::Ptr> ObjectGnnDescriptor::constructBatch(
+    const Dsg& graph,
+    const std::vector<const SceneGraphNode*>& agent_nodes,
+    SubgraphCache& cache) const {
+  std::vector<Descriptor::Ptr> descriptors;
+  std::vector<Descriptor*> to_infer;
+  for (const auto agent_node : agent_nodes) {
+    auto& descriptor = descriptors.emplace_back();
+    auto parent = agent_node->getParent();
+    if (!parent) {
+      continue;
+    }
 
-  auto input = makeInput(graph, descriptor->nodes);
-  VLOG(20) << "Inputs:";
-  VLOG(20) << "  - x: " << std::endl << input.at("x").map<float>();
-  VLOG(20) << "  - edge_index: " << std::endl << input.at("edge_index").map<int64_t>();
-  if (!use_pos_in_feature_) {
-    VLOG(20) << "  - pos: " << std::endl << input.at("pos").map<float>();
+    descriptor = std::make_unique<Descriptor>();
+    descriptor->normalized = false;
+    descriptor->nodes = getSubgraphNodes(config_, cache, *parent, false);
+    descriptor->root_node = *parent;
+    descriptor->root_position = graph.getPosition(*parent);
+    descriptor->timestamp = agent_node->timestamp.value();
+    if (descriptor->nodes.empty()) {
+      descriptor->is_null = true;
+      continue;
+    }
+
+    to_infer.push_back(descriptor.get());
   }
 
-  auto output = (*model_)(input).at("output");
-  VLOG(20) << "--------------------------------------";
-  VLOG(20) << "Output type: " << output;
-  VLOG(20) << "Output:" << std::endl << output.map<float>();
-  descriptor->values = output.map<float>().transpose();
-  return descriptor;
+  inferDescriptors(
+      *model_,
+      buffers_,
+      to_infer,
+      [&](const Subgraphs& subgraphs, gnn::TensorMap& input, bool batched) {
+        makeBatchInput(graph, subgraphs, input, batched);
+      });
+  return descriptors;
 }
 
 PlaceGnnDescriptor::PlaceGnnDescriptor(const std::string& model_path,
                                        const SubgraphConfig& config,
-                                       bool use_pos_in_feature)
+                                       bool use_pos_in_feature,
+                                       const gnn::SessionConfig& session_config)
     : config_(config), use_pos_in_feature_(use_pos_in_feature) {
-  model_.reset(new gnn::GnnInterface(model_path));
+  model_.reset(new gnn::GnnInterface(model_path, {{"output", {0}}}, session_config));
 }
 
 gnn::TensorMap PlaceGnnDescriptor::makeInput(const DynamicSceneGraph& graph,
                                              const std::set<NodeId>& nodes) const {
-  gnn::Tensor x(nodes.size(), use_pos_in_feature_ ? 5 : 2, gnn::Tensor::Type::FLOAT32);
-  auto x_map = x.map<float>();
+  gnn::TensorMap input;
+  makeBatchInput(graph, {&nodes}, input, false);
+  return input;
+}
+
+void PlaceGnnDescriptor::makeBatchInput(const DynamicSceneGraph& graph,
+                                        const Subgraphs& subgraphs,
+                                        gnn::TensorMap& input,
+                                        bool add_batch_index) const {
+  int64_t num_nodes = 0;
+  for (const auto nodes : subgraphs) {
+    num_nodes += nodes->size();
+  }
+
+  using Type = gnn::Tensor::Type;
+  const int64_t feature_size = use_pos_in_feature_ ? 5 : 2;
+  auto x_map =
+      gnn::getTensorBuffer(input, "x", {num_nodes, feature_size}, Type::FLOAT32)
+          .map<float>();
 
   gnn::Tensor pos;
   if (!use_pos_in_feature_) {
-    pos = gnn::Tensor(nodes.size(), 3, gnn::Tensor::Type::FLOAT32);
+    pos = gnn::getTensorBuffer(input, "pos", {num_nodes, 3}, Type::FLOAT32);
   }
   auto pos_map = pos.map<float>();
 
-  size_t index = 0;
-  std::map<NodeId, size_t> index_mapping;
-  for (const auto node : nodes) {
-    const auto& attrs = graph.getNode(node)->get().attributes<PlaceNodeAttributes>();
-    if (use_pos_in_feature_) {
-      x_map.block(index, 0, 1, 3) = attrs.position.cast<float>().transpose();
-      x_map(index, 3) = attrs.distance;
-      x_map(index, 4) = static_cast<float>(attrs.num_basis_points);
-    } else {
-      pos_map.block(index, 0, 1, 3) = attrs.position.cast<float>().transpose();
-      x_map(index, 0) = attrs.distance;
-      x_map(index, 1) = static_cast<float>(attrs.num_basis_points);
-    }
-    index_mapping[node] = index;
-    ++index;
+  gnn::Tensor batch;
+  if (add_batch_index) {
+    batch = gnn::getTensorBuffer(input, "batch", {num_nodes}, Type::INT64);
   }
 
-  std::list<std::pair<int64_t, int64_t>> edges;
-  for (const auto source : nodes) {
-    const SceneGraphNode& node = *graph.getNode(source);
-    for (const auto sibling : node.siblings()) {
-      if (!nodes.count(sibling)) {
-        continue;
+  size_t index = 0;
+  EdgeList edges;
+  std::unordered_map<NodeId, size_t> index_mapping;
+  for (size_t b = 0; b < subgraphs.size(); ++b) {
+    const auto& nodes = *subgraphs[b];
+    index_mapping.clear();
+    for (const auto node : nodes) {
+      const auto& attrs = graph.getNode(node).attributes<PlaceNodeAttributes>();
+      if (use_pos_in_feature_) {
+        x_map.block(index, 0, 1, 3) = attrs.position.cast<float>().transpose();
+        x_map(index, 3) = attrs.distance;
+        x_map(index, 4) = static_cast<float>(attrs.num_basis_points);
+      } else {
+        pos_map.block(index, 0, 1, 3) = attrs.position.cast<float>().transpose();
+        x_map(index, 0) = attrs.distance;
+        x_map(index, 1) = static_cast<float>(attrs.num_basis_points);
       }
 
-      edges.push_back({index_mapping[source], index_mapping[sibling]});
+      if (add_batch_index) {
+        batch.data<int64_t>()[index] = b;
+      }
+
+      index_mapping[node] = index;
+      ++index;
     }
-  }
 
-  // note that edges is built in an undirected manner, so edges.size() = 2 * |E|
-  gnn::Tensor edge_index(2, edges.size(), gnn::Tensor::Type::INT64);
-  auto edge_map = edge_index.map<int64_t>();
-  size_t edge_idx = 0;
-  for (const auto& edge : edges) {
-    edge_map(0, edge_idx) = edge.first;
-    edge_map(1, edge_idx) = edge.second;
-    ++edge_idx;
-  }
+    for (const auto source : nodes) {
+      const auto& node = graph.getNode(source);
+      for (const auto sibling : node.siblings()) {
+        if (!nodes.count(sibling)) {
+          continue;
+        }
 
-  if (use_pos_in_feature_) {
-    return {{"x", x}, {"edge_index", edge_index}};
-  } else {
-    return {{"x", x}, {"edge_index", edge_index}, {"pos", pos}};
+        edges.push_back({index_mapping[source], index_mapping[sibling]});
+      }
+    }
   }
+
+  fillEdgeIndex(edges, input);
 }
 
 Descriptor::Ptr PlaceGnnDescriptor::construct(const Dsg& graph,
-                                              const DsgNode& agent_node) const {
-  auto parent = agent_node.getParent();
-  if (!parent) {
-    return nullptr;
-  }
+                                              const SceneGraphNode& agent_node) const {
+  SubgraphCache cache(graph);
+  return constructWithCache(graph, agent_node, cache);
+}
 
-  auto descriptor = std::make_unique<Descriptor>();
-  descriptor->normalized = false;
-  descriptor->nodes = getSubgraphNodes(config_, graph, *parent, true);
-  descriptor->root_node = *parent;
-  descriptor->root_position = graph.getPosition(*parent);
-  descriptor->timestamp = agent_node.timestamp;
+Descriptor::Ptr PlaceGnnDescriptor::constructWithCache(
+    const Dsg& graph, const SceneGraphNode& agent_node, SubgraphCache& cache) const {
+  auto descriptors = constructBatch(graph, {&agent_node}, cache);
+  return std::move(descriptors.front());
+}
 
-  if (descriptor->nodes.empty()) {
-    return nullptr;
-  }
+std::vector<Descriptor::Ptr> PlaceGnnDescriptor::constructBatch(
+    const Dsg& graph,
+    const std::vector<const SceneGraphNode*>& agent_nodes,
+    SubgraphCache& cache) const {
+  std::vector<Descriptor::Ptr> descriptors;
+  std::vector<Descriptor*> to_infer;
+  for (const auto agent_node : agent_nodes) {
+    auto& descriptor = descriptors.emplace_back();
+    auto parent = agent_node->getParent();
+    if (!parent) {
+      continue;
+    }
 
-  auto input = makeInput(graph, descriptor->nodes);
-  VLOG(20) << "Inputs:";
-  VLOG(20) << "  - x: " << std::endl << input.at("x").map<float>();
-  VLOG(20) << "  - edge_index: " << std::endl << input.at("edge_index").map<int64_t>();
-  if (!use_pos_in_feature_) {
-    VLOG(20) << "  - pos: " << std::endl << input.at("pos").map<float>();
+    auto nodes = getSubgraphNodes(config_, cache, *parent, true);
+    if (nodes.empty()) {
+      continue;
+    }
+
+    descriptor = std::make_unique<Descriptor>();
+    descriptor->normalized = false;
+    descriptor->nodes = std::move(nodes);
+    descriptor->root_node = *parent;
+    descriptor->root_position = graph.getPosition(*parent);
+    descriptor->timestamp = agent_node->timestamp.value();
+    to_infer.push_back(descriptor.get());
   }
 
-  auto output = (*model_)(input).at("output");
-  VLOG(20) << "--------------------------------------";
-  VLOG(20) << "Output type: " << output;
-  VLOG(20) << "Output:" << std::endl << output.map<float>();
-  descriptor->values = output.map<float>().transpose();
-  return descriptor;
+  inferDescriptors(
+      *model_,
+      buffers_,
+      to_infer,
+      [&](const Subgraphs& subgraphs, gnn::TensorMap& input, bool batched) {
+        makeBatchInput(graph, subgraphs, input, batched);
+      });
+  return descriptors;
 }
 
 ObjectGnnDescriptor::LabelEmbeddings loadLabelEmbeddings(const std::string& filename) {
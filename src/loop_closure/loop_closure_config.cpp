@@ -35,6 +35,7 @@
 #include "hydra/loop_closure/loop_closure_config.h"
 
 #include <config_utilities/config.h>
+#include <config_utilities/types/conversions.h>
 #include <config_utilities/types/eigen_matrix.h>
 #include <config_utilities/types/enum.h>
 
@@ -112,6 +113,8 @@ void declare_config(GnnLcdConfig& conf) {
   field(conf.object_connection_radius_m, "object_connection_radius_m");
   field(conf.object_model_path, "object_model_path");
   field(conf.places_model_path, "places_model_path");
+  field<ThreadNumConversion>(conf.intra_op_threads, "intra_op_threads");
+  field<ThreadNumConversion>(conf.inter_op_threads, "inter_op_threads");
   field(conf.objects_pos_in_feature, "objects_pos_in_feature");
   field(conf.places_pos_in_feature, "places_pos_in_feature");
 }
@@ -130,6 +133,10 @@ void declare_config(LcdDetectorConfig& conf) {
   field(conf.places, "places");
   field(conf.teaser_config, "teaser");
   field(conf.enable_agent_registration, "enable_agent_registration");
+  field<ThreadNumConversion>(conf.registration_threads, "registration_threads");
+  field(conf.registration_time_budget_s, "registration_time_budget_s", "s");
+  field<ThreadNumConversion>(conf.descriptor_threads, "descriptor_threads");
+  field(conf.descriptor_batch_size, "descriptor_batch_size");
   field(conf.object_extraction, "object_extraction");
   field(conf.places_extraction, "places_extraction");
   field(conf.place_histogram_config, "place_histogram_config");
@@ -141,6 +148,10 @@ void declare_config(LcdDetectorConfig& conf) {
   if (conf.use_gnn_descriptors) {
     field(conf.gnn_lcd, "gnn_lcd");
   }
+
+  check(conf.registration_threads, GT, 0, "registration_threads");
+  check(conf.descriptor_threads, GT, 0, "descriptor_threads");
+  check(conf.descriptor_batch_size, GT, 0, "descriptor_batch_size");
 }
 
 }  // namespace lcd
@@ -75,6 +75,11 @@ void LoopClosureModule::save(const LogSetup& log_setup) {
   const auto log_path = log_setup.getLogDir("lcd");
   lcd_detector_->dumpDescriptors(log_path);
   lcd_graph_->save(log_path + "/dsg.json", false);
+  if (log_setup.config().save_graph_checkpoints) {
+    GraphCheckpointOptions options;
+    options.include_mesh = false;
+    checkpoint_writer_.save(*lcd_graph_, log_path + "/dsg.hdck", options);
+  }
 }
 
 std::string LoopClosureModule::printInfo() const {
@@ -34,6 +34,8 @@
  * -------------------------------------------------------------------------- */
 #include "hydra/loop_closure/registration.h"
 
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iomanip>
 
@@ -47,8 +49,6 @@ inline std::ostream& operator<<(std::ostream& out, const gtsam::Quaternion& q) {
   return out;
 }
 
-using hydra::timing::ScopedTimer;
-
 struct AgentNodePose {
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   bool valid = false;
@@ -139,10 +139,9 @@ void logRegistrationProblem(const std::string& path_prefix,
                             const LayerRegistrationSolution& solution,
                             const DsgRegistrationInput& match,
                             NodeId query_agent_id) {
-  static size_t registration_index = 0;
+  static std::atomic<size_t> registration_index{0};
   std::stringstream ss;
-  ss << path_prefix << registration_index << ".json";
-  ++registration_index;
+  ss << path_prefix << registration_index++ << ".json";
 
   std::ofstream outfile(ss.str());
   outfile << "query_id: " << query_agent_id << std::endl;
@@ -167,22 +166,107 @@ void logRegistrationProblem(const std::string& path_prefix,
   // TODO(nathan) output position data
 }
 
+IndexCorrespondences getCorrespondences(const RegistrationNodes& src_nodes,
+                                        const RegistrationNodes& dest_nodes,
+                                        const CorrespondenceFunc& correspondence_func) {
+  IndexCorrespondences correspondences;
+  for (size_t i = 0; i < src_nodes.size(); ++i) {
+    for (size_t j = 0; j < dest_nodes.size(); ++j) {
+      if (correspondence_func(*src_nodes[i], *dest_nodes[j])) {
+        correspondences.emplace_back(i, j);
+      }
+    }
+  }
+
+  return correspondences;
+}
+
+IndexCorrespondences getSemanticCorrespondences(const RegistrationNodes& src_nodes,
+                                                const RegistrationNodes& dest_nodes) {
+  // buckets are filled in order, so each bucket is sorted by destination index
+  std::unordered_map<SemanticNodeAttributes::Label, std::vector<size_t>> dest_buckets;
+  for (size_t j = 0; j < dest_nodes.size(); ++j) {
+    const auto& attrs = dest_nodes[j]->attributes<SemanticNodeAttributes>();
+    dest_buckets[attrs.semantic_label].push_back(j);
+  }
+
+  IndexCorrespondences correspondences;
+  for (size_t i = 0; i < src_nodes.size(); ++i) {
+    const auto& attrs = src_nodes[i]->attributes<SemanticNodeAttributes>();
+    const auto iter = dest_buckets.find(attrs.semantic_label);
+    if (iter == dest_buckets.end()) {
+      continue;
+    }
+
+    for (const auto j : iter->second) {
+      correspondences.emplace_back(i, j);
+    }
+  }
+
+  return correspondences;
+}
+
 DsgTeaserSolver::DsgTeaserSolver(LayerId layer_id,
                                  const LayerRegistrationConfig& config,
                                  const TeaserParams& params)
-    : layer_id(layer_id), config(config), solver(params) {
+    : layer_id(layer_id), config(config), params(params) {
   const std::string layer_str = DsgLayers::LayerIdToString(layer_id);
   timer_prefix = "lcd/" + layer_str + "_registration";
   log_prefix = config.registration_output_path + "/" + layer_str + "_registration_";
 }
 
+DsgTeaserSolver::TeaserSolverPtr DsgTeaserSolver::acquireSolver(
+    const DsgRegistrationInput& match) const {
+  TeaserSolverPtr solver;
+  {  // start critical section
+    std::lock_guard<std::mutex> lock(solver_mutex_);
+    if (!solver_pool_.empty()) {
+      solver = std::move(solver_pool_.front());
+      solver_pool_.pop_front();
+    }
+  }  // end critical section
+
+  auto curr_params = params;
+  if (match.time_limit_s) {
+    curr_params.max_clique_time_limit =
+        std::min(curr_params.max_clique_time_limit, *match.time_limit_s);
+  }
+
+  if (!solver) {
+    return std::make_unique<teaser::RobustRegistrationSolver>(curr_params);
+  }
+
+  solver->reset(curr_params);
+  return solver;
+}
+
+void DsgTeaserSolver::releaseSolver(TeaserSolverPtr&& solver) const {
+  std::lock_guard<std::mutex> lock(solver_mutex_);
+  solver_pool_.push_back(std::move(solver));
+}
+
 RegistrationSolution DsgTeaserSolver::solve(const DynamicSceneGraph& dsg,
                                             const DsgRegistrationInput& match,
                                             NodeId query_agent_id) const {
   // TODO(nathan) helper function in dsg
   const uint64_t timestamp = dsg.getNode(query_agent_id).timestamp.value().count();
-  ScopedTimer timer(timer_prefix, timestamp, true, 2, false);
+  // candidates may be solved concurrently, so record elapsed time directly instead
+  // of using a scoped timer (which requires unique names for concurrent timers)
+  const auto start = std::chrono::steady_clock::now();
+  RegistrationSolution result = solveImpl(dsg, match, query_agent_id);
+  const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start);
+  auto& recorder = timing::ElapsedTimeRecorder::instance();
+  if (!recorder.timing_disabled) {
+    recorder.record(timer_prefix, timestamp, elapsed);
+  }
 
+  return result;
+}
+
+RegistrationSolution DsgTeaserSolver::solveImpl(const DynamicSceneGraph& dsg,
+                                                const DsgRegistrationInput& match,
+                                                NodeId query_agent_id) const {
   LayerRegistrationProblem<std::set<NodeId>> problem;
   if (config.recreate_subgraph) {
     const bool is_places = layer_id == DsgLayers::PLACES;
@@ -219,13 +303,16 @@ RegistrationSolution DsgTeaserSolver::solve(const DynamicSceneGraph& dsg,
   }
 
   const auto& layer = dsg.getLayer(layer_id);
+  auto solver = acquireSolver(match);
   LayerRegistrationSolution solution;
   if (config.use_pairwise_registration) {
-    solution = registerDsgLayerPairwise(config, solver, problem, layer);
+    solution = registerDsgLayerPairwise(config, *solver, problem, layer);
   } else {
-    solution = registerDsgLayerSemantic(config, solver, problem, layer);
+    solution = registerDsgLayerSemantic(config, *solver, problem, layer);
   }
 
+  releaseSolver(std::move(solver));
+
   if (config.log_registration_problem) {
     logRegistrationProblem(log_prefix, dsg, solution, match, query_agent_id);
   }
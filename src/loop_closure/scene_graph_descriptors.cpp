@@ -65,6 +65,12 @@ ObjectDescriptorFactory::ObjectDescriptorFactory(const SubgraphConfig& config,
 
 Descriptor::Ptr ObjectDescriptorFactory::construct(
     const Dsg& graph, const SceneGraphNode& agent_node) const {
+  SubgraphCache cache(graph);
+  return constructWithCache(graph, agent_node, cache);
+}
+
+Descriptor::Ptr ObjectDescriptorFactory::constructWithCache(
+    const Dsg& graph, const SceneGraphNode& agent_node, SubgraphCache& cache) const {
   auto parent = agent_node.getParent();
   if (!parent) {
     return nullptr;
@@ -78,19 +84,23 @@ Descriptor::Ptr ObjectDescriptorFactory::construct(
   descriptor->root_node = *parent;
   descriptor->timestamp = agent_node.timestamp.value();
   descriptor->root_position = root_position;
-  descriptor->nodes = getSubgraphNodes(config, graph, *parent, false);
+  descriptor->nodes = getSubgraphNodes(config, cache, *parent, false);
 
   for (const auto node : descriptor->nodes) {
-    const auto attrs = graph.getNode(node).attributes<SemanticNodeAttributes>();
-    const size_t label = attrs.semantic_label;
-    if (label > static_cast<size_t>(descriptor->values.rows())) {
-      LOG(ERROR) << "label " << static_cast<int>(label) << " for node "
+    const auto label = cache.getLabel(node);
+    if (!label) {
+      LOG(ERROR) << "node " << NodeSymbol(node).getLabel() << " has no semantic label";
+      continue;
+    }
+
+    if (*label >= static_cast<size_t>(descriptor->values.rows())) {
+      LOG(ERROR) << "label " << static_cast<int>(*label) << " for node "
                  << NodeSymbol(node).getLabel() << " exceeds max label "
                  << descriptor->values.rows();
       continue;
     }
 
-    descriptor->values(label) += 1.0f;
+    descriptor->values(*label) += 1.0f;
   }
 
   return descriptor;
@@ -102,6 +112,12 @@ PlaceDescriptorFactory::PlaceDescriptorFactory(const SubgraphConfig& config,
 
 Descriptor::Ptr PlaceDescriptorFactory::construct(
     const Dsg& graph, const SceneGraphNode& agent_node) const {
+  SubgraphCache cache(graph);
+  return constructWithCache(graph, agent_node, cache);
+}
+
+Descriptor::Ptr PlaceDescriptorFactory::constructWithCache(
+    const Dsg& graph, const SceneGraphNode& agent_node, SubgraphCache& cache) const {
   auto parent = agent_node.getParent();
   if (!parent) {
     return nullptr;
@@ -115,12 +131,16 @@ Descriptor::Ptr PlaceDescriptorFactory::construct(
   descriptor->root_node = *parent;
   descriptor->timestamp = agent_node.timestamp.value();
   descriptor->root_position = root_position;
-  descriptor->nodes = getSubgraphNodes(config, graph, *parent, true);
+  descriptor->nodes = getSubgraphNodes(config, cache, *parent, true);
 
-  const auto& places = graph.getLayer(DsgLayers::PLACES);
   for (const auto node : descriptor->nodes) {
-    const auto& attrs = places.getNode(node).attributes<PlaceNodeAttributes>();
-    descriptor->values(histogram.getBin(attrs.distance)) += 1.0f;
+    const auto place = cache.getPlace(node);
+    if (!place || !place->distance) {
+      LOG(ERROR) << "node " << NodeSymbol(node).getLabel() << " is not a valid place";
+      continue;
+    }
+
+    descriptor->values(histogram.getBin(*place->distance)) += 1.0f;
   }
 
   return descriptor;
@@ -101,15 +101,10 @@ void getPlacesWithinRadius(const DynamicSceneGraph& graph,
       [&](const SceneGraphLayer&, NodeId node) { found.insert(node); });
 }
 
+using DistanceNodePairs = std::vector<std::pair<double, NodeId>>;
+
 std::set<NodeId> getFilteredNodeSet(const SubgraphConfig& config,
-                                    const DynamicSceneGraph& graph,
-                                    const Eigen::Vector3d& origin,
-                                    const std::set<NodeId>& found) {
-  std::vector<std::pair<double, NodeId>> candidates;
-  for (const auto node : found) {
-    const double distance_m = (graph.getPosition(node) - origin).norm();
-    candidates.push_back({distance_m, node});
-  }
+                                    DistanceNodePairs& candidates) {
   std::sort(candidates.begin(), candidates.end());
 
   std::set<NodeId> valid;
@@ -168,7 +163,147 @@ std::set<NodeId> getSubgraphNodes(const SubgraphConfig& config,
     return found;
   }
 
-  return getFilteredNodeSet(config, graph, origin, found);
+  DistanceNodePairs candidates;
+  for (const auto node : found) {
+    const double distance_m = (graph.getPosition(node) - origin).norm();
+    candidates.push_back({distance_m, node});
+  }
+
+  return getFilteredNodeSet(config, candidates);
+}
+
+SubgraphCache::SubgraphCache(const DynamicSceneGraph& graph) : graph(graph) {}
+
+const PlaceNeighborhood* SubgraphCache::getPlace(NodeId place) {
+  auto iter = places_.find(place);
+  if (iter != places_.end()) {
+    return iter->second ? &(*iter->second) : nullptr;
+  }
+
+  const auto& places = graph.getLayer(DsgLayers::PLACES);
+  const auto node = places.findNode(place);
+  iter = places_.emplace(place, std::nullopt).first;
+  if (!node) {
+    return nullptr;
+  }
+
+  auto& info = iter->second.emplace();
+  info.position = node->attributes().position;
+  const auto& attrs = node->attributes();
+  const auto place_attrs = dynamic_cast<const PlaceNodeAttributes*>(&attrs);
+  if (place_attrs) {
+    info.distance = place_attrs->distance;
+  }
+
+  const auto& siblings = node->siblings();
+  info.siblings.assign(siblings.begin(), siblings.end());
+  for (const auto child : node->children()) {
+    if (graph.isDynamic(child)) {
+      continue;
+    }
+
+    const auto& child_node = graph.getNode(child);
+    auto& child_info = info.children.emplace_back();
+    child_info.id = child;
+    child_info.position = child_node.attributes().position;
+    const auto semantic_attrs =
+        dynamic_cast<const SemanticNodeAttributes*>(&child_node.attributes());
+    if (semantic_attrs) {
+      child_info.label = semantic_attrs->semantic_label;
+      labels_[child] = semantic_attrs->semantic_label;
+    }
+  }
+
+  return &(*iter->second);
+}
+
+std::optional<SemanticNodeAttributes::Label> SubgraphCache::getLabel(
+    NodeId object) const {
+  const auto iter = labels_.find(object);
+  if (iter == labels_.end()) {
+    return std::nullopt;
+  }
+
+  return iter->second;
+}
+
+std::set<NodeId> getSubgraphNodes(const SubgraphConfig& config,
+                                  SubgraphCache& cache,
+                                  NodeId root_node,
+                                  bool is_places) {
+  const auto root = cache.getPlace(root_node);
+  if (!root) {
+    LOG(ERROR) << "Invalid root node " << NodeSymbol(root_node).getLabel();
+    return {};
+  }
+
+  const Eigen::Vector3d origin = root->position;
+  const double radius_m = config.max_radius_m;
+
+  // mirrors the breadth-first searches above, but only touches cached places
+  std::map<NodeId, double> found;
+  std::deque<NodeId> frontier{root_node};
+  std::unordered_set<NodeId> visited{root_node};
+  while (!frontier.empty()) {
+    const NodeId place_id = frontier.front();
+    frontier.pop_front();
+    const auto place = cache.getPlace(place_id);
+    if (!place) {
+      continue;
+    }
+
+    if (is_places) {
+      found[place_id] = (place->position - origin).norm();
+    } else {
+      for (const auto& child : place->children) {
+        const double distance_m = (child.position - origin).norm();
+        if (distance_m < radius_m) {
+          found[child.id] = distance_m;
+        }
+      }
+    }
+
+    for (const auto sibling : place->siblings) {
+      if (visited.count(sibling)) {
+        continue;
+      }
+
+      const auto neighbor = cache.getPlace(sibling);
+      if (!neighbor) {
+        continue;
+      }
+
+      bool valid = (origin - neighbor->position).norm() < radius_m;
+      if (!is_places) {
+        for (const auto& child : neighbor->children) {
+          valid |= (origin - child.position).norm() < radius_m;
+        }
+      }
+
+      if (!valid) {
+        continue;
+      }
+
+      visited.insert(sibling);
+      frontier.push_back(sibling);
+    }
+  }
+
+  if (config.fixed_radius) {
+    std::set<NodeId> nodes;
+    for (const auto& id_distance_pair : found) {
+      nodes.insert(nodes.end(), id_distance_pair.first);
+    }
+
+    return nodes;
+  }
+
+  DistanceNodePairs candidates;
+  for (const auto& id_distance_pair : found) {
+    candidates.push_back({id_distance_pair.second, id_distance_pair.first});
+  }
+
+  return getFilteredNodeSet(config, candidates);
 }
 
 }  // namespace hydra
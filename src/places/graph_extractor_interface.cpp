@@ -71,24 +71,23 @@ void GraphExtractorInterface::fillParentInfo(const GvdLayer& gvd,
       continue;
     }
 
-    CHECK(tracker.parents.count(node_index))
-        << "bad gvd voxel: " << *voxel << " @ " << node_index.transpose();
+    const auto* parents = tracker.getParents(node_index);
+    CHECK(parents) << "bad gvd voxel: " << *voxel << " @ " << node_index.transpose();
 
     // save primary parent first
-    const GlobalIndex curr_parent = voxel->parent;
-    auto iter = tracker.parent_vertices.find(curr_parent);
-    if (iter != tracker.parent_vertices.end()) {
-      attrs.voxblox_mesh_connections.push_back(convertInfo(iter->second));
+    const auto* primary_info = tracker.getVertex(voxel->parent);
+    if (primary_info) {
+      attrs.voxblox_mesh_connections.push_back(convertInfo(*primary_info));
     }
 
     // save all other basis points
-    for (const auto& parent : tracker.parents.at(node_index)) {
-      if (!tracker.parent_vertices.count(parent)) {
+    for (const auto& parent : *parents) {
+      const auto* parent_info = tracker.getVertex(parent);
+      if (!parent_info) {
         continue;
       }
 
-      const auto& parent_info = tracker.parent_vertices.at(parent);
-      attrs.voxblox_mesh_connections.push_back(convertInfo(parent_info));
+      attrs.voxblox_mesh_connections.push_back(convertInfo(*parent_info));
     }
   }
 }
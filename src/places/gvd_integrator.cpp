@@ -57,6 +57,7 @@ GvdIntegrator::GvdIntegrator(const GvdIntegratorConfig& config,
       config_(config),
       gvd_layer_(gvd_layer),
       graph_extractor_(graph_extractor),
+      parent_tracker_(CHECK_NOTNULL(gvd_layer)->voxel_size, gvd_layer->voxels_per_side),
       neighbor_search_(26) {
   // TODO(nathan) we could consider an exception here
   CHECK(gvd_layer_);
@@ -144,6 +145,8 @@ void GvdIntegrator::archiveBlocks(const BlockIndices& blocks) {
 
     VLOG(5) << "Removing block: " << idx.transpose();
     gvd_layer_->removeBlock(idx);
+    // parent vertices in the block are released with it
+    parent_tracker_.removeBlock(idx);
   }
 }
 
@@ -34,20 +34,94 @@
  * -------------------------------------------------------------------------- */
 #include "hydra/places/gvd_parent_tracker.h"
 
+#include <algorithm>
+
 #include "hydra/places/gvd_utilities.h"
 
 namespace hydra::places {
 
+namespace {
+
+template <typename T>
+struct EntryLess {
+  bool operator()(const std::pair<uint32_t, T>& entry, uint32_t voxel) const {
+    return entry.first < voxel;
+  }
+};
+
+template <typename T>
+T* findEntry(std::vector<std::pair<uint32_t, T>>& entries, uint32_t voxel) {
+  auto iter = std::lower_bound(entries.begin(), entries.end(), voxel, EntryLess<T>());
+  return (iter == entries.end() || iter->first != voxel) ? nullptr : &iter->second;
+}
+
+template <typename T>
+const T* findEntry(const std::vector<std::pair<uint32_t, T>>& entries,
+                   uint32_t voxel) {
+  auto iter = std::lower_bound(entries.begin(), entries.end(), voxel, EntryLess<T>());
+  return (iter == entries.end() || iter->first != voxel) ? nullptr : &iter->second;
+}
+
+template <typename T>
+T& findOrAddEntry(std::vector<std::pair<uint32_t, T>>& entries, uint32_t voxel) {
+  auto iter = std::lower_bound(entries.begin(), entries.end(), voxel, EntryLess<T>());
+  if (iter == entries.end() || iter->first != voxel) {
+    iter = entries.emplace(iter, voxel, T());
+  }
+
+  return iter->second;
+}
+
+}  // namespace
+
+void GvdParentSet::insert(const GlobalIndex& parent) {
+  if (size_ < kInlineSize) {
+    inline_[size_] = parent;
+  } else {
+    if (size_ == kInlineSize) {
+      overflow_.assign(inline_.begin(), inline_.end());
+    }
+
+    overflow_.push_back(parent);
+  }
+
+  ++size_;
+}
+
+GvdParentTracker::GvdParentTracker(float voxel_size, int voxels_per_side)
+    : voxels_per_side_(voxels_per_side), layer_(voxel_size * voxels_per_side) {}
+
+std::pair<BlockIndex, uint32_t> GvdParentTracker::getKey(
+    const GlobalIndex& index) const {
+  BlockIndex block_index;
+  VoxelIndex voxel_index;
+  for (int i = 0; i < 3; ++i) {
+    // floor division so negative indices map to the correct block
+    auto block_coord = index(i) / voxels_per_side_;
+    if (index(i) % voxels_per_side_ != 0 && index(i) < 0) {
+      --block_coord;
+    }
+
+    block_index(i) = block_coord;
+    voxel_index(i) = index(i) - block_coord * voxels_per_side_;
+  }
+
+  const auto linear_index =
+      spatial_hash::linearIndexFromVoxelIndex(voxel_index, voxels_per_side_);
+  return {block_index, static_cast<uint32_t>(linear_index)};
+}
+
 uint8_t GvdParentTracker::updateGvdParentMap(const GvdLayer& layer,
                                              const VoronoiCheckConfig& config,
                                              const GlobalIndex& voxel_index,
                                              const GvdVoxel& neighbor) {
-  if (!parents.count(voxel_index)) {
-    parents[voxel_index] = GlobalIndexSet();
-  }
+  const auto [block_index, voxel] = getKey(voxel_index);
+  auto& block = layer_.hasBlock(block_index) ? layer_.getBlock(block_index)
+                                             : layer_.allocateBlock(block_index);
+  auto& voxel_parents = findOrAddEntry(block.parents, voxel);
 
-  uint8_t curr_extra_basis = parents[voxel_index].size();
-  for (const auto& other_parent : parents[voxel_index]) {
+  uint8_t curr_extra_basis = voxel_parents.size();
+  for (const auto& other_parent : voxel_parents) {
     const bool is_unique =
         isParentUnique(config, voxel_index, other_parent, neighbor.parent);
     if (!is_unique) {
@@ -56,16 +130,19 @@ uint8_t GvdParentTracker::updateGvdParentMap(const GvdLayer& layer,
   }
 
   // parent is unique enough
-  parents[voxel_index].insert(neighbor.parent);
+  voxel_parents.insert(neighbor.parent);
   markNewGvdParent(layer, neighbor.parent);
   return curr_extra_basis + 1;
 }
 
 void GvdParentTracker::markNewGvdParent(const GvdLayer& layer,
                                         const GlobalIndex& parent) {
-  if (parent_vertices.count(parent)) {
+  const auto [block_index, voxel] = getKey(parent);
+  auto block = layer_.getBlockPtr(block_index);
+  auto* info = block ? findEntry(block->vertices, voxel) : nullptr;
+  if (info) {
     // make sure the parent vertex map stays alive for this gvd member
-    parent_vertices[parent].ref_count++;
+    info->ref_count++;
     return;
   }
 
@@ -76,50 +153,100 @@ void GvdParentTracker::markNewGvdParent(const GvdLayer& layer,
     return;
   }
 
-  GvdVertexInfo info;
-  info.ref_count = 1;
-  info.pos = parent_voxel->parent_pos;
-
-  parent_vertices[parent] = info;
+  auto& new_block = block ? *block : layer_.allocateBlock(block_index);
+  auto& new_info = findOrAddEntry(new_block.vertices, voxel);
+  new_info.ref_count = 1;
+  new_info.pos = parent_voxel->parent_pos;
 }
 
 void GvdParentTracker::removeVoronoiFromGvdParentMap(const GlobalIndex& voxel_index) {
-  auto voxel_parents = parents.find(voxel_index);
-  if (voxel_parents != parents.end()) {
-    for (const auto& parent : voxel_parents->second) {
-      if (parent_vertices.count(parent)) {
-        // decrement the ref count (we garbage collect later to avoid losing parents
-        // due to thrashing)
-        parent_vertices[parent].ref_count--;
-      }
+  const auto [block_index, voxel] = getKey(voxel_index);
+  auto block = layer_.getBlockPtr(block_index);
+  if (!block) {
+    return;
+  }
+
+  auto& parents = block->parents;
+  auto iter = std::lower_bound(
+      parents.begin(), parents.end(), voxel, EntryLess<GvdParentSet>());
+  if (iter == parents.end() || iter->first != voxel) {
+    return;
+  }
+
+  for (const auto& parent : iter->second) {
+    const auto [parent_block_index, parent_voxel] = getKey(parent);
+    auto parent_block = layer_.getBlockPtr(parent_block_index);
+    auto* info =
+        parent_block ? findEntry(parent_block->vertices, parent_voxel) : nullptr;
+    if (info) {
+      // decrement the ref count (we garbage collect later to avoid losing parents
+      // due to thrashing)
+      info->ref_count--;
     }
+  }
 
-    parents.erase(voxel_parents);
+  parents.erase(iter);
+  if (block->empty()) {
+    layer_.removeBlock(block_index);
   }
 }
 
 void GvdParentTracker::updateVertexMapping(const GvdLayer& layer) {
-  auto iter = parent_vertices.begin();
-  while (iter != parent_vertices.end()) {
-    if (!iter->second.ref_count) {
-      iter = parent_vertices.erase(iter);
-      continue;
-    }
+  BlockIndices empty_blocks;
+  for (auto& block : layer_) {
+    const GlobalIndex block_origin =
+        block.index.cast<GlobalIndex::Scalar>() * voxels_per_side_;
+    auto& vertices = block.vertices;
+    auto iter = vertices.begin();
+    while (iter != vertices.end()) {
+      if (!iter->second.ref_count) {
+        iter = vertices.erase(iter);
+        continue;
+      }
+
+      const auto voxel_index =
+          spatial_hash::voxelIndexFromLinearIndex(iter->first, voxels_per_side_);
+      const GlobalIndex global_index =
+          block_origin + voxel_index.cast<GlobalIndex::Scalar>();
+      const auto* voxel = layer.getVoxelPtr(global_index);
+      if (!voxel) {
+        ++iter;
+        continue;
+      }
 
-    const auto* voxel = layer.getVoxelPtr(static_cast<GlobalIndex>(iter->first));
-    if (!voxel) {
+      if (!voxel->on_surface) {
+        iter = vertices.erase(iter);
+        continue;
+      }
+
+      iter->second.pos = voxel->parent_pos;
       ++iter;
-      continue;
     }
 
-    if (!voxel->on_surface) {
-      iter = parent_vertices.erase(iter);
-      continue;
+    if (block.empty()) {
+      empty_blocks.push_back(block.index);
     }
+  }
 
-    iter->second.pos = voxel->parent_pos;
-    ++iter;
+  for (const auto& block_index : empty_blocks) {
+    layer_.removeBlock(block_index);
   }
 }
 
+void GvdParentTracker::removeBlock(const BlockIndex& block_index) {
+  layer_.removeBlock(block_index);
+}
+
+const GvdParentSet* GvdParentTracker::getParents(const GlobalIndex& voxel_index) const {
+  const auto [block_index, voxel] = getKey(voxel_index);
+  const auto block = layer_.getBlockPtr(block_index);
+  return block ? findEntry(block->parents, voxel) : nullptr;
+}
+
+const GvdVertexInfo* GvdParentTracker::getVertex(const GlobalIndex& parent) const {
+  const auto [block_index, voxel] = getKey(parent);
+  const auto block = layer_.getBlockPtr(block_index);
+  return block ? findEntry(block->vertices, voxel) : nullptr;
+}
+
 }  // namespace hydra::places
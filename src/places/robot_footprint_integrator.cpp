@@ -35,8 +35,14 @@
 #include "hydra/places/robot_footprint_integrator.h"
 
 #include <config_utilities/config.h>
+#include <config_utilities/types/conversions.h>
 #include <config_utilities/types/eigen_matrix.h>
 
+#include <cmath>
+#include <limits>
+
+#include "hydra/reconstruction/parallel_utilities.h"
+
 namespace hydra {
 
 void declare_config(RobotFootprintIntegrator::Config& config) {
@@ -45,6 +51,8 @@ void declare_config(RobotFootprintIntegrator::Config& config) {
   field(config.bbox_min, "bbox_min");
   field(config.bbox_max, "bbox_max");
   field(config.tsdf_weight, "tsdf_weight");
+  field<ThreadNumConversion>(config.num_threads, "num_threads");
+  check(config.num_threads, GT, 0, "num_threads");
 }
 
 RobotFootprintIntegrator::RobotFootprintIntegrator(const Config& config)
@@ -52,33 +60,47 @@ RobotFootprintIntegrator::RobotFootprintIntegrator(const Config& config)
 
 RobotFootprintIntegrator::~RobotFootprintIntegrator() = default;
 
-// somewhat adapted from findBlocksInViewFrustum
-BlockIndices getAffectedBlocks(const Eigen::Isometry3f& world_T_body,
-                               const BoundingBox& bbox,
-                               VolumetricMap& map) {
-  const auto b_size = map.blockSize();
-  const auto block_diag_half = std::sqrt(3.0f) * b_size / 2.0f;
-  const auto margin = Eigen::Vector3f::Constant(block_diag_half);
-  BoundingBox inflated = bbox;
-  inflated.dimensions += 2.0f * margin;
-
-  const double max_range = inflated.dimensions.maxCoeff();
-  const int max_steps = std::ceil(max_range / b_size) + 1;
-  const auto body_T_world = world_T_body.inverse();
-  const auto pos = world_T_body.translation();
-  const auto body_idx = spatial_hash::indexFromPoint<BlockIndex>(pos, 1.0f / b_size);
+BlockIndices RobotFootprintIntegrator::getCandidateBlocks(
+    const Eigen::Isometry3f& w_T_b, float block_size) const {
+  // world-frame extent of the oriented footprint
+  Eigen::Vector3f world_min =
+      Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector3f world_max = -world_min;
+  for (int i = 0; i < 8; ++i) {
+    const Eigen::Vector3f corner((i & 1) ? config.bbox_max.x() : config.bbox_min.x(),
+                                 (i & 2) ? config.bbox_max.y() : config.bbox_min.y(),
+                                 (i & 4) ? config.bbox_max.z() : config.bbox_min.z());
+    const Eigen::Vector3f corner_w = w_T_b * corner;
+    world_min = world_min.cwiseMin(corner_w);
+    world_max = world_max.cwiseMax(corner_w);
+  }
+
+  const float block_size_inv = 1.0f / block_size;
+  const auto min_idx =
+      spatial_hash::indexFromPoint<BlockIndex>(world_min, block_size_inv);
+  const auto max_idx =
+      spatial_hash::indexFromPoint<BlockIndex>(world_max, block_size_inv);
+
+  // blocks whose bounding sphere misses the footprint can't contain covered voxels
+  const auto b_T_w = w_T_b.inverse();
+  const float radius = std::sqrt(3.0f) * block_size / 2.0f;
+  const Eigen::Vector3f inflated_min = config.bbox_min.array() - radius;
+  const Eigen::Vector3f inflated_max = config.bbox_max.array() + radius;
 
   BlockIndices result;
-  for (int x = -max_steps; x <= max_steps; ++x) {
-    for (int y = -max_steps; y <= max_steps; ++y) {
-      for (int z = -max_steps; z <= max_steps; ++z) {
-        const Eigen::Vector3f offset(x, y, z);
-        const auto p_body = body_T_world * (pos + offset * b_size);
-        if (!inflated.contains(p_body)) {
+  BlockIndex idx;
+  for (idx.x() = min_idx.x(); idx.x() <= max_idx.x(); ++idx.x()) {
+    for (idx.y() = min_idx.y(); idx.y() <= max_idx.y(); ++idx.y()) {
+      for (idx.z() = min_idx.z(); idx.z() <= max_idx.z(); ++idx.z()) {
+        const Eigen::Vector3f center =
+            (idx.cast<float>().array() + 0.5f) * block_size;
+        const Eigen::Vector3f p_body = b_T_w * center;
+        if ((p_body.array() < inflated_min.array()).any() ||
+            (p_body.array() > inflated_max.array()).any()) {
           continue;
         }
 
-        result.push_back(body_idx + offset.cast<BlockIndex::Scalar>());
+        result.push_back(idx);
       }
     }
   }
@@ -86,15 +108,79 @@ BlockIndices getAffectedBlocks(const Eigen::Isometry3f& world_T_body,
   return result;
 }
 
+std::vector<RobotFootprintIntegrator::VoxelRun>
+RobotFootprintIntegrator::rasterizeBlock(const Eigen::Isometry3f& b_T_w,
+                                         const BlockIndex& block_index,
+                                         float voxel_size,
+                                         int voxels_per_side) const {
+  // voxel (x, y, z) has center c(y, z) + x * step in the body frame
+  const float block_size = voxel_size * voxels_per_side;
+  const Eigen::Vector3f origin = block_index.cast<float>() * block_size;
+  const Eigen::Vector3f step = b_T_w.linear().col(0) * voxel_size;
+  const Eigen::Vector3f y_step = b_T_w.linear().col(1) * voxel_size;
+  const Eigen::Vector3f z_step = b_T_w.linear().col(2) * voxel_size;
+  const Eigen::Vector3f first_center =
+      b_T_w * (origin + Eigen::Vector3f::Constant(0.5f * voxel_size));
+
+  std::vector<VoxelRun> runs;
+  for (int z = 0; z < voxels_per_side; ++z) {
+    for (int y = 0; y < voxels_per_side; ++y) {
+      const Eigen::Vector3f row_start = first_center + y * y_step + z * z_step;
+
+      // intersect min <= row_start + x * step <= max over all axes
+      float lower = 0.0f;
+      float upper = voxels_per_side - 1;
+      for (int axis = 0; axis < 3 && lower <= upper; ++axis) {
+        const float min_offset = config.bbox_min(axis) - row_start(axis);
+        const float max_offset = config.bbox_max(axis) - row_start(axis);
+        if (std::abs(step(axis)) < 1.0e-9f) {
+          if (min_offset > 0.0f || max_offset < 0.0f) {
+            upper = -1.0f;  // row is entirely outside the slab
+          }
+          continue;
+        }
+
+        const float t1 = min_offset / step(axis);
+        const float t2 = max_offset / step(axis);
+        lower = std::max(lower, std::min(t1, t2));
+        upper = std::min(upper, std::max(t1, t2));
+      }
+
+      const int x_min = std::ceil(lower);
+      const int x_max = std::floor(upper);
+      if (x_min > x_max) {
+        continue;
+      }
+
+      runs.push_back({y, z, x_min, x_max});
+    }
+  }
+
+  return runs;
+}
+
 void RobotFootprintIntegrator::addFreespaceFootprint(const Eigen::Isometry3f& w_T_b,
                                                      VolumetricMap& map) const {
-  const auto block_indices = getAffectedBlocks(w_T_b, bbox, map);
   const auto b_T_w = w_T_b.inverse();
+  const auto voxel_size = map.config.voxel_size;
+  const auto vps = map.config.voxels_per_side;
+  const auto candidates = getCandidateBlocks(w_T_b, map.blockSize());
+
+  std::vector<std::vector<VoxelRun>> block_runs(candidates.size());
+  parallelFor(candidates.size(), config.num_threads, [&](size_t i, size_t) {
+    block_runs[i] = rasterizeBlock(b_T_w, candidates[i], voxel_size, vps);
+  });
+
+  // allocation isn't thread-safe, so only blocks the footprint covers are added here
   auto& tsdf = map.getTsdfLayer();
   const auto semantic_layer = map.getSemanticLayer();
+  std::vector<std::pair<TsdfBlock::Ptr, const std::vector<VoxelRun>*>> to_update;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (block_runs[i].empty()) {
+      continue;
+    }
 
-  BlockIndices new_blocks;
-  for (const auto& idx : block_indices) {
+    const auto& idx = candidates[i];
     TsdfBlock::Ptr block;
     if (tsdf.hasBlock(idx)) {
       block = tsdf.getBlockPtr(idx);
@@ -103,36 +189,27 @@ void RobotFootprintIntegrator::addFreespaceFootprint(const Eigen::Isometry3f& w_
       if (semantic_layer) {
         semantic_layer->allocateBlockPtr(idx);
       }
-
-      new_blocks.push_back(idx);
     }
 
-    for (size_t i = 0; i < block->numVoxels(); ++i) {
-      const auto p_body = b_T_w * block->getVoxelPosition(i);
-      // technically we should expand by sqrt(3) * voxel_size, but the more
-      // conservative, the better
-      if (!bbox.contains(p_body)) {
-        continue;  // voxel doesn't intersect with free-space pattern
-      }
-
-      block->setUpdated();
-      auto& voxel = block->getVoxel(i);
-      voxel.distance = map.config.truncation_distance;
-      voxel.weight = config.tsdf_weight;
-    }
+    to_update.emplace_back(block, &block_runs[i]);
   }
 
-  for (const auto& idx : new_blocks) {
-    const auto block = map.getTsdfLayer().getBlockPtr(idx);
-    if (!block || block->esdf_updated || block->mesh_updated) {
-      continue;
-    }
-
-    map.getTsdfLayer().removeBlock(idx);
-    if (semantic_layer) {
-      semantic_layer->removeBlock(idx);
+  const float distance = map.config.truncation_distance;
+  const float weight = config.tsdf_weight;
+  parallelFor(to_update.size(), config.num_threads, [&](size_t i, size_t) {
+    auto& [block, runs] = to_update[i];
+    block->setUpdated();
+    for (const auto& run : *runs) {
+      for (int x = run.x_min; x <= run.x_max; ++x) {
+        const VoxelIndex voxel_index(x, run.y, run.z);
+        const auto linear_index =
+            spatial_hash::linearIndexFromVoxelIndex(voxel_index, vps);
+        auto& voxel = block->getVoxel(linear_index);
+        voxel.distance = distance;
+        voxel.weight = weight;
+      }
     }
-  }
+  });
 }
 
 }  // namespace hydra
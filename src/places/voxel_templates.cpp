@@ -55,63 +55,141 @@ inline std::vector<GlobalIndex> get26ConnectedOffsets() {
   return search.neighborIndices(GlobalIndex::Zero().eval(), true);
 }
 
-inline spatial_hash::IndexHashMap<size_t> get26ConnectedLookup() {
-  const spatial_hash::NeighborSearch search(26);
-  const auto indices = search.neighborIndices(GlobalIndex::Zero().eval(), true);
+// index of an offset in [-1, 1]^3 in x -> y -> z ordering (plus shift from [-1, 1] to
+// [0, 2] to reflect lower corner origin)
+inline size_t rowMajorIndex(const GlobalIndex& offset) {
+  return 1 * static_cast<size_t>(offset.x() + 1) +
+         3 * static_cast<size_t>(offset.y() + 1) +
+         9 * static_cast<size_t>(offset.z() + 1);
+}
 
-  spatial_hash::IndexHashMap<size_t> lookup;
-  for (size_t i = 0; i < indices.size(); ++i) {
-    lookup[indices[i]] = i;
-  }
+}  // namespace
+
+const std::vector<GlobalIndex> CubeFlagExtractor::sh_offsets = get26ConnectedOffsets();
+
+namespace {
 
+// position in the offset iteration order for every row-major index
+const std::array<size_t, 27>& shFromRowMajor() {
+  static const auto lookup = []() {
+    std::array<size_t, 27> lookup;
+    for (size_t i = 0; i < CubeFlagExtractor::sh_offsets.size(); ++i) {
+      lookup[rowMajorIndex(CubeFlagExtractor::sh_offsets[i])] = i;
+    }
+    return lookup;
+  }();
   return lookup;
 }
 
-}  // namespace
+// row-major flags are stored with the first voxel as the most significant bit
+const CubeBitPermutation& fromRowMajorPermutation() {
+  static const auto permutation = []() {
+    std::array<size_t, 27> destinations;
+    for (size_t i = 0; i < 27; ++i) {
+      destinations[26 - i] = shFromRowMajor()[i];
+    }
+    return CubeBitPermutation(destinations);
+  }();
+  return permutation;
+}
 
-const std::vector<GlobalIndex> CubeFlagExtractor::sh_offsets = get26ConnectedOffsets();
-const spatial_hash::IndexHashMap<size_t> CubeFlagExtractor::sh_offset_lookup =
-    get26ConnectedLookup();
+const CubeBitPermutation& toRowMajorPermutation() {
+  static const auto permutation = []() {
+    std::array<size_t, 27> destinations;
+    for (size_t i = 0; i < 27; ++i) {
+      destinations[shFromRowMajor()[i]] = 26 - i;
+    }
+    return CubeBitPermutation(destinations);
+  }();
+  return permutation;
+}
 
-std::bitset<27> CubeFlagExtractor::fromRowMajor(const std::bitset<27>& flags_rm) {
-  std::bitset<27> flags_sh{0};
-  for (size_t i = 1; i < sh_offsets.size(); ++i) {
-    // x -> y -> z ordering (plus shift from [-1, 1] to [0, 2] to reflect lower corner
-    // origin)
-    size_t row_major_index = 1 * static_cast<size_t>(sh_offsets[i].x() + 1) +
-                             3 * static_cast<size_t>(sh_offsets[i].y() + 1) +
-                             9 * static_cast<size_t>(sh_offsets[i].z() + 1);
-
-    flags_sh.set(i, flags_rm[26 - row_major_index]);
+inline int64_t floorDiv(int64_t value, int64_t divisor) {
+  const auto result = value / divisor;
+  return (value % divisor != 0 && value < 0) ? result - 1 : result;
+}
+
+}  // namespace
+
+CubeBitPermutation::CubeBitPermutation(const std::array<size_t, 27>& destinations) {
+  for (size_t chunk = 0; chunk < table.size(); ++chunk) {
+    for (uint32_t value = 0; value < 512; ++value) {
+      uint32_t permuted = 0;
+      for (size_t bit = 0; bit < 9; ++bit) {
+        if (value & (1u << bit)) {
+          permuted |= 1u << destinations[9 * chunk + bit];
+        }
+      }
+
+      table[chunk][value] = permuted;
+    }
   }
+}
 
-  flags_sh.set(0, flags_rm[13]);
-  return flags_sh;
+size_t CubeFlagExtractor::offsetIndex(const GlobalIndex& offset) {
+  return shFromRowMajor().at(rowMajorIndex(offset));
 }
 
-std::bitset<27> CubeFlagExtractor::toRowMajor(const std::bitset<27>& flags_sh) {
-  std::bitset<27> flags_rm{0};
-  for (size_t i = 1; i < sh_offsets.size(); ++i) {
-    // x -> y -> z ordering (plus shift from [-1, 1] to [0, 2] to reflect lower corner
-    // origin)
-    size_t row_major_index = 1 * static_cast<size_t>(sh_offsets[i].x() + 1) +
-                             3 * static_cast<size_t>(sh_offsets[i].y() + 1) +
-                             9 * static_cast<size_t>(sh_offsets[i].z() + 1);
-
-    flags_rm.set(26 - row_major_index, flags_sh[i]);
-  }
+std::bitset<27> CubeFlagExtractor::fromRowMajor(const std::bitset<27>& flags_rm) {
+  return fromRowMajorPermutation()(flags_rm.to_ulong());
+}
 
-  flags_rm.set(13, flags_sh[0]);
-  return flags_rm;
+std::bitset<27> CubeFlagExtractor::toRowMajor(const std::bitset<27>& flags_sh) {
+  return toRowMajorPermutation()(flags_sh.to_ulong());
 }
 
 std::bitset<27> CubeFlagExtractor::extract(const GvdLayer& layer,
                                            const GlobalIndex& index,
                                            uint8_t min_extra_basis) {
+  const auto& sh_from_rm = shFromRowMajor();
+  const int64_t vps = layer.voxels_per_side;
+  const VoxelIndex unit_x(1, 0, 0), unit_y(0, 1, 0), unit_z(0, 0, 1);
+  const std::array<size_t, 3> strides{
+      spatial_hash::linearIndexFromVoxelIndex(unit_x, vps),
+      spatial_hash::linearIndexFromVoxelIndex(unit_y, vps),
+      spatial_hash::linearIndexFromVoxelIndex(unit_z, vps)};
+
+  // along each axis, the neighbors fall into the block of the lowest neighbor and
+  // possibly the next block (or the next two for single-voxel blocks)
+  BlockIndex lower_block;
+  std::array<std::array<int, 3>, 3> block_offsets;
+  std::array<std::array<size_t, 3>, 3> voxel_offsets;
+  for (size_t axis = 0; axis < 3; ++axis) {
+    lower_block(axis) = floorDiv(index(axis) - 1, vps);
+    for (size_t i = 0; i < 3; ++i) {
+      const int64_t coord = index(axis) + static_cast<int64_t>(i) - 1;
+      const int64_t block = floorDiv(coord, vps);
+      block_offsets[axis][i] = block - lower_block(axis);
+      voxel_offsets[axis][i] = strides[axis] * (coord - block * vps);
+    }
+  }
+
+  std::array<const GvdBlock*, 27> blocks;
+  std::array<bool, 27> blocks_valid{};
   std::bitset<27> neighbor_values;
-  for (size_t n = 0; n < sh_offsets.size(); ++n) {
-    const auto* voxel = layer.getVoxelPtr((sh_offsets[n] + index).eval());
-    neighbor_values.set(n, isValidPoint(voxel, min_extra_basis));
+  for (size_t z = 0; z < 3; ++z) {
+    for (size_t y = 0; y < 3; ++y) {
+      for (size_t x = 0; x < 3; ++x) {
+        const auto block_idx =
+            block_offsets[0][x] + 3 * block_offsets[1][y] + 9 * block_offsets[2][z];
+        if (!blocks_valid[block_idx]) {
+          const BlockIndex offset(
+              block_offsets[0][x], block_offsets[1][y], block_offsets[2][z]);
+          blocks[block_idx] = layer.getBlockPtr((lower_block + offset).eval());
+          blocks_valid[block_idx] = true;
+        }
+
+        const auto block = blocks[block_idx];
+        if (!block) {
+          continue;
+        }
+
+        const auto& voxel = block->getVoxel(voxel_offsets[0][x] + voxel_offsets[1][y] +
+                                            voxel_offsets[2][z]);
+        neighbor_values.set(sh_from_rm[x + 3 * y + 9 * z],
+                            isValidPoint(&voxel, min_extra_basis));
+      }
+    }
   }
 
   return neighbor_values;
@@ -123,8 +201,7 @@ std::bitset<27> CubeFlagExtractor::rotate(const IndexRotation& rotation,
   rotated.set(0, flags_sh[0]);  // center voxel will always remain the same
   for (size_t i = 0; i < sh_offsets.size(); ++i) {
     const GlobalIndex rotated_index = rotation * sh_offsets[i];
-    size_t rotated_idx = sh_offset_lookup.at(rotated_index);
-    rotated[rotated_idx] = flags_sh[i];
+    rotated[offsetIndex(rotated_index)] = flags_sh[i];
   }
 
   return rotated;
@@ -218,9 +295,42 @@ CornerFinder::CornerFinder() {
                           0b000'000'000'110'100'000'110'100'000,
                           0b000'000'000'011'001'000'011'001'000,
                           0b000'000'000'000'001'011'000'001'011}};
+
+  // a state matches a template rotation if every bit that isn't ignored agrees with
+  // the foreground mask, so the match can be split into independent checks per chunk
+  const std::array<const GvdCornerTemplate*, 6> templates{&negative_x_template,
+                                                          &positive_x_template,
+                                                          &negative_y_template,
+                                                          &positive_y_template,
+                                                          &negative_z_template,
+                                                          &positive_z_template};
+  for (size_t chunk = 0; chunk < match_table_.size(); ++chunk) {
+    for (uint32_t value = 0; value < 512; ++value) {
+      const uint32_t state = value << (9 * chunk);
+      const uint32_t chunk_mask = 0x1FFu << (9 * chunk);
+      uint32_t matches = 0;
+      for (size_t t = 0; t < templates.size(); ++t) {
+        const uint32_t fg_mask = templates[t]->fg_mask.to_ulong();
+        for (size_t r = 0; r < 4; ++r) {
+          const uint32_t care = ~templates[t]->unused_mask_array[r].to_ulong();
+          if (((state ^ fg_mask) & care & chunk_mask) == 0) {
+            matches |= 1u << (4 * t + r);
+          }
+        }
+      }
+
+      match_table_[chunk][value] = matches;
+    }
+  }
 }
 
 bool CornerFinder::match(std::bitset<27> values) const {
+  const uint32_t state = values.to_ulong();
+  return (match_table_[0][state & 0x1FF] & match_table_[1][(state >> 9) & 0x1FF] &
+          match_table_[2][(state >> 18) & 0x1FF]) != 0;
+}
+
+bool CornerFinder::matchTemplates(std::bitset<27> values) const {
   return negative_x_template.matches(values) || positive_x_template.matches(values) ||
          negative_y_template.matches(values) || positive_y_template.matches(values) ||
          negative_z_template.matches(values) || positive_z_template.matches(values);
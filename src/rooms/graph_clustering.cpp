@@ -34,6 +34,8 @@
  * -------------------------------------------------------------------------- */
 #include "hydra/rooms/graph_clustering.h"
 
+#include <algorithm>
+#include <limits>
 #include <queue>
 
 namespace hydra {
@@ -79,87 +81,143 @@ ClusterResults clusterGraphByModularity(const SceneGraphLayer& layer,
                                         const EdgeWeightFunc& edge_weight_func,
                                         size_t max_iters,
                                         double gamma) {
-  std::map<NodeId, double> degrees;
-  std::map<NodeId, std::map<NodeId, double>> neighbors;
-  for (const auto& id_node_pair : layer.nodes()) {
-    double degree = 0.0;
-    neighbors[id_node_pair.first] = std::map<NodeId, double>();
-    for (const auto& sibling : id_node_pair.second->siblings()) {
-      double edge_weight = edge_weight_func(layer, id_node_pair.first, sibling);
+  const CsrGraph graph(layer, edge_weight_func);
+  return clusterGraphByModularity(graph, initial_clusters, max_iters, gamma);
+}
+
+ClusterResults clusterGraphByNeighbors(const SceneGraphLayer& layer,
+                                       const InitialClusters& initial_clusters) {
+  const CsrGraph graph(layer);
+  return clusterGraphByNeighbors(graph, initial_clusters);
+}
+
+namespace {
+
+inline constexpr size_t kUnlabeled = std::numeric_limits<size_t>::max();
+
+std::vector<size_t> getInitialLabels(const CsrGraph& graph,
+                                     const InitialClusters& initial_clusters) {
+  std::vector<size_t> labels(graph.numNodes(), kUnlabeled);
+  for (size_t i = 0; i < initial_clusters.size(); ++i) {
+    for (const auto& node_id : initial_clusters[i]) {
+      labels[graph.indices.at(node_id)] = i;
+    }
+  }
+
+  return labels;
+}
+
+ClusterResults makeResults(const CsrGraph& graph,
+                           const std::vector<size_t>& labels,
+                           size_t total_iters) {
+  ClusterResults results;
+  results.valid = true;
+  results.total_iters = total_iters;
+  // dense indices are sorted by node id, so labels can be appended in order
+  for (size_t i = 0; i < labels.size(); ++i) {
+    if (labels[i] == kUnlabeled) {
+      continue;
+    }
+
+    const auto node_id = graph.ids[i];
+    results.labels.emplace_hint(results.labels.end(), node_id, labels[i]);
+    results.clusters[labels[i]].insert(node_id);
+  }
+
+  return results;
+}
+
+}  // namespace
+
+ClusterResults clusterGraphByModularity(const CsrGraph& graph,
+                                        const InitialClusters& initial_clusters,
+                                        size_t max_iters,
+                                        double gamma) {
+  const size_t num_nodes = graph.numNodes();
+  const size_t num_clusters = initial_clusters.size();
+
+  std::vector<double> degrees(num_nodes, 0.0);
+  std::vector<double> weights(graph.weights.size(), 0.0);
+  for (size_t i = 0; i < num_nodes; ++i) {
+    for (size_t e = graph.offsets[i]; e < graph.offsets[i + 1]; ++e) {
       // we should probably assert that this isn't happening, but it should be pretty
       // feasbile to not return negative weights
-      edge_weight = edge_weight < 0.0 ? 0.0 : edge_weight;
-      degree += edge_weight;
-      neighbors[id_node_pair.first][sibling] = edge_weight;
+      weights[e] = graph.weights[e] < 0.0 ? 0.0 : graph.weights[e];
+      degrees[i] += weights[e];
     }
-    degrees[id_node_pair.first] = degree;
   }
 
-  const double m = layer.numEdges();
+  const double m = graph.numEdges();
 
-  std::map<size_t, double> community_degrees;
-  std::map<NodeId, size_t> labels;
-  for (size_t i = 0; i < initial_clusters.size(); ++i) {
-    const auto& component = initial_clusters[i];
-    double total_degree = 0.0;
-    for (const auto& node_id : component) {
-      labels[node_id] = i;
-      total_degree += degrees.at(node_id);
+  auto labels = getInitialLabels(graph, initial_clusters);
+  std::vector<double> community_degrees(num_clusters, 0.0);
+  for (size_t i = 0; i < num_clusters; ++i) {
+    for (const auto& node_id : initial_clusters[i]) {
+      community_degrees[i] += degrees[graph.indices.at(node_id)];
     }
-    community_degrees[i] = total_degree;
   }
 
-  std::set<NodeId> unlabeled_nodes;
-  for (const auto& id_node_pair : layer.nodes()) {
-    if (labels.count(id_node_pair.first)) {
-      continue;
+  std::vector<size_t> unlabeled_nodes;
+  for (size_t i = 0; i < num_nodes; ++i) {
+    if (labels[i] == kUnlabeled) {
+      unlabeled_nodes.push_back(i);
     }
-
-    unlabeled_nodes.insert(id_node_pair.first);
   }
 
+  // scratch space for accumulating community weights without allocation
+  std::vector<double> community_weights(num_clusters, 0.0);
+  std::vector<bool> community_seen(num_clusters, false);
+  std::vector<size_t> seen;
+  seen.reserve(num_clusters);
+
   size_t iter;
   for (iter = 0; iter < max_iters; ++iter) {
     size_t num_changes = 0;
-    for (const auto& node : unlabeled_nodes) {
-      std::map<size_t, double> community_weights;
-      for (const auto id_weight_pair : neighbors.at(node)) {
-        if (!labels.count(id_weight_pair.first)) {
+    for (const auto node : unlabeled_nodes) {
+      seen.clear();
+      for (size_t e = graph.offsets[node]; e < graph.offsets[node + 1]; ++e) {
+        const size_t community = labels[graph.neighbors[e]];
+        if (community == kUnlabeled) {
           continue;
         }
 
-        const size_t community = labels.at(id_weight_pair.first);
-        if (!community_weights.count(community)) {
-          community_weights[community] = 0.0;
+        if (!community_seen[community]) {
+          community_seen[community] = true;
+          seen.push_back(community);
         }
 
-        community_weights[community] += id_weight_pair.second;
+        community_weights[community] += weights[e];
       }
 
-      const double node_degree = degrees.at(node);
-      if (labels.count(node)) {
-        community_degrees[labels.at(node)] -= node_degree;
+      const double node_degree = degrees[node];
+      if (labels[node] != kUnlabeled) {
+        community_degrees[labels[node]] -= node_degree;
       }
 
+      // visit communities in order to keep tie-breaking stable
+      std::sort(seen.begin(), seen.end());
+
       double best_gain = 0.0;
-      size_t best_community = initial_clusters.size();
-      for (const auto& id_weight_pair : community_weights) {
-        const double gain =
-            2 * id_weight_pair.second -
-            gamma * (community_degrees.at(id_weight_pair.first) * node_degree) / m;
+      size_t best_community = num_clusters;
+      for (const auto community : seen) {
+        const double gain = 2 * community_weights[community] -
+                            gamma * (community_degrees[community] * node_degree) / m;
         if (gain > best_gain) {
           best_gain = gain;
-          best_community = id_weight_pair.first;
+          best_community = community;
         }
+
+        community_weights[community] = 0.0;
+        community_seen[community] = false;
       }
 
-      if (best_community == initial_clusters.size()) {
+      if (best_community == num_clusters) {
         continue;  // we couldn't pick a community
       }
 
       community_degrees[best_community] += node_degree;
 
-      if (labels.count(node) && labels.at(node) == best_community) {
+      if (labels[node] == best_community) {
         continue;
       }
 
@@ -172,50 +230,35 @@ ClusterResults clusterGraphByModularity(const SceneGraphLayer& layer,
     }
   }
 
-  std::map<size_t, std::unordered_set<NodeId>> clusters;
-  for (const auto& node_cluster_pair : labels) {
-    if (!clusters.count(node_cluster_pair.second)) {
-      clusters[node_cluster_pair.second] = std::unordered_set<NodeId>();
-    }
-
-    clusters[node_cluster_pair.second].insert(node_cluster_pair.first);
-  }
-
-  return {clusters, labels, iter, true};
+  return makeResults(graph, labels, iter);
 }
 
 struct EdgeInfo {
-  NodeId id;
+  size_t index;
   size_t label;
   double distance;
 
   bool operator<(const EdgeInfo& other) const { return distance < other.distance; }
 };
 
-ClusterResults clusterGraphByNeighbors(const SceneGraphLayer& layer,
+ClusterResults clusterGraphByNeighbors(const CsrGraph& graph,
                                        const InitialClusters& initial_clusters) {
-  std::map<NodeId, size_t> labels;
-  for (size_t i = 0; i < initial_clusters.size(); ++i) {
-    const auto& component = initial_clusters[i];
-    for (const auto& node_id : component) {
-      labels[node_id] = i;
-    }
-  }
+  auto labels = getInitialLabels(graph, initial_clusters);
 
   // populate frontier from all room boundaries
   std::priority_queue<EdgeInfo> frontier;
-  for (auto&& [id, node] : layer.nodes()) {
-    if (labels.count(id)) {
+  for (size_t i = 0; i < graph.numNodes(); ++i) {
+    if (labels[i] != kUnlabeled) {
       continue;
     }
 
-    for (const auto sibling : node->siblings()) {
-      auto iter = labels.find(sibling);
-      if (iter == labels.end()) {
+    for (size_t e = graph.offsets[i]; e < graph.offsets[i + 1]; ++e) {
+      const auto label = labels[graph.neighbors[e]];
+      if (label == kUnlabeled) {
         continue;
       }
 
-      frontier.push({id, iter->second, layer.getEdge(id, sibling).info->weight});
+      frontier.push({i, label, graph.weights[e]});
     }
   }
 
@@ -223,33 +266,24 @@ ClusterResults clusterGraphByNeighbors(const SceneGraphLayer& layer,
     const auto candidate = frontier.top();
     frontier.pop();
 
-    if (labels.count(candidate.id)) {
+    if (labels[candidate.index] != kUnlabeled) {
       continue;
     }
 
-    labels[candidate.id] = candidate.label;
-    const auto& node = layer.getNode(candidate.id);
-    for (const auto sibling : node.siblings()) {
-      if (labels.count(sibling)) {
+    labels[candidate.index] = candidate.label;
+    for (size_t e = graph.offsets[candidate.index];
+         e < graph.offsets[candidate.index + 1];
+         ++e) {
+      const auto neighbor = graph.neighbors[e];
+      if (labels[neighbor] != kUnlabeled) {
         continue;
       }
 
-      frontier.push({sibling,
-                     candidate.label,
-                     layer.getEdge(candidate.id, sibling).info->weight});
+      frontier.push({neighbor, candidate.label, graph.weights[e]});
     }
   }
 
-  std::map<size_t, std::unordered_set<NodeId>> clusters;
-  for (const auto& node_cluster_pair : labels) {
-    if (!clusters.count(node_cluster_pair.second)) {
-      clusters[node_cluster_pair.second] = std::unordered_set<NodeId>();
-    }
-
-    clusters[node_cluster_pair.second].insert(node_cluster_pair.first);
-  }
-
-  return {clusters, labels, 0, true};
+  return makeResults(graph, labels, 0);
 }
 
 }  // namespace hydra
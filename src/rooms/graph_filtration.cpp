@@ -36,6 +36,7 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <iomanip>
 
 namespace hydra {
@@ -228,30 +229,19 @@ void updateComponentsFromNode(NodeId node,
 }
 
 Filtration getGraphFiltration(const SceneGraphLayer& layer, double diff_threshold_m) {
-  BarcodeTracker tracker;
-  return getGraphFiltration(
-      layer, tracker, diff_threshold_m, [](const DisjointSet& components) -> size_t {
-        return components.sizes.size();
-      });
+  return getGraphFiltration(layer, 0, diff_threshold_m);
 }
 
 Filtration getGraphFiltration(const SceneGraphLayer& layer,
                               size_t min_component_size,
                               double diff_threshold_m) {
   BarcodeTracker tracker;
-  return getGraphFiltration(
-      layer,
-      tracker,
-      diff_threshold_m,
-      [&min_component_size](const DisjointSet& components) -> size_t {
-        size_t num_components = 0;
-        for (const auto id_size_pair : components.sizes) {
-          if (id_size_pair.second >= min_component_size) {
-            ++num_components;
-          }
-        }
-        return num_components;
-      });
+  const CsrGraph graph(layer);
+  return getGraphFiltration(graph,
+                            getNodeDistances(graph, layer),
+                            tracker,
+                            diff_threshold_m,
+                            min_component_size);
 }
 
 Filtration getGraphFiltration(const SceneGraphLayer& layer,
@@ -320,6 +310,182 @@ Filtration getGraphFiltration(const SceneGraphLayer& layer,
   return Filtration(filtration.begin(), filtration.end());
 }
 
+std::vector<double> getNodeDistances(const CsrGraph& graph,
+                                     const SceneGraphLayer& layer) {
+  std::vector<double> distances;
+  distances.reserve(graph.numNodes());
+  for (const auto node_id : graph.ids) {
+    const auto& attrs = layer.getNode(node_id).attributes<PlaceNodeAttributes>();
+    distances.push_back(attrs.distance);
+  }
+
+  return distances;
+}
+
+namespace {
+
+struct DenseEntry {
+  double distance;
+  size_t source;
+  size_t target;
+
+  inline bool isNode() const { return target == DenseDisjointSet::kInvalid; }
+};
+
+struct DenseComponentTracker {
+  DenseComponentTracker(const CsrGraph& graph,
+                        const std::vector<double>& distances,
+                        BarcodeTracker& tracker,
+                        size_t min_component_size)
+      : graph(graph),
+        distances(distances),
+        tracker(tracker),
+        min_component_size(min_component_size),
+        components(graph.numNodes()),
+        pending(graph.numNodes()) {}
+
+  inline bool counts(size_t size) const { return size >= min_component_size; }
+
+  void addNode(size_t node) {
+    const auto curr_distance = distances[node];
+    if (components.addSet(node)) {
+      num_components += counts(1) ? 1 : 0;
+      tracker.addNode(graph.ids[node], curr_distance);
+    }
+
+    // "delayed" edges get assigned the distance of the node that was added last
+    for (const auto other : pending[node]) {
+      if (components.hasSet(other)) {
+        doUnion(node, other, curr_distance);
+      }
+    }
+
+    pending[node].clear();
+    pending[node].shrink_to_fit();
+  }
+
+  bool addEdge(size_t source, size_t target, double distance) {
+    const bool has_source = components.hasSet(source);
+    const bool has_target = components.hasSet(target);
+    if (!has_source) {
+      pending[source].push_back(target);
+    }
+
+    if (!has_target) {
+      pending[target].push_back(source);
+    }
+
+    if (!has_source || !has_target) {
+      return false;
+    }
+
+    doUnion(source, target, distance);
+    return true;
+  }
+
+  void doUnion(size_t lhs, size_t rhs, double distance) {
+    const size_t lhs_set = components.findSet(lhs);
+    const size_t rhs_set = components.findSet(rhs);
+    if (lhs_set == rhs_set) {
+      return;
+    }
+
+    const auto lhs_size = components.size(lhs_set);
+    const auto rhs_size = components.size(rhs_set);
+    const bool rhs_better = distances[rhs_set] >= distances[lhs_set];
+    const size_t erased = *components.doUnion(lhs_set, rhs_set, rhs_better);
+    const size_t kept = erased == lhs_set ? rhs_set : lhs_set;
+    const auto new_size = components.size(kept);
+
+    num_components -= (counts(lhs_size) ? 1 : 0) + (counts(rhs_size) ? 1 : 0);
+    num_components += counts(new_size) ? 1 : 0;
+
+    // mirrors BarcodeTracker::doUnion
+    auto& barcodes = tracker.barcodes;
+    if (new_size >= tracker.min_component_size) {
+      barcodes.emplace(graph.ids[kept], ComponentLifetime{0.0, distance});
+    }
+
+    auto riter = barcodes.find(graph.ids[erased]);
+    if (riter != barcodes.end()) {
+      riter->second.start = distance;
+    }
+  }
+
+  const CsrGraph& graph;
+  const std::vector<double>& distances;
+  BarcodeTracker& tracker;
+  const size_t min_component_size;
+  DenseDisjointSet components;
+  std::vector<std::vector<size_t>> pending;
+  size_t num_components = 0;
+};
+
+}  // namespace
+
+Filtration getGraphFiltration(const CsrGraph& graph,
+                              const std::vector<double>& node_distances,
+                              BarcodeTracker& tracker,
+                              double diff_threshold_m,
+                              size_t min_component_size,
+                              bool include_nodes) {
+  CHECK_EQ(node_distances.size(), graph.numNodes());
+
+  std::vector<DenseEntry> entries;
+  entries.reserve(graph.numEdges() + (include_nodes ? graph.numNodes() : 0));
+  for (size_t i = 0; i < graph.numNodes(); ++i) {
+    for (size_t e = graph.offsets[i]; e < graph.offsets[i + 1]; ++e) {
+      if (graph.neighbors[e] > i) {
+        entries.push_back({graph.weights[e], i, graph.neighbors[e]});
+      }
+    }
+
+    if (include_nodes) {
+      entries.push_back({node_distances[i], i, DenseDisjointSet::kInvalid});
+    }
+  }
+
+  // entries are processed from largest to smallest distance
+  std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.distance > rhs.distance;
+  });
+
+  DenseComponentTracker components(graph, node_distances, tracker, min_component_size);
+  if (!include_nodes) {
+    // seed components with all nodes if we're not including nodes in the filtration
+    for (size_t i = 0; i < graph.numNodes(); ++i) {
+      components.addNode(i);
+    }
+  }
+
+  Filtration filtration;
+  for (const auto& x : entries) {
+    bool change_in_components = true;
+    if (x.isNode()) {
+      components.addNode(x.source);
+    } else {
+      change_in_components = components.addEdge(x.source, x.target, x.distance);
+    }
+
+    if (!change_in_components) {
+      continue;
+    }
+
+    const auto num_components = components.num_components;
+    // this may help smooth the resulting filtration a little
+    if (!filtration.empty() &&
+        std::abs(filtration.back().distance - x.distance) < diff_threshold_m) {
+      filtration.back().num_components = num_components;
+    } else {
+      filtration.push_back({x.distance, num_components});
+    }
+  }
+
+  // filtration is expected in order of increasing distance
+  std::reverse(filtration.begin(), filtration.end());
+  return filtration;
+}
+
 std::pair<size_t, size_t> getTrimmedFiltration(const Filtration& filtration,
                                                double min_dilation_m,
                                                double max_dilation_m,
@@ -153,22 +153,17 @@ void RoomFinder::enableLogging(const std::string& log_path) {
   graph_log_file_.reset(new std::ofstream(gname, std::ios::binary));
 }
 
-InitialClusters RoomFinder::getBestComponents(const SceneGraphLayer& places) const {
+InitialClusters RoomFinder::getBestComponents(const SceneGraphLayer& places,
+                                              const CsrGraph& graph) const {
+  const auto distances = getNodeDistances(graph, places);
+
   BarcodeTracker tracker(config_.min_component_size);
-  const auto filtration = getGraphFiltration(
-      places,
-      tracker,
-      config_.dilation_diff_threshold_m,
-      [this](const DisjointSet& components) -> size_t {
-        size_t num_components = 0;
-        for (const auto id_size_pair : components.sizes) {
-          if (id_size_pair.second >= config_.min_component_size) {
-            ++num_components;
-          }
-        }
-        return num_components;
-      },
-      false);
+  const auto filtration = getGraphFiltration(graph,
+                                             distances,
+                                             tracker,
+                                             config_.dilation_diff_threshold_m,
+                                             config_.min_component_size,
+                                             false);
 
   VLOG(10) << "[RoomFinder] Filtration: " << filtration;
 
@@ -246,12 +241,9 @@ InitialClusters RoomFinder::getBestComponents(const SceneGraphLayer& places) con
     logged_once_ = true;
   }
 
-  const auto components = graph_utilities::getConnectedComponents(
-      places,
-      [&](const SceneGraphNode& node) {
-        return node.attributes<PlaceNodeAttributes>().distance > info.distance;
-      },
-      [&](const SceneGraphEdge& edge) { return edge.info->weight > info.distance; });
+  const auto components = graph.getComponents(
+      [&](size_t index) { return distances[index] > info.distance; },
+      [&](size_t, size_t, double weight) { return weight > info.distance; });
 
   InitialClusters filtered;
   for (const auto& component : components) {
@@ -259,7 +251,11 @@ InitialClusters RoomFinder::getBestComponents(const SceneGraphLayer& places) con
       continue;
     }
 
-    filtered.push_back(component);
+    auto& cluster = filtered.emplace_back();
+    cluster.reserve(component.size());
+    for (const auto index : component) {
+      cluster.push_back(graph.ids[index]);
+    }
   }
 
   return filtered;
@@ -268,7 +264,8 @@ InitialClusters RoomFinder::getBestComponents(const SceneGraphLayer& places) con
 SceneGraphLayer::Ptr RoomFinder::findRooms(const SceneGraphLayer& places) {
   VLOG(2) << "[Room Finder] Detecting rooms for " << places.numNodes() << " nodes";
 
-  const auto components = getBestComponents(places);
+  const CsrGraph graph(places);
+  const auto components = getBestComponents(places, graph);
   if (components.empty()) {
     VLOG(2) << "[Room Finder] No rooms found";
     return nullptr;
@@ -278,7 +275,7 @@ SceneGraphLayer::Ptr RoomFinder::findRooms(const SceneGraphLayer& places) {
   switch (config_.clustering_mode) {
     case RoomClusterMode::MODULARITY:
       last_results_ = clusterGraphByModularity(
-          places, components, config_.max_modularity_iters, config_.modularity_gamma);
+          graph, components, config_.max_modularity_iters, config_.modularity_gamma);
       break;
     case RoomClusterMode::MODULARITY_DISTANCE:
       last_results_ = clusterGraphByModularity(
@@ -292,7 +289,7 @@ SceneGraphLayer::Ptr RoomFinder::findRooms(const SceneGraphLayer& places) {
           config_.modularity_gamma);
       break;
     case RoomClusterMode::NEIGHBORS:
-      last_results_ = clusterGraphByNeighbors(places, components);
+      last_results_ = clusterGraphByNeighbors(graph, components);
       break;
     case RoomClusterMode::NONE:
     default:
@@ -36,49 +36,254 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+
 namespace hydra {
 
-void ActiveWindowTracker::clear() {
-  for (const auto node : to_clear_) {
-    prev_active_.erase(node);
+ActiveWindowView::ActiveWindowView(const SceneGraphLayer& layer) {
+  nodes_.reserve(layer.numNodes());
+  for (const auto& id_node_pair : layer.nodes()) {
+    nodes_.push_back(id_node_pair.second.get());
   }
-  to_clear_.clear();
 }
 
-void ActiveWindowTracker::reset() {
-  to_clear_.clear();
-  prev_active_.clear();
-}
-
-spark_dsg::LayerView ActiveWindowTracker::view(const SceneGraphLayer& layer) const {
-  // prune all removed nodes
-  auto iter = prev_active_.begin();
-  while (iter != prev_active_.end()) {
-    if (!layer.hasNode(*iter)) {
-      to_clear_.erase(*iter);
-      iter = prev_active_.erase(iter);
-    } else {
-      ++iter;
+void ActiveWindowIndex::activate(NodeId node) {
+  const auto [iter, inserted] = members_.emplace(node, true);
+  if (!inserted) {
+    if (!iter->second) {
+      iter->second = true;  // archived node was reactivated before the window cleared
+      --num_archived_;
     }
+
+    return;
+  }
+
+  // ids of new nodes mostly increase, so members are usually appended
+  if (window_.empty() || window_.back() < node) {
+    window_.push_back(node);
+    return;
   }
 
-  return {layer, [this](const auto& node) -> bool { return isActive(node); }};
+  auto pos = std::lower_bound(window_.begin(), window_.end(), node);
+  if (pos != window_.end() && *pos == node) {
+    --num_stale_;  // removed member that has not been dropped yet
+  } else {
+    window_.insert(pos, node);
+  }
+}
+
+void ActiveWindowIndex::archive(NodeId node) {
+  auto iter = members_.find(node);
+  if (iter != members_.end() && iter->second) {
+    iter->second = false;
+    ++num_archived_;
+  }
 }
 
-bool ActiveWindowTracker::isActive(const SceneGraphNode& node) const {
-  const auto active = node.attributes().is_active;
-  if (prev_active_.count(node.id)) {
+void ActiveWindowIndex::remove(NodeId node) {
+  auto iter = members_.find(node);
+  if (iter == members_.end()) {
+    return;
+  }
+
+  if (!iter->second) {
+    --num_archived_;
+  }
+
+  members_.erase(iter);
+  if (++num_stale_ > window_.size() / 2) {
+    compact();
+  }
+}
+
+void ActiveWindowIndex::update(const SceneGraphLayer& layer,
+                               const std::vector<NodeId>& new_nodes,
+                               const std::vector<NodeId>& removed_nodes) {
+  for (const auto node_id : removed_nodes) {
+    remove(node_id);
+  }
+
+  for (const auto node_id : new_nodes) {
+    const auto node = layer.findNode(node_id);
+    if (node && node->attributes().is_active) {
+      activate(node_id);
+    }
+  }
+
+  for (auto& [node_id, active] : members_) {
     if (!active) {
-      to_clear_.insert(node.id);
+      continue;
+    }
+
+    const auto node = layer.findNode(node_id);
+    if (node && !node->attributes().is_active) {
+      active = false;
+      ++num_archived_;
     }
-    return true;
   }
 
-  if (active) {
-    prev_active_.insert(node.id);
+  if (!hasConsumers()) {
+    dropArchived();  // nobody can see archived nodes
+  }
+}
+
+ActiveWindowView ActiveWindowIndex::view(const SceneGraphLayer& layer) const {
+  ActiveWindowView::Nodes nodes;
+  nodes.reserve(members_.size());
+  for (const auto node_id : window_) {
+    if (!members_.count(node_id)) {
+      continue;
+    }
+
+    const auto node = layer.findNode(node_id);
+    if (node) {
+      nodes.push_back(node);
+    }
   }
 
-  return active;
+  return ActiveWindowView(std::move(nodes));
+}
+
+bool ActiveWindowIndex::contains(NodeId node) const { return members_.count(node); }
+
+void ActiveWindowIndex::reset() {
+  members_.clear();
+  window_.clear();
+  num_archived_ = 0;
+  num_stale_ = 0;
+  pending_clear_ = consumers_;
+}
+
+void ActiveWindowIndex::dropArchived() {
+  if (!num_archived_) {
+    return;
+  }
+
+  for (auto iter = members_.begin(); iter != members_.end();) {
+    iter = iter->second ? std::next(iter) : members_.erase(iter);
+  }
+
+  num_archived_ = 0;
+  compact();
+}
+
+void ActiveWindowIndex::compact() {
+  auto end = std::remove_if(window_.begin(), window_.end(), [this](NodeId node) {
+    return !members_.count(node);
+  });
+  window_.erase(end, window_.end());
+  num_stale_ = 0;
+}
+
+bool ActiveWindowIndex::hasConsumers() const {
+  return std::find(consumers_.begin(), consumers_.end(), true) != consumers_.end();
+}
+
+size_t ActiveWindowIndex::addConsumer() {
+  auto iter = std::find(consumers_.begin(), consumers_.end(), false);
+  const size_t consumer = iter - consumers_.begin();
+  if (iter == consumers_.end()) {
+    consumers_.push_back(true);
+    pending_clear_.push_back(true);
+  } else {
+    consumers_[consumer] = true;
+    pending_clear_[consumer] = true;
+  }
+
+  return consumer;
+}
+
+void ActiveWindowIndex::removeConsumer(size_t consumer) {
+  consumers_.at(consumer) = false;
+  pending_clear_.at(consumer) = false;
+}
+
+void ActiveWindowIndex::clear(size_t consumer) {
+  pending_clear_.at(consumer) = false;
+  if (std::find(pending_clear_.begin(), pending_clear_.end(), true) !=
+      pending_clear_.end()) {
+    return;  // other trackers still have to see the archived nodes
+  }
+
+  dropArchived();
+  pending_clear_ = consumers_;
+}
+
+void ActiveWindows::update(const DynamicSceneGraph& graph,
+                           const std::vector<NodeId>& new_nodes,
+                           const std::vector<NodeId>& removed_nodes) {
+  for (const auto& id_layer_pair : graph.layers()) {
+    index(id_layer_pair.first)->update(*id_layer_pair.second, new_nodes, removed_nodes);
+  }
+}
+
+const ActiveWindowIndex::Ptr& ActiveWindows::index(LayerId layer) {
+  auto& index = indices_[layer];
+  if (!index) {
+    index = std::make_shared<ActiveWindowIndex>();
+  }
+
+  return index;
+}
+
+ActiveWindowTracker::ActiveWindowTracker(const ActiveWindowIndex::Ptr& index) {
+  bind(index);
+}
+
+ActiveWindowTracker::ActiveWindowTracker(const ActiveWindowTracker& other) {
+  bind(other.index_);
+}
+
+ActiveWindowTracker& ActiveWindowTracker::operator=(const ActiveWindowTracker& other) {
+  if (this != &other) {
+    bind(other.index_);
+  }
+
+  return *this;
+}
+
+ActiveWindowTracker::~ActiveWindowTracker() {
+  if (index_) {
+    index_->removeConsumer(consumer_);
+  }
+}
+
+void ActiveWindowTracker::bind(const ActiveWindowIndex::Ptr& index) {
+  if (index_ == index) {
+    return;
+  }
+
+  if (index_) {
+    index_->removeConsumer(consumer_);
+  }
+
+  index_ = index;
+  consumer_ = index_ ? index_->addConsumer() : 0;
+}
+
+ActiveWindowView ActiveWindowTracker::view(const SceneGraphLayer& layer) const {
+  return index_ ? index_->view(layer) : ActiveWindowView(layer);
+}
+
+ActiveWindowView ActiveWindowTracker::view(const SceneGraphLayer& layer,
+                                           ActiveWindows* windows) {
+  if (windows) {
+    bind(windows->index(layer.id));
+  }
+
+  return view(layer);
+}
+
+void ActiveWindowTracker::clear() {
+  if (index_) {
+    index_->clear(consumer_);
+  }
+}
+
+void ActiveWindowTracker::reset() {
+  if (index_) {
+    index_->reset();
+  }
 }
 
 }  // namespace hydra
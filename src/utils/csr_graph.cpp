@@ -0,0 +1,143 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "hydra/utils/csr_graph.h"
+
+#include <algorithm>
+
+namespace hydra {
+
+CsrGraph::CsrGraph() : offsets{0} {}
+
+CsrGraph::CsrGraph(const SceneGraphLayer& layer) {
+  init(layer, [](const SceneGraphLayer& G, NodeId n1, NodeId n2) {
+    return G.getEdge(n1, n2).info->weight;
+  });
+}
+
+CsrGraph::CsrGraph(const SceneGraphLayer& layer, const WeightFunc& weight_func) {
+  init(layer, weight_func);
+}
+
+void CsrGraph::init(const SceneGraphLayer& layer, const WeightFunc& weight_func) {
+  ids.reserve(layer.numNodes());
+  for (const auto& id_node_pair : layer.nodes()) {
+    ids.push_back(id_node_pair.first);
+  }
+
+  std::sort(ids.begin(), ids.end());
+  indices.reserve(ids.size());
+  for (size_t i = 0; i < ids.size(); ++i) {
+    indices.emplace(ids[i], i);
+  }
+
+  offsets.resize(ids.size() + 1, 0);
+  neighbors.reserve(2 * layer.numEdges());
+  weights.reserve(2 * layer.numEdges());
+
+  std::vector<std::pair<size_t, double>> row;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    const auto& node = layer.getNode(ids[i]);
+    row.clear();
+    for (const auto sibling : node.siblings()) {
+      row.emplace_back(indices.at(sibling), weight_func(layer, ids[i], sibling));
+    }
+
+    std::sort(row.begin(), row.end(), [](const auto& lhs, const auto& rhs) {
+      return lhs.first < rhs.first;
+    });
+
+    for (const auto& [index, weight] : row) {
+      neighbors.push_back(index);
+      weights.push_back(weight);
+    }
+
+    offsets[i + 1] = neighbors.size();
+  }
+}
+
+std::optional<size_t> CsrGraph::getIndex(NodeId node) const {
+  const auto iter = indices.find(node);
+  if (iter == indices.end()) {
+    return std::nullopt;
+  }
+
+  return iter->second;
+}
+
+CsrGraph::Components CsrGraph::getComponents(const NodeFilter& node_filter,
+                                             const EdgeFilter& edge_filter) const {
+  // 0: unvisited, 1: visited, 2: filtered out
+  std::vector<uint8_t> status(numNodes(), 0);
+  if (node_filter) {
+    for (size_t i = 0; i < numNodes(); ++i) {
+      status[i] = node_filter(i) ? 0 : 2;
+    }
+  }
+
+  Components components;
+  std::vector<size_t> frontier;
+  for (size_t i = 0; i < numNodes(); ++i) {
+    if (status[i]) {
+      continue;
+    }
+
+    auto& component = components.emplace_back();
+    status[i] = 1;
+    frontier.push_back(i);
+    while (!frontier.empty()) {
+      const auto curr = frontier.back();
+      frontier.pop_back();
+      component.push_back(curr);
+
+      for (size_t e = offsets[curr]; e < offsets[curr + 1]; ++e) {
+        const auto neighbor = neighbors[e];
+        if (status[neighbor]) {
+          continue;
+        }
+
+        if (edge_filter && !edge_filter(curr, neighbor, weights[e])) {
+          continue;
+        }
+
+        status[neighbor] = 1;
+        frontier.push_back(neighbor);
+      }
+    }
+  }
+
+  return components;
+}
+
+}  // namespace hydra
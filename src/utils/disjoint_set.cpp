@@ -96,4 +96,50 @@ std::optional<NodeId> DisjointSet::doUnion(NodeId lhs, NodeId rhs, bool rhs_bett
   return rhs_set;
 }
 
+DenseDisjointSet::DenseDisjointSet(size_t num_elements)
+    : parents(num_elements, kInvalid), sizes(num_elements, 0) {}
+
+bool DenseDisjointSet::addSet(size_t index) {
+  if (hasSet(index)) {
+    return false;
+  }
+
+  parents[index] = index;
+  sizes[index] = 1;
+  ++num_sets;
+  return true;
+}
+
+size_t DenseDisjointSet::findSet(size_t index) {
+  // path halving keeps the trees shallow without recursion
+  while (parents[index] != index) {
+    parents[index] = parents[parents[index]];
+    index = parents[index];
+  }
+
+  return index;
+}
+
+std::optional<size_t> DenseDisjointSet::doUnion(size_t lhs,
+                                                size_t rhs,
+                                                bool rhs_better) {
+  size_t lhs_set = findSet(lhs);
+  size_t rhs_set = findSet(rhs);
+  if (lhs_set == rhs_set) {
+    return std::nullopt;
+  }
+
+  const auto lhs_size = sizes[lhs_set];
+  const auto rhs_size = sizes[rhs_set];
+  if (lhs_size < rhs_size || (lhs_size == rhs_size && rhs_better)) {
+    std::swap(lhs_set, rhs_set);
+  }
+
+  parents[rhs_set] = lhs_set;
+  sizes[lhs_set] += sizes[rhs_set];
+  sizes[rhs_set] = 0;
+  --num_sets;
+  return rhs_set;
+}
+
 }  // namespace hydra
@@ -0,0 +1,584 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "hydra/utils/graph_checkpoint.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "hydra_build_config.h"
+
+#if HYDRA_USE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace hydra {
+
+namespace {
+
+constexpr uint8_t kVersion = 1;
+constexpr char kMagic[4] = {'H', 'D', 'C', 'K'};
+
+enum class ChunkType : uint8_t {
+  GRAPH = 0,
+  MESH = 1,
+  VERTICES = 2,
+  FACES = 3,
+  END = 4,
+};
+enum class Codec : uint8_t { RAW = 0, ZLIB = 1 };
+
+struct ChunkHeader {
+  ChunkType type;
+  Codec codec;
+  uint64_t raw_size;
+  uint64_t stored_size;
+};
+
+template <typename T>
+void append(std::vector<uint8_t>& buffer, const T& value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  const auto offset = buffer.size();
+  buffer.resize(offset + sizeof(T));
+  std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+void write(std::ostream& out, const T& value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool read(std::istream& in, T& value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  in.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return static_cast<bool>(in);
+}
+
+struct ChunkReader {
+  explicit ChunkReader(const std::vector<uint8_t>& buffer) : buffer(buffer) {}
+
+  template <typename T>
+  bool read(T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (pos + sizeof(T) > buffer.size()) {
+      return false;
+    }
+
+    std::memcpy(&value, buffer.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+  }
+
+  bool done() const { return pos == buffer.size(); }
+
+  const std::vector<uint8_t>& buffer;
+  size_t pos = 0;
+};
+
+class ChunkWriter {
+ public:
+  ChunkWriter(std::ostream& out, const GraphCheckpointOptions& options)
+      : out_(out), options_(options) {}
+
+  void write(ChunkType type, const std::vector<uint8_t>& raw) {
+    ChunkHeader header{type, Codec::RAW, raw.size(), raw.size()};
+    const uint8_t* payload = raw.data();
+#if HYDRA_USE_ZLIB
+    if (options_.compress && !raw.empty()) {
+      uLongf compressed_size = compressBound(raw.size());
+      compressed_.resize(compressed_size);
+      const auto ret = compress2(compressed_.data(),
+                                 &compressed_size,
+                                 raw.data(),
+                                 raw.size(),
+                                 options_.compression_level);
+      // chunks that do not compress are stored as is
+      if (ret == Z_OK && compressed_size < raw.size()) {
+        header.codec = Codec::ZLIB;
+        header.stored_size = compressed_size;
+        payload = compressed_.data();
+      }
+    }
+#endif
+
+    ::hydra::write(out_, static_cast<uint8_t>(header.type));
+    ::hydra::write(out_, static_cast<uint8_t>(header.codec));
+    ::hydra::write(out_, header.raw_size);
+    ::hydra::write(out_, header.stored_size);
+    out_.write(reinterpret_cast<const char*>(payload), header.stored_size);
+  }
+
+ private:
+  std::ostream& out_;
+  const GraphCheckpointOptions& options_;
+  std::vector<uint8_t> compressed_;
+};
+
+bool readChunk(std::istream& in,
+               ChunkHeader& header,
+               std::vector<uint8_t>& stored,
+               std::vector<uint8_t>& raw) {
+  uint8_t type, codec;
+  if (!read(in, type) || !read(in, codec) || !read(in, header.raw_size) ||
+      !read(in, header.stored_size)) {
+    return false;
+  }
+
+  header.type = static_cast<ChunkType>(type);
+  header.codec = static_cast<Codec>(codec);
+  if (header.codec == Codec::RAW) {
+    if (header.raw_size != header.stored_size) {
+      return false;
+    }
+
+    raw.resize(header.raw_size);
+    in.read(reinterpret_cast<char*>(raw.data()), raw.size());
+    return static_cast<bool>(in);
+  }
+
+  if (header.codec != Codec::ZLIB) {
+    LOG(ERROR) << "Unknown checkpoint codec: " << static_cast<int>(codec);
+    return false;
+  }
+
+#if HYDRA_USE_ZLIB
+  stored.resize(header.stored_size);
+  in.read(reinterpret_cast<char*>(stored.data()), stored.size());
+  if (!in) {
+    return false;
+  }
+
+  raw.resize(header.raw_size);
+  uLongf raw_size = raw.size();
+  const auto ret = uncompress(raw.data(), &raw_size, stored.data(), stored.size());
+  return ret == Z_OK && raw_size == header.raw_size;
+#else
+  (void)stored;
+  LOG(ERROR) << "Checkpoint is compressed but hydra was built without zlib";
+  return false;
+#endif
+}
+
+void encodeVertices(const spark_dsg::Mesh& mesh,
+                    size_t start,
+                    size_t end,
+                    std::vector<uint8_t>& buffer) {
+  buffer.clear();
+  append<uint64_t>(buffer, start);
+  append<uint64_t>(buffer, end - start);
+  // vertex attributes are stored as separate arrays to compress better
+  for (size_t i = start; i < end; ++i) {
+    const auto& pos = mesh.pos(i);
+    append<float>(buffer, pos.x());
+    append<float>(buffer, pos.y());
+    append<float>(buffer, pos.z());
+  }
+
+  if (mesh.has_colors) {
+    for (size_t i = start; i < end; ++i) {
+      const auto c = mesh.color(i);
+      append(buffer, c.r);
+      append(buffer, c.g);
+      append(buffer, c.b);
+      append(buffer, c.a);
+    }
+  }
+
+  if (mesh.has_timestamps) {
+    for (size_t i = start; i < end; ++i) {
+      append<uint64_t>(buffer, mesh.timestamp(i));
+    }
+  }
+
+  if (mesh.has_labels) {
+    for (size_t i = start; i < end; ++i) {
+      append<uint32_t>(buffer, mesh.label(i));
+    }
+  }
+}
+
+bool decodeVertices(const std::vector<uint8_t>& buffer, spark_dsg::Mesh& mesh) {
+  ChunkReader reader(buffer);
+  uint64_t start, count;
+  if (!reader.read(start) || !reader.read(count) ||
+      start + count > mesh.numVertices()) {
+    return false;
+  }
+
+  const auto end = start + count;
+  for (size_t i = start; i < end; ++i) {
+    float x, y, z;
+    if (!reader.read(x) || !reader.read(y) || !reader.read(z)) {
+      return false;
+    }
+
+    mesh.setPos(i, Eigen::Vector3f(x, y, z));
+  }
+
+  if (mesh.has_colors) {
+    for (size_t i = start; i < end; ++i) {
+      uint8_t r, g, b, a;
+      if (!reader.read(r) || !reader.read(g) || !reader.read(b) || !reader.read(a)) {
+        return false;
+      }
+
+      mesh.setColor(i, Color(r, g, b, a));
+    }
+  }
+
+  if (mesh.has_timestamps) {
+    for (size_t i = start; i < end; ++i) {
+      uint64_t stamp;
+      if (!reader.read(stamp)) {
+        return false;
+      }
+
+      mesh.setTimestamp(i, stamp);
+    }
+  }
+
+  if (mesh.has_labels) {
+    for (size_t i = start; i < end; ++i) {
+      uint32_t label;
+      if (!reader.read(label)) {
+        return false;
+      }
+
+      mesh.setLabel(i, label);
+    }
+  }
+
+  return reader.done();
+}
+
+void encodeFaces(const spark_dsg::Mesh& mesh,
+                 size_t start,
+                 size_t end,
+                 std::vector<uint8_t>& buffer) {
+  buffer.clear();
+  append<uint64_t>(buffer, start);
+  append<uint64_t>(buffer, end - start);
+  for (size_t i = start; i < end; ++i) {
+    for (const auto index : mesh.face(i)) {
+      append<uint64_t>(buffer, index);
+    }
+  }
+}
+
+bool decodeFaces(const std::vector<uint8_t>& buffer, spark_dsg::Mesh& mesh) {
+  ChunkReader reader(buffer);
+  uint64_t start, count;
+  if (!reader.read(start) || !reader.read(count) || start + count > mesh.numFaces()) {
+    return false;
+  }
+
+  for (size_t i = start; i < start + count; ++i) {
+    for (auto& index : mesh.face(i)) {
+      uint64_t value;
+      if (!reader.read(value)) {
+        return false;
+      }
+
+      index = value;
+    }
+  }
+
+  return reader.done();
+}
+
+std::shared_ptr<spark_dsg::Mesh> copyMesh(const spark_dsg::Mesh& mesh) {
+  auto copy = std::make_shared<spark_dsg::Mesh>(
+      mesh.has_colors, mesh.has_timestamps, mesh.has_labels);
+  copy->resizeVertices(mesh.numVertices());
+  for (size_t i = 0; i < mesh.numVertices(); ++i) {
+    copy->setPos(i, mesh.pos(i));
+    if (mesh.has_colors) {
+      copy->setColor(i, mesh.color(i));
+    }
+
+    if (mesh.has_timestamps) {
+      copy->setTimestamp(i, mesh.timestamp(i));
+    }
+
+    if (mesh.has_labels) {
+      copy->setLabel(i, mesh.label(i));
+    }
+  }
+
+  copy->resizeFaces(mesh.numFaces());
+  for (size_t i = 0; i < mesh.numFaces(); ++i) {
+    copy->face(i) = mesh.face(i);
+  }
+
+  return copy;
+}
+
+}  // namespace
+
+GraphSnapshot::GraphSnapshot(const DynamicSceneGraph& graph, bool include_mesh)
+    : graph_bytes(graph.serialize()) {
+  const auto graph_mesh = graph.mesh();
+  if (include_mesh && graph_mesh) {
+    mesh = copyMesh(*graph_mesh);
+  }
+}
+
+bool writeGraphCheckpoint(const std::string& filepath,
+                          const DynamicSceneGraph& graph,
+                          const GraphCheckpointOptions& options) {
+  const GraphSnapshot snapshot(graph, options.include_mesh);
+  return writeGraphCheckpoint(filepath, snapshot, options);
+}
+
+bool writeGraphCheckpoint(const std::string& filepath,
+                          const GraphSnapshot& snapshot,
+                          const GraphCheckpointOptions& options) {
+  std::ofstream out(filepath, std::ios::binary);
+  if (!out) {
+    LOG(ERROR) << "Unable to open checkpoint file: " << filepath;
+    return false;
+  }
+
+  out.write(kMagic, sizeof(kMagic));
+  write(out, kVersion);
+
+  ChunkWriter writer(out, options);
+  writer.write(ChunkType::GRAPH, snapshot.graph_bytes);
+
+  const auto mesh = options.include_mesh ? snapshot.mesh : nullptr;
+  if (mesh) {
+    std::vector<uint8_t> buffer;
+    append<uint8_t>(buffer, mesh->has_colors);
+    append<uint8_t>(buffer, mesh->has_timestamps);
+    append<uint8_t>(buffer, mesh->has_labels);
+    append<uint64_t>(buffer, mesh->numVertices());
+    append<uint64_t>(buffer, mesh->numFaces());
+    writer.write(ChunkType::MESH, buffer);
+
+    const size_t chunk_size = std::max<size_t>(options.chunk_size, 1);
+    for (size_t i = 0; i < mesh->numVertices(); i += chunk_size) {
+      encodeVertices(*mesh, i, std::min(mesh->numVertices(), i + chunk_size), buffer);
+      writer.write(ChunkType::VERTICES, buffer);
+    }
+
+    for (size_t i = 0; i < mesh->numFaces(); i += chunk_size) {
+      encodeFaces(*mesh, i, std::min(mesh->numFaces(), i + chunk_size), buffer);
+      writer.write(ChunkType::FACES, buffer);
+    }
+  }
+
+  writer.write(ChunkType::END, {});
+  out.flush();
+  if (!out) {
+    LOG(ERROR) << "Failed to write checkpoint file: " << filepath;
+    return false;
+  }
+
+  return true;
+}
+
+DynamicSceneGraph::Ptr readGraphCheckpoint(const std::string& filepath) {
+  std::ifstream in(filepath, std::ios::binary);
+  if (!in) {
+    LOG(ERROR) << "Unable to open checkpoint file: " << filepath;
+    return nullptr;
+  }
+
+  char magic[sizeof(kMagic)];
+  uint8_t version;
+  in.read(magic, sizeof(magic));
+  if (!in || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 || !read(in, version) ||
+      version != kVersion) {
+    LOG(ERROR) << "Invalid checkpoint header: " << filepath;
+    return nullptr;
+  }
+
+  DynamicSceneGraph::Ptr graph;
+  std::shared_ptr<spark_dsg::Mesh> mesh;
+  ChunkHeader header;
+  std::vector<uint8_t> stored;
+  std::vector<uint8_t> raw;
+  while (readChunk(in, header, stored, raw)) {
+    switch (header.type) {
+      case ChunkType::GRAPH:
+        graph = DynamicSceneGraph::deserialize(raw.data(), raw.size());
+        if (!graph) {
+          LOG(ERROR) << "Invalid graph chunk in checkpoint: " << filepath;
+          return nullptr;
+        }
+        break;
+      case ChunkType::MESH: {
+        uint8_t has_colors, has_timestamps, has_labels;
+        uint64_t num_vertices, num_faces;
+        ChunkReader reader(raw);
+        if (!reader.read(has_colors) || !reader.read(has_timestamps) ||
+            !reader.read(has_labels) || !reader.read(num_vertices) ||
+            !reader.read(num_faces) || !reader.done()) {
+          LOG(ERROR) << "Invalid mesh chunk in checkpoint: " << filepath;
+          return nullptr;
+        }
+
+        mesh = std::make_shared<spark_dsg::Mesh>(
+            has_colors, has_timestamps, has_labels);
+        mesh->resizeVertices(num_vertices);
+        mesh->resizeFaces(num_faces);
+      } break;
+      case ChunkType::VERTICES:
+        if (!mesh || !decodeVertices(raw, *mesh)) {
+          LOG(ERROR) << "Invalid vertex chunk in checkpoint: " << filepath;
+          return nullptr;
+        }
+        break;
+      case ChunkType::FACES:
+        if (!mesh || !decodeFaces(raw, *mesh)) {
+          LOG(ERROR) << "Invalid face chunk in checkpoint: " << filepath;
+          return nullptr;
+        }
+        break;
+      case ChunkType::END:
+        if (!graph) {
+          LOG(ERROR) << "Checkpoint is missing graph: " << filepath;
+          return nullptr;
+        }
+
+        if (mesh) {
+          graph->setMesh(mesh);
+        }
+
+        return graph;
+      default:
+        LOG(ERROR) << "Unknown chunk type " << static_cast<int>(header.type)
+                   << " in checkpoint: " << filepath;
+        return nullptr;
+    }
+  }
+
+  LOG(ERROR) << "Checkpoint is truncated: " << filepath;
+  return nullptr;
+}
+
+bool isGraphCheckpoint(const std::string& filepath) {
+  std::ifstream in(filepath, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  in.read(magic, sizeof(magic));
+  return in && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+DynamicSceneGraph::Ptr loadGraph(const std::string& filepath) {
+  if (isGraphCheckpoint(filepath)) {
+    return readGraphCheckpoint(filepath);
+  }
+
+  return DynamicSceneGraph::load(filepath);
+}
+
+bool convertCheckpointToJson(const std::string& checkpoint_path,
+                             const std::string& json_path,
+                             bool include_mesh) {
+  const auto graph = readGraphCheckpoint(checkpoint_path);
+  if (!graph) {
+    return false;
+  }
+
+  graph->save(json_path, include_mesh);
+  return true;
+}
+
+GraphCheckpointWriter::GraphCheckpointWriter(const GraphCheckpointOptions& options)
+    : options(options) {
+  thread_ = std::thread(&GraphCheckpointWriter::spin, this);
+}
+
+GraphCheckpointWriter::~GraphCheckpointWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    should_shutdown_ = true;
+  }
+
+  cv_.notify_all();
+  thread_.join();
+}
+
+void GraphCheckpointWriter::save(const DynamicSceneGraph& graph,
+                                 const std::string& filepath) {
+  save(graph, filepath, options);
+}
+
+void GraphCheckpointWriter::save(const DynamicSceneGraph& graph,
+                                 const std::string& filepath,
+                                 const GraphCheckpointOptions& job_options) {
+  auto snapshot = std::make_shared<GraphSnapshot>(graph, job_options.include_mesh);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back({filepath, job_options, snapshot});
+  }
+
+  cv_.notify_all();
+}
+
+void GraphCheckpointWriter::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return jobs_.empty() && !writing_; });
+}
+
+void GraphCheckpointWriter::spin() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    // pending jobs are always finished before shutting down
+    cv_.wait(lock, [this] { return should_shutdown_ || !jobs_.empty(); });
+    if (jobs_.empty()) {
+      return;
+    }
+
+    auto job = std::move(jobs_.front());
+    jobs_.pop_front();
+    writing_ = true;
+    lock.unlock();
+
+    VLOG(2) << "[Graph Checkpoint] writing " << job.filepath;
+    writeGraphCheckpoint(job.filepath, *job.snapshot, job.options);
+    job.snapshot.reset();
+
+    lock.lock();
+    writing_ = false;
+    cv_.notify_all();
+  }
+}
+
+}  // namespace hydra
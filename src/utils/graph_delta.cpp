@@ -0,0 +1,678 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "hydra/utils/graph_delta.h"
+
+#include <config_utilities/config.h>
+#include <config_utilities/validation.h>
+#include <glog/logging.h>
+
+#include <cstring>
+#include <numeric>
+
+namespace hydra {
+
+namespace {
+
+constexpr uint8_t kVersion = 2;
+constexpr char kMagic[4] = {'H', 'D', 'S', 'D'};
+
+struct ByteWriter {
+  explicit ByteWriter(std::vector<uint8_t>& buffer) : buffer(buffer) {}
+
+  template <typename T>
+  void write(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto offset = buffer.size();
+    buffer.resize(offset + sizeof(T));
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+  }
+
+  void writeBytes(const uint8_t* data, size_t length) {
+    write<uint64_t>(length);
+    buffer.insert(buffer.end(), data, data + length);
+  }
+
+  std::vector<uint8_t>& buffer;
+};
+
+struct ByteReader {
+  ByteReader(const uint8_t* data, size_t length) : data(data), length(length) {}
+
+  template <typename T>
+  bool read(T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (pos + sizeof(T) > length) {
+      return false;
+    }
+
+    std::memcpy(&value, data + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+  }
+
+  //! Skip over a span of bytes, returning a pointer to the start of the span
+  const uint8_t* skip(size_t num_bytes) {
+    if (pos + num_bytes > length) {
+      return nullptr;
+    }
+
+    const auto start = data + pos;
+    pos += num_bytes;
+    return start;
+  }
+
+  const uint8_t* data;
+  size_t length;
+  size_t pos = 0;
+};
+
+struct MeshFlags {
+  uint8_t has_colors;
+  uint8_t has_timestamps;
+  uint8_t has_labels;
+
+  size_t vertexBytes() const {
+    return 3 * sizeof(float) + (has_colors ? 4 : 0) +
+           (has_timestamps ? sizeof(uint64_t) : 0) +
+           (has_labels ? sizeof(uint32_t) : 0);
+  }
+
+  uint8_t bits() const { return has_colors | has_timestamps << 1 | has_labels << 2; }
+};
+
+constexpr size_t kFaceBytes = 3 * sizeof(uint64_t);
+
+void writeVertex(const spark_dsg::Mesh& mesh, size_t i, ByteWriter& writer) {
+  const auto& pos = mesh.pos(i);
+  writer.write(pos.x());
+  writer.write(pos.y());
+  writer.write(pos.z());
+  if (mesh.has_colors) {
+    const auto c = mesh.color(i);
+    writer.write(c.r);
+    writer.write(c.g);
+    writer.write(c.b);
+    writer.write(c.a);
+  }
+
+  if (mesh.has_timestamps) {
+    writer.write<uint64_t>(mesh.timestamp(i));
+  }
+
+  if (mesh.has_labels) {
+    writer.write<uint32_t>(mesh.label(i));
+  }
+}
+
+void readVertex(ByteReader& reader, spark_dsg::Mesh& mesh, size_t i) {
+  float x, y, z;
+  reader.read(x);
+  reader.read(y);
+  reader.read(z);
+  mesh.setPos(i, Eigen::Vector3f(x, y, z));
+  if (mesh.has_colors) {
+    uint8_t r, g, b, a;
+    reader.read(r);
+    reader.read(g);
+    reader.read(b);
+    reader.read(a);
+    mesh.setColor(i, Color(r, g, b, a));
+  }
+
+  if (mesh.has_timestamps) {
+    uint64_t stamp;
+    reader.read(stamp);
+    mesh.setTimestamp(i, stamp);
+  }
+
+  if (mesh.has_labels) {
+    uint32_t label;
+    reader.read(label);
+    mesh.setLabel(i, label);
+  }
+}
+
+// writes the given blocks (every block if none are given)
+template <typename WriteFunc>
+void writeBlocks(size_t num_items,
+                 size_t block_size,
+                 const std::set<size_t>* blocks,
+                 const WriteFunc& write_item,
+                 ByteWriter& writer) {
+  const size_t num_blocks = (num_items + block_size - 1) / block_size;
+  std::vector<size_t> to_send;
+  if (!blocks) {
+    to_send.resize(num_blocks);
+    std::iota(to_send.begin(), to_send.end(), 0);
+  } else {
+    // blocks past the end of the mesh were removed since they were marked
+    auto end = blocks->lower_bound(num_blocks);
+    to_send.assign(blocks->begin(), end);
+  }
+
+  writer.write<uint64_t>(to_send.size());
+  for (const auto b : to_send) {
+    writer.write<uint64_t>(b);
+    const size_t end = std::min(num_items, (b + 1) * block_size);
+    for (size_t i = b * block_size; i < end; ++i) {
+      write_item(i, writer);
+    }
+  }
+}
+
+void markBlocks(size_t begin, size_t end, size_t block_size, std::set<size_t>& blocks) {
+  for (size_t b = begin / block_size; b * block_size < end; ++b) {
+    blocks.insert(b);
+  }
+}
+
+//! Whether the id belongs to a (possibly removed) node of a dynamic layer
+bool isDynamicNode(const DynamicSceneGraph& graph, NodeId node_id) {
+  const NodeSymbol symbol(node_id);
+  for (const auto& id_prefix_map : graph.dynamicLayers()) {
+    auto iter = id_prefix_map.second.find(symbol.category());
+    if (iter != id_prefix_map.second.end() &&
+        symbol.categoryId() < iter->second->nodes().size()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+DynamicSceneGraph::Ptr makeEmptyGraph(const DynamicSceneGraph& graph) {
+  DynamicSceneGraph::LayerIds layer_ids;
+  for (const auto& id_layer_pair : graph.layers()) {
+    layer_ids.push_back(id_layer_pair.first);
+  }
+
+  return std::make_shared<DynamicSceneGraph>(layer_ids);
+}
+
+}  // namespace
+
+void declare_config(GraphDeltaEncoder::Config& config) {
+  using namespace config;
+  name("GraphDeltaEncoderConfig");
+  field(config.keyframe_period, "keyframe_period");
+  field(config.mesh_block_size, "mesh_block_size");
+  check(config.mesh_block_size, GT, 0, "mesh_block_size");
+}
+
+bool readGraphDeltaHeader(const uint8_t* data,
+                          size_t length,
+                          GraphDeltaHeader& header) {
+  ByteReader reader(data, length);
+  const auto magic = reader.skip(sizeof(kMagic));
+  if (!magic || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+    return false;
+  }
+
+  uint8_t version;
+  uint8_t type;
+  if (!reader.read(version) || version != kVersion || !reader.read(type) ||
+      type > static_cast<uint8_t>(GraphDeltaType::DELTA)) {
+    return false;
+  }
+
+  header.type = static_cast<GraphDeltaType>(type);
+  return reader.read(header.sequence) && reader.read(header.base_sequence);
+}
+
+GraphDeltaEncoder::GraphDeltaEncoder(const Config& config)
+    : config(config::checkValid(config)) {}
+
+void GraphDeltaEncoder::requestKeyframe() { need_keyframe_ = true; }
+
+void GraphDeltaEncoder::markNode(NodeId node) { nodes_.insert(node); }
+
+void GraphDeltaEncoder::markEdge(NodeId source, NodeId target) {
+  edges_.insert(EdgeKey(source, target));
+}
+
+void GraphDeltaEncoder::markVertices(size_t begin, size_t end) {
+  markBlocks(begin, end, config.mesh_block_size, vertex_blocks_);
+}
+
+void GraphDeltaEncoder::markFaces(size_t begin, size_t end) {
+  markBlocks(begin, end, config.mesh_block_size, face_blocks_);
+}
+
+GraphDeltaHeader GraphDeltaEncoder::encode(DynamicSceneGraph& graph,
+                                           bool include_mesh,
+                                           std::vector<uint8_t>& buffer) {
+  for (const auto node_id : graph.getNewNodes(true)) {
+    nodes_.insert(node_id);
+  }
+
+  for (const auto node_id : graph.getRemovedNodes(true)) {
+    removed_nodes_.insert(node_id);
+  }
+
+  for (const auto& key : graph.getNewEdges(true)) {
+    edges_.insert(key);
+  }
+
+  for (const auto& key : graph.getRemovedEdges(true)) {
+    removed_edges_.insert(key);
+  }
+
+  bool keyframe = need_keyframe_;
+  if (config.keyframe_period > 0 &&
+      messages_since_keyframe_ + 1 >= config.keyframe_period) {
+    keyframe = true;
+  }
+
+  for (const auto node_id : removed_nodes_) {
+    if (keyframe) {
+      break;
+    }
+
+    // removed dynamic nodes cannot be re-indexed by the receiver
+    keyframe = !graph.hasNode(node_id) && isDynamicNode(graph, node_id);
+  }
+
+  GraphDeltaHeader header;
+  header.type = keyframe ? GraphDeltaType::KEYFRAME : GraphDeltaType::DELTA;
+  header.sequence = sequence_ + 1;
+  header.base_sequence = sequence_;
+
+  buffer.clear();
+  ByteWriter writer(buffer);
+  buffer.insert(buffer.end(), kMagic, kMagic + sizeof(kMagic));
+  writer.write(kVersion);
+  writer.write(static_cast<uint8_t>(header.type));
+  writer.write(header.sequence);
+  writer.write(header.base_sequence);
+
+  if (keyframe) {
+    const auto graph_bytes = graph.serialize();
+    writer.write<uint64_t>(0);  // removed nodes
+    writer.write<uint64_t>(0);  // removed edges
+    writer.writeBytes(graph_bytes.data(), graph_bytes.size());
+    writer.write<uint64_t>(0);  // dynamic nodes
+    writer.write<uint64_t>(0);  // edges
+  } else {
+    writer.write<uint64_t>(removed_nodes_.size());
+    for (const auto node_id : removed_nodes_) {
+      writer.write<uint64_t>(node_id);
+    }
+
+    writer.write<uint64_t>(removed_edges_.size());
+    for (const auto& key : removed_edges_) {
+      writer.write<uint64_t>(key.k1);
+      writer.write<uint64_t>(key.k2);
+    }
+
+    // dynamic nodes are re-indexed in the delta, so their ids are sent separately
+    // (nodes are sorted by id, so new dynamic nodes are appended in order)
+    auto delta = makeEmptyGraph(graph);
+    std::vector<std::pair<NodeId, NodeId>> dynamic_ids;
+    for (const auto node_id : nodes_) {
+      if (!graph.hasNode(node_id)) {
+        continue;
+      }
+
+      const auto& node = graph.getNode(node_id);
+      if (!node.timestamp) {
+        delta->emplaceNode(node.layer, node_id, node.attributes().clone());
+        continue;
+      }
+
+      const auto prefix = NodeSymbol(node_id).category();
+      delta->emplaceNode(
+          node.layer, prefix, node.timestamp.value(), node.attributes().clone(), false);
+      const auto& layer = *delta->dynamicLayers().at(node.layer).at(prefix);
+      dynamic_ids.emplace_back(layer.nodes().back()->id, node_id);
+    }
+
+    const auto graph_bytes =
+        delta->numNodes() ? delta->serialize() : std::vector<uint8_t>();
+    writer.writeBytes(graph_bytes.data(), graph_bytes.size());
+    writer.write<uint64_t>(dynamic_ids.size());
+    for (const auto& [delta_id, node_id] : dynamic_ids) {
+      writer.write<uint64_t>(delta_id);
+      writer.write<uint64_t>(node_id);
+    }
+
+    std::vector<const SceneGraphEdge*> edges;
+    for (const auto& key : edges_) {
+      if (graph.hasEdge(key.k1, key.k2)) {
+        edges.push_back(&graph.getEdge(key.k1, key.k2));
+      }
+    }
+
+    writer.write<uint64_t>(edges.size());
+    for (const auto edge : edges) {
+      const auto& attrs = edge->attributes();
+      writer.write<uint64_t>(edge->source);
+      writer.write<uint64_t>(edge->target);
+      writer.write<uint8_t>(attrs.weighted);
+      writer.write<double>(attrs.weight);
+    }
+  }
+
+  nodes_.clear();
+  removed_nodes_.clear();
+  edges_.clear();
+  removed_edges_.clear();
+
+  const auto mesh = graph.mesh();
+  if (!include_mesh || !mesh) {
+    writer.write<uint8_t>(0);
+  } else {
+    const MeshFlags flags{mesh->has_colors, mesh->has_timestamps, mesh->has_labels};
+    // receivers rebuild the mesh if the flags change
+    const bool full_mesh = keyframe || !sent_mesh_ || flags.bits() != mesh_flags_;
+
+    // appended vertices and faces are always sent
+    const auto num_vertices = mesh->numVertices();
+    const auto num_faces = mesh->numFaces();
+    markVertices(std::min(num_vertices_, num_vertices), num_vertices);
+    markFaces(std::min(num_faces_, num_faces), num_faces);
+
+    writer.write<uint8_t>(1);
+    writer.write(flags);
+    writer.write<uint64_t>(num_vertices);
+    writer.write<uint64_t>(num_faces);
+    writer.write<uint64_t>(config.mesh_block_size);
+    writeBlocks(
+        num_vertices,
+        config.mesh_block_size,
+        full_mesh ? nullptr : &vertex_blocks_,
+        [&](size_t i, ByteWriter& block) { writeVertex(*mesh, i, block); },
+        writer);
+    writeBlocks(
+        num_faces,
+        config.mesh_block_size,
+        full_mesh ? nullptr : &face_blocks_,
+        [&](size_t i, ByteWriter& block) {
+          const auto& face = mesh->face(i);
+          for (const auto index : face) {
+            block.write<uint64_t>(index);
+          }
+        },
+        writer);
+
+    vertex_blocks_.clear();
+    face_blocks_.clear();
+    sent_mesh_ = true;
+    mesh_flags_ = flags.bits();
+    num_vertices_ = num_vertices;
+    num_faces_ = num_faces;
+  }
+
+  ++sequence_;
+  messages_since_keyframe_ = keyframe ? 0 : messages_since_keyframe_ + 1;
+  need_keyframe_ = false;
+  return header;
+}
+
+GraphDeltaApplier::Status GraphDeltaApplier::apply(const uint8_t* data, size_t length) {
+  GraphDeltaHeader header;
+  if (!readGraphDeltaHeader(data, length, header)) {
+    return Status::INVALID;
+  }
+
+  const bool keyframe = header.type == GraphDeltaType::KEYFRAME;
+  if (!keyframe && (!synced_ || header.base_sequence != sequence_)) {
+    return Status::NEEDS_KEYFRAME;
+  }
+
+  // decode everything before touching the graph so that invalid messages are no-ops
+  ByteReader reader(data, length);
+  reader.skip(sizeof(kMagic) + 2 + 2 * sizeof(uint64_t));
+
+  uint64_t num_removed_nodes;
+  if (!reader.read(num_removed_nodes)) {
+    return Status::INVALID;
+  }
+
+  std::vector<NodeId> removed_nodes(num_removed_nodes);
+  for (auto& node_id : removed_nodes) {
+    if (!reader.read(node_id)) {
+      return Status::INVALID;
+    }
+  }
+
+  uint64_t num_removed_edges;
+  if (!reader.read(num_removed_edges)) {
+    return Status::INVALID;
+  }
+
+  std::vector<std::pair<NodeId, NodeId>> removed_edges(num_removed_edges);
+  for (auto& edge : removed_edges) {
+    if (!reader.read(edge.first) || !reader.read(edge.second)) {
+      return Status::INVALID;
+    }
+  }
+
+  uint64_t num_graph_bytes;
+  if (!reader.read(num_graph_bytes)) {
+    return Status::INVALID;
+  }
+
+  const auto graph_bytes = reader.skip(num_graph_bytes);
+  if (!graph_bytes) {
+    return Status::INVALID;
+  }
+
+  DynamicSceneGraph::Ptr delta;
+  if (num_graph_bytes) {
+    try {
+      delta = DynamicSceneGraph::deserialize(graph_bytes, num_graph_bytes);
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "[Graph Delta] failed to decode graph: " << e.what();
+      return Status::INVALID;
+    }
+  }
+
+  uint64_t num_dynamic_nodes;
+  if (!reader.read(num_dynamic_nodes)) {
+    return Status::INVALID;
+  }
+
+  std::vector<std::pair<NodeId, NodeId>> dynamic_ids(num_dynamic_nodes);
+  for (auto& [delta_id, node_id] : dynamic_ids) {
+    if (!reader.read(delta_id) || !reader.read(node_id) || !delta ||
+        !delta->hasNode(delta_id)) {
+      return Status::INVALID;
+    }
+  }
+
+  struct EdgeInfo {
+    NodeId source;
+    NodeId target;
+    uint8_t weighted;
+    double weight;
+  };
+
+  uint64_t num_edges;
+  if (!reader.read(num_edges)) {
+    return Status::INVALID;
+  }
+
+  std::vector<EdgeInfo> edges(num_edges);
+  for (auto& edge : edges) {
+    if (!reader.read(edge.source) || !reader.read(edge.target) ||
+        !reader.read(edge.weighted) || !reader.read(edge.weight)) {
+      return Status::INVALID;
+    }
+  }
+
+  uint8_t has_mesh;
+  if (!reader.read(has_mesh)) {
+    return Status::INVALID;
+  }
+
+  MeshFlags flags{0, 0, 0};
+  uint64_t num_vertices = 0;
+  uint64_t num_faces = 0;
+  uint64_t block_size = 0;
+  std::vector<std::pair<uint64_t, const uint8_t*>> vertex_blocks;
+  std::vector<std::pair<uint64_t, const uint8_t*>> face_blocks;
+  if (has_mesh) {
+    if (!reader.read(flags) || !reader.read(num_vertices) || !reader.read(num_faces) ||
+        !reader.read(block_size) || !block_size) {
+      return Status::INVALID;
+    }
+
+    auto read_blocks = [&](uint64_t num_items, size_t item_bytes, auto& blocks) {
+      uint64_t num_blocks;
+      if (!reader.read(num_blocks)) {
+        return false;
+      }
+
+      for (uint64_t i = 0; i < num_blocks; ++i) {
+        uint64_t b;
+        if (!reader.read(b) || b * block_size >= num_items) {
+          return false;
+        }
+
+        const auto count = std::min(block_size, num_items - b * block_size);
+        const auto start = reader.skip(count * item_bytes);
+        if (!start) {
+          return false;
+        }
+
+        blocks.emplace_back(b, start);
+      }
+
+      return true;
+    };
+
+    if (!read_blocks(num_vertices, flags.vertexBytes(), vertex_blocks) ||
+        !read_blocks(num_faces, kFaceBytes, face_blocks)) {
+      return Status::INVALID;
+    }
+  }
+
+  if (keyframe) {
+    graph_ = delta ? delta : std::make_shared<DynamicSceneGraph>();
+  } else {
+    for (const auto& edge : removed_edges) {
+      graph_->removeEdge(edge.first, edge.second);
+    }
+
+    for (const auto node_id : removed_nodes) {
+      graph_->removeNode(node_id);
+    }
+
+    if (delta) {
+      for (const auto& id_layer_pair : delta->layers()) {
+        for (const auto& id_node_pair : id_layer_pair.second->nodes()) {
+          auto attrs = id_node_pair.second->attributes().clone();
+          if (graph_->hasNode(id_node_pair.first)) {
+            graph_->setNodeAttributes(id_node_pair.first, std::move(attrs));
+          } else {
+            graph_->emplaceNode(
+                id_layer_pair.first, id_node_pair.first, std::move(attrs));
+          }
+        }
+      }
+    }
+
+    for (const auto& [delta_id, node_id] : dynamic_ids) {
+      const auto& node = delta->getNode(delta_id);
+      auto attrs = node.attributes().clone();
+      if (graph_->hasNode(node_id)) {
+        graph_->setNodeAttributes(node_id, std::move(attrs));
+        continue;
+      }
+
+      graph_->emplaceNode(node.layer,
+                          NodeSymbol(node_id).category(),
+                          node.timestamp.value(),
+                          std::move(attrs),
+                          false);
+      if (!graph_->hasNode(node_id)) {
+        // new dynamic nodes have to be appended in order
+        LOG(WARNING) << "[Graph Delta] dynamic node " << NodeSymbol(node_id).getLabel()
+                     << " is out of order";
+        synced_ = false;
+        return Status::NEEDS_KEYFRAME;
+      }
+    }
+
+    for (const auto& edge : edges) {
+      auto attrs = std::make_unique<EdgeAttributes>();
+      attrs->weighted = edge.weighted;
+      attrs->weight = edge.weight;
+      graph_->addOrUpdateEdge(edge.source, edge.target, std::move(attrs));
+    }
+  }
+
+  if (has_mesh) {
+    auto mesh = graph_->mesh();
+    if (!mesh || keyframe || mesh->has_colors != static_cast<bool>(flags.has_colors) ||
+        mesh->has_timestamps != static_cast<bool>(flags.has_timestamps) ||
+        mesh->has_labels != static_cast<bool>(flags.has_labels)) {
+      mesh = std::make_shared<spark_dsg::Mesh>(
+          flags.has_colors, flags.has_timestamps, flags.has_labels);
+      graph_->setMesh(mesh);
+    }
+
+    mesh->resizeVertices(num_vertices);
+    mesh->resizeFaces(num_faces);
+    for (const auto& index_start : vertex_blocks) {
+      const size_t start = index_start.first * block_size;
+      const size_t end = std::min(num_vertices, start + block_size);
+      ByteReader block(index_start.second, (end - start) * flags.vertexBytes());
+      for (size_t i = start; i < end; ++i) {
+        readVertex(block, *mesh, i);
+      }
+    }
+
+    for (const auto& index_start : face_blocks) {
+      const size_t start = index_start.first * block_size;
+      const size_t end = std::min(num_faces, start + block_size);
+      ByteReader block(index_start.second, (end - start) * kFaceBytes);
+      for (size_t i = start; i < end; ++i) {
+        auto& face = mesh->face(i);
+        for (auto& index : face) {
+          uint64_t value;
+          block.read(value);
+          index = value;
+        }
+      }
+    }
+  }
+
+  synced_ = true;
+  sequence_ = header.sequence;
+  return Status::APPLIED;
+}
+
+}  // namespace hydra
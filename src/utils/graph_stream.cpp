@@ -0,0 +1,252 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include "hydra/utils/graph_stream.h"
+
+#include <config_utilities/config.h>
+#include <config_utilities/validation.h>
+#include <glog/logging.h>
+
+#include <stdexcept>
+
+#include "hydra_build_config.h"
+
+#if HYDRA_USE_ZMQ
+#include <zmq.h>
+#endif
+
+namespace hydra {
+
+void declare_config(GraphStreamPublisher::Config& config) {
+  using namespace config;
+  name("GraphStreamPublisherConfig");
+  field(config.url, "url");
+  field(config.resync_url, "resync_url");
+  field(config.num_threads, "num_threads");
+  field(config.encoder, "encoder");
+  check(config.num_threads, GT, 0, "num_threads");
+}
+
+void declare_config(GraphStreamSubscriber::Config& config) {
+  using namespace config;
+  name("GraphStreamSubscriberConfig");
+  field(config.url, "url");
+  field(config.resync_url, "resync_url");
+  field(config.num_threads, "num_threads");
+  field(config.resync_period_ms, "resync_period_ms");
+  check(config.num_threads, GT, 0, "num_threads");
+}
+
+#if HYDRA_USE_ZMQ
+
+namespace {
+
+void* makeContext(size_t num_threads) {
+  void* context = zmq_ctx_new();
+  zmq_ctx_set(context, ZMQ_IO_THREADS, static_cast<int>(num_threads));
+  return context;
+}
+
+void* makeSocket(void* context, int type, const std::string& url, bool bind) {
+  void* socket = zmq_socket(context, type);
+  const int linger = 0;
+  zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+  if (type == ZMQ_SUB) {
+    zmq_setsockopt(socket, ZMQ_SUBSCRIBE, "", 0);
+  }
+
+  const int ret =
+      bind ? zmq_bind(socket, url.c_str()) : zmq_connect(socket, url.c_str());
+  if (ret != 0) {
+    const std::string error = zmq_strerror(zmq_errno());
+    zmq_close(socket);
+    throw std::runtime_error("unable to open zmq socket for '" + url + "': " + error);
+  }
+
+  return socket;
+}
+
+}  // namespace
+
+struct GraphStreamPublisher::Sockets {
+  Sockets(const GraphStreamPublisher::Config& config)
+      : context(makeContext(config.num_threads)),
+        pub(makeSocket(context, ZMQ_PUB, config.url, true)),
+        resync(makeSocket(context, ZMQ_PULL, config.resync_url, true)) {}
+
+  ~Sockets() {
+    zmq_close(resync);
+    zmq_close(pub);
+    zmq_ctx_term(context);
+  }
+
+  void* context;
+  void* pub;
+  void* resync;
+};
+
+struct GraphStreamSubscriber::Sockets {
+  Sockets(const GraphStreamSubscriber::Config& config)
+      : context(makeContext(config.num_threads)),
+        sub(makeSocket(context, ZMQ_SUB, config.url, false)),
+        resync(makeSocket(context, ZMQ_PUSH, config.resync_url, false)) {}
+
+  ~Sockets() {
+    zmq_close(resync);
+    zmq_close(sub);
+    zmq_ctx_term(context);
+  }
+
+  void* context;
+  void* sub;
+  void* resync;
+};
+
+GraphStreamPublisher::GraphStreamPublisher(const Config& config)
+    : config(config::checkValid(config)),
+      sockets_(new Sockets(config)),
+      encoder_(config.encoder) {}
+
+GraphStreamPublisher::~GraphStreamPublisher() = default;
+
+GraphDeltaHeader GraphStreamPublisher::publish(DynamicSceneGraph& graph,
+                                               bool include_mesh) {
+  // drain pending resync requests; any number of requests results in one keyframe
+  bool resync_requested = false;
+  char request;
+  while (zmq_recv(sockets_->resync, &request, sizeof(request), ZMQ_DONTWAIT) >= 0) {
+    resync_requested = true;
+  }
+
+  if (resync_requested) {
+    VLOG(2) << "[Graph Stream] keyframe requested by subscriber";
+    encoder_.requestKeyframe();
+  }
+
+  const auto header = encoder_.encode(graph, include_mesh, buffer_);
+  if (zmq_send(sockets_->pub, buffer_.data(), buffer_.size(), 0) < 0) {
+    LOG(ERROR) << "[Graph Stream] failed to send message " << header.sequence << ": "
+               << zmq_strerror(zmq_errno());
+  }
+
+  VLOG(5) << "[Graph Stream] sent " << buffer_.size() << " bytes for "
+          << (header.type == GraphDeltaType::KEYFRAME ? "keyframe " : "delta ")
+          << header.sequence;
+  return header;
+}
+
+GraphStreamSubscriber::GraphStreamSubscriber(const Config& config)
+    : config(config::checkValid(config)), sockets_(new Sockets(config)) {}
+
+GraphStreamSubscriber::~GraphStreamSubscriber() = default;
+
+bool GraphStreamSubscriber::recv(size_t timeout_ms) {
+  zmq_pollitem_t item{sockets_->sub, 0, ZMQ_POLLIN, 0};
+  const int ret = zmq_poll(&item, 1, static_cast<long>(timeout_ms));
+  if (ret <= 0 || !(item.revents & ZMQ_POLLIN)) {
+    if (!applier_.synced()) {
+      requestKeyframe();
+    }
+
+    return false;
+  }
+
+  zmq_msg_t msg;
+  zmq_msg_init(&msg);
+  if (zmq_msg_recv(&msg, sockets_->sub, 0) < 0) {
+    zmq_msg_close(&msg);
+    return false;
+  }
+
+  const auto status = applier_.apply(static_cast<const uint8_t*>(zmq_msg_data(&msg)),
+                                     zmq_msg_size(&msg));
+  zmq_msg_close(&msg);
+
+  switch (status) {
+    case GraphDeltaApplier::Status::APPLIED:
+      requested_resync_ = false;
+      return true;
+    case GraphDeltaApplier::Status::NEEDS_KEYFRAME:
+      requestKeyframe();
+      return false;
+    case GraphDeltaApplier::Status::INVALID:
+    default:
+      LOG(WARNING) << "[Graph Stream] dropping invalid message";
+      return false;
+  }
+}
+
+void GraphStreamSubscriber::requestKeyframe() {
+  const auto now = std::chrono::steady_clock::now();
+  const auto period = std::chrono::milliseconds(config.resync_period_ms);
+  if (requested_resync_ && now - last_resync_ < period) {
+    return;
+  }
+
+  const char request = 1;
+  zmq_send(sockets_->resync, &request, sizeof(request), ZMQ_DONTWAIT);
+  requested_resync_ = true;
+  last_resync_ = now;
+}
+
+#else
+
+struct GraphStreamPublisher::Sockets {};
+
+struct GraphStreamSubscriber::Sockets {};
+
+GraphStreamPublisher::GraphStreamPublisher(const Config& config)
+    : config(config), encoder_(config.encoder) {
+  throw std::runtime_error("hydra was built without zmq support");
+}
+
+GraphStreamPublisher::~GraphStreamPublisher() = default;
+
+GraphDeltaHeader GraphStreamPublisher::publish(DynamicSceneGraph&, bool) {
+  return {};
+}
+
+GraphStreamSubscriber::GraphStreamSubscriber(const Config& config) : config(config) {
+  throw std::runtime_error("hydra was built without zmq support");
+}
+
+GraphStreamSubscriber::~GraphStreamSubscriber() = default;
+
+bool GraphStreamSubscriber::recv(size_t) { return false; }
+
+void GraphStreamSubscriber::requestKeyframe() {}
+
+#endif
+
+}  // namespace hydra
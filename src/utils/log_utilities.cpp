@@ -60,6 +60,7 @@ void declare_config(LogConfig& config) {
   field(config.timing_stats_name, "timing_stats_name");
   field(config.timing_suffix, "timing_suffix");
   field(config.log_raw_timers_to_single_dir, "log_raw_timers_to_single_dir");
+  field(config.save_graph_checkpoints, "save_graph_checkpoints");
 }
 
 LogSetup::LogSetup(const LogConfig& conf) : valid_(false), config_(conf) {
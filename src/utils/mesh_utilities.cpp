@@ -80,14 +80,23 @@ bool updateObjectGeometry(const spark_dsg::Mesh& mesh,
   }
 }
 
-MeshLayer::Ptr getActiveMesh(const MeshLayer& mesh_layer,
+BlockIndices getActiveBlocks(const MeshLayer& mesh_layer,
                              const BlockIndices& archived_blocks) {
-  auto active_mesh = std::make_shared<MeshLayer>(mesh_layer.blockSize());
+  BlockIndices active;
   const BlockIndexSet archived_set(archived_blocks.begin(), archived_blocks.end());
   for (const auto& block : mesh_layer.updatedBlockIndices()) {
     if (archived_set.count(block)) {
       continue;
     }
+    active.push_back(block);
+  }
+  return active;
+}
+
+MeshLayer::Ptr getActiveMesh(const MeshLayer& mesh_layer,
+                             const BlockIndices& archived_blocks) {
+  auto active_mesh = std::make_shared<MeshLayer>(mesh_layer.blockSize());
+  for (const auto& block : getActiveBlocks(mesh_layer, archived_blocks)) {
     active_mesh->allocateBlock(block) = mesh_layer.getBlock(block);
   }
   return active_mesh;
@@ -36,6 +36,11 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <tuple>
+
 #include "hydra/utils/disjoint_set.h"
 
 namespace hydra {
@@ -94,4 +99,271 @@ MinimumSpanningTreeInfo getMinimumSpanningEdges(const SceneGraphLayer& layer,
   return info;
 }
 
+namespace {
+
+using Edge = IncrementalSpanningForest::Edge;
+
+inline Edge makeEdge(NodeId source, NodeId target) {
+  return source < target ? Edge(source, target) : Edge(target, source);
+}
+
+// ties are broken by node ids so that the minimum spanning forest is unique
+inline bool lighter(double lhs_weight,
+                    const Edge& lhs,
+                    double rhs_weight,
+                    const Edge& rhs) {
+  return std::tie(lhs_weight, lhs) < std::tie(rhs_weight, rhs);
+}
+
+const IncrementalSpanningForest::Neighbors empty_neighbors;
+
+}  // namespace
+
+void IncrementalSpanningForest::addEdge(NodeId source, NodeId target, double weight) {
+  if (source == target) {
+    return;
+  }
+
+  auto iter = graph_.find(source);
+  if (iter != graph_.end()) {
+    auto neighbor = iter->second.find(target);
+    if (neighbor != iter->second.end()) {
+      if (neighbor->second == weight) {
+        return;
+      }
+
+      removeEdge(source, target);
+    }
+  }
+
+  graph_[source][target] = weight;
+  graph_[target][source] = weight;
+
+  std::vector<NodeId> path;
+  if (!findPath(source, target, path)) {
+    link(source, target, weight);
+    return;
+  }
+
+  // the new edge replaces the heaviest edge of the cycle it closes (if lighter)
+  Edge heaviest;
+  double max_weight = 0.0;
+  for (size_t i = 0; i + 1 < path.size(); ++i) {
+    const auto edge = makeEdge(path[i], path[i + 1]);
+    const double edge_weight = forest_.at(path[i]).at(path[i + 1]);
+    if (i == 0 || lighter(max_weight, heaviest, edge_weight, edge)) {
+      heaviest = edge;
+      max_weight = edge_weight;
+    }
+  }
+
+  if (lighter(weight, makeEdge(source, target), max_weight, heaviest)) {
+    cut(heaviest.first, heaviest.second);
+    link(source, target, weight);
+  }
+}
+
+void IncrementalSpanningForest::removeEdge(NodeId source, NodeId target) {
+  if (!hasEdge(source, target)) {
+    return;
+  }
+
+  for (const auto& [lhs, rhs] : {Edge(source, target), Edge(target, source)}) {
+    auto iter = graph_.find(lhs);
+    iter->second.erase(rhs);
+    if (iter->second.empty()) {
+      graph_.erase(iter);
+    }
+  }
+
+  if (!inForest(source, target)) {
+    return;
+  }
+
+  cut(source, target);
+
+  // every edge leaving either half of the split tree connects it to the other half
+  const auto tree = getSmallerTree(source, target);
+  bool found = false;
+  Edge best;
+  double best_weight = 0.0;
+  for (const auto node : tree) {
+    for (const auto& [neighbor, weight] : neighbors(node)) {
+      if (tree.count(neighbor)) {
+        continue;
+      }
+
+      const auto edge = makeEdge(node, neighbor);
+      if (!found || lighter(weight, edge, best_weight, best)) {
+        found = true;
+        best = edge;
+        best_weight = weight;
+      }
+    }
+  }
+
+  if (found) {
+    link(best.first, best.second, best_weight);
+  }
+}
+
+void IncrementalSpanningForest::removeNode(NodeId node) {
+  std::vector<NodeId> to_remove;
+  for (const auto& id_weight_pair : neighbors(node)) {
+    to_remove.push_back(id_weight_pair.first);
+  }
+
+  for (const auto neighbor : to_remove) {
+    removeEdge(node, neighbor);
+  }
+}
+
+bool IncrementalSpanningForest::hasEdge(NodeId source, NodeId target) const {
+  return neighbors(source).count(target);
+}
+
+bool IncrementalSpanningForest::inForest(NodeId source, NodeId target) const {
+  return forestNeighbors(source).count(target);
+}
+
+size_t IncrementalSpanningForest::degree(NodeId node) const {
+  return forestNeighbors(node).size();
+}
+
+const IncrementalSpanningForest::Neighbors& IncrementalSpanningForest::neighbors(
+    NodeId node) const {
+  auto iter = graph_.find(node);
+  return iter == graph_.end() ? empty_neighbors : iter->second;
+}
+
+const IncrementalSpanningForest::Neighbors& IncrementalSpanningForest::forestNeighbors(
+    NodeId node) const {
+  auto iter = forest_.find(node);
+  return iter == forest_.end() ? empty_neighbors : iter->second;
+}
+
+std::vector<MinimalEdge> IncrementalSpanningForest::edges() const {
+  std::vector<MinimalEdge> edges;
+  for (const auto& [node, neighbors] : forest_) {
+    for (const auto& [neighbor, weight] : neighbors) {
+      if (node < neighbor) {
+        edges.emplace_back(node, neighbor, weight);
+      }
+    }
+  }
+
+  return edges;
+}
+
+void IncrementalSpanningForest::popChanges(std::vector<Edge>& added,
+                                           std::vector<Edge>& removed) {
+  added.assign(added_.begin(), added_.end());
+  removed.assign(removed_.begin(), removed_.end());
+  added_.clear();
+  removed_.clear();
+}
+
+void IncrementalSpanningForest::clear() {
+  graph_.clear();
+  forest_.clear();
+  added_.clear();
+  removed_.clear();
+}
+
+bool IncrementalSpanningForest::findPath(NodeId source,
+                                         NodeId target,
+                                         std::vector<NodeId>& path) const {
+  // searches from both ends take turns so that only the neighborhoods of the
+  // endpoints are explored when the endpoints are close in the tree
+  const std::array<NodeId, 2> roots{source, target};
+  std::array<std::unordered_map<NodeId, NodeId>, 2> parents;
+  std::array<std::deque<NodeId>, 2> queues;
+  for (size_t i = 0; i < 2; ++i) {
+    parents[i][roots[i]] = roots[i];
+    queues[i].push_back(roots[i]);
+  }
+
+  size_t side = 0;
+  while (!queues[0].empty() && !queues[1].empty()) {
+    const auto node = queues[side].front();
+    queues[side].pop_front();
+    for (const auto& id_weight_pair : forestNeighbors(node)) {
+      const auto neighbor = id_weight_pair.first;
+      if (!parents[side].emplace(neighbor, node).second) {
+        continue;
+      }
+
+      if (!parents[1 - side].count(neighbor)) {
+        queues[side].push_back(neighbor);
+        continue;
+      }
+
+      // walk back to the source and then forward to the target
+      path.clear();
+      for (NodeId curr = neighbor; curr != source; curr = parents[0].at(curr)) {
+        path.push_back(curr);
+      }
+
+      path.push_back(source);
+      std::reverse(path.begin(), path.end());
+      for (NodeId curr = neighbor; curr != target;) {
+        curr = parents[1].at(curr);
+        path.push_back(curr);
+      }
+
+      return true;
+    }
+
+    side = 1 - side;
+  }
+
+  return false;
+}
+
+std::unordered_set<NodeId> IncrementalSpanningForest::getSmallerTree(NodeId lhs,
+                                                                     NodeId rhs) const {
+  std::array<std::unordered_set<NodeId>, 2> visited{{{lhs}, {rhs}}};
+  std::array<std::deque<NodeId>, 2> queues{{{lhs}, {rhs}}};
+  size_t side = 0;
+  while (true) {
+    if (queues[side].empty()) {
+      return visited[side];
+    }
+
+    const auto node = queues[side].front();
+    queues[side].pop_front();
+    for (const auto& id_weight_pair : forestNeighbors(node)) {
+      if (visited[side].insert(id_weight_pair.first).second) {
+        queues[side].push_back(id_weight_pair.first);
+      }
+    }
+
+    side = 1 - side;
+  }
+}
+
+void IncrementalSpanningForest::link(NodeId source, NodeId target, double weight) {
+  forest_[source][target] = weight;
+  forest_[target][source] = weight;
+  const auto edge = makeEdge(source, target);
+  if (!removed_.erase(edge)) {
+    added_.insert(edge);
+  }
+}
+
+void IncrementalSpanningForest::cut(NodeId source, NodeId target) {
+  for (const auto& [lhs, rhs] : {Edge(source, target), Edge(target, source)}) {
+    auto iter = forest_.find(lhs);
+    iter->second.erase(rhs);
+    if (iter->second.empty()) {
+      forest_.erase(iter);
+    }
+  }
+
+  const auto edge = makeEdge(source, target);
+  if (!added_.erase(edge)) {
+    removed_.insert(edge);
+  }
+}
+
 }  // namespace hydra
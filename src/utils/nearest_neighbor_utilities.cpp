@@ -36,22 +36,51 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <nanoflann.hpp>
 
+#include "hydra/reconstruction/parallel_utilities.h"
+
 namespace hydra {
 
 using nanoflann::KDTreeSingleIndexAdaptor;
 using nanoflann::KDTreeSingleIndexDynamicAdaptor;
 using nanoflann::L2_Simple_Adaptor;
 
+namespace {
+
+//! Number of queries handed to a thread at a time by batch queries
+inline constexpr size_t kQueryChunkSize = 64;
+
+// Splits queries into chunks and calls the functor on each chunk (in parallel if
+// there are enough chunks). The functor receives the query range and a
+// per-thread scratch index.
+template <typename Func>
+void runChunked(size_t num_queries, int num_threads, const Func& func) {
+  const size_t num_chunks = (num_queries + kQueryChunkSize - 1) / kQueryChunkSize;
+  parallelFor(num_chunks, num_threads, [&](size_t chunk, size_t thread_idx) {
+    const size_t start = chunk * kQueryChunkSize;
+    const size_t end = std::min(num_queries, start + kQueryChunkSize);
+    func(start, end, thread_idx);
+  });
+}
+
+}  // namespace
+
+// Keeps a contiguous copy of the node positions so that tree construction and
+// traversal do not go through the layer's node map
 struct GraphKdTreeAdaptor {
   GraphKdTreeAdaptor(const SceneGraphLayer& layer, const std::vector<NodeId>& nodes)
-      : layer(layer), nodes(nodes) {}
+      : nodes(nodes), coords(3 * nodes.size()) {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      Eigen::Map<Eigen::Vector3d>(coords.data() + 3 * i) = layer.getPosition(nodes[i]);
+    }
+  }
 
   inline size_t kdtree_get_point_count() const { return nodes.size(); }
 
   inline double kdtree_get_pt(const size_t idx, const size_t dim) const {
-    return layer.getPosition(nodes[idx])(dim);
+    return coords[3 * idx + dim];
   }
 
   template <class T>
@@ -59,8 +88,8 @@ struct GraphKdTreeAdaptor {
     return false;
   }
 
-  const SceneGraphLayer& layer;
   std::vector<NodeId> nodes;
+  std::vector<double> coords;
 };
 
 struct NearestNodeFinder::Detail {
@@ -147,6 +176,58 @@ size_t NearestNodeFinder::findRadius(const Eigen::Vector3d& position,
   }
 }
 
+void NearestNodeFinder::findBatch(const Eigen::Ref<const Queries>& positions,
+                                  size_t num_to_find,
+                                  bool skip_first,
+                                  NeighborBatch<double>& result,
+                                  int num_threads) const {
+  findBatch(positions,
+            num_to_find,
+            std::vector<bool>(positions.cols(), skip_first),
+            result,
+            num_threads);
+}
+
+void NearestNodeFinder::findBatch(const Eigen::Ref<const Queries>& positions,
+                                  size_t num_to_find,
+                                  const std::vector<bool>& skip_first,
+                                  NeighborBatch<double>& result,
+                                  int num_threads) const {
+  const size_t num_queries = positions.cols();
+  CHECK_EQ(skip_first.size(), num_queries) << "skip flags must match queries";
+  result.resize(num_queries, num_to_find);
+  if (num_to_find == 0) {
+    return;
+  }
+
+  const size_t limit = num_to_find + 1;
+  const size_t max_threads = getNumWorkers(num_threads, num_queries);
+  // scratch space per thread so queries don't allocate
+  std::vector<size_t> scratch_indices(max_threads * limit);
+  std::vector<double> scratch_distances(max_threads * limit);
+
+  const auto& kdtree = *internals_->kdtree;
+  runChunked(num_queries, num_threads, [&](size_t start, size_t end, size_t thread) {
+    size_t* indices = scratch_indices.data() + thread * limit;
+    double* distances = scratch_distances.data() + thread * limit;
+    for (size_t q = start; q < end; ++q) {
+      const size_t offset = skip_first[q] ? 1 : 0;
+      const Eigen::Vector3d query = positions.col(q);
+      const size_t num_found =
+          kdtree.knnSearch(query.data(), num_to_find + offset, indices, distances);
+      const size_t num_valid = num_found > offset ? num_found - offset : 0;
+      std::copy_n(indices + offset, num_valid, result.indices.begin() + q * result.k);
+      std::copy_n(
+          distances + offset, num_valid, result.distances.begin() + q * result.k);
+      result.num_found[q] = num_valid;
+    }
+  });
+}
+
+NodeId NearestNodeFinder::nodeId(size_t index) const {
+  return internals_->adaptor.nodes.at(index);
+}
+
 size_t makeSemanticNodeFinders(const SceneGraphLayer& layer,
                                SemanticNodeFinders& finders,
                                bool use_active) {
@@ -180,20 +261,23 @@ size_t makeSemanticNodeFinders(const SceneGraphLayer& layer,
 struct PointNeighborSearch::Detail {
   // Nanoflann interface.
   explicit Detail(const std::vector<Eigen::Vector3f>& points)
-      : points_(points),
+      : coords_(flatten(points)),
         tree_(3, *this, nanoflann::KDTreeSingleIndexAdaptorParams(10)) {
     tree_.buildIndex();
   }
 
-  std::size_t kdtree_get_point_count() const { return points_.size(); }
+  static std::vector<float> flatten(const std::vector<Eigen::Vector3f>& points) {
+    std::vector<float> coords(3 * points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+      Eigen::Map<Eigen::Vector3f>(coords.data() + 3 * i) = points[i];
+    }
+    return coords;
+  }
+
+  std::size_t kdtree_get_point_count() const { return coords_.size() / 3; }
 
   float kdtree_get_pt(const size_t idx, const size_t dim) const {
-    if (dim == 0)
-      return points_[idx].x();
-    else if (dim == 1)
-      return points_[idx].y();
-    else
-      return points_[idx].z();
+    return coords_[3 * idx + dim];
   }
 
   template <class BBOX>
@@ -201,7 +285,8 @@ struct PointNeighborSearch::Detail {
     return false;
   }
 
-  const std::vector<Eigen::Vector3f>& points_;
+  // contiguous copy of the points (x, y, z per point)
+  std::vector<float> coords_;
   KDTreeSingleIndexAdaptor<L2_Simple_Adaptor<float, Detail>, Detail, 3> tree_;
 };
 
@@ -220,4 +305,26 @@ bool PointNeighborSearch::search(const Eigen::Vector3f& query_point,
   return internals_->tree_.findNeighbors(resultSet, &query_point_arr[0]);
 }
 
+void PointNeighborSearch::searchBatch(const Eigen::Ref<const Queries>& query_points,
+                                      size_t k,
+                                      NeighborBatch<float>& result,
+                                      int num_threads) const {
+  const size_t num_queries = query_points.cols();
+  result.resize(num_queries, k);
+  if (k == 0) {
+    return;
+  }
+
+  const auto& tree = internals_->tree_;
+  runChunked(num_queries, num_threads, [&](size_t start, size_t end, size_t) {
+    nanoflann::KNNResultSet<float> result_set(k);
+    for (size_t q = start; q < end; ++q) {
+      const Eigen::Vector3f query = query_points.col(q);
+      result_set.init(result.indices.data() + q * k, result.distances.data() + q * k);
+      tree.findNeighbors(result_set, query.data());
+      result.num_found[q] = result_set.size();
+    }
+  });
+}
+
 }  // namespace hydra
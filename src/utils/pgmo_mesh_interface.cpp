@@ -35,8 +35,33 @@
 
 #include "hydra/utils/pgmo_mesh_interface.h"
 
+#include <algorithm>
+
 namespace hydra {
 
+MeshBlockView::MeshBlockView(const Mesh& mesh)
+    : size(mesh.points.size()),
+      points(mesh.points.data()),
+      colors(mesh.colors.size() < size ? nullptr : mesh.colors.data()),
+      labels(mesh.labels.data()),
+      num_labels(std::min(mesh.labels.size(), size)) {}
+
+pcl::PointXYZRGBA MeshBlockView::vertex(size_t index) const {
+  pcl::PointXYZRGBA point;
+  const auto& pos = points[index];
+  point.x = pos(0);
+  point.y = pos(1);
+  point.z = pos(2);
+  if (colors) {
+    const auto& color = colors[index];
+    point.r = color.r;
+    point.g = color.g;
+    point.b = color.b;
+    point.a = color.a;
+  }
+  return point;
+}
+
 PgmoMeshLayerInterface::PgmoMeshLayerInterface(const MeshLayer& mesh) : mesh_(mesh) {
   block_indices_ = mesh.allocatedBlockIndices();
 }
@@ -46,32 +71,24 @@ const BlockIndices& PgmoMeshLayerInterface::blockIndices() const {
 }
 
 void PgmoMeshLayerInterface::markBlockActive(const BlockIndex& block) const {
-  active_mesh_ = mesh_.getBlockPtr(block);
+  // only the raw vertex arrays are kept (the layer owns the block)
+  const auto block_ptr = mesh_.getBlockPtr(block);
+  active_view_ = block_ptr ? MeshBlockView(*block_ptr) : MeshBlockView();
 }
 
 size_t PgmoMeshLayerInterface::activeBlockSize() const {
   // Assumes we mark the active block first.
-  return active_mesh_->points.size();
+  return active_view_.size;
 }
 
 pcl::PointXYZRGBA PgmoMeshLayerInterface::getActiveVertex(size_t index) const {
   // Assumes we mark the active block first.
-  pcl::PointXYZRGBA point;
-  const auto& pos = active_mesh_->points[index];
-  point.x = pos(0);
-  point.y = pos(1);
-  point.z = pos(2);
-  const auto& color = active_mesh_->colors[index];
-  point.r = color.r;
-  point.g = color.g;
-  point.b = color.b;
-  point.a = color.a;
-  return point;
+  return active_view_.vertex(index);
 };
 
 std::optional<uint32_t> PgmoMeshLayerInterface::getActiveSemantics(size_t index) const {
-  if (index < active_mesh_->labels.size()) {
-    return active_mesh_->labels[index];
+  if (index < active_view_.num_labels) {
+    return active_view_.labels[index];
   }
   return std::nullopt;
 }
@@ -87,7 +104,7 @@ kimera_pgmo::MeshInterface::Ptr PgmoMeshLayerInterface::clone() const {
   return std::make_shared<PgmoMeshLayerInterface>(*this);
 }
 
-PgmoMeshInterface::PgmoMeshInterface(const Mesh& mesh) : mesh_(mesh) {
+PgmoMeshInterface::PgmoMeshInterface(const Mesh& mesh) : mesh_(mesh), view_(mesh) {
   block_indices_ = {BlockIndex(0, 0, 0)};
 }
 
@@ -95,27 +112,17 @@ const BlockIndices& PgmoMeshInterface::blockIndices() const { return block_indic
 
 size_t PgmoMeshInterface::activeBlockSize() const {
   // Assumes we mark the active block first.
-  return mesh_.numVertices();
+  return view_.size;
 }
 
 pcl::PointXYZRGBA PgmoMeshInterface::getActiveVertex(size_t index) const {
   // Assumes we mark the active block first.
-  pcl::PointXYZRGBA point;
-  const auto& pos = mesh_.pos(index);
-  point.x = pos(0);
-  point.y = pos(1);
-  point.z = pos(2);
-  const auto& color = mesh_.color(index);
-  point.r = color.r;
-  point.g = color.g;
-  point.b = color.b;
-  point.a = color.a;
-  return point;
+  return view_.vertex(index);
 };
 
 std::optional<uint32_t> PgmoMeshInterface::getActiveSemantics(size_t index) const {
-  if (index < mesh_.labels.size()) {
-    return mesh_.label(index);
+  if (index < view_.num_labels) {
+    return view_.labels[index];
   }
   return std::nullopt;
 }
@@ -126,4 +133,104 @@ kimera_pgmo::MeshInterface::Ptr PgmoMeshInterface::clone() const {
   return std::make_shared<PgmoMeshInterface>(*this);
 }
 
+PgmoMeshSnapshot::PgmoMeshSnapshot(const MeshLayer& mesh)
+    : PgmoMeshSnapshot(mesh, mesh.allocatedBlockIndices()) {}
+
+PgmoMeshSnapshot::PgmoMeshSnapshot(const MeshLayer& mesh, const BlockIndices& blocks)
+    : has_semantics_(mesh.numBlocks() > 0 && mesh.begin()->has_labels) {
+  std::vector<const MeshBlock*> to_pack;
+  to_pack.reserve(blocks.size());
+  size_t num_vertices = 0;
+  for (const auto& index : blocks) {
+    const auto block = mesh.getBlockPtr(index);
+    if (!block) {
+      continue;
+    }
+
+    to_pack.push_back(block.get());
+    block_indices_.push_back(index);
+    num_vertices += block->points.size();
+  }
+
+  vertices_.resize(num_vertices);
+  if (has_semantics_) {
+    labels_.resize(num_vertices);
+  }
+
+  size_t offset = 0;
+  for (size_t i = 0; i < to_pack.size(); ++i) {
+    const MeshBlockView view(*to_pack[i]);
+    auto& range = blocks_[block_indices_[i]];
+    range.offset = offset;
+    range.size = view.size;
+    for (size_t v = 0; v < view.size; ++v) {
+      vertices_[offset + v] = view.vertex(v);
+    }
+
+    if (has_semantics_) {
+      range.num_labels = view.num_labels;
+      std::copy_n(view.labels, view.num_labels, labels_.begin() + offset);
+    }
+
+    offset += view.size;
+  }
+}
+
+const PgmoMeshSnapshot::BlockRange* PgmoMeshSnapshot::findBlock(
+    const BlockIndex& block) const {
+  const auto iter = blocks_.find(block);
+  return iter == blocks_.end() ? nullptr : &iter->second;
+}
+
+PgmoMeshSnapshotInterface::PgmoMeshSnapshotInterface(
+    const PgmoMeshSnapshot::Ptr& snapshot)
+    : PgmoMeshSnapshotInterface(snapshot, snapshot->blockIndices()) {}
+
+PgmoMeshSnapshotInterface::PgmoMeshSnapshotInterface(
+    const PgmoMeshSnapshot::Ptr& snapshot, const BlockIndices& blocks)
+    : snapshot_(snapshot) {
+  // only expose blocks that were packed
+  block_indices_.reserve(blocks.size());
+  for (const auto& block : blocks) {
+    if (snapshot_->findBlock(block)) {
+      block_indices_.push_back(block);
+    }
+  }
+}
+
+const BlockIndices& PgmoMeshSnapshotInterface::blockIndices() const {
+  return block_indices_;
+}
+
+void PgmoMeshSnapshotInterface::markBlockActive(const BlockIndex& block) const {
+  const auto range = snapshot_->findBlock(block);
+  active_block_ = range ? *range : PgmoMeshSnapshot::BlockRange();
+}
+
+size_t PgmoMeshSnapshotInterface::activeBlockSize() const {
+  // Assumes we mark the active block first.
+  return active_block_.size;
+}
+
+pcl::PointXYZRGBA PgmoMeshSnapshotInterface::getActiveVertex(size_t index) const {
+  // Assumes we mark the active block first.
+  return snapshot_->vertex(active_block_.offset + index);
+}
+
+bool PgmoMeshSnapshotInterface::hasSemantics() const {
+  return snapshot_->hasSemantics();
+}
+
+std::optional<uint32_t> PgmoMeshSnapshotInterface::getActiveSemantics(
+    size_t index) const {
+  if (index < active_block_.num_labels) {
+    return snapshot_->label(active_block_.offset + index);
+  }
+  return std::nullopt;
+}
+
+kimera_pgmo::MeshInterface::Ptr PgmoMeshSnapshotInterface::clone() const {
+  return std::make_shared<PgmoMeshSnapshotInterface>(*this);
+}
+
 }  // namespace hydra
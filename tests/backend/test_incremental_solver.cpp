@@ -0,0 +1,202 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <gtsam/base/Testable.h>
+#include <gtsam/nonlinear/LevenbergMarquardtOptimizer.h>
+#include <gtsam/slam/BetweenFactor.h>
+#include <gtsam/slam/PriorFactor.h>
+#include <hydra/backend/incremental_solver.h>
+
+namespace hydra {
+
+namespace {
+
+using Between = gtsam::BetweenFactor<gtsam::Pose3>;
+using Prior = gtsam::PriorFactor<gtsam::Pose3>;
+
+const auto kNoise = gtsam::noiseModel::Isotropic::Variance(6, 1.0e-2);
+
+gtsam::Pose3 step() {
+  return gtsam::Pose3(gtsam::Rot3::Yaw(0.1), gtsam::Point3(1.0, 0.0, 0.0));
+}
+
+void addChain(size_t start,
+              size_t end,
+              gtsam::NonlinearFactorGraph& factors,
+              gtsam::Values& values) {
+  for (size_t i = start; i < end; ++i) {
+    factors.emplace_shared<Between>(i, i + 1, step(), kNoise);
+    // initial guess is slightly off so the solver has something to do
+    const gtsam::Pose3 error(gtsam::Rot3(), gtsam::Point3(0.05, -0.05, 0.0));
+    values.insert(i + 1, values.at<gtsam::Pose3>(i) * step() * error);
+  }
+}
+
+gtsam::Values batchSolve(const gtsam::NonlinearFactorGraph& factors,
+                         const gtsam::Values& values) {
+  return gtsam::LevenbergMarquardtOptimizer(factors, values).optimize();
+}
+
+}  // namespace
+
+TEST(IncrementalSolver, UpdateMatchesBatch) {
+  gtsam::NonlinearFactorGraph factors;
+  gtsam::Values values;
+  factors.emplace_shared<Prior>(0, gtsam::Pose3(), kNoise);
+  values.insert(0, gtsam::Pose3());
+  addChain(0, 10, factors, values);
+
+  IncrementalSolver::Config config;
+  config.batch_threshold = 0.5;
+  IncrementalSolver solver(config);
+  EXPECT_FALSE(solver.initialized());
+  EXPECT_FALSE(solver.update(factors, values, {}, {}));
+
+  auto result = batchSolve(factors, values);
+  solver.reset(factors, result, {}, {});
+  ASSERT_TRUE(solver.initialized());
+  EXPECT_EQ(solver.numFactors(), 11u);
+
+  // new factors keep the optimized values of the old variables as their seed
+  for (const auto key : result.keys()) {
+    values.update(key, result.at(key));
+  }
+
+  addChain(10, 13, factors, values);
+  ASSERT_TRUE(solver.update(factors, values, {}, {}));
+  EXPECT_EQ(solver.numLastChanged(), 3u);
+  EXPECT_EQ(solver.numFactors(), 14u);
+
+  const auto expected = batchSolve(factors, values);
+  ASSERT_EQ(solver.values().size(), expected.size());
+  for (const auto key : expected.keys()) {
+    EXPECT_TRUE(gtsam::assert_equal(expected.at<gtsam::Pose3>(key),
+                                    solver.values().at<gtsam::Pose3>(key),
+                                    1.0e-4));
+  }
+}
+
+TEST(IncrementalSolver, RebuiltTempFactorsUnchanged) {
+  gtsam::NonlinearFactorGraph factors;
+  gtsam::Values values;
+  factors.emplace_shared<Prior>(0, gtsam::Pose3(), kNoise);
+  values.insert(0, gtsam::Pose3());
+  addChain(0, 4, factors, values);
+  values = batchSolve(factors, values);
+
+  const gtsam::Pose3 offset(gtsam::Rot3(), gtsam::Point3(0.0, 1.0, 0.0));
+  gtsam::NonlinearFactorGraph temp_factors;
+  gtsam::Values temp_values;
+  temp_factors.emplace_shared<Between>(2, 100, offset, kNoise);
+  temp_values.insert(100, values.at<gtsam::Pose3>(2) * offset);
+
+  IncrementalSolver::Config config;
+  config.batch_threshold = 0.5;
+  IncrementalSolver solver(config);
+  solver.reset(factors, values, temp_factors, temp_values);
+  ASSERT_TRUE(solver.initialized());
+
+  // an identical copy of the temporary factor is not a change
+  gtsam::NonlinearFactorGraph rebuilt;
+  rebuilt.emplace_shared<Between>(2, 100, offset, kNoise);
+  ASSERT_TRUE(solver.update(factors, values, rebuilt, temp_values));
+  EXPECT_EQ(solver.numLastChanged(), 0u);
+  EXPECT_EQ(solver.numFactors(), 6u);
+  EXPECT_TRUE(gtsam::assert_equal(temp_values.at<gtsam::Pose3>(100),
+                                  solver.tempValues().at<gtsam::Pose3>(100),
+                                  1.0e-6));
+
+  // a moved place replaces the old factor
+  const gtsam::Pose3 new_offset(gtsam::Rot3(), gtsam::Point3(0.0, 1.1, 0.0));
+  gtsam::NonlinearFactorGraph moved;
+  moved.emplace_shared<Between>(2, 100, new_offset, kNoise);
+  ASSERT_TRUE(solver.update(factors, values, moved, temp_values));
+  EXPECT_EQ(solver.numLastChanged(), 2u);
+  EXPECT_EQ(solver.numFactors(), 6u);
+  EXPECT_TRUE(gtsam::assert_equal(values.at<gtsam::Pose3>(2) * new_offset,
+                                  solver.tempValues().at<gtsam::Pose3>(100),
+                                  1.0e-4));
+
+  // a removed place is no longer reported
+  ASSERT_TRUE(solver.update(factors, values, {}, {}));
+  EXPECT_EQ(solver.numFactors(), 5u);
+  EXPECT_TRUE(solver.tempValues().empty());
+  EXPECT_EQ(solver.values().size(), values.size());
+}
+
+TEST(IncrementalSolver, LargeChangeRequestsBatch) {
+  gtsam::NonlinearFactorGraph factors;
+  gtsam::Values values;
+  factors.emplace_shared<Prior>(0, gtsam::Pose3(), kNoise);
+  values.insert(0, gtsam::Pose3());
+  addChain(0, 4, factors, values);
+
+  IncrementalSolver::Config config;
+  config.batch_threshold = 0.5;
+  IncrementalSolver solver(config);
+  solver.reset(factors, values, {}, {});
+  ASSERT_TRUE(solver.initialized());
+
+  addChain(4, 8, factors, values);
+  EXPECT_FALSE(solver.update(factors, values, {}, {}));
+  EXPECT_EQ(solver.numLastChanged(), 4u);
+  // the solver state is untouched
+  EXPECT_EQ(solver.numFactors(), 5u);
+}
+
+TEST(IncrementalSolver, RejectedFactorsIgnored) {
+  gtsam::NonlinearFactorGraph factors;
+  gtsam::Values values;
+  factors.emplace_shared<Prior>(0, gtsam::Pose3(), kNoise);
+  values.insert(0, gtsam::Pose3());
+  addChain(0, 4, factors, values);
+  // outlier loop closure
+  factors.emplace_shared<Between>(0, 4, gtsam::Pose3(), kNoise);
+  values = batchSolve(factors, values);
+
+  gtsam::Vector weights = gtsam::Vector::Ones(factors.size());
+  weights(factors.size() - 1) = 0.0;
+
+  IncrementalSolver solver(IncrementalSolver::Config{});
+  solver.reset(factors, values, {}, {}, weights);
+  ASSERT_TRUE(solver.initialized());
+  EXPECT_EQ(solver.numFactors(), 5u);
+
+  ASSERT_TRUE(solver.update(factors, values, {}, {}));
+  EXPECT_EQ(solver.numLastChanged(), 0u);
+  EXPECT_EQ(solver.numFactors(), 5u);
+}
+
+}  // namespace hydra
@@ -0,0 +1,138 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/backend/merge_tracker.h>
+
+#include <algorithm>
+
+namespace hydra {
+
+TEST(MergeRegistry, FindRepresentatives) {
+  MergeRegistry registry;
+  EXPECT_EQ(registry.find(1), 1u);
+  EXPECT_FALSE(registry.merged(1));
+
+  EXPECT_TRUE(registry.merge(1, 2));
+  EXPECT_TRUE(registry.merge(3, 4));
+  EXPECT_TRUE(registry.merge(2, 4));
+  EXPECT_FALSE(registry.merge(1, 3));
+
+  for (NodeId node = 1; node <= 4; ++node) {
+    EXPECT_EQ(registry.find(node), 4u);
+  }
+
+  EXPECT_TRUE(registry.merged(1));
+  EXPECT_FALSE(registry.merged(4));
+  EXPECT_EQ(registry.size(), 3u);
+
+  auto members = registry.members(4);
+  std::sort(members.begin(), members.end());
+  std::vector<NodeId> expected{1, 2, 3};
+  EXPECT_EQ(members, expected);
+  EXPECT_TRUE(registry.members(2).empty());
+}
+
+TEST(MergeRegistry, ExportMatchesFind) {
+  MergeRegistry registry;
+  std::map<NodeId, NodeId> merges;
+
+  // long chain of merges into new representatives
+  for (NodeId node = 0; node < 20; ++node) {
+    registry.merge(node, node + 1);
+    if (node % 3 == 0) {
+      registry.exportMerges(merges);
+    }
+  }
+
+  registry.exportMerges(merges);
+  EXPECT_EQ(merges.size(), 20u);
+  for (const auto& [node, representative] : merges) {
+    EXPECT_EQ(representative, 20u);
+    EXPECT_EQ(registry.find(node), 20u);
+  }
+}
+
+TEST(MergeRegistry, Undo) {
+  MergeRegistry registry;
+  std::map<NodeId, NodeId> merges;
+  registry.merge(1, 2);
+  registry.merge(2, 3);
+  registry.merge(4, 3);
+  registry.exportMerges(merges);
+
+  EXPECT_FALSE(registry.undo(3));
+  EXPECT_FALSE(registry.undo(5));
+  EXPECT_TRUE(registry.undo(2));
+  registry.exportMerges(merges);
+
+  // nodes previously merged through the undone node keep their representative
+  EXPECT_EQ(registry.find(1), 3u);
+  EXPECT_EQ(registry.find(2), 2u);
+  EXPECT_EQ(registry.find(4), 3u);
+  std::map<NodeId, NodeId> expected{{1, 3}, {4, 3}};
+  EXPECT_EQ(merges, expected);
+
+  // undone nodes can be merged again
+  EXPECT_TRUE(registry.merge(2, 4));
+  registry.exportMerges(merges);
+  expected[2] = 3;
+  EXPECT_EQ(merges, expected);
+}
+
+TEST(MergeRegistry, Compact) {
+  MergeRegistry registry;
+  std::map<NodeId, NodeId> merges;
+  registry.merge(1, 2);
+  registry.merge(2, 3);
+  registry.merge(4, 5);
+  registry.exportMerges(merges);
+  EXPECT_EQ(merges.size(), 3u);
+
+  // node 2 was the parent of node 1 before compression
+  const std::set<NodeId> kept{1, 3, 5};
+  const auto num_removed =
+      registry.compact([&](NodeId node) { return kept.count(node) > 0; });
+  registry.exportMerges(merges);
+
+  EXPECT_EQ(num_removed, 2u);
+  EXPECT_EQ(registry.size(), 1u);
+  EXPECT_EQ(registry.find(1), 3u);
+  EXPECT_EQ(registry.find(4), 4u);
+  EXPECT_TRUE(registry.members(5).empty());
+  std::map<NodeId, NodeId> expected{{1, 3}};
+  EXPECT_EQ(merges, expected);
+}
+
+}  // namespace hydra
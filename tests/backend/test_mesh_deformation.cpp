@@ -0,0 +1,237 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <gtsam/inference/Symbol.h>
+#include <hydra/backend/mesh_deformation.h>
+#include <hydra/utils/pgmo_mesh_traits.h>
+#include <kimera_pgmo/deformation_graph.h>
+
+#include <random>
+
+namespace hydra {
+
+namespace {
+
+inline constexpr char kVertexPrefix = 'v';
+
+struct DeformationInputs {
+  pcl::PointCloud<pcl::PointXYZ> vertices;
+  std::vector<uint64_t> stamps;
+  std::vector<gtsam::Key> keys;
+  gtsam::Values values;
+};
+
+// control points along a line one second apart with vertices scattered around them
+DeformationInputs makeInputs(MeshDeformer& deformer,
+                             size_t num_controls,
+                             size_t num_vertices) {
+  DeformationInputs inputs;
+  for (size_t i = 0; i < num_controls; ++i) {
+    const gtsam::Key key = gtsam::Symbol(kVertexPrefix, i);
+    const Eigen::Vector3d pos(static_cast<double>(i), 0.0, 0.0);
+    const uint64_t stamp_ns = i * 1000000000ull;
+    deformer.addControlPoint(key, stamp_ns, pos);
+    inputs.keys.push_back(key);
+    // bend the line a little
+    const gtsam::Rot3 rot = gtsam::Rot3::Yaw(0.02 * i);
+    const Eigen::Vector3d bend(0.0, 0.1 * i, 0.0);
+    inputs.values.insert(key, gtsam::Pose3(rot, pos + bend));
+  }
+
+  std::mt19937 gen(12345);
+  std::uniform_real_distribution<double> offset(-0.5, 0.5);
+  std::uniform_real_distribution<double> x(0.0, num_controls - 1.0);
+  for (size_t i = 0; i < num_vertices; ++i) {
+    const double vx = x(gen);
+    inputs.vertices.push_back(pcl::PointXYZ(vx, offset(gen), offset(gen)));
+    inputs.stamps.push_back(static_cast<uint64_t>(vx * 1.0e9));
+  }
+
+  return inputs;
+}
+
+// reference deformation graph with the same control points as makeInputs
+void addControlPoints(kimera_pgmo::DeformationGraph& graph, size_t num_controls) {
+  std::vector<std::pair<gtsam::Key, gtsam::Key>> edges;
+  gtsam::Values nodes;
+  std::vector<kimera_pgmo::Timestamp> stamps;
+  for (size_t i = 0; i < num_controls; ++i) {
+    const gtsam::Symbol key(kVertexPrefix, i);
+    nodes.insert(key, gtsam::Pose3(gtsam::Rot3(), gtsam::Point3(1.0 * i, 0.0, 0.0)));
+    stamps.push_back(i * 1000000000ull);
+    if (i > 0) {
+      edges.emplace_back(gtsam::Symbol(kVertexPrefix, i - 1), key);
+    }
+  }
+
+  gtsam::Values added_vertices;
+  gtsam::NonlinearFactorGraph added_factors;
+  graph.addNewMeshEdgesAndNodes(edges, nodes, stamps, &added_vertices, &added_factors);
+}
+
+spark_dsg::Mesh makeMesh(size_t num_vertices) {
+  spark_dsg::Mesh mesh;
+  mesh.resizeVertices(num_vertices);
+  return mesh;
+}
+
+}  // namespace
+
+TEST(MeshDeformer, ParallelMatchesSerial) {
+  MeshDeformer::Config config;
+  config.chunk_size = 16;
+  config.num_threads = 1;
+  MeshDeformer serial(config, 4, 3.0);
+  config.num_threads = 4;
+  MeshDeformer parallel(config, 4, 3.0);
+
+  const auto inputs = makeInputs(serial, 20, 1000);
+  makeInputs(parallel, 20, 0);
+
+  auto serial_mesh = makeMesh(inputs.vertices.size());
+  auto parallel_mesh = makeMesh(inputs.vertices.size());
+  serial.deform(inputs.vertices, inputs.stamps, inputs.values, 500, serial_mesh);
+  parallel.deform(inputs.vertices, inputs.stamps, inputs.values, 500, parallel_mesh);
+  EXPECT_EQ(serial.numLastDeformed(), 1000u);
+  EXPECT_EQ(parallel.numLastDeformed(), 1000u);
+
+  for (size_t i = 0; i < inputs.vertices.size(); ++i) {
+    EXPECT_EQ(serial_mesh.pos(i), parallel_mesh.pos(i)) << "vertex " << i;
+  }
+}
+
+TEST(MeshDeformer, MatchesPgmoDeformation) {
+  MeshDeformer::Config config;
+  config.chunk_size = 16;
+  config.num_threads = 4;
+  MeshDeformer deformer(config, 4, 3.0);
+  const auto inputs = makeInputs(deformer, 20, 1000);
+  const size_t num_vertices = inputs.vertices.size();
+
+  kimera_pgmo::DeformationGraph graph;
+  addControlPoints(graph, 20);
+  auto expected = makeMesh(num_vertices);
+  kimera_pgmo::ConstStampedCloud<pcl::PointXYZ> cloud{inputs.vertices, inputs.stamps};
+  graph.deformPoints(
+      expected, cloud, kVertexPrefix, inputs.values, 4, 3.0, nullptr, 0);
+
+  auto mesh = makeMesh(num_vertices);
+  deformer.deform(inputs.vertices, inputs.stamps, inputs.values, 500, mesh);
+  for (size_t i = 0; i < num_vertices; ++i) {
+    EXPECT_NEAR((mesh.pos(i) - expected.pos(i)).norm(), 0.0, 1.0e-5) << "vertex " << i;
+  }
+
+  // skipping unchanged vertices still tracks the serial deformation
+  const gtsam::Pose3 shift(gtsam::Rot3::Roll(0.05), gtsam::Point3(0.0, 0.0, 0.2));
+  auto values = inputs.values;
+  for (size_t i = 10; i < 20; ++i) {
+    const gtsam::Symbol key(kVertexPrefix, i);
+    values.update(key, shift * values.at<gtsam::Pose3>(key));
+  }
+
+  graph.deformPoints(expected, cloud, kVertexPrefix, values, 4, 3.0, nullptr, 0);
+  deformer.deform(inputs.vertices, inputs.stamps, values, 500, mesh);
+  EXPECT_LT(deformer.numLastDeformed(), num_vertices);
+  for (size_t i = 0; i < num_vertices; ++i) {
+    EXPECT_NEAR((mesh.pos(i) - expected.pos(i)).norm(), 0.0, 1.0e-5) << "vertex " << i;
+  }
+}
+
+TEST(MeshDeformer, RigidTransformExact) {
+  MeshDeformer deformer(MeshDeformer::Config(), 4, 3.0);
+  auto inputs = makeInputs(deformer, 10, 200);
+
+  const gtsam::Pose3 world_T_map(gtsam::Rot3::Yaw(0.3), gtsam::Point3(1.0, -2.0, 0.5));
+  for (size_t i = 0; i < inputs.keys.size(); ++i) {
+    const gtsam::Pose3 initial(gtsam::Rot3(), gtsam::Point3(1.0 * i, 0.0, 0.0));
+    inputs.values.update(inputs.keys[i], world_T_map * initial);
+  }
+
+  auto mesh = makeMesh(inputs.vertices.size());
+  deformer.deform(inputs.vertices, inputs.stamps, inputs.values, 0, mesh);
+  for (size_t i = 0; i < inputs.vertices.size(); ++i) {
+    const auto& p = inputs.vertices[i];
+    const gtsam::Point3 pos(p.x, p.y, p.z);
+    const Eigen::Vector3d expected = world_T_map.transformFrom(pos);
+    EXPECT_NEAR((mesh.pos(i).cast<double>() - expected).norm(), 0.0, 1.0e-5);
+  }
+}
+
+TEST(MeshDeformer, SkipsUnchangedVertices) {
+  MeshDeformer::Config config;
+  config.num_threads = 2;
+  config.chunk_size = 32;
+  MeshDeformer deformer(config, 4, 2.0);
+  auto inputs = makeInputs(deformer, 30, 500);
+  const size_t num_vertices = inputs.vertices.size();
+
+  auto mesh = makeMesh(num_vertices);
+  deformer.deform(inputs.vertices, inputs.stamps, inputs.values, num_vertices, mesh);
+  EXPECT_EQ(deformer.numLastDeformed(), num_vertices);
+
+  // only vertices that can still see new control points are redeformed
+  size_t num_open = 0;
+  for (const auto stamp : inputs.stamps) {
+    num_open += (stamp + 2000000000ull >= 29000000000ull) ? 1 : 0;
+  }
+
+  deformer.deform(inputs.vertices, inputs.stamps, inputs.values, num_vertices, mesh);
+  EXPECT_EQ(deformer.numLastDeformed(), num_open);
+
+  // moving a control point only touches its neighbors, but matches a full update
+  const gtsam::Pose3 prev = inputs.values.at<gtsam::Pose3>(inputs.keys[10]);
+  const gtsam::Pose3 shift(gtsam::Rot3(), gtsam::Point3(0.0, 0.0, 0.2));
+  inputs.values.update(inputs.keys[10], shift * prev);
+  deformer.deform(inputs.vertices, inputs.stamps, inputs.values, num_vertices, mesh);
+  EXPECT_GT(deformer.numLastDeformed(), num_open);
+  EXPECT_LT(deformer.numLastDeformed(), num_vertices);
+
+  MeshDeformer fresh(config, 4, 2.0);
+  makeInputs(fresh, 30, 0);
+  auto expected = makeMesh(num_vertices);
+  fresh.deform(inputs.vertices, inputs.stamps, inputs.values, num_vertices, expected);
+  for (size_t i = 0; i < num_vertices; ++i) {
+    EXPECT_EQ(mesh.pos(i), expected.pos(i)) << "vertex " << i;
+  }
+
+  // movements below the threshold are ignored
+  const gtsam::Pose3 moved = inputs.values.at<gtsam::Pose3>(inputs.keys[10]);
+  const gtsam::Pose3 nudge(gtsam::Rot3(), gtsam::Point3(0.0, 0.0, 1.0e-5));
+  inputs.values.update(inputs.keys[10], nudge * moved);
+  deformer.deform(inputs.vertices, inputs.stamps, inputs.values, num_vertices, mesh);
+  EXPECT_EQ(deformer.numLastDeformed(), num_open);
+}
+
+}  // namespace hydra
@@ -0,0 +1,233 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/backend/place_deformation_graph.h>
+
+#include <random>
+#include <set>
+
+namespace hydra {
+
+namespace {
+
+using EdgeSet = std::set<std::pair<NodeId, NodeId>>;
+
+void addPlace(IsolatedSceneGraphLayer& layer,
+              NodeId node,
+              const Eigen::Vector3d& pos,
+              bool active = false,
+              const std::vector<size_t>& connections = {}) {
+  auto attrs = std::make_unique<PlaceNodeAttributes>(0.0, 0.0);
+  attrs->position = pos;
+  attrs->is_active = active;
+  attrs->deformation_connections = connections;
+  layer.emplaceNode(node, std::move(attrs));
+}
+
+EdgeSet getEdges(const std::vector<MinimalEdge>& edges) {
+  EdgeSet result;
+  for (const auto& edge : edges) {
+    const auto source = std::min(edge.source, edge.target);
+    result.emplace(source, std::max(edge.source, edge.target));
+  }
+
+  return result;
+}
+
+size_t numFactors(const PlaceDeformationGraph& graph) {
+  size_t num_factors = 0;
+  for (const auto& factor : graph.factors()) {
+    num_factors += factor ? 1 : 0;
+  }
+
+  return num_factors;
+}
+
+void checkAgainstLayer(const PlaceDeformationGraph& graph,
+                       const SceneGraphLayer& layer) {
+  const auto info = getMinimumSpanningEdges(layer);
+  EXPECT_EQ(getEdges(info.edges), getEdges(graph.forest().edges()));
+
+  size_t expected_factors = info.edges.size();
+  std::set<NodeId> expected_values;
+  for (const auto& id_node_pair : layer.nodes()) {
+    const auto& node = *id_node_pair.second;
+    if (!node.hasSiblings()) {
+      EXPECT_FALSE(graph.values().exists(node.id));
+      continue;
+    }
+
+    expected_values.insert(node.id);
+    const bool leaf = info.leaves.count(node.id);
+    EXPECT_EQ(leaf, graph.places().at(node.id).leaf);
+    if (leaf) {
+      const auto& attrs = node.attributes<PlaceNodeAttributes>();
+      expected_factors += 2 * attrs.deformation_connections.size();
+    }
+  }
+
+  std::set<NodeId> values;
+  for (const auto key : graph.values().keys()) {
+    values.insert(key);
+  }
+
+  EXPECT_EQ(expected_values, values);
+  EXPECT_EQ(expected_factors, numFactors(graph));
+}
+
+}  // namespace
+
+TEST(PlaceDeformationGraph, MatchesMinimumSpanningTree) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> dist(0.0, 10.0);
+  IsolatedSceneGraphLayer layer(DsgLayers::PLACES);
+  PlaceDeformationGraph graph('v', 1.0, 1.0);
+  for (size_t i = 0; i < 4; ++i) {
+    graph.addVertex(i, Eigen::Vector3d::Zero());
+  }
+
+  const auto add_places = [&](size_t start, size_t end) {
+    for (size_t i = start; i < end; ++i) {
+      addPlace(layer, i, Eigen::Vector3d(dist(gen), dist(gen), 0.0), false, {i % 4});
+      graph.markChanged(i);
+    }
+
+    for (size_t i = start; i < end; ++i) {
+      for (size_t j = 0; j < i; ++j) {
+        if (layer.hasNode(j) &&
+            (layer.getPosition(i) - layer.getPosition(j)).norm() < 3.0) {
+          layer.insertEdge(i, j);
+          graph.markChanged(j);
+        }
+      }
+    }
+  };
+
+  add_places(0, 40);
+  EXPECT_TRUE(graph.update(layer));
+  checkAgainstLayer(graph, layer);
+
+  // removed places and edges
+  for (NodeId node = 0; node < 40; node += 7) {
+    layer.removeNode(node);
+    graph.markRemoved(node);
+  }
+
+  std::vector<std::pair<NodeId, NodeId>> to_remove;
+  for (const auto& id_edge_pair : layer.edges()) {
+    if (to_remove.size() < 10) {
+      to_remove.emplace_back(id_edge_pair.second.source, id_edge_pair.second.target);
+    }
+  }
+
+  for (const auto& [source, target] : to_remove) {
+    layer.removeEdge(source, target);
+    graph.markChanged(source);
+    graph.markChanged(target);
+  }
+
+  EXPECT_TRUE(graph.update(layer));
+  checkAgainstLayer(graph, layer);
+
+  // new places connecting to the existing ones
+  add_places(40, 60);
+  EXPECT_TRUE(graph.update(layer));
+  checkAgainstLayer(graph, layer);
+}
+
+TEST(PlaceDeformationGraph, OnlyChangedFactorsReplaced) {
+  IsolatedSceneGraphLayer layer(DsgLayers::PLACES);
+  PlaceDeformationGraph graph('v', 1.0, 1.0);
+  graph.addVertex(0, Eigen::Vector3d::Zero());
+  addPlace(layer, 0, Eigen::Vector3d(0.0, 0.0, 0.0), false, {0});
+  addPlace(layer, 1, Eigen::Vector3d(1.0, 0.0, 0.0));
+  addPlace(layer, 2, Eigen::Vector3d(2.0, 0.0, 0.0));
+  addPlace(layer, 3, Eigen::Vector3d(3.0, 0.0, 0.0), true);
+  layer.insertEdge(0, 1);
+  layer.insertEdge(1, 2);
+  layer.insertEdge(2, 3);
+  for (NodeId node = 0; node < 4; ++node) {
+    graph.markChanged(node);
+  }
+
+  EXPECT_TRUE(graph.update(layer));
+  checkAgainstLayer(graph, layer);
+  const auto prev_factors = graph.factors();
+
+  // nothing changed
+  EXPECT_FALSE(graph.update(layer));
+  ASSERT_EQ(prev_factors.size(), graph.factors().size());
+  for (size_t i = 0; i < prev_factors.size(); ++i) {
+    EXPECT_EQ(prev_factors[i], graph.factors()[i]);
+  }
+
+  // the active place moved: only the edge touching it is rebuilt
+  layer.getNode(3).attributes<PlaceNodeAttributes>().position.x() = 3.5;
+  EXPECT_TRUE(graph.update(layer));
+  checkAgainstLayer(graph, layer);
+  size_t num_kept = 0;
+  for (size_t i = 0; i < prev_factors.size(); ++i) {
+    num_kept += prev_factors[i] == graph.factors()[i] ? 1 : 0;
+  }
+
+  // two valence factors and two edges are untouched
+  EXPECT_EQ(4u, num_kept);
+
+  // archived places are not checked anymore
+  layer.getNode(3).attributes<PlaceNodeAttributes>().is_active = false;
+  graph.update(layer);
+  layer.getNode(3).attributes<PlaceNodeAttributes>().position.x() = 4.0;
+  EXPECT_FALSE(graph.update(layer));
+}
+
+TEST(PlaceDeformationGraph, ValencesWaitForVertices) {
+  IsolatedSceneGraphLayer layer(DsgLayers::PLACES);
+  PlaceDeformationGraph graph('v', 1.0, 1.0);
+  addPlace(layer, 0, Eigen::Vector3d(0.0, 0.0, 0.0), false, {3});
+  addPlace(layer, 1, Eigen::Vector3d(1.0, 0.0, 0.0));
+  layer.insertEdge(0, 1);
+  graph.markChanged(0);
+  graph.markChanged(1);
+
+  EXPECT_TRUE(graph.update(layer));
+  EXPECT_EQ(1u, numFactors(graph));
+
+  graph.addVertex(3, Eigen::Vector3d(0.0, 1.0, 0.0));
+  EXPECT_TRUE(graph.update(layer));
+  EXPECT_EQ(3u, numFactors(graph));
+  EXPECT_TRUE(graph.places().at(0).leaf);
+}
+
+}  // namespace hydra
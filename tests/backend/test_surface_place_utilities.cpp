@@ -0,0 +1,109 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/backend/surface_place_utilities.h>
+
+namespace hydra::utils {
+
+namespace {
+
+EllipseBounds makeCircle(double x, double y, double radius) {
+  const Eigen::Matrix2d A = Eigen::Matrix2d::Identity() / (radius * radius);
+  return EllipseBounds::fromQuadric(A, Eigen::Vector2d(x, y));
+}
+
+}  // namespace
+
+TEST(SurfacePlaceUtilities, EllipseBoundsCorrect) {
+  {  // circles are bounded by their radius
+    const auto bounds = makeCircle(1.0, 2.0, 0.5);
+    EXPECT_TRUE(bounds.bounded);
+    EXPECT_NEAR(bounds.min.x(), 0.5, 1.0e-9);
+    EXPECT_NEAR(bounds.min.y(), 1.5, 1.0e-9);
+    EXPECT_NEAR(bounds.max.x(), 1.5, 1.0e-9);
+    EXPECT_NEAR(bounds.max.y(), 2.5, 1.0e-9);
+  }
+
+  {  // rotated ellipse with semi-axes 2 and 1 at 45 degrees
+    const Eigen::Matrix2d R = Eigen::Rotation2Dd(M_PI / 4.0).toRotationMatrix();
+    const Eigen::Matrix2d D = Eigen::Vector2d(0.25, 1.0).asDiagonal();
+    const Eigen::Matrix2d A = R * D * R.transpose();
+    const auto bounds = EllipseBounds::fromQuadric(A, Eigen::Vector2d::Zero());
+    EXPECT_TRUE(bounds.bounded);
+    EXPECT_NEAR(bounds.max.x(), std::sqrt(2.5), 1.0e-9);
+    EXPECT_NEAR(bounds.max.y(), std::sqrt(2.5), 1.0e-9);
+  }
+
+  {  // indefinite forms don't describe a bounded region
+    const Eigen::Matrix2d A = Eigen::Vector2d(1.0, -1.0).asDiagonal();
+    const auto bounds = EllipseBounds::fromQuadric(A, Eigen::Vector2d::Zero());
+    EXPECT_FALSE(bounds.bounded);
+    EXPECT_TRUE(bounds.intersects(makeCircle(100.0, 100.0, 1.0)));
+  }
+
+  EXPECT_TRUE(makeCircle(0.0, 0.0, 1.0).intersects(makeCircle(1.5, 0.0, 1.0)));
+  EXPECT_FALSE(makeCircle(0.0, 0.0, 1.0).intersects(makeCircle(2.5, 0.0, 1.0)));
+}
+
+TEST(SurfacePlaceUtilities, EllipseGridCandidates) {
+  std::vector<EllipseBounds> bounds;
+  for (size_t i = 0; i < 10; ++i) {
+    for (size_t j = 0; j < 10; ++j) {
+      bounds.push_back(makeCircle(2.0 * i, 2.0 * j, 0.6 + 0.1 * ((i + j) % 5)));
+    }
+  }
+
+  // large and unbounded ellipses overlap everything
+  bounds.push_back(makeCircle(9.0, 9.0, 1000.0));
+  bounds.push_back(EllipseBounds());
+
+  const EllipseGrid grid(bounds);
+  EXPECT_EQ(grid.size(), bounds.size());
+
+  std::vector<size_t> candidates;
+  for (size_t i = 0; i < bounds.size(); ++i) {
+    std::vector<size_t> expected;
+    for (size_t j = i + 1; j < bounds.size(); ++j) {
+      if (bounds[i].intersects(bounds[j])) {
+        expected.push_back(j);
+      }
+    }
+
+    grid.candidates(i, candidates);
+    EXPECT_EQ(candidates, expected) << "query: " << i;
+  }
+}
+
+}  // namespace hydra::utils
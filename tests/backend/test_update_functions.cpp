@@ -0,0 +1,109 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/backend/update_functions.h>
+
+namespace hydra {
+
+namespace {
+
+LayerAccess makeAccess(const std::set<LayerId>& reads,
+                       const std::set<LayerId>& writes,
+                       bool structural = false) {
+  LayerAccess access;
+  access.reads = reads;
+  access.writes = writes;
+  access.structural = structural;
+  return access;
+}
+
+}  // namespace
+
+TEST(UpdateFunctions, LayerAccessConflicts) {
+  const auto objects = makeAccess({2}, {2});
+  const auto places = makeAccess({3}, {3}, true);
+  const auto rooms = makeAccess({3, 4}, {3, 4}, true);
+  const auto reader = makeAccess({2, 3}, {});
+
+  EXPECT_FALSE(objects.conflictsWith(places));
+  EXPECT_TRUE(places.conflictsWith(rooms));
+  EXPECT_TRUE(rooms.conflictsWith(places));
+  EXPECT_TRUE(reader.conflictsWith(objects));
+  EXPECT_FALSE(reader.conflictsWith(makeAccess({2}, {})));
+
+  LayerAccess unknown;
+  unknown.unknown = true;
+  EXPECT_TRUE(unknown.conflictsWith(LayerAccess()));
+  EXPECT_TRUE(LayerAccess().conflictsWith(unknown));
+  EXPECT_FALSE(LayerAccess().conflictsWith(LayerAccess()));
+}
+
+TEST(UpdateFunctions, ScheduleDisjointFunctors) {
+  // agents, objects, places, rooms, buildings, 2d places
+  std::vector<LayerAccess> accesses{makeAccess({6}, {6}),
+                                    makeAccess({2}, {2}),
+                                    makeAccess({3}, {3}, true),
+                                    makeAccess({3, 4}, {3, 4}, true),
+                                    makeAccess({4, 5}, {4, 5}, true),
+                                    makeAccess({20}, {20})};
+
+  const auto stages = scheduleUpdateFunctors(accesses);
+  std::vector<std::vector<size_t>> expected{{0, 1, 5}, {2}, {3}, {4}};
+  EXPECT_EQ(stages, expected);
+}
+
+TEST(UpdateFunctions, ScheduleKeepsConflictingOrder) {
+  std::vector<LayerAccess> accesses{makeAccess({2}, {2}),
+                                    makeAccess({2}, {}),
+                                    makeAccess({3}, {3}),
+                                    makeAccess({2, 3}, {4})};
+
+  const auto stages = scheduleUpdateFunctors(accesses);
+  std::vector<std::vector<size_t>> expected{{0, 2}, {1, 3}};
+  EXPECT_EQ(stages, expected);
+}
+
+TEST(UpdateFunctions, ScheduleUnknownAccess) {
+  LayerAccess unknown;
+  unknown.unknown = true;
+  std::vector<LayerAccess> accesses(3, unknown);
+
+  // undeclared functors run one at a time in their original order
+  const auto stages = scheduleUpdateFunctors(accesses);
+  std::vector<std::vector<size_t>> expected{{0}, {1}, {2}};
+  EXPECT_EQ(stages, expected);
+}
+
+}  // namespace hydra
@@ -0,0 +1,195 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/frontend/incremental_clusterer.h>
+
+#include <map>
+#include <random>
+#include <set>
+
+namespace hydra {
+
+namespace {
+
+using ClusterSet = std::set<std::vector<size_t>>;
+
+ClusterSet getExpectedClusters(const Mesh::Positions& points,
+                               const std::vector<size_t>& indices,
+                               double tolerance) {
+  std::map<size_t, size_t> labels;
+  size_t next_label = 0;
+  for (const auto idx : indices) {
+    if (labels.count(idx)) {
+      continue;
+    }
+
+    std::vector<size_t> frontier{idx};
+    labels[idx] = next_label;
+    while (!frontier.empty()) {
+      const auto curr = frontier.back();
+      frontier.pop_back();
+      for (const auto other : indices) {
+        if (labels.count(other)) {
+          continue;
+        }
+
+        if ((points[curr] - points[other]).norm() <= tolerance) {
+          labels[other] = next_label;
+          frontier.push_back(other);
+        }
+      }
+    }
+
+    ++next_label;
+  }
+
+  std::vector<std::vector<size_t>> clusters(next_label);
+  for (const auto& [idx, label] : labels) {
+    clusters[label].push_back(idx);
+  }
+
+  return ClusterSet(clusters.begin(), clusters.end());
+}
+
+ClusterSet getClusterSet(const IncrementalClusterer& clusterer) {
+  ClusterSet result;
+  for (const auto& cluster : clusterer.getClusters(0, 1000)) {
+    result.insert(cluster.indices);
+  }
+
+  return result;
+}
+
+}  // namespace
+
+TEST(IncrementalClusterer, RemappingDropsDeletedIndices) {
+  const std::set<size_t> deleted{5, 7};
+  const std::map<size_t, size_t> prev_to_curr{{6, 4}, {8, 5}, {7, 1}};
+  const VertexRemapping remapping(deleted, prev_to_curr);
+  EXPECT_FALSE(remapping.empty());
+  EXPECT_EQ(remapping(3), 3u);
+  EXPECT_EQ(remapping(5), VertexRemapping::DELETED);
+  EXPECT_EQ(remapping(6), 4u);
+  EXPECT_EQ(remapping(7), VertexRemapping::DELETED);
+  EXPECT_EQ(remapping(8), 5u);
+  EXPECT_EQ(remapping(9), 9u);
+
+  std::vector<size_t> indices{9, 8, 7, 6, 5, 4};
+  EXPECT_TRUE(remapping.apply(indices));
+  std::vector<size_t> expected{9, 5, 4, 4};
+  EXPECT_EQ(indices, expected);
+}
+
+TEST(IncrementalClusterer, KeepsUnchangedClusters) {
+  Mesh::Positions points{{0.0, 0.0, 0.0},
+                         {0.5, 0.0, 0.0},
+                         {1.0, 0.0, 0.0},
+                         {5.0, 0.0, 0.0},
+                         {5.5, 0.0, 0.0},
+                         {10.0, 0.0, 0.0}};
+
+  IncrementalClusterer clusterer(0.6);
+  clusterer.update({}, {0, 1, 2, 3, 4}, points);
+  auto clusters = clusterer.getClusters(2, 10);
+  ASSERT_EQ(clusters.size(), 2u);
+  EXPECT_EQ(clusters[0].indices, std::vector<size_t>({0, 1, 2}));
+  EXPECT_EQ(clusters[1].indices, std::vector<size_t>({3, 4}));
+  const auto first_id = clusters[0].id;
+  const auto second_id = clusters[1].id;
+
+  // a new isolated vertex doesn't touch the existing clusters
+  clusterer.update({}, {0, 1, 2, 3, 4, 5}, points);
+  EXPECT_EQ(clusterer.numClusters(), 3u);
+  clusters = clusterer.getClusters(2, 10);
+  ASSERT_EQ(clusters.size(), 2u);
+  EXPECT_EQ(clusters[0].id, first_id);
+  EXPECT_EQ(clusters[1].id, second_id);
+
+  // removing the middle vertex splits the first cluster
+  clusterer.update({}, {0, 2, 3, 4, 5}, points);
+  clusters = clusterer.getClusters(1, 1);
+  ASSERT_EQ(clusters.size(), 3u);
+  clusters = clusterer.getClusters(2, 10);
+  ASSERT_EQ(clusters.size(), 1u);
+  EXPECT_EQ(clusters[0].id, second_id);
+
+  // remapped indices are applied to unchanged clusters
+  const std::set<size_t> deleted{0, 1};
+  const std::map<size_t, size_t> prev_to_curr{{2, 0}, {3, 1}, {4, 2}, {5, 3}};
+  points.erase(points.begin(), points.begin() + 2);
+  clusterer.update(VertexRemapping(deleted, prev_to_curr), {1, 2, 3}, points);
+  clusters = clusterer.getClusters(2, 10);
+  ASSERT_EQ(clusters.size(), 1u);
+  EXPECT_EQ(clusters[0].id, second_id);
+  EXPECT_EQ(clusters[0].indices, std::vector<size_t>({1, 2}));
+  EXPECT_EQ(clusterer.numVertices(), 3u);
+}
+
+TEST(IncrementalClusterer, MatchesBatchClustering) {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> coord(0.0, 4.0);
+  std::uniform_real_distribution<float> coin(0.0, 1.0);
+
+  Mesh::Positions points(300);
+  for (auto& point : points) {
+    point = Mesh::Pos(coord(rng), coord(rng), 0.0);
+  }
+
+  const double tolerance = 0.25;
+  IncrementalClusterer clusterer(tolerance);
+  for (size_t iter = 0; iter < 20; ++iter) {
+    // move a few vertices and toggle which vertices are active
+    for (auto& point : points) {
+      if (coin(rng) < 0.05) {
+        point = Mesh::Pos(coord(rng), coord(rng), 0.0);
+      }
+    }
+
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < points.size(); ++i) {
+      if (coin(rng) < 0.8) {
+        indices.push_back(i);
+      }
+    }
+
+    clusterer.update({}, indices, points);
+    EXPECT_EQ(clusterer.numVertices(), indices.size());
+    EXPECT_EQ(getClusterSet(clusterer),
+              getExpectedClusters(points, indices, tolerance))
+        << "iteration " << iter;
+  }
+}
+
+}  // namespace hydra
@@ -0,0 +1,283 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/frontend/place_2d_split_logic.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+
+namespace hydra {
+
+namespace {
+
+using Indices = std::vector<Place2d::Index>;
+
+Eigen::Vector2d getPoint(const Place2d::CloudT& points, size_t idx) {
+  return Eigen::Vector2d(points[idx].x(), points[idx].y());
+}
+
+double cross(const Eigen::Vector2d& o,
+             const Eigen::Vector2d& a,
+             const Eigen::Vector2d& b) {
+  return (a.x() - o.x()) * (b.y() - o.y()) - (a.y() - o.y()) * (b.x() - o.x());
+}
+
+Indices getAllIndices(const Place2d::CloudT& points) {
+  Indices indices(points.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  return indices;
+}
+
+double bruteForceMinArea(const Place2d::CloudT& points, const Indices& hull) {
+  double best = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < hull.size(); ++i) {
+    const auto p1 = getPoint(points, hull[i]);
+    const auto p2 = getPoint(points, hull[(i + 1) % hull.size()]);
+    const Eigen::Vector2d u = (p2 - p1).normalized();
+    const Eigen::Vector2d n(-u.y(), u.x());
+    double u_min = std::numeric_limits<double>::infinity();
+    double u_max = -u_min;
+    double n_min = u_min;
+    double n_max = -u_min;
+    for (size_t idx = 0; idx < points.size(); ++idx) {
+      const auto p = getPoint(points, idx);
+      u_min = std::min(u_min, p.dot(u));
+      u_max = std::max(u_max, p.dot(u));
+      n_min = std::min(n_min, p.dot(n));
+      n_max = std::max(n_max, p.dot(n));
+    }
+
+    best = std::min(best, (u_max - u_min) * (n_max - n_min));
+  }
+
+  return best;
+}
+
+std::vector<Place2d> referenceDecompose(const Place2d::CloudT& points,
+                                        const Place2d& place,
+                                        double min_size,
+                                        size_t min_points) {
+  const auto children = splitPlace(points, place, 1.0);
+  std::vector<Place2d> result;
+  for (const auto& child : {children.first, children.second}) {
+    if (child.indices.size() > min_points && child.cut_plane.norm() > min_size) {
+      const auto descendants = referenceDecompose(points, child, min_size, min_points);
+      result.insert(result.end(), descendants.begin(), descendants.end());
+    } else {
+      result.push_back(child);
+    }
+  }
+
+  return result;
+}
+
+Place2d::CloudT makeGrid(size_t rows, size_t cols, double angle, double spacing) {
+  const Eigen::Rotation2Dd rotation(angle);
+  Place2d::CloudT points;
+  for (size_t r = 0; r < rows; ++r) {
+    for (size_t c = 0; c < cols; ++c) {
+      const Eigen::Vector2d p = rotation * Eigen::Vector2d(c * spacing, r * spacing);
+      points.emplace_back(p.x() + 1.0, p.y() - 2.0, 0.5);
+    }
+  }
+
+  return points;
+}
+
+}  // namespace
+
+TEST(Place2dSplitLogic, ConvexHullIsStrictlyConvexAndContainsPoints) {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> coord(-5.0, 5.0);
+  Place2d::CloudT points;
+  for (size_t i = 0; i < 200; ++i) {
+    points.emplace_back(coord(rng), coord(rng), coord(rng));
+  }
+
+  // duplicates and collinear points on the boundary
+  points.emplace_back(6.0, 6.0, 0.0);
+  points.emplace_back(6.0, 6.0, 1.0);
+  points.emplace_back(6.0, 0.0, 0.0);
+  points.emplace_back(6.0, -6.0, 0.0);
+
+  Indices hull;
+  convexHull2d(points, getAllIndices(points), hull);
+  ASSERT_GE(hull.size(), 3u);
+  for (size_t i = 0; i < hull.size(); ++i) {
+    const auto p0 = getPoint(points, hull[i]);
+    const auto p1 = getPoint(points, hull[(i + 1) % hull.size()]);
+    const auto p2 = getPoint(points, hull[(i + 2) % hull.size()]);
+    EXPECT_GT(cross(p0, p1, p2), 0.0) << "hull vertex " << i;
+    for (size_t idx = 0; idx < points.size(); ++idx) {
+      EXPECT_GE(cross(p0, p1, getPoint(points, idx)), -1.0e-9);
+    }
+  }
+
+  // collinear boundary point is not a hull vertex
+  EXPECT_EQ(std::count(hull.begin(), hull.end(), 202u), 0);
+}
+
+TEST(Place2dSplitLogic, ConvexHullDegenerate) {
+  Place2d::CloudT points{{1.0, 1.0, 0.0}, {1.0, 1.0, 2.0}, {3.0, 1.0, 0.0}};
+  Indices hull;
+  convexHull2d(points, Indices{0, 1}, hull);
+  EXPECT_EQ(hull, Indices({0}));
+  convexHull2d(points, Indices{0, 1, 2}, hull);
+  EXPECT_EQ(hull, Indices({2, 0}));
+  convexHull2d(points, Indices{}, hull);
+  EXPECT_TRUE(hull.empty());
+}
+
+TEST(Place2dSplitLogic, MinAreaRectMatchesBruteForce) {
+  std::mt19937 rng(13);
+  std::uniform_real_distribution<float> coord(-3.0, 3.0);
+  for (size_t trial = 0; trial < 20; ++trial) {
+    Place2d::CloudT points;
+    for (size_t i = 0; i < 50; ++i) {
+      points.emplace_back(coord(rng), 0.3 * coord(rng), 0.0);
+    }
+
+    const auto indices = getAllIndices(points);
+    Indices hull;
+    convexHull2d(points, indices, hull);
+    const auto rect = minAreaRect2d(points, indices);
+    const double area = rect.width_ray.norm() * rect.height_ray.norm();
+    EXPECT_NEAR(area, bruteForceMinArea(points, hull), 1.0e-6) << "trial " << trial;
+    EXPECT_NEAR(rect.width_ray.dot(rect.height_ray), 0.0, 1.0e-6);
+
+    // every point is inside the rectangle
+    const Eigen::Vector2d u = rect.width_ray.normalized();
+    const Eigen::Vector2d n = rect.height_ray.normalized();
+    for (size_t idx = 0; idx < points.size(); ++idx) {
+      const Eigen::Vector2d diff = getPoint(points, idx) - rect.center;
+      EXPECT_LE(std::abs(diff.dot(u)), rect.width_ray.norm() / 2 + 1.0e-6);
+      EXPECT_LE(std::abs(diff.dot(n)), rect.height_ray.norm() / 2 + 1.0e-6);
+    }
+  }
+}
+
+TEST(Place2dSplitLogic, RectInfoMatchesReference) {
+  // 5 x 3 grid spanning a 4 x 2 rectangle rotated by 30 degrees
+  const double angle = M_PI / 6.0;
+  const auto points = makeGrid(3, 5, angle, 1.0);
+  Place2d place;
+  place.indices = getAllIndices(points);
+  addRectInfo(points, 1.0, place);
+
+  const Eigen::Rotation2Dd rotation(angle);
+  const Eigen::Vector2d center = rotation * Eigen::Vector2d(2.0, 1.0);
+  EXPECT_NEAR(place.ellipse_centroid.x(), center.x() + 1.0, 1.0e-5);
+  EXPECT_NEAR(place.ellipse_centroid.y(), center.y() - 2.0, 1.0e-5);
+
+  // sides follow cv::RotatedRect::points: p1 - p0 is the height (2 x the width
+  // direction rotated clockwise) and p3 - p0 is the width (4 x the long axis at 30
+  // degrees), matching ((2.23205, -0.13397), (4, 2), 30) from cv::minAreaRect
+  const Eigen::Vector2d e1 = -2.0 * (rotation * Eigen::Vector2d::UnitY());
+  const Eigen::Vector2d e2 = 4.0 * (rotation * Eigen::Vector2d::UnitX());
+  Eigen::Matrix2d expand;
+  expand << e1, e2;
+  expand *= std::sqrt(2) / 2;
+  EXPECT_TRUE(place.ellipse_matrix_expand.isApprox(expand, 1.0e-5))
+      << place.ellipse_matrix_expand << " != " << expand;
+
+  // cut plane is the long side of the rectangle, including its sign
+  EXPECT_TRUE(place.cut_plane.isApprox(e2, 1.0e-5))
+      << place.cut_plane.transpose() << " != " << e2.transpose();
+
+  // compression matrix is diag(1 / 8, 1 / 2) in the rectangle frame
+  const Eigen::Matrix2d R = rotation.toRotationMatrix();
+  const Eigen::Matrix2d expected =
+      R * Eigen::Vector2d(1.0 / 8.0, 1.0 / 2.0).asDiagonal() * R.transpose();
+  EXPECT_TRUE(place.ellipse_matrix_compress.isApprox(expected, 1.0e-5))
+      << place.ellipse_matrix_compress << " != " << expected;
+}
+
+TEST(Place2dSplitLogic, BoundaryInfoMatchesReference) {
+  const auto points = makeGrid(3, 5, 0.0, 1.0);
+  Place2d place;
+  place.indices = getAllIndices(points);
+  addBoundaryInfo(points, place);
+
+  // counter-clockwise corners without the collinear points on the sides, starting
+  // from the top-right corner like cv::convexHull
+  EXPECT_EQ(place.boundary_indices, Indices({14, 10, 0, 4}));
+  ASSERT_EQ(place.boundary.size(), 4u);
+  EXPECT_NEAR(place.boundary[0].x(), points[14].x(), 1.0e-9);
+  EXPECT_NEAR(place.boundary[0].y(), points[14].y(), 1.0e-9);
+  EXPECT_NEAR(place.boundary[0].z(), 0.5, 1.0e-9);
+
+  pcl::PointXYZ centroid;
+  place.centroid.get(centroid);
+  EXPECT_NEAR(centroid.x, 3.0, 1.0e-6);
+  EXPECT_NEAR(centroid.y, -1.0, 1.0e-6);
+}
+
+TEST(Place2dSplitLogic, DecomposeMatchesSplitPlace) {
+  // odd number of columns puts a row of points on the first cut plane
+  const auto points = makeGrid(11, 41, 0.0, 0.1);
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> noise(-0.01, 0.01);
+  Place2d::CloudT noisy = points;
+  for (auto& p : noisy) {
+    p.x() += noise(rng);
+    p.y() += noise(rng);
+  }
+
+  for (const auto& cloud : {points, noisy}) {
+    Place2d place;
+    place.indices = getAllIndices(cloud);
+    addRectInfo(cloud, 1.0, place);
+
+    const auto expected = referenceDecompose(cloud, place, 0.5, 20);
+    const auto result = decomposePlace(cloud, place, 0.5, 20, 1.0);
+    ASSERT_EQ(result.size(), expected.size());
+    ASSERT_GT(result.size(), 4u);
+    for (size_t i = 0; i < result.size(); ++i) {
+      auto result_indices = result[i].indices;
+      auto expected_indices = expected[i].indices;
+      std::sort(result_indices.begin(), result_indices.end());
+      std::sort(expected_indices.begin(), expected_indices.end());
+      EXPECT_EQ(result_indices, expected_indices) << "place " << i;
+      EXPECT_EQ(result[i].min_mesh_index, expected[i].min_mesh_index);
+      EXPECT_EQ(result[i].max_mesh_index, expected[i].max_mesh_index);
+      EXPECT_TRUE(result[i].cut_plane.isApprox(expected[i].cut_plane));
+      EXPECT_TRUE(result[i].ellipse_centroid.isApprox(expected[i].ellipse_centroid));
+    }
+  }
+}
+
+}  // namespace hydra
@@ -0,0 +1,231 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/frontend/place_mesh_connector.h>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <set>
+
+namespace hydra {
+
+namespace {
+
+struct Vertex {
+  size_t index;
+  Eigen::Vector3f pos;
+  uint32_t label;
+};
+
+// Simulated active mesh that emits the same vertex events as the mesh compression:
+// deletions compact the remaining vertex indices, moved vertices keep their index and
+// archived vertices are reported one last time before leaving the active window
+class MeshReplay {
+ public:
+  explicit MeshReplay(size_t seed) : rng_(seed) {}
+
+  kimera_pgmo::MeshDelta::Ptr step(double delete_prob,
+                                   double move_prob,
+                                   size_t num_archive,
+                                   size_t num_add) {
+    auto delta = std::make_shared<kimera_pgmo::MeshDelta>(vertex_start_, 0);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    std::vector<Vertex> survivors;
+    for (const auto& vertex : active_) {
+      if (unit(rng_) < delete_prob) {
+        delta->deleted_indices.insert(vertex.index);
+        ++num_removed;
+      } else {
+        survivors.push_back(vertex);
+      }
+    }
+
+    for (size_t i = 0; i < survivors.size(); ++i) {
+      auto& vertex = survivors[i];
+      const size_t curr = vertex_start_ + i;
+      if (curr != vertex.index) {
+        delta->prev_to_curr[vertex.index] = curr;
+        vertex.index = curr;
+      }
+
+      if (unit(rng_) < move_prob) {
+        std::uniform_real_distribution<float> offset(-0.3f, 0.3f);
+        vertex.pos += Eigen::Vector3f(offset(rng_), offset(rng_), offset(rng_));
+        ++num_removed;
+      }
+    }
+
+    for (size_t i = 0; i < num_add; ++i) {
+      const size_t index = vertex_start_ + survivors.size();
+      survivors.push_back({index, randomPosition(), static_cast<uint32_t>(index % 7)});
+    }
+
+    num_archive = std::min(num_archive, survivors.size());
+    num_removed += num_archive;
+    for (size_t i = 0; i < survivors.size(); ++i) {
+      const auto& vertex = survivors[i];
+      pcl::PointXYZRGBA point;
+      point.x = vertex.pos.x();
+      point.y = vertex.pos.y();
+      point.z = vertex.pos.z();
+      delta->addVertex(0, point, vertex.label, i < num_archive);
+    }
+
+    vertex_start_ += num_archive;
+    active_.assign(survivors.begin() + num_archive, survivors.end());
+    return delta;
+  }
+
+  Eigen::Vector3f randomPosition() {
+    std::uniform_real_distribution<float> coord(0.0f, 10.0f);
+    return Eigen::Vector3f(coord(rng_), coord(rng_), coord(rng_));
+  }
+
+  const std::vector<Vertex>& active() const { return active_; }
+
+  //! Number of vertex removals (deletions, moves and archived vertices) so far
+  size_t num_removed = 0;
+
+ private:
+  std::mt19937 rng_;
+  size_t vertex_start_ = 0;
+  std::vector<Vertex> active_;
+};
+
+void setBasisPoints(PlaceNodeAttributes& attrs, MeshReplay& mesh, size_t num_points) {
+  attrs.voxblox_mesh_connections.resize(num_points);
+  for (auto& info : attrs.voxblox_mesh_connections) {
+    const Eigen::Vector3d pos = mesh.randomPosition().cast<double>();
+    std::copy_n(pos.data(), 3, info.voxel_pos);
+  }
+}
+
+double bruteForceDistance(const MeshReplay& mesh, const double* pos) {
+  const Eigen::Map<const Eigen::Vector3d> query(pos);
+  double best = std::numeric_limits<double>::infinity();
+  for (const auto& vertex : mesh.active()) {
+    best = std::min(best, (vertex.pos.cast<double>() - query).squaredNorm());
+  }
+
+  return best;
+}
+
+}  // namespace
+
+TEST(PlaceMeshConnector, ReplayMatchesNearestVertex) {
+  MeshReplay mesh(5);
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+  IsolatedSceneGraphLayer places(DsgLayers::PLACES);
+  for (NodeId node = 0; node < 30; ++node) {
+    auto attrs = std::make_unique<PlaceNodeAttributes>();
+    attrs->is_active = true;
+    // the first place never has basis points
+    setBasisPoints(*attrs, mesh, node ? 1 + node % 4 : 0);
+    places.emplaceNode(node, std::move(attrs));
+  }
+
+  PlaceMeshConnector connector;
+  for (size_t step = 0; step < 40; ++step) {
+    const auto delta = step ? mesh.step(0.1, 0.1, 15, 60) : mesh.step(0.0, 0.0, 0, 300);
+    connector.updateVertices(delta);
+    EXPECT_EQ(connector.numVertices(), mesh.active().size()) << "step " << step;
+
+    // change, deactivate and reactivate some places between updates
+    for (const auto& [node_id, node] : places.nodes()) {
+      auto& attrs = node->attributes<PlaceNodeAttributes>();
+      if (node_id > 0 && unit(rng) < 0.2) {
+        setBasisPoints(attrs, mesh, attrs.voxblox_mesh_connections.size());
+      }
+
+      if (node_id > 0 && unit(rng) < 0.1) {
+        attrs.is_active = !attrs.is_active;
+      }
+    }
+
+    std::set<size_t> active;
+    for (const auto& vertex : mesh.active()) {
+      active.insert(vertex.index);
+    }
+
+    size_t expected_missing = 0;
+    std::set<size_t> expected_connected;
+    const auto num_missing = connector.updateConnections(places);
+    for (const auto& [node_id, node] : places.nodes()) {
+      const auto& attrs = node->attributes<PlaceNodeAttributes>();
+      if (!attrs.is_active) {
+        continue;
+      }
+
+      const auto& connections = attrs.voxblox_mesh_connections;
+      expected_missing += connections.empty() ? 1 : 0;
+      ASSERT_EQ(attrs.pcl_mesh_connections.size(), connections.size());
+      ASSERT_EQ(attrs.mesh_vertex_labels.size(), connections.size());
+      for (size_t i = 0; i < connections.size(); ++i) {
+        const auto mesh_idx = attrs.pcl_mesh_connections[i];
+        EXPECT_EQ(connections[i].vertex, mesh_idx);
+        const auto local_idx = delta->getLocalIndex(mesh_idx);
+        ASSERT_LT(local_idx, delta->vertex_updates->size());
+        EXPECT_EQ(attrs.mesh_vertex_labels[i], delta->semantic_updates[local_idx]);
+        expected_connected.insert(local_idx);
+
+        // connected vertex is active and as close as any other active vertex
+        const auto& p = delta->vertex_updates->at(local_idx);
+        const Eigen::Vector3d vertex_pos(p.x, p.y, p.z);
+        const Eigen::Map<const Eigen::Vector3d> query(connections[i].voxel_pos);
+        EXPECT_TRUE(active.count(mesh_idx)) << "step " << step << ": " << mesh_idx;
+        EXPECT_NEAR((vertex_pos - query).squaredNorm(),
+                    bruteForceDistance(mesh, connections[i].voxel_pos),
+                    1.0e-9)
+            << "step " << step << ", place " << node_id << ", point " << i;
+      }
+    }
+
+    EXPECT_EQ(num_missing, expected_missing);
+    const auto& connected = connector.connectedVertices();
+    ASSERT_EQ(connected.size(), delta->vertex_updates->size());
+    for (size_t i = 0; i < connected.size(); ++i) {
+      EXPECT_EQ(connected[i], expected_connected.count(i) > 0) << "vertex " << i;
+    }
+  }
+
+  // enough vertices were removed for the vertex index to be compacted repeatedly
+  EXPECT_GT(mesh.num_removed, 2048u);
+}
+
+}  // namespace hydra
@@ -36,6 +36,8 @@
 #include <gtest/gtest.h>
 #include <ros/package.h>
 
+#include <chrono>
+
 #include "hydra/gnn/gnn_interface.h"
 
 namespace hydra::gnn {
@@ -83,4 +85,85 @@ TEST(GnnInterfaceTests, TestSimpleNetwork) {
   EXPECT_NEAR(diff, 0.0, 1.0e-9);
 }
 
+TEST(GnnInterfaceTests, TestBatchedThroughput) {
+  std::string package_path = ros::package::getPath("hydra");
+  std::string model_path = package_path + "/src/gnn/tests/resources/simple_model.onnx";
+
+  GnnInterface model(model_path, {{"output", {0}}}, SessionConfig{2, 1});
+
+  // the model is node-level, so a disjoint union of chains should give the same
+  // result as running every chain separately
+  const int64_t num_graphs = 64;
+  const int64_t nodes_per_graph = 5;
+  std::vector<TensorMap> graphs;
+  for (int64_t g = 0; g < num_graphs; ++g) {
+    Tensor x(nodes_per_graph, 2);
+    auto x_map = x.map<float>();
+    for (int i = 0; i < x.rows(); ++i) {
+      x_map(i, 0) = g + i + 1;
+      x_map(i, 1) = g - i;
+    }
+
+    Tensor edge_index(2, nodes_per_graph - 1, Tensor::Type::INT64);
+    auto index_map = edge_index.map<int64_t>();
+    for (int i = 0; i < edge_index.cols(); ++i) {
+      index_map(0, i) = i;
+      index_map(1, i) = i + 1;
+    }
+
+    graphs.push_back({{"x", x}, {"edge_index", edge_index}});
+  }
+
+  const int64_t total_nodes = num_graphs * nodes_per_graph;
+  const int64_t total_edges = num_graphs * (nodes_per_graph - 1);
+  TensorMap batch_input;
+  auto x_map =
+      getTensorBuffer(batch_input, "x", {total_nodes, 2}, Tensor::Type::FLOAT32)
+          .map<float>();
+  auto index_map = getTensorBuffer(batch_input,
+                                   "edge_index",
+                                   {2, total_edges},
+                                   Tensor::Type::INT64)
+                       .map<int64_t>();
+  for (int64_t g = 0; g < num_graphs; ++g) {
+    const auto node_offset = g * nodes_per_graph;
+    const auto edge_offset = g * (nodes_per_graph - 1);
+    x_map.block(node_offset, 0, nodes_per_graph, 2) = graphs[g].at("x").map<float>();
+    index_map.block(0, edge_offset, 2, nodes_per_graph - 1) =
+        graphs[g].at("edge_index").map<int64_t>().array() + node_offset;
+  }
+
+  using Clock = std::chrono::steady_clock;
+  const size_t num_trials = 20;
+
+  std::vector<Tensor> expected;
+  const auto single_start = Clock::now();
+  for (size_t trial = 0; trial < num_trials; ++trial) {
+    expected.clear();
+    for (const auto& graph : graphs) {
+      expected.push_back(model(graph, {nodes_per_graph}).at("output"));
+    }
+  }
+  const std::chrono::duration<double> single_elapsed = Clock::now() - single_start;
+
+  TensorMap batch_output;
+  const auto batch_start = Clock::now();
+  for (size_t trial = 0; trial < num_trials; ++trial) {
+    model(batch_input, batch_output, {total_nodes});
+  }
+  const std::chrono::duration<double> batch_elapsed = Clock::now() - batch_start;
+
+  auto y_map = batch_output.at("output").map<float>();
+  ASSERT_EQ(y_map.rows(), total_nodes);
+  for (int64_t g = 0; g < num_graphs; ++g) {
+    Eigen::MatrixXf result = y_map.block(g * nodes_per_graph, 0, nodes_per_graph, 2);
+    Eigen::MatrixXf single = expected[g].map<float>();
+    EXPECT_NEAR((result - single).norm(), 0.0, 1.0e-5) << "graph " << g;
+  }
+
+  const double total_graphs = num_graphs * num_trials;
+  LOG(INFO) << "single: " << total_graphs / single_elapsed.count() << " graphs/s, "
+            << "batched: " << total_graphs / batch_elapsed.count() << " graphs/s";
+}
+
 }  // namespace::hydra
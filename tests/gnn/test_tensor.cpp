@@ -133,4 +133,34 @@ TEST(GnnTensorTests, AbitraryConstructorInvariants) {
   }
 }
 
+TEST(GnnTensorTests, TestResizeReusesMemory) {
+  Tensor tensor(4, 3, Tensor::Type::INT64);
+  const auto original = tensor.data<int64_t>();
+
+  {  // test case 1: shrinking keeps the allocation
+    tensor.resize({2, 3});
+    std::vector<int64_t> expected_dims{2, 3};
+    EXPECT_EQ(tensor.dims(), expected_dims);
+    EXPECT_EQ(tensor.size(), 6u);
+    EXPECT_EQ(tensor.num_bytes(), 48u);
+    EXPECT_EQ(tensor.data<int64_t>(), original);
+  }
+
+  {  // test case 2: growing back within capacity keeps the allocation
+    tensor.resize({12});
+    EXPECT_EQ(tensor.size(), 12u);
+    EXPECT_EQ(tensor.num_dims(), 1u);
+    EXPECT_EQ(tensor.rows(), 12);
+    EXPECT_EQ(tensor.cols(), 1);
+    EXPECT_EQ(tensor.data<int64_t>(), original);
+  }
+
+  {  // test case 3: growing past capacity still gives a valid tensor
+    tensor.resize({5, 5});
+    EXPECT_EQ(tensor.size(), 25u);
+    EXPECT_EQ(tensor.num_bytes(), 200u);
+    EXPECT_EQ(tensor.type(), Tensor::Type::INT64);
+  }
+}
+
 }  // namespace::hydra
@@ -35,6 +35,9 @@
 #include <gtest/gtest.h>
 #include <hydra/loop_closure/detector.h>
 
+#include <atomic>
+#include <thread>
+
 namespace hydra::lcd {
 
 struct LcdDetectorTests : public ::testing::Test {
@@ -176,4 +179,89 @@ TEST_F(LcdDetectorTests, TestNonEmptySearch) {
   EXPECT_EQ(0u, results.size());
 }
 
+struct FakeRegistrationSolver : DsgRegistrationSolver {
+  explicit FakeRegistrationSolver(const std::set<NodeId>& valid_roots)
+      : valid_roots(valid_roots) {}
+
+  RegistrationSolution solve(const DynamicSceneGraph&,
+                             const DsgRegistrationInput& match,
+                             NodeId query_agent_id) const override {
+    // earlier candidates take longer so that later candidates finish first
+    const auto delay_ms = 10 * (6 - static_cast<int>(match.match_root));
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    ++num_calls;
+
+    RegistrationSolution solution;
+    solution.valid = valid_roots.count(match.match_root);
+    solution.from_node = query_agent_id;
+    solution.to_node = match.match_root;
+    return solution;
+  }
+
+  const std::set<NodeId> valid_roots;
+  mutable std::atomic<size_t> num_calls{0};
+};
+
+struct TestableLcdDetector : LcdDetector {
+  explicit TestableLcdDetector(const LcdDetectorConfig& config) : LcdDetector(config) {}
+
+  using LcdDetector::registerAndVerify;
+};
+
+LcdDetector::SearchResultMap makeRegistrationMatches() {
+  LayerSearchResults results;
+  results.query_root = 6;
+  results.valid_matches = {1, 2, 3, 4, 5};
+  for (NodeId root = 1; root <= 5; ++root) {
+    results.score.push_back(0.9);
+    results.match_root.push_back(root);
+    results.match_nodes.push_back({});
+  }
+
+  return {{1, results}};
+}
+
+TEST_F(LcdDetectorTests, TestParallelRegistrationMatchesSerial) {
+  for (NodeId i = 1; i <= 6; ++i) {
+    dsg->emplaceNode(DsgLayers::PLACES, i, std::make_unique<PlaceNodeAttributes>());
+  }
+
+  const auto matches = makeRegistrationMatches();
+  for (const int num_threads : {1, 4}) {
+    config.registration_threads = num_threads;
+    TestableLcdDetector module(config);
+    auto solver = std::make_unique<FakeRegistrationSolver>(std::set<NodeId>{3, 4});
+    const auto& solver_ref = *solver;
+    module.setRegistrationSolver(1, std::move(solver));
+
+    const auto results = module.registerAndVerify(*dsg, matches, 7);
+    ASSERT_EQ(1u, results.size()) << "threads: " << num_threads;
+    // the best-ranked valid candidate is always picked
+    EXPECT_EQ(3u, results[0].to_node);
+    EXPECT_EQ(1, results[0].level);
+    if (num_threads == 1) {
+      // serial verification stops at the first valid candidate
+      EXPECT_EQ(3u, solver_ref.num_calls.load());
+    }
+  }
+}
+
+TEST_F(LcdDetectorTests, TestRegistrationTimeBudget) {
+  for (NodeId i = 1; i <= 6; ++i) {
+    dsg->emplaceNode(DsgLayers::PLACES, i, std::make_unique<PlaceNodeAttributes>());
+  }
+
+  config.registration_threads = 1;
+  config.registration_time_budget_s = 0.015;
+  TestableLcdDetector module(config);
+  auto solver = std::make_unique<FakeRegistrationSolver>(std::set<NodeId>{5});
+  const auto& solver_ref = *solver;
+  module.setRegistrationSolver(1, std::move(solver));
+
+  // first candidate exhausts the budget, so the valid candidate is never tried
+  const auto results = module.registerAndVerify(*dsg, makeRegistrationMatches(), 7);
+  EXPECT_EQ(0u, results.size());
+  EXPECT_EQ(1u, solver_ref.num_calls.load());
+}
+
 }  // namespace hydra::lcd
@@ -179,6 +179,81 @@ TEST(GnnLcdTests, testObjectTensors) {
       << tensors.at("edge_index").map<int64_t>();
 }
 
+TEST(GnnLcdTests, testObjectBatchTensors) {
+  SubgraphConfig config;
+  Eigen::VectorXf fake_embedding(2);
+  fake_embedding << 1.0, 2.0;
+
+  ObjectGnnDescriptor factory(test::get_resource_path("loop_closure/objects.onnx"),
+                              config,
+                              1.5,
+                              {{0, fake_embedding}},
+                              false);
+
+  size_t node_idx = 0;
+  DynamicSceneGraph graph;
+  for (size_t i = 0; i < 7; ++i) {
+    // interleave positions along x so the edge sweep has to reorder nodes
+    const Eigen::Vector3d pos((i % 2 ? 3.0 : 0.0) - 0.4 * i, 0.1 * i, 0.0);
+    emplaceObjectNode(graph, pos, Eigen::Vector3f::Constant(0.1 * i), node_idx);
+  }
+
+  const std::set<NodeId> first{"o0"_id, "o1"_id, "o2"_id, "o3"_id};
+  const std::set<NodeId> second{"o3"_id, "o4"_id, "o5"_id, "o6"_id};
+  const auto first_tensors = factory.makeInput(graph, first);
+  const auto second_tensors = factory.makeInput(graph, second);
+
+  gnn::TensorMap batch;
+  factory.makeBatchInput(graph, {&first, &second}, batch, true);
+  ASSERT_TRUE(batch.count("x"));
+  ASSERT_TRUE(batch.count("pos"));
+  ASSERT_TRUE(batch.count("edge_index"));
+  ASSERT_TRUE(batch.count("batch"));
+
+  for (const auto& name : {"x", "pos"}) {
+    auto batch_map = batch.at(name).map<float>();
+    auto first_map = gnn::Tensor(first_tensors.at(name)).map<float>();
+    auto second_map = gnn::Tensor(second_tensors.at(name)).map<float>();
+    ASSERT_EQ(batch_map.rows(), first_map.rows() + second_map.rows());
+    EXPECT_EQ(batch_map.topRows(first_map.rows()), first_map);
+    EXPECT_EQ(batch_map.bottomRows(second_map.rows()), second_map);
+  }
+
+  auto batch_edges = batch.at("edge_index").map<int64_t>();
+  auto first_edges = gnn::Tensor(first_tensors.at("edge_index")).map<int64_t>();
+  auto second_edges = gnn::Tensor(second_tensors.at("edge_index")).map<int64_t>();
+  ASSERT_GT(first_edges.cols(), 0);
+  ASSERT_EQ(batch_edges.cols(), first_edges.cols() + second_edges.cols());
+  EXPECT_EQ(batch_edges.leftCols(first_edges.cols()), first_edges);
+  Eigen::Matrix<int64_t, Eigen::Dynamic, Eigen::Dynamic> offset_edges =
+      second_edges.array() + 4;
+  EXPECT_EQ(batch_edges.rightCols(second_edges.cols()), offset_edges);
+
+  // edges should match a dense all-pairs search in the same (sorted) order
+  std::vector<std::pair<int64_t, int64_t>> expected;
+  const std::vector<NodeId> nodes(first.begin(), first.end());
+  for (int64_t i = 0; i < static_cast<int64_t>(nodes.size()); ++i) {
+    for (int64_t j = 0; j < static_cast<int64_t>(nodes.size()); ++j) {
+      const auto& source = graph.getPosition(nodes[i]);
+      const auto& target = graph.getPosition(nodes[j]);
+      if (i != j && (source - target).norm() <= 1.5) {
+        expected.push_back({i, j});
+      }
+    }
+  }
+
+  ASSERT_EQ(static_cast<size_t>(first_edges.cols()), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(first_edges(0, i), expected[i].first);
+    EXPECT_EQ(first_edges(1, i), expected[i].second);
+  }
+
+  Eigen::Matrix<int64_t, Eigen::Dynamic, 1> batch_index(8);
+  batch_index << 0, 0, 0, 0, 1, 1, 1, 1;
+  auto batch_map = batch.at("batch").map<int64_t>();
+  EXPECT_EQ(batch_map, batch_index);
+}
+
 TEST(GnnLcdTests, testLoadEmbeddings) {
   const auto embeddings =
       loadLabelEmbeddings(test::get_resource_path("loop_closure/test_embeddings.yaml"));
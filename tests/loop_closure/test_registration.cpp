@@ -344,6 +344,32 @@ TEST_F(GraphRegistrationTests, DISABLED_TestFullPlaceRegistration) {
   EXPECT_FALSE(invalid_result.valid);
 }
 
+TEST_F(LayerRegistrationTests, TestSemanticCorrespondencesMatchPairwise) {
+  // assign a small number of labels so that buckets have multiple entries
+  std::list<NodeId> src_ids;
+  std::list<NodeId> dest_ids;
+  for (int i = 0; i < src_points.cols(); ++i) {
+    src_layer->getNode(i).attributes<SemanticNodeAttributes>().semantic_label = i % 7;
+    dest_layer->getNode(i).attributes<SemanticNodeAttributes>().semantic_label =
+        (3 * i) % 5;
+    src_ids.push_back(i);
+    if (i % 3) {
+      dest_ids.push_back(i);
+    }
+  }
+
+  const auto src_nodes = getRegistrationNodes(*src_layer, src_ids);
+  const auto dest_nodes = getRegistrationNodes(*dest_layer, dest_ids);
+  const auto expected = getCorrespondences(
+      src_nodes, dest_nodes, [](const SceneGraphNode& lhs, const SceneGraphNode& rhs) {
+        return lhs.attributes<SemanticNodeAttributes>().semantic_label ==
+               rhs.attributes<SemanticNodeAttributes>().semantic_label;
+      });
+  const auto result = getSemanticCorrespondences(src_nodes, dest_nodes);
+  EXPECT_FALSE(result.empty());
+  EXPECT_EQ(expected, result);
+}
+
 TEST_F(LayerRegistrationTests, TestRepeatedRegistration) {
   teaser::RobustRegistrationSolver::Params params;
   params.estimate_scaling = false;
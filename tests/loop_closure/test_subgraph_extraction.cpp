@@ -208,4 +208,54 @@ TEST(GnnLcdTests, testGetSubgraphObjects) {
   }
 }
 
+TEST(GnnLcdTests, testCachedSubgraphMatches) {
+  DynamicSceneGraph graph;
+
+  // 5 x 5 grid of places with an object next to every other place
+  size_t p_idx = 0;
+  size_t o_idx = 0;
+  for (size_t i = 0; i < 25; ++i) {
+    const Eigen::Vector3d pos(0.5 * (i % 5) + 0.01 * i, 0.5 * (i / 5), 0.0);
+    emplacePlaceNode(graph, pos, 0.1, 1, p_idx);
+    if (i % 5 > 0) {
+      graph.insertEdge(NodeSymbol('p', i - 1), NodeSymbol('p', i));
+    }
+
+    if (i >= 5) {
+      graph.insertEdge(NodeSymbol('p', i - 5), NodeSymbol('p', i));
+    }
+
+    if (i % 2 == 0) {
+      const Eigen::Vector3d offset(0.05, 0.02 * i, 0.0);
+      emplaceObjectNode(graph, pos + offset, Eigen::Vector3f::Zero(), o_idx);
+      graph.insertEdge(NodeSymbol('p', i), NodeSymbol('o', o_idx - 1));
+    }
+  }
+
+  SubgraphConfig fixed(0.8);
+  SubgraphConfig filtered;
+  filtered.fixed_radius = false;
+  filtered.max_radius_m = 1.2;
+  filtered.min_radius_m = 0.3;
+  filtered.min_nodes = 4;
+
+  // a single cache is reused across all roots to exercise overlapping subgraphs
+  SubgraphCache cache(graph);
+  for (size_t i = 0; i < 25; ++i) {
+    const NodeId root = NodeSymbol('p', i);
+    for (const auto& config : {fixed, filtered}) {
+      for (const bool is_places : {true, false}) {
+        const auto expected = getSubgraphNodes(config, graph, root, is_places);
+        const auto result = getSubgraphNodes(config, cache, root, is_places);
+        EXPECT_EQ(result, expected) << "root: " << i << ", places: " << is_places;
+      }
+    }
+  }
+
+  EXPECT_EQ(cache.size(), 25u);
+  EXPECT_EQ(cache.getLabel("o0"_id), 0u);
+  EXPECT_FALSE(cache.getLabel("p0"_id));
+  EXPECT_TRUE(getSubgraphNodes(fixed, cache, "p100"_id, true).empty());
+}
+
 }  // namespace hydra
@@ -0,0 +1,129 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/places/gvd_integrator_config.h>
+#include <hydra/places/gvd_parent_tracker.h>
+
+namespace hydra::places {
+
+TEST(GvdParentTracker, ParentSetOverflow) {
+  GvdParentSet parents;
+  EXPECT_TRUE(parents.empty());
+
+  std::vector<GlobalIndex> expected;
+  for (int i = 0; i < 7; ++i) {
+    expected.emplace_back(i, -i, 2 * i);
+    parents.insert(expected.back());
+    EXPECT_EQ(parents.size(), expected.size());
+  }
+
+  std::vector<GlobalIndex> result(parents.begin(), parents.end());
+  EXPECT_EQ(result, expected);
+}
+
+TEST(GvdParentTracker, TracksParentsAndVertices) {
+  GvdLayer layer(0.1, 8);
+  const GlobalIndex surface(-9, 3, 0);
+  auto& block = layer.allocateBlock(BlockIndex(-2, 0, 0));
+  const VoxelIndex voxel_index(7, 3, 0);
+  auto& voxel = block.getVoxel(spatial_hash::linearIndexFromVoxelIndex(voxel_index, 8));
+  voxel.on_surface = true;
+  voxel.parent_pos = Point(1.0, 2.0, 3.0);
+  ASSERT_EQ(layer.getVoxelPtr(surface), &voxel);
+
+  VoronoiCheckConfig config;
+  config.mode = ParentUniquenessMode::L1_DISTANCE;
+  config.parent_l1_separation = 1.0;
+
+  GvdParentTracker tracker(0.1, 8);
+  const GlobalIndex gvd_index(-1, 0, 0);
+  GvdVoxel neighbor;
+  neighbor.parent = surface;
+  EXPECT_EQ(tracker.updateGvdParentMap(layer, config, gvd_index, neighbor), 1u);
+  // the same parent isn't unique
+  EXPECT_EQ(tracker.updateGvdParentMap(layer, config, gvd_index, neighbor), 1u);
+  neighbor.parent = GlobalIndex(5, 5, 5);
+  EXPECT_EQ(tracker.updateGvdParentMap(layer, config, gvd_index, neighbor), 2u);
+
+  const auto* parents = tracker.getParents(gvd_index);
+  ASSERT_TRUE(parents != nullptr);
+  EXPECT_EQ(parents->size(), 2u);
+  EXPECT_TRUE(tracker.getParents(GlobalIndex(0, 0, 0)) == nullptr);
+
+  // only parents on the surface get vertex information
+  const auto* info = tracker.getVertex(surface);
+  ASSERT_TRUE(info != nullptr);
+  EXPECT_EQ(info->ref_count, 1u);
+  EXPECT_EQ(info->pos, Point(1.0, 2.0, 3.0));
+  EXPECT_TRUE(tracker.getVertex(GlobalIndex(5, 5, 5)) == nullptr);
+
+  voxel.parent_pos = Point(4.0, 5.0, 6.0);
+  tracker.updateVertexMapping(layer);
+  EXPECT_EQ(tracker.getVertex(surface)->pos, Point(4.0, 5.0, 6.0));
+
+  // unreferenced vertices are collected and empty blocks are released
+  tracker.removeVoronoiFromGvdParentMap(gvd_index);
+  EXPECT_TRUE(tracker.getParents(gvd_index) == nullptr);
+  EXPECT_EQ(tracker.getVertex(surface)->ref_count, 0u);
+  tracker.updateVertexMapping(layer);
+  EXPECT_TRUE(tracker.getVertex(surface) == nullptr);
+  EXPECT_EQ(tracker.numBlocks(), 0u);
+}
+
+TEST(GvdParentTracker, RemoveBlockReleasesInfo) {
+  GvdLayer layer(0.1, 8);
+  auto& block = layer.allocateBlock(BlockIndex(0, 0, 0));
+  const VoxelIndex voxel_index(1, 1, 1);
+  auto& voxel = block.getVoxel(spatial_hash::linearIndexFromVoxelIndex(voxel_index, 8));
+  voxel.on_surface = true;
+
+  VoronoiCheckConfig config;
+  GvdParentTracker tracker(0.1, 8);
+  GvdVoxel neighbor;
+  neighbor.parent = GlobalIndex(1, 1, 1);
+  tracker.updateGvdParentMap(layer, config, GlobalIndex(12, 0, 0), neighbor);
+  EXPECT_EQ(tracker.numBlocks(), 2u);
+
+  tracker.removeBlock(BlockIndex(0, 0, 0));
+  EXPECT_EQ(tracker.numBlocks(), 1u);
+  EXPECT_TRUE(tracker.getVertex(GlobalIndex(1, 1, 1)) == nullptr);
+  ASSERT_TRUE(tracker.getParents(GlobalIndex(12, 0, 0)) != nullptr);
+
+  // removing the voxel after its parent block is gone is still safe
+  tracker.removeVoronoiFromGvdParentMap(GlobalIndex(12, 0, 0));
+  EXPECT_EQ(tracker.numBlocks(), 0u);
+}
+
+}  // namespace hydra::places
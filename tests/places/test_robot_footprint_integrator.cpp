@@ -0,0 +1,135 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/places/robot_footprint_integrator.h>
+
+namespace hydra {
+
+namespace {
+
+inline bool insideFootprint(const RobotFootprintIntegrator::Config& config,
+                            const Eigen::Isometry3f& body_T_world,
+                            const Point& p_world) {
+  const Eigen::Vector3f p_body = body_T_world * p_world;
+  return (p_body.array() >= config.bbox_min.array()).all() &&
+         (p_body.array() <= config.bbox_max.array()).all();
+}
+
+}  // namespace
+
+TEST(RobotFootprintIntegrator, MatchesPerVoxelTest) {
+  RobotFootprintIntegrator::Config config;
+  config.bbox_min << -0.53f, -0.31f, -0.12f;
+  config.bbox_max << 0.61f, 0.33f, 0.21f;
+  config.tsdf_weight = 0.5;
+  config.num_threads = 2;
+  const RobotFootprintIntegrator integrator(config);
+
+  VolumetricMap::Config map_config;
+  map_config.voxel_size = 0.1f;
+  map_config.voxels_per_side = 8;
+  VolumetricMap map(map_config);
+
+  Eigen::Isometry3f world_T_body = Eigen::Isometry3f::Identity();
+  world_T_body.linear() =
+      (Eigen::AngleAxisf(0.7f, Eigen::Vector3f::UnitZ()) *
+       Eigen::AngleAxisf(0.2f, Eigen::Vector3f::UnitX()))
+          .toRotationMatrix();
+  world_T_body.translation() << 1.03f, -0.27f, 0.11f;
+  const auto body_T_world = world_T_body.inverse();
+
+  integrator.addFreespaceFootprint(world_T_body, map);
+
+  // every allocated voxel is updated if and only if its center is in the footprint
+  const auto& tsdf = map.getTsdfLayer();
+  size_t num_updated = 0;
+  for (const auto& block : tsdf) {
+    size_t block_updated = 0;
+    for (size_t i = 0; i < block.numVoxels(); ++i) {
+      const auto& voxel = block.getVoxel(i);
+      const bool updated = voxel.weight > 0.0f;
+      const auto pos = block.getVoxelPosition(i);
+      EXPECT_EQ(updated, insideFootprint(config, body_T_world, pos))
+          << "voxel " << block.getGlobalVoxelIndex(i).transpose();
+      if (updated) {
+        EXPECT_NEAR(voxel.distance, map_config.truncation_distance, 1.0e-6f);
+        EXPECT_NEAR(voxel.weight, config.tsdf_weight, 1.0e-6f);
+        ++block_updated;
+      }
+    }
+
+    // blocks the footprint doesn't cover should never be allocated
+    EXPECT_GT(block_updated, 0u);
+    num_updated += block_updated;
+  }
+
+  // every voxel center inside the footprint should have been written
+  size_t num_expected = 0;
+  GlobalIndex index;
+  for (index.x() = -30; index.x() < 50; ++index.x()) {
+    for (index.y() = -40; index.y() < 40; ++index.y()) {
+      for (index.z() = -20; index.z() < 20; ++index.z()) {
+        if (insideFootprint(config, body_T_world, tsdf.getVoxelPosition(index))) {
+          ++num_expected;
+        }
+      }
+    }
+  }
+
+  EXPECT_GT(num_expected, 0u);
+  EXPECT_EQ(num_updated, num_expected);
+}
+
+TEST(RobotFootprintIntegrator, RasterizeBlockOutsideFootprint) {
+  RobotFootprintIntegrator::Config config;
+  config.bbox_min << -0.5f, -0.5f, -0.5f;
+  config.bbox_max << 0.5f, 0.5f, 0.5f;
+  const RobotFootprintIntegrator integrator(config);
+
+  const Eigen::Isometry3f identity = Eigen::Isometry3f::Identity();
+  const BlockIndex far_block(5, 0, 0);
+  const auto outside = integrator.rasterizeBlock(identity, far_block, 0.1f, 8);
+  EXPECT_TRUE(outside.empty());
+
+  // block [0, 0.8)^3 overlaps the footprint in its first five voxels per axis
+  const auto runs = integrator.rasterizeBlock(identity, BlockIndex(0, 0, 0), 0.1f, 8);
+  EXPECT_EQ(runs.size(), 25u);
+  for (const auto& run : runs) {
+    EXPECT_EQ(run.x_min, 0);
+    EXPECT_EQ(run.x_max, 4);
+  }
+}
+
+}  // namespace hydra
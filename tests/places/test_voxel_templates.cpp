@@ -155,6 +155,78 @@ TEST(VoxelTemplates, RowMajorConversion) {
   }
 }
 
+TEST(VoxelTemplates, RowMajorConversionTables) {
+  // reference conversion between row-major and offset order, bit by bit
+  const auto to_row_major_bit = [](size_t sh_index) {
+    const auto& offset = CubeFlagExtractor::sh_offsets.at(sh_index);
+    return 26 - static_cast<size_t>((offset.x() + 1) + 3 * (offset.y() + 1) +
+                                    9 * (offset.z() + 1));
+  };
+
+  // conversions are applied per 9-bit chunk, so this checks every table entry
+  for (size_t chunk = 0; chunk < 3; ++chunk) {
+    for (uint32_t value = 0; value < 512; ++value) {
+      const std::bitset<27> flags(value << (9 * chunk));
+      std::bitset<27> expected_sh;
+      std::bitset<27> expected_rm;
+      for (size_t i = 0; i < 27; ++i) {
+        expected_sh.set(i, flags[to_row_major_bit(i)]);
+        expected_rm.set(to_row_major_bit(i), flags[i]);
+      }
+
+      EXPECT_EQ(expected_sh, CubeFlagExtractor::fromRowMajor(flags));
+      EXPECT_EQ(expected_rm, CubeFlagExtractor::toRowMajor(flags));
+    }
+  }
+
+  for (uint32_t value = 0; value < (1u << 27); value += 999'983) {
+    const std::bitset<27> flags(value);
+    const auto flags_sh = CubeFlagExtractor::fromRowMajor(flags);
+    EXPECT_EQ(flags, CubeFlagExtractor::toRowMajor(flags_sh));
+  }
+
+  for (size_t i = 0; i < CubeFlagExtractor::sh_offsets.size(); ++i) {
+    EXPECT_EQ(i, CubeFlagExtractor::offsetIndex(CubeFlagExtractor::sh_offsets[i]));
+  }
+}
+
+TEST(VoxelTemplates, NeighborhoodExtractionAcrossBlocks) {
+  for (const size_t voxels_per_side : {1, 2, 4}) {
+    GvdLayer layer(0.1, voxels_per_side);
+    size_t count = 0;
+    for (int x = -1; x <= 0; ++x) {
+      for (int y = -1; y <= 1; ++y) {
+        for (int z = 0; z <= 1; ++z) {
+          auto& block = layer.allocateBlock(BlockIndex(x, y, z));
+          for (size_t i = 0; i < block.numVoxels(); ++i) {
+            block.getVoxel(i).num_extra_basis = (++count % 7) % 3;
+          }
+        }
+      }
+    }
+
+    const int limit = 3 * voxels_per_side;
+    for (int x = -limit; x < limit; ++x) {
+      for (int y = -limit; y < limit; ++y) {
+        for (int z = -limit; z < limit; ++z) {
+          const GlobalIndex index(x, y, z);
+          for (const uint8_t min_basis : {1, 2}) {
+            std::bitset<27> expected;
+            for (size_t n = 0; n < CubeFlagExtractor::sh_offsets.size(); ++n) {
+              const auto neighbor = (CubeFlagExtractor::sh_offsets[n] + index).eval();
+              const auto voxel = layer.getVoxelPtr(neighbor);
+              expected.set(n, voxel && voxel->num_extra_basis >= min_basis);
+            }
+
+            EXPECT_EQ(expected, CubeFlagExtractor::extract(layer, index, min_basis))
+                << "index: " << index.transpose() << ", vps: " << voxels_per_side;
+          }
+        }
+      }
+    }
+  }
+}
+
 TEST_F(SingleBlockExtractionTestFixture, NeighborhoodExtraction) {
   {  // outside any allocated voxels -> nothing should be in the GVD
     GlobalIndex index;
@@ -290,4 +362,51 @@ TEST(VoxelTemplates, CornerDetectionTemplateCorrect) {
 
 #undef TEST_CORNER_ROTATION
 
+TEST(VoxelTemplates, CornerMatchTableExhaustive) {
+  CornerFinder finder;
+  const std::array<const GvdCornerTemplate*, 6> templates{&finder.negative_x_template,
+                                                          &finder.positive_x_template,
+                                                          &finder.negative_y_template,
+                                                          &finder.positive_y_template,
+                                                          &finder.negative_z_template,
+                                                          &finder.positive_z_template};
+
+  // a template rotation matches every state that agrees with the foreground mask
+  // outside of the unused voxels, so enumerate all of those states
+  std::vector<bool> matching(1u << 27, false);
+  for (const auto corner_template : templates) {
+    for (const auto& unused_mask : corner_template->unused_mask_array) {
+      std::vector<size_t> unused_bits;
+      for (size_t i = 0; i < 27; ++i) {
+        if (unused_mask[i]) {
+          unused_bits.push_back(i);
+        }
+      }
+
+      for (uint32_t combo = 0; combo < (1u << unused_bits.size()); ++combo) {
+        std::bitset<27> state = corner_template->fg_mask;
+        for (size_t i = 0; i < unused_bits.size(); ++i) {
+          state.set(unused_bits[i], (combo >> i) & 1);
+        }
+
+        EXPECT_TRUE(finder.matchTemplates(state));
+        matching[state.to_ulong()] = true;
+      }
+    }
+  }
+
+  size_t num_mismatches = 0;
+  for (uint32_t state = 0; state < (1u << 27); ++state) {
+    if (finder.match(std::bitset<27>(state)) != matching[state]) {
+      ++num_mismatches;
+    }
+  }
+  EXPECT_EQ(0u, num_mismatches);
+
+  // spot-check the template logic for states outside the enumerated set
+  for (uint32_t state = 0; state < (1u << 27); state += 9'973) {
+    EXPECT_EQ(matching[state], finder.matchTemplates(std::bitset<27>(state)));
+  }
+}
+
 }  // namespace hydra::places
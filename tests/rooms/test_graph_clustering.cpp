@@ -124,4 +124,35 @@ TEST(GraphClusteringTests, ModularityClusteringCorrect) {
   EXPECT_EQ(second_cluster, cluster_results.clusters.at(1));
 }
 
+TEST(GraphClusteringTests, NeighborClusteringCorrect) {
+  IsolatedSceneGraphLayer layer(1);
+  for (size_t i = 0; i < 6; ++i) {
+    layer.emplaceNode(i, std::make_unique<NodeAttributes>());
+  }
+
+  layer.insertEdge(0, 1, std::make_unique<EdgeAttributes>(1.0));
+  layer.insertEdge(1, 2, std::make_unique<EdgeAttributes>(0.5));
+  layer.insertEdge(2, 3, std::make_unique<EdgeAttributes>(0.2));
+  layer.insertEdge(3, 4, std::make_unique<EdgeAttributes>(0.9));
+  layer.insertEdge(4, 5, std::make_unique<EdgeAttributes>(1.0));
+
+  // node 3 should be claimed through the stronger edge from node 4
+  InitialClusters initial_clusters{{0}, {5}};
+  const auto results = clusterGraphByNeighbors(layer, initial_clusters);
+  EXPECT_TRUE(results.valid);
+
+  std::map<NodeId, size_t> expected_labels{
+      {0, 0}, {1, 0}, {2, 0}, {3, 1}, {4, 1}, {5, 1}};
+  EXPECT_EQ(results.labels, expected_labels);
+
+  ClusterResults::Clusters expected_clusters{{0, {0, 1, 2}}, {1, {3, 4, 5}}};
+  EXPECT_EQ(results.clusters, expected_clusters);
+
+  // csr-based clustering should be identical
+  const CsrGraph graph(layer);
+  const auto csr_results = clusterGraphByNeighbors(graph, initial_clusters);
+  EXPECT_EQ(results.labels, csr_results.labels);
+  EXPECT_EQ(results.clusters, csr_results.clusters);
+}
+
 }  // namespace hydra
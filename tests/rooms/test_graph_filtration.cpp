@@ -205,6 +205,62 @@ TEST(GraphFiltrationTests, TestBarcodeFiltration) {
   EXPECT_EQ(expected_barcodes, tracker.barcodes);
 }
 
+TEST(GraphFiltrationTests, TestCsrMatchesCallback) {
+  // grid of places with distinct distances so that processing order is unique
+  IsolatedSceneGraphLayer layer(1);
+  const size_t rows = 6;
+  const size_t cols = 7;
+  for (size_t r = 0; r < rows; ++r) {
+    for (size_t c = 0; c < cols; ++c) {
+      const double distance = 0.1003 + ((r * cols + c) * 37 % 43) * 0.05;
+      addNode(layer, r * cols + c, distance);
+    }
+  }
+
+  size_t edge_index = 0;
+  for (size_t r = 0; r < rows; ++r) {
+    for (size_t c = 0; c < cols; ++c) {
+      const NodeId node = r * cols + c;
+      if (c + 1 < cols) {
+        addEdge(layer, node, node + 1, 0.07 + (edge_index++ * 13 % 71) * 0.031);
+      }
+      if (r + 1 < rows) {
+        addEdge(layer, node, node + cols, 0.07 + (edge_index++ * 13 % 71) * 0.031);
+      }
+    }
+  }
+
+  for (const bool include_nodes : {true, false}) {
+    for (const size_t min_size : {1u, 3u}) {
+      BarcodeTracker expected_tracker(min_size);
+      const auto expected = getGraphFiltration(
+          layer,
+          expected_tracker,
+          1.0e-4,
+          [&](const DisjointSet& components) {
+            size_t num_components = 0;
+            for (const auto& id_size_pair : components.sizes) {
+              num_components += id_size_pair.second >= min_size ? 1 : 0;
+            }
+            return num_components;
+          },
+          include_nodes);
+
+      BarcodeTracker tracker(min_size);
+      const CsrGraph graph(layer);
+      const auto result = getGraphFiltration(graph,
+                                             getNodeDistances(graph, layer),
+                                             tracker,
+                                             1.0e-4,
+                                             min_size,
+                                             include_nodes);
+      EXPECT_EQ(expected, result) << "include_nodes: " << std::boolalpha
+                                  << include_nodes << ", min_size: " << min_size;
+      EXPECT_EQ(expected_tracker.barcodes, tracker.barcodes);
+    }
+  }
+}
+
 TEST(GraphFiltrationTests, TestLongestSequence) {
   {  // empty values -> no best index
     Filtration values;
@@ -64,10 +64,13 @@ inline DynamicSceneGraph::Ptr makeGraph() {
 }
 
 inline std::list<NodeId> getNodes(ActiveWindowTracker& tracker,
-                                  const SceneGraphLayer& layer,
+                                  ActiveWindows& windows,
+                                  DynamicSceneGraph& graph,
+                                  LayerId layer_id,
                                   bool clear = true) {
+  windows.update(graph, graph.getNewNodes(true), graph.getRemovedNodes(true));
   std::list<NodeId> to_return;
-  for (const auto& node : tracker.view(layer)) {
+  for (const auto& node : tracker.view(graph.getLayer(layer_id), &windows)) {
     to_return.push_back(node.id);
   }
 
@@ -82,30 +85,32 @@ inline std::list<NodeId> getNodes(ActiveWindowTracker& tracker,
 
 TEST(ActiveWindowTracker, ViewCorrect) {
   const auto graph = makeGraph();
+  ActiveWindows windows;
   {  // layer 2 should just be active
     ActiveWindowTracker tracker;
     const std::list<NodeId> expected{5, 6, 7, 8, 9};
-    const auto result = getNodes(tracker, graph->getLayer(2));
+    const auto result = getNodes(tracker, windows, *graph, 2);
     EXPECT_EQ(expected, result);
   }
 
   {  // layer 3 should just be active
     ActiveWindowTracker tracker;
     const std::list<NodeId> expected{10, 11, 12, 13, 14};
-    const auto result = getNodes(tracker, graph->getLayer(3));
+    const auto result = getNodes(tracker, windows, *graph, 3);
     EXPECT_EQ(expected, result);
   }
 
   {  // empty layer should be empty
     ActiveWindowTracker tracker;
     const std::list<NodeId> expected;
-    const auto result = getNodes(tracker, graph->getLayer(4));
+    const auto result = getNodes(tracker, windows, *graph, 4);
     EXPECT_EQ(expected, result);
   }
 }
 
 TEST(ActiveWindowTracker, FirstNodeStateCorrect) {
   const auto graph = makeGraph();
+  ActiveWindows windows;
   ActiveWindowTracker tracker;
 
   // toggle active flag on for all nodes
@@ -115,7 +120,7 @@ TEST(ActiveWindowTracker, FirstNodeStateCorrect) {
 
   {  // layer 2 should just be active
     const std::list<NodeId> expected{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
-    const auto result = getNodes(tracker, graph->getLayer(2));
+    const auto result = getNodes(tracker, windows, *graph, 2);
     EXPECT_EQ(expected, result);
   }
 
@@ -126,18 +131,19 @@ TEST(ActiveWindowTracker, FirstNodeStateCorrect) {
 
   {  // layer 2 should be all previous active nodes
     const std::list<NodeId> expected{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
-    const auto result = getNodes(tracker, graph->getLayer(2));
+    const auto result = getNodes(tracker, windows, *graph, 2);
     EXPECT_EQ(expected, result);
   }
 }
 
 TEST(ActiveWindowTracker, ViewStateCorrect) {
   const auto graph = makeGraph();
+  ActiveWindows windows;
   ActiveWindowTracker tracker;
 
   {  // layer 2 should just be active
     const std::list<NodeId> expected{5, 6, 7, 8, 9};
-    const auto result = getNodes(tracker, graph->getLayer(2));
+    const auto result = getNodes(tracker, windows, *graph, 2);
     EXPECT_EQ(expected, result);
   }
 
@@ -148,30 +154,31 @@ TEST(ActiveWindowTracker, ViewStateCorrect) {
 
   {  // layer 2 should be all previous active nodes
     const std::list<NodeId> expected{5, 6, 7, 8, 9};
-    const auto result = getNodes(tracker, graph->getLayer(2), false);
+    const auto result = getNodes(tracker, windows, *graph, 2, false);
     EXPECT_EQ(expected, result);
   }
 
   {  // repeated iteration without clearing should get the same result
     const std::list<NodeId> expected{5, 6, 7, 8, 9};
-    const auto result = getNodes(tracker, graph->getLayer(2), true);
+    const auto result = getNodes(tracker, windows, *graph, 2, true);
     EXPECT_EQ(expected, result);
   }
 
   {  // layer 2 should be empty (now that we've cleared previously active nodes)
     const std::list<NodeId> expected;
-    const auto result = getNodes(tracker, graph->getLayer(2));
+    const auto result = getNodes(tracker, windows, *graph, 2);
     EXPECT_EQ(expected, result);
   }
 }
 
 TEST(ActiveWindowTracker, RemovedNodesCorrect) {
   const auto graph = makeGraph();
+  ActiveWindows windows;
   ActiveWindowTracker tracker;
 
   {  // layer 2 should just be active
     const std::list<NodeId> expected{5, 6, 7, 8, 9};
-    const auto result = getNodes(tracker, graph->getLayer(2));
+    const auto result = getNodes(tracker, windows, *graph, 2);
     EXPECT_EQ(expected, result);
   }
 
@@ -186,9 +193,92 @@ TEST(ActiveWindowTracker, RemovedNodesCorrect) {
 
   {  // layer 2 should be all previous active nodes
     const std::list<NodeId> expected{5, 6, 7, 9};
-    const auto result = getNodes(tracker, graph->getLayer(2));
+    const auto result = getNodes(tracker, windows, *graph, 2);
     EXPECT_EQ(expected, result);
   }
 }
 
+TEST(ActiveWindowTracker, SharedIndexCorrect) {
+  const auto graph = makeGraph();
+  ActiveWindows windows;
+  const auto index = windows.index(2);
+  ActiveWindowTracker first(index);
+  ActiveWindowTracker second(index);
+
+  {  // both trackers see the active nodes
+    const std::list<NodeId> expected{5, 6, 7, 8, 9};
+    EXPECT_EQ(expected, getNodes(first, windows, *graph, 2));
+    EXPECT_EQ(expected, getNodes(second, windows, *graph, 2));
+  }
+
+  for (const auto& iter : graph->getLayer(2).nodes()) {
+    iter.second->attributes().is_active = false;
+  }
+
+  {  // archived nodes stay visible until both trackers have cleared
+    const std::list<NodeId> expected{5, 6, 7, 8, 9};
+    EXPECT_EQ(expected, getNodes(first, windows, *graph, 2));
+    EXPECT_EQ(index->size(), 5u);
+    EXPECT_EQ(expected, getNodes(second, windows, *graph, 2));
+    EXPECT_EQ(index->size(), 0u);
+  }
+
+  {  // window is empty for both trackers afterwards
+    const std::list<NodeId> expected;
+    EXPECT_EQ(expected, getNodes(first, windows, *graph, 2));
+    EXPECT_EQ(expected, getNodes(second, windows, *graph, 2));
+  }
+}
+
+TEST(ActiveWindowTracker, IndexEventsCorrect) {
+  const auto graph = makeGraph();
+  ActiveWindowIndex index;
+  index.activate(0);
+  index.activate(5);
+  index.archive(5);
+  index.remove(0);
+  EXPECT_FALSE(index.contains(0));
+  EXPECT_TRUE(index.contains(5));
+  EXPECT_EQ(index.size(), 1u);
+
+  // out-of-order ids are inserted in sorted order
+  index.activate(9);
+  index.activate(7);
+  index.activate(0);
+  index.remove(0);
+  index.activate(0);
+  {
+    std::list<NodeId> result;
+    for (const auto& node : index.view(graph->getLayer(2))) {
+      result.push_back(node.id);
+    }
+
+    const std::list<NodeId> expected{0, 5, 7, 9};
+    EXPECT_EQ(expected, result);
+  }
+
+  // removed nodes are dropped and new nodes are picked up from notifications
+  graph->getNewNodes(true);
+  graph->removeNode(7);
+  {
+    auto attrs = std::make_unique<NodeAttributes>();
+    attrs->is_active = true;
+    graph->emplaceNode(2, 20, std::move(attrs));
+  }
+
+  // no tracker uses the index, so archived nodes are dropped right away
+  const auto new_nodes = graph->getNewNodes(true);
+  index.update(graph->getLayer(2), new_nodes, graph->getRemovedNodes(true));
+  std::list<NodeId> result;
+  for (const auto& node : index.view(graph->getLayer(2))) {
+    result.push_back(node.id);
+  }
+
+  const std::list<NodeId> expected{9, 20};
+  EXPECT_EQ(expected, result);
+  EXPECT_FALSE(index.contains(0));
+  EXPECT_FALSE(index.contains(5));
+  EXPECT_FALSE(index.contains(7));
+}
+
 }  // namespace hydra
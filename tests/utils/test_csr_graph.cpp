@@ -0,0 +1,151 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/utils/csr_graph.h>
+#include <hydra/utils/disjoint_set.h>
+
+namespace hydra {
+
+TEST(CsrGraph, EmptyLayerCorrect) {
+  IsolatedSceneGraphLayer layer(1);
+  CsrGraph graph(layer);
+  EXPECT_EQ(graph.numNodes(), 0u);
+  EXPECT_EQ(graph.numEdges(), 0u);
+  ASSERT_EQ(graph.offsets.size(), 1u);
+  EXPECT_TRUE(graph.getComponents().empty());
+}
+
+TEST(CsrGraph, ConstructionCorrect) {
+  IsolatedSceneGraphLayer layer(1);
+  layer.emplaceNode(7, std::make_unique<NodeAttributes>());
+  layer.emplaceNode(3, std::make_unique<NodeAttributes>());
+  layer.emplaceNode(5, std::make_unique<NodeAttributes>());
+  layer.emplaceNode(1, std::make_unique<NodeAttributes>());
+  layer.insertEdge(7, 3, std::make_unique<EdgeAttributes>(0.5));
+  layer.insertEdge(3, 1, std::make_unique<EdgeAttributes>(2.0));
+  layer.insertEdge(7, 1, std::make_unique<EdgeAttributes>(1.5));
+
+  CsrGraph graph(layer);
+  EXPECT_EQ(graph.numNodes(), 4u);
+  EXPECT_EQ(graph.numEdges(), 3u);
+
+  // indices are assigned in order of node id
+  std::vector<NodeId> expected_ids{1, 3, 5, 7};
+  EXPECT_EQ(graph.ids, expected_ids);
+  EXPECT_EQ(graph.getIndex(5), std::optional<size_t>(2));
+  EXPECT_FALSE(graph.getIndex(2));
+
+  std::vector<size_t> expected_offsets{0, 2, 4, 4, 6};
+  std::vector<size_t> expected_neighbors{1, 3, 0, 3, 0, 1};
+  std::vector<double> expected_weights{2.0, 1.5, 2.0, 0.5, 1.5, 0.5};
+  EXPECT_EQ(graph.offsets, expected_offsets);
+  EXPECT_EQ(graph.neighbors, expected_neighbors);
+  EXPECT_EQ(graph.weights, expected_weights);
+  EXPECT_EQ(graph.degree(2), 0u);
+}
+
+TEST(CsrGraph, WeightFunctionCorrect) {
+  IsolatedSceneGraphLayer layer(1);
+  layer.emplaceNode(0, std::make_unique<NodeAttributes>(Eigen::Vector3d::Zero()));
+  layer.emplaceNode(1, std::make_unique<NodeAttributes>(Eigen::Vector3d(2.0, 0, 0)));
+  layer.insertEdge(0, 1);
+
+  CsrGraph graph(layer, [](const SceneGraphLayer& G, NodeId n1, NodeId n2) {
+    return 1.0 / (G.getPosition(n1) - G.getPosition(n2)).norm();
+  });
+
+  std::vector<double> expected_weights{0.5, 0.5};
+  EXPECT_EQ(graph.weights, expected_weights);
+}
+
+TEST(CsrGraph, ComponentsCorrect) {
+  IsolatedSceneGraphLayer layer(1);
+  for (size_t i = 0; i < 6; ++i) {
+    layer.emplaceNode(i, std::make_unique<NodeAttributes>());
+  }
+
+  layer.insertEdge(0, 1, std::make_unique<EdgeAttributes>(1.0));
+  layer.insertEdge(1, 2, std::make_unique<EdgeAttributes>(0.1));
+  layer.insertEdge(3, 4, std::make_unique<EdgeAttributes>(1.0));
+  layer.insertEdge(4, 5, std::make_unique<EdgeAttributes>(1.0));
+
+  CsrGraph graph(layer);
+  {  // no filters
+    const auto components = graph.getComponents();
+    ASSERT_EQ(components.size(), 2u);
+    EXPECT_EQ(std::set<size_t>(components[0].begin(), components[0].end()),
+              std::set<size_t>({0, 1, 2}));
+    EXPECT_EQ(std::set<size_t>(components[1].begin(), components[1].end()),
+              std::set<size_t>({3, 4, 5}));
+  }
+
+  {  // node and edge filters
+    const auto components = graph.getComponents(
+        [](size_t index) { return index != 4; },
+        [](size_t, size_t, double weight) { return weight > 0.5; });
+    ASSERT_EQ(components.size(), 4u);
+    EXPECT_EQ(std::set<size_t>(components[0].begin(), components[0].end()),
+              std::set<size_t>({0, 1}));
+    EXPECT_EQ(components[1], std::vector<size_t>{2});
+    EXPECT_EQ(components[2], std::vector<size_t>{3});
+    EXPECT_EQ(components[3], std::vector<size_t>{5});
+  }
+}
+
+TEST(DenseDisjointSet, UnionCorrect) {
+  DenseDisjointSet set(4);
+  EXPECT_FALSE(set.hasSet(0));
+  EXPECT_TRUE(set.addSet(0));
+  EXPECT_FALSE(set.addSet(0));
+  EXPECT_TRUE(set.addSet(1));
+  EXPECT_TRUE(set.addSet(2));
+  EXPECT_EQ(set.numSets(), 3u);
+
+  auto result = set.doUnion(0, 1);
+  ASSERT_TRUE(result);
+  EXPECT_EQ(*result, 1u);
+  EXPECT_FALSE(set.doUnion(1, 0));
+  EXPECT_EQ(set.findSet(1), 0u);
+  EXPECT_EQ(set.size(0), 2u);
+
+  // larger set always survives
+  result = set.doUnion(2, 1, true);
+  ASSERT_TRUE(result);
+  EXPECT_EQ(*result, 2u);
+  EXPECT_EQ(set.size(0), 3u);
+  EXPECT_EQ(set.numSets(), 1u);
+}
+
+}  // namespace hydra
@@ -0,0 +1,219 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/utils/graph_checkpoint.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "hydra_test/resources.h"
+
+namespace hydra {
+
+namespace {
+
+DynamicSceneGraph::Ptr makeGraph(size_t num_vertices) {
+  auto graph = std::make_shared<DynamicSceneGraph>();
+  for (size_t i = 0; i < 4; ++i) {
+    auto attrs = std::make_unique<PlaceNodeAttributes>();
+    attrs->position << i, 0.0, 0.0;
+    attrs->distance = 1.0 + i;
+    graph->emplaceNode(DsgLayers::PLACES, i, std::move(attrs));
+  }
+
+  graph->insertEdge(0, 1);
+  graph->insertEdge(1, 2, std::make_unique<EdgeAttributes>(0.5));
+
+  auto mesh = std::make_shared<Mesh>(true, true, true);
+  mesh->resizeVertices(num_vertices);
+  for (size_t i = 0; i < num_vertices; ++i) {
+    mesh->setPos(i, Mesh::Pos(i, 2.0 * i, -0.5 * i));
+    mesh->setColor(i, Color(i % 256, 2 * i % 256, 3 * i % 256, 255));
+    mesh->setTimestamp(i, 10 * i);
+    mesh->setLabel(i, i % 7);
+  }
+
+  mesh->resizeFaces(num_vertices - 2);
+  for (size_t i = 0; i + 2 < num_vertices; ++i) {
+    mesh->face(i) = {i, i + 1, i + 2};
+  }
+
+  graph->setMesh(mesh);
+  return graph;
+}
+
+void expectGraphsEqual(const DynamicSceneGraph& expected,
+                       const DynamicSceneGraph& result,
+                       bool with_mesh) {
+  EXPECT_EQ(expected.numNodes(), result.numNodes());
+  EXPECT_EQ(expected.numEdges(), result.numEdges());
+  for (const auto& id_node_pair : expected.getLayer(DsgLayers::PLACES).nodes()) {
+    ASSERT_TRUE(result.hasNode(id_node_pair.first));
+    const auto& node = result.getNode(id_node_pair.first);
+    EXPECT_TRUE(id_node_pair.second->attributes() == node.attributes());
+  }
+
+  ASSERT_TRUE(result.hasEdge(1, 2));
+  EXPECT_EQ(result.getEdge(1, 2).info->weight, 0.5);
+
+  const auto mesh = expected.mesh();
+  const auto result_mesh = result.mesh();
+  if (!with_mesh) {
+    EXPECT_TRUE(!result_mesh || result_mesh->empty());
+    return;
+  }
+
+  ASSERT_TRUE(result_mesh);
+  ASSERT_EQ(result_mesh->numVertices(), mesh->numVertices());
+  ASSERT_EQ(result_mesh->numFaces(), mesh->numFaces());
+  EXPECT_TRUE(result_mesh->has_colors);
+  EXPECT_TRUE(result_mesh->has_timestamps);
+  EXPECT_TRUE(result_mesh->has_labels);
+  for (size_t i = 0; i < mesh->numVertices(); ++i) {
+    EXPECT_EQ(mesh->pos(i), result_mesh->pos(i));
+    EXPECT_EQ(mesh->color(i), result_mesh->color(i));
+    EXPECT_EQ(mesh->timestamp(i), result_mesh->timestamp(i));
+    EXPECT_EQ(mesh->label(i), result_mesh->label(i));
+  }
+
+  for (size_t i = 0; i < mesh->numFaces(); ++i) {
+    EXPECT_EQ(mesh->face(i), result_mesh->face(i));
+  }
+}
+
+}  // namespace
+
+struct GraphCheckpointFixture : public ::testing::Test {
+  void SetUp() override {
+    std::filesystem::remove_all(path());
+    std::filesystem::create_directories(path());
+  }
+
+  void TearDown() override { std::filesystem::remove_all(path()); }
+
+  static std::filesystem::path path() {
+    return std::filesystem::path(test::get_resource_path("graph_checkpoint_tests"));
+  }
+};
+
+TEST_F(GraphCheckpointFixture, RoundTripCorrect) {
+  const auto graph = makeGraph(100);
+  for (const bool compress : {false, true}) {
+    SCOPED_TRACE("compress: " + std::to_string(compress));
+    GraphCheckpointOptions options;
+    options.compress = compress;
+    options.chunk_size = 16;  // spread the mesh over multiple partial chunks
+
+    const auto filepath = (path() / "dsg.hdck").string();
+    ASSERT_TRUE(writeGraphCheckpoint(filepath, *graph, options));
+    EXPECT_TRUE(isGraphCheckpoint(filepath));
+
+    const auto result = readGraphCheckpoint(filepath);
+    ASSERT_TRUE(result);
+    expectGraphsEqual(*graph, *result, true);
+  }
+}
+
+TEST_F(GraphCheckpointFixture, WithoutMeshCorrect) {
+  const auto graph = makeGraph(10);
+  GraphCheckpointOptions options;
+  options.include_mesh = false;
+
+  const auto filepath = (path() / "dsg.hdck").string();
+  ASSERT_TRUE(writeGraphCheckpoint(filepath, *graph, options));
+  const auto result = readGraphCheckpoint(filepath);
+  ASSERT_TRUE(result);
+  expectGraphsEqual(*graph, *result, false);
+}
+
+TEST_F(GraphCheckpointFixture, InvalidFilesRejected) {
+  const auto graph = makeGraph(100);
+  const auto filepath = (path() / "dsg.hdck").string();
+  ASSERT_TRUE(writeGraphCheckpoint(filepath, *graph));
+
+  // json files are not checkpoints
+  const auto json_path = (path() / "dsg.json").string();
+  graph->save(json_path, false);
+  EXPECT_FALSE(isGraphCheckpoint(json_path));
+  EXPECT_FALSE(readGraphCheckpoint(json_path));
+
+  // truncated checkpoints are rejected instead of returning a partial graph
+  const auto size = std::filesystem::file_size(filepath);
+  std::filesystem::resize_file(filepath, size - 1);
+  EXPECT_TRUE(isGraphCheckpoint(filepath));
+  EXPECT_FALSE(readGraphCheckpoint(filepath));
+}
+
+TEST_F(GraphCheckpointFixture, ConvertToJsonCorrect) {
+  const auto graph = makeGraph(20);
+  const auto filepath = (path() / "dsg.hdck").string();
+  const auto json_path = (path() / "dsg.json").string();
+  ASSERT_TRUE(writeGraphCheckpoint(filepath, *graph));
+  ASSERT_TRUE(convertCheckpointToJson(filepath, json_path));
+
+  // loading dispatches on the file contents
+  const auto from_json = loadGraph(json_path);
+  ASSERT_TRUE(from_json);
+  expectGraphsEqual(*graph, *from_json, true);
+
+  const auto from_checkpoint = loadGraph(filepath);
+  ASSERT_TRUE(from_checkpoint);
+  expectGraphsEqual(*graph, *from_checkpoint, true);
+}
+
+TEST_F(GraphCheckpointFixture, BackgroundWriterUsesSnapshot) {
+  const auto graph = makeGraph(50);
+  const auto expected = makeGraph(50);
+  const auto filepath = (path() / "dsg.hdck").string();
+  {
+    GraphCheckpointWriter writer;
+    writer.save(*graph, filepath);
+    // changes after saving do not show up in the checkpoint
+    graph->removeNode(3);
+    graph->mesh()->setPos(0, Mesh::Pos(-1.0, -1.0, -1.0));
+    writer.wait();
+    expectGraphsEqual(*expected, *readGraphCheckpoint(filepath), true);
+
+    // pending checkpoints are written before the writer is destroyed
+    writer.save(*graph, (path() / "modified.hdck").string());
+  }
+
+  const auto result = readGraphCheckpoint((path() / "modified.hdck").string());
+  ASSERT_TRUE(result);
+  EXPECT_FALSE(result->hasNode(3));
+  EXPECT_EQ(result->mesh()->pos(0), Mesh::Pos(-1.0, -1.0, -1.0));
+}
+
+}  // namespace hydra
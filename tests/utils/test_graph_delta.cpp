@@ -0,0 +1,250 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/utils/graph_delta.h>
+
+namespace hydra {
+
+namespace {
+
+void addPlace(DynamicSceneGraph& graph, NodeId node_id, double x) {
+  auto attrs = std::make_unique<PlaceNodeAttributes>();
+  attrs->position << x, 0.0, 0.0;
+  attrs->distance = 1.0;
+  graph.emplaceNode(DsgLayers::PLACES, node_id, std::move(attrs));
+}
+
+void expectGraphsEqual(const DynamicSceneGraph& expected,
+                       const DynamicSceneGraph& result) {
+  EXPECT_EQ(expected.numNodes(), result.numNodes());
+  EXPECT_EQ(expected.numEdges(), result.numEdges());
+  for (const auto& id_node_pair : expected.getLayer(DsgLayers::PLACES).nodes()) {
+    ASSERT_TRUE(result.hasNode(id_node_pair.first));
+    const auto& node = result.getNode(id_node_pair.first);
+    EXPECT_TRUE(id_node_pair.second->attributes() == node.attributes());
+  }
+
+  for (const auto& key_edge_pair : expected.getLayer(DsgLayers::PLACES).edges()) {
+    const auto& key = key_edge_pair.first;
+    ASSERT_TRUE(result.hasEdge(key.k1, key.k2));
+    EXPECT_EQ(key_edge_pair.second.info->weight,
+              result.getEdge(key.k1, key.k2).info->weight);
+  }
+}
+
+}  // namespace
+
+TEST(GraphDelta, KeyframeThenDeltas) {
+  DynamicSceneGraph graph;
+  addPlace(graph, 0, 0.0);
+  addPlace(graph, 1, 1.0);
+  addPlace(graph, 2, 2.0);
+  graph.insertEdge(0, 1);
+  graph.insertEdge(1, 2);
+
+  GraphDeltaEncoder encoder({0, 2});
+  GraphDeltaApplier applier;
+  std::vector<uint8_t> buffer;
+
+  auto header = encoder.encode(graph, false, buffer);
+  EXPECT_EQ(header.type, GraphDeltaType::KEYFRAME);
+  EXPECT_EQ(header.sequence, 1u);
+  EXPECT_EQ(applier.apply(buffer), GraphDeltaApplier::Status::APPLIED);
+  ASSERT_TRUE(applier.graph());
+  expectGraphsEqual(graph, *applier.graph());
+  const auto keyframe_size = buffer.size();
+
+  // an unchanged graph results in an empty delta
+  header = encoder.encode(graph, false, buffer);
+  EXPECT_EQ(header.type, GraphDeltaType::DELTA);
+  EXPECT_LT(buffer.size(), keyframe_size);
+  EXPECT_EQ(applier.apply(buffer), GraphDeltaApplier::Status::APPLIED);
+  expectGraphsEqual(graph, *applier.graph());
+
+  // add, update and remove nodes and edges
+  addPlace(graph, 3, 3.0);
+  graph.insertEdge(2, 3);
+  graph.getNode(0).attributes<PlaceNodeAttributes>().distance = 2.0;
+  encoder.markNode(0);
+  graph.removeEdge(0, 1);
+  graph.removeNode(1);
+  graph.addOrUpdateEdge(2, 3, std::make_unique<EdgeAttributes>(0.5));
+  encoder.markEdge(2, 3);
+
+  header = encoder.encode(graph, false, buffer);
+  EXPECT_EQ(header.type, GraphDeltaType::DELTA);
+  EXPECT_EQ(applier.apply(buffer), GraphDeltaApplier::Status::APPLIED);
+  EXPECT_EQ(applier.sequence(), 3u);
+  EXPECT_FALSE(applier.graph()->hasNode(1));
+  expectGraphsEqual(graph, *applier.graph());
+}
+
+TEST(GraphDelta, GapRequiresKeyframe) {
+  DynamicSceneGraph graph;
+  addPlace(graph, 0, 0.0);
+
+  GraphDeltaEncoder encoder({0, 2});
+  GraphDeltaApplier applier;
+  std::vector<uint8_t> buffer;
+
+  // deltas without a keyframe can't be applied
+  encoder.encode(graph, false, buffer);
+  addPlace(graph, 1, 1.0);
+  encoder.encode(graph, false, buffer);
+  EXPECT_EQ(applier.apply(buffer), GraphDeltaApplier::Status::NEEDS_KEYFRAME);
+  EXPECT_FALSE(applier.synced());
+
+  encoder.requestKeyframe();
+  auto header = encoder.encode(graph, false, buffer);
+  EXPECT_EQ(header.type, GraphDeltaType::KEYFRAME);
+  EXPECT_EQ(applier.apply(buffer), GraphDeltaApplier::Status::APPLIED);
+  EXPECT_TRUE(applier.synced());
+
+  // dropping a delta is detected by the sequence number
+  addPlace(graph, 2, 2.0);
+  encoder.encode(graph, false, buffer);
+  addPlace(graph, 3, 3.0);
+  encoder.encode(graph, false, buffer);
+  EXPECT_EQ(applier.apply(buffer), GraphDeltaApplier::Status::NEEDS_KEYFRAME);
+  EXPECT_EQ(applier.graph()->numNodes(), 2u);
+
+  // garbage is rejected
+  std::vector<uint8_t> garbage{1, 2, 3};
+  EXPECT_EQ(applier.apply(garbage), GraphDeltaApplier::Status::INVALID);
+  buffer.resize(buffer.size() / 2);
+  EXPECT_NE(applier.apply(buffer), GraphDeltaApplier::Status::APPLIED);
+}
+
+TEST(GraphDelta, DynamicNodes) {
+  DynamicSceneGraph graph;
+  const std::chrono::nanoseconds stamp(10);
+  for (size_t i = 0; i < 3; ++i) {
+    auto attrs = std::make_unique<NodeAttributes>();
+    graph.emplaceNode(DsgLayers::AGENTS, 'a', stamp, std::move(attrs));
+  }
+
+  GraphDeltaEncoder encoder({0, 2});
+  GraphDeltaApplier applier;
+  std::vector<uint8_t> buffer;
+  encoder.encode(graph, false, buffer);
+  ASSERT_EQ(applier.apply(buffer), GraphDeltaApplier::Status::APPLIED);
+  const auto keyframe_size = buffer.size();
+
+  // only the new node and the updated node are sent
+  auto attrs = std::make_unique<NodeAttributes>();
+  graph.emplaceNode(DsgLayers::AGENTS, 'a', stamp, std::move(attrs));
+  graph.getNode(NodeSymbol('a', 1)).attributes().position << 1.0, 2.0, 3.0;
+  encoder.markNode(NodeSymbol('a', 1));
+  encoder.encode(graph, false, buffer);
+  EXPECT_LT(buffer.size(), keyframe_size);
+  ASSERT_EQ(applier.apply(buffer), GraphDeltaApplier::Status::APPLIED);
+
+  const auto result = applier.graph();
+  for (size_t i = 0; i < 4; ++i) {
+    ASSERT_TRUE(result->hasNode(NodeSymbol('a', i)));
+  }
+
+  const Eigen::Vector3d expected(1.0, 2.0, 3.0);
+  const auto& node = result->getNode(NodeSymbol('a', 1));
+  EXPECT_NEAR(0.0, (node.attributes().position - expected).norm(), 1.0e-9);
+  EXPECT_EQ(result->getNode(NodeSymbol('a', 3)).timestamp.value(), stamp);
+}
+
+TEST(GraphDelta, PeriodicKeyframes) {
+  DynamicSceneGraph graph;
+  addPlace(graph, 0, 0.0);
+
+  GraphDeltaEncoder encoder({3, 2});
+  std::vector<uint8_t> buffer;
+  std::vector<GraphDeltaType> types;
+  for (size_t i = 0; i < 6; ++i) {
+    types.push_back(encoder.encode(graph, false, buffer).type);
+  }
+
+  std::vector<GraphDeltaType> expected{GraphDeltaType::KEYFRAME,
+                                       GraphDeltaType::DELTA,
+                                       GraphDeltaType::DELTA,
+                                       GraphDeltaType::KEYFRAME,
+                                       GraphDeltaType::DELTA,
+                                       GraphDeltaType::DELTA};
+  EXPECT_EQ(types, expected);
+}
+
+TEST(GraphDelta, MeshBlocks) {
+  DynamicSceneGraph graph;
+  auto mesh = std::make_shared<Mesh>();
+  mesh->resizeVertices(5);
+  for (size_t i = 0; i < 5; ++i) {
+    mesh->setPos(i, Mesh::Pos(i, 2.0 * i, 3.0 * i));
+  }
+  mesh->resizeFaces(2);
+  mesh->face(0) = {0, 1, 2};
+  mesh->face(1) = {2, 3, 4};
+  graph.setMesh(mesh);
+
+  GraphDeltaEncoder encoder({0, 2});
+  GraphDeltaApplier applier;
+  std::vector<uint8_t> buffer;
+  encoder.encode(graph, true, buffer);
+  ASSERT_EQ(applier.apply(buffer), GraphDeltaApplier::Status::APPLIED);
+  const auto keyframe_size = buffer.size();
+
+  // only the block containing the changed vertex is resent
+  mesh->setPos(3, Mesh::Pos(-1.0, -1.0, -1.0));
+  encoder.markVertices(3, 4);
+  encoder.encode(graph, true, buffer);
+  EXPECT_LT(buffer.size(), keyframe_size);
+  ASSERT_EQ(applier.apply(buffer), GraphDeltaApplier::Status::APPLIED);
+
+  // growing the mesh resends the partial block
+  mesh->resizeVertices(6);
+  mesh->setPos(5, Mesh::Pos(5.0, 5.0, 5.0));
+  encoder.encode(graph, true, buffer);
+  ASSERT_EQ(applier.apply(buffer), GraphDeltaApplier::Status::APPLIED);
+
+  const auto result = applier.graph()->mesh();
+  ASSERT_TRUE(result);
+  ASSERT_EQ(result->numVertices(), mesh->numVertices());
+  for (size_t i = 0; i < mesh->numVertices(); ++i) {
+    EXPECT_NEAR(0.0, (mesh->pos(i) - result->pos(i)).norm(), 1.0e-7);
+  }
+
+  ASSERT_EQ(result->numFaces(), mesh->numFaces());
+  for (size_t i = 0; i < mesh->numFaces(); ++i) {
+    EXPECT_EQ(mesh->face(i), result->face(i));
+  }
+}
+
+}  // namespace hydra
@@ -0,0 +1,82 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/utils/graph_stream.h>
+
+namespace hydra {
+
+TEST(GraphStream, LocalhostRoundTrip) {
+  DynamicSceneGraph graph;
+  for (size_t i = 0; i < 3; ++i) {
+    auto attrs = std::make_unique<PlaceNodeAttributes>();
+    attrs->position << i, 0.0, 0.0;
+    graph.emplaceNode(DsgLayers::PLACES, i, std::move(attrs));
+  }
+
+  GraphStreamPublisher::Config pub_config;
+  pub_config.url = "tcp://127.0.0.1:18101";
+  pub_config.resync_url = "tcp://127.0.0.1:18102";
+  pub_config.encoder.keyframe_period = 0;
+  GraphStreamPublisher publisher(pub_config);
+
+  GraphStreamSubscriber::Config sub_config;
+  sub_config.url = pub_config.url;
+  sub_config.resync_url = pub_config.resync_url;
+  sub_config.resync_period_ms = 10;
+  GraphStreamSubscriber subscriber(sub_config);
+
+  // the subscriber misses the initial keyframe because of the slow joiner problem and
+  // has to request a resync
+  for (size_t i = 0; i < 200 && !subscriber.synced(); ++i) {
+    publisher.publish(graph, false);
+    subscriber.recv(10);
+  }
+
+  ASSERT_TRUE(subscriber.synced());
+  EXPECT_EQ(subscriber.graph()->numNodes(), 3u);
+
+  // messages queued before the keyframe are dropped, so keep publishing until the
+  // delta arrives
+  graph.insertEdge(0, 1);
+  for (size_t i = 0; i < 200 && !subscriber.graph()->hasEdge(0, 1); ++i) {
+    publisher.publish(graph, false);
+    subscriber.recv(10);
+  }
+
+  EXPECT_TRUE(subscriber.synced());
+  EXPECT_TRUE(subscriber.graph()->hasEdge(0, 1));
+}
+
+}  // namespace hydra
@@ -107,4 +107,39 @@ TEST(MinimumSpanningTreeTests, TestCompleteGraph) {
   EXPECT_EQ(3u, info.edges[2].target);
 }
 
+TEST(MinimumSpanningTreeTests, TestIncrementalForest) {
+  IncrementalSpanningForest forest;
+  forest.addEdge(0, 1, 1.0);
+  forest.addEdge(1, 2, 2.0);
+  forest.addEdge(2, 3, 3.0);
+  EXPECT_EQ(1u, forest.degree(0));
+  EXPECT_EQ(2u, forest.degree(1));
+
+  // closing the cycle swaps out the heaviest edge
+  forest.addEdge(0, 3, 1.5);
+  EXPECT_TRUE(forest.hasEdge(2, 3));
+  EXPECT_FALSE(forest.inForest(2, 3));
+  EXPECT_TRUE(forest.inForest(0, 3));
+
+  std::vector<IncrementalSpanningForest::Edge> added, removed;
+  forest.popChanges(added, removed);
+  EXPECT_EQ(3u, added.size());
+  EXPECT_TRUE(removed.empty());
+
+  // removing a forest edge reconnects the tree with the lightest remaining edge
+  forest.removeEdge(1, 2);
+  EXPECT_TRUE(forest.inForest(2, 3));
+  forest.popChanges(added, removed);
+  ASSERT_EQ(1u, added.size());
+  EXPECT_EQ(IncrementalSpanningForest::Edge(2, 3), added.front());
+  ASSERT_EQ(1u, removed.size());
+  EXPECT_EQ(IncrementalSpanningForest::Edge(1, 2), removed.front());
+
+  // removing a node splits the forest
+  forest.removeNode(3);
+  EXPECT_EQ(0u, forest.degree(2));
+  EXPECT_EQ(1u, forest.edges().size());
+  EXPECT_TRUE(forest.inForest(0, 1));
+}
+
 }  // namespace hydra
@@ -72,4 +72,99 @@ TEST(NearestNeighborUtilities, TestSkipFirst) {
   }
 }
 
+TEST(NearestNeighborUtilities, TestBatchMatchesSingleQueries) {
+  IsolatedSceneGraphLayer layer(1);
+  std::vector<NodeId> nodes;
+  for (size_t i = 0; i < 50; ++i) {
+    const Eigen::Vector3d pos(i % 5, (i / 5) % 5, 0.5 * i);
+    layer.emplaceNode(i, std::make_unique<NodeAttributes>(pos));
+    nodes.push_back(i);
+  }
+
+  NearestNodeFinder finder(layer, nodes);
+
+  // enough queries to be split across several chunks
+  NearestNodeFinder::Queries queries(3, 300);
+  std::vector<bool> skip_first(queries.cols());
+  for (int i = 0; i < queries.cols(); ++i) {
+    queries.col(i) << 0.1 * (i % 7), 0.2 * (i % 11), 0.13 * i;
+    skip_first[i] = i % 2;
+  }
+
+  for (const int num_threads : {1, 4}) {
+    NeighborBatch<double> result;
+    finder.findBatch(queries, 3, skip_first, result, num_threads);
+    ASSERT_EQ(result.size(), 300u);
+    ASSERT_EQ(result.k, 3u);
+    for (int i = 0; i < queries.cols(); ++i) {
+      std::vector<NodeId> expected;
+      std::vector<double> expected_distances;
+      finder.find(queries.col(i), 3, skip_first[i], [&](NodeId id, size_t, double d) {
+        expected.push_back(id);
+        expected_distances.push_back(d);
+      });
+
+      ASSERT_EQ(result.num_found[i], expected.size()) << "query " << i;
+      for (size_t n = 0; n < expected.size(); ++n) {
+        EXPECT_EQ(finder.nodeId(result.index(i, n)), expected[n]);
+        EXPECT_NEAR(result.distance(i, n), expected_distances[n], 1.0e-9);
+      }
+    }
+  }
+}
+
+TEST(NearestNeighborUtilities, TestBatchSkipFirst) {
+  IsolatedSceneGraphLayer layer(1);
+  layer.emplaceNode(0, std::make_unique<NodeAttributes>(Eigen::Vector3d(0, 0, 3)));
+  layer.emplaceNode(1, std::make_unique<NodeAttributes>(Eigen::Vector3d(0, 0, 0)));
+
+  NearestNodeFinder finder(layer, std::vector<NodeId>{0, 1});
+  NearestNodeFinder::Queries queries(3, 2);
+  queries.col(0) << 0, 0, 2;
+  queries.col(1) << 0, 0, 2;
+
+  NeighborBatch<double> result;
+  finder.findBatch(queries, 2, std::vector<bool>{false, true}, result);
+  ASSERT_EQ(result.num_found[0], 2u);
+  EXPECT_EQ(finder.nodeId(result.index(0, 0)), 0u);
+  EXPECT_NEAR(result.distance(0, 0), 1.0, 1.0e-9);
+  // only one neighbor is left after skipping the closest
+  ASSERT_EQ(result.num_found[1], 1u);
+  EXPECT_EQ(finder.nodeId(result.index(1, 0)), 1u);
+  EXPECT_NEAR(result.distance(1, 0), 4.0, 1.0e-9);
+
+  // empty queries produce empty results
+  finder.findBatch(queries.leftCols(0), 1, false, result);
+  EXPECT_EQ(result.size(), 0u);
+}
+
+TEST(NearestNeighborUtilities, TestPointSearchBatch) {
+  std::vector<Eigen::Vector3f> points;
+  for (size_t i = 0; i < 20; ++i) {
+    points.emplace_back(i, 2.0f * i, 0.0f);
+  }
+
+  PointNeighborSearch search(points);
+  // points are copied by the search and can go out of scope
+  points.clear();
+
+  PointNeighborSearch::Queries queries(3, 100);
+  for (int i = 0; i < queries.cols(); ++i) {
+    queries.col(i) << 0.21f * i, 0.4f * i, 0.1f;
+  }
+
+  NeighborBatch<float> result;
+  search.searchBatch(queries, 2, result, 4);
+  ASSERT_EQ(result.size(), 100u);
+  for (int i = 0; i < queries.cols(); ++i) {
+    float distance;
+    size_t index;
+    ASSERT_TRUE(search.search(queries.col(i), distance, index));
+    ASSERT_EQ(result.num_found[i], 2u);
+    EXPECT_NEAR(result.distance(i, 0), distance, 1.0e-4);
+    EXPECT_LE(result.distance(i, 0), result.distance(i, 1));
+    EXPECT_EQ(result.index(i, 0), index);
+  }
+}
+
 }  // namespace hydra
@@ -0,0 +1,114 @@
+/* -----------------------------------------------------------------------------
+ * Copyright 2022 Massachusetts Institute of Technology.
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Research was sponsored by the United States Air Force Research Laboratory and
+ * the United States Air Force Artificial Intelligence Accelerator and was
+ * accomplished under Cooperative Agreement Number FA8750-19-2-1000. The views
+ * and conclusions contained in this document are those of the authors and should
+ * not be interpreted as representing the official policies, either expressed or
+ * implied, of the United States Air Force or the U.S. Government. The U.S.
+ * Government is authorized to reproduce and distribute reprints for Government
+ * purposes notwithstanding any copyright notation herein.
+ * -------------------------------------------------------------------------- */
+#include <gtest/gtest.h>
+#include <hydra/utils/pgmo_mesh_interface.h>
+
+namespace hydra {
+
+namespace {
+
+void addBlock(MeshLayer& layer,
+              const BlockIndex& index,
+              size_t num_vertices,
+              float offset) {
+  MeshBlock block(layer.blockSize(), index, true);
+  block.points.resize(num_vertices);
+  block.colors.resize(num_vertices);
+  block.labels.resize(num_vertices);
+  for (size_t i = 0; i < num_vertices; ++i) {
+    block.points[i] = Mesh::Pos(offset + i, 2.0 * i, -1.0 * i);
+    block.colors[i] = Color(10 * i, 20, 30 + i, 255);
+    block.labels[i] = static_cast<uint32_t>(i + offset);
+  }
+
+  layer.allocateBlock(index) = block;
+}
+
+void expectSameBlock(const kimera_pgmo::MeshInterface& expected,
+                     const kimera_pgmo::MeshInterface& result,
+                     const BlockIndex& block) {
+  expected.markBlockActive(block);
+  result.markBlockActive(block);
+  ASSERT_EQ(expected.activeBlockSize(), result.activeBlockSize());
+  for (size_t i = 0; i < expected.activeBlockSize(); ++i) {
+    const auto lhs = expected.getActiveVertex(i);
+    const auto rhs = result.getActiveVertex(i);
+    EXPECT_EQ(lhs.x, rhs.x);
+    EXPECT_EQ(lhs.y, rhs.y);
+    EXPECT_EQ(lhs.z, rhs.z);
+    EXPECT_EQ(lhs.r, rhs.r);
+    EXPECT_EQ(lhs.g, rhs.g);
+    EXPECT_EQ(lhs.b, rhs.b);
+    EXPECT_EQ(lhs.a, rhs.a);
+    EXPECT_EQ(expected.getActiveSemantics(i), result.getActiveSemantics(i));
+  }
+}
+
+}  // namespace
+
+TEST(PgmoMeshInterface, SnapshotMatchesMeshInterface) {
+  MeshLayer layer(1.0);
+  const BlockIndex first(0, 0, 0);
+  const BlockIndex second(1, 0, 0);
+  const BlockIndex skipped(2, 0, 0);
+  addBlock(layer, first, 3, 0.0);
+  addBlock(layer, second, 5, 10.0);
+  addBlock(layer, skipped, 2, 20.0);
+
+  // only the requested blocks are packed
+  const auto snapshot =
+      std::make_shared<PgmoMeshSnapshot>(layer, BlockIndices{first, second});
+  const PgmoMeshSnapshotInterface interface(snapshot);
+  EXPECT_EQ(snapshot->numVertices(), 8u);
+  EXPECT_EQ(interface.blockIndices(), (BlockIndices{first, second}));
+  EXPECT_TRUE(interface.hasSemantics());
+
+  for (const auto& block : {first, second}) {
+    const PgmoMeshInterface expected(layer.getBlock(block));
+    EXPECT_EQ(expected.hasSemantics(), interface.hasSemantics());
+    expectSameBlock(expected, interface, block);
+  }
+
+  // blocks that weren't packed are empty
+  interface.markBlockActive(skipped);
+  EXPECT_EQ(interface.activeBlockSize(), 0u);
+
+  // a subset of the packed blocks matches as well
+  const PgmoMeshSnapshotInterface subset(snapshot, {second, skipped});
+  EXPECT_EQ(subset.blockIndices(), BlockIndices{second});
+  expectSameBlock(PgmoMeshInterface(layer.getBlock(second)), subset, second);
+}
+
+}  // namespace hydra